@@ -7,6 +7,7 @@ for item in "${list[@]}" ; do
   echo "generate query $1"
 
   nohup /usr/bin/time -f "#bit, BTreePlusAlpha, n = $1, %e sec, %M KB" ./build/bit_rank_select.out -x BTreePlusAlpha -n $1 -q 1000000 >> "./log/bit_rank_select_my.log"
+  nohup /usr/bin/time -f "#bit, BTreePlusAlpha_NaiveLeaf, n = $1, %e sec, %M KB" ./build/bit_rank_select.out -x BTreePlusAlpha_NaiveLeaf -n $1 -q 1000000 >> "./log/bit_rank_select_naive_leaf.log"
 
   # nohup /usr/bin/time -f "#bit, bit_vector, n = $1, %e sec, %M KB" ./bit_rank_select.out -x bit_vector -n $1 -q 1000000 >> "./log/bit_rank_select_bv.log"
   # nohup /usr/bin/time -f "#bit, DYNAMIC, n = $1, %e sec, %M KB" ./bit_rank_select.out -x DYNAMIC -n $1 -q 1000000 >> "./log/bit_rank_select_dynamic.log"
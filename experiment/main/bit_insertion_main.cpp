@@ -0,0 +1,108 @@
+#include <iostream>
+#include <string>
+#include <memory>
+#include <cassert>
+#include <chrono>
+#include "stool/include/all.hpp"
+#include "../../include/all.hpp"
+
+template <typename T>
+void bit_insertion_test(T &dynamic_bit_sequence, std::string name, uint64_t item_num, uint64_t query_num, uint64_t seed)
+{
+    std::cout << "Test: " << name << std::endl;
+
+    std::mt19937_64 mt64(seed);
+    uint64_t hash = 0;
+    std::chrono::system_clock::time_point st1, st2;
+
+    std::cout << "Construction..." << std::endl;
+    st1 = std::chrono::system_clock::now();
+    for (uint64_t i = 0; i < item_num; i++)
+    {
+        dynamic_bit_sequence.push_back(mt64() % 2 == 1);
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_construction = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    std::cout << "Sequential Insertion..." << std::endl;
+    uint64_t cursor = dynamic_bit_sequence.size() / 2;
+    st1 = std::chrono::system_clock::now();
+    for (uint64_t i = 0; i < query_num; i++)
+    {
+        bool value = mt64() % 2 == 1;
+        dynamic_bit_sequence.insert(cursor, value);
+        cursor += 1 + (mt64() % 4);
+        if (cursor > dynamic_bit_sequence.size())
+        {
+            cursor = 0;
+        }
+        hash += value + cursor;
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_sequential_insertion = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    std::cout << "Random Insertion..." << std::endl;
+    st1 = std::chrono::system_clock::now();
+    for (uint64_t i = 0; i < query_num; i++)
+    {
+        uint64_t pos = mt64() % (dynamic_bit_sequence.size() + 1);
+        bool value = mt64() % 2 == 1;
+        dynamic_bit_sequence.insert(pos, value);
+        hash += value + pos;
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_random_insertion = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    std::cout << "rank1..." << std::endl;
+    st1 = std::chrono::system_clock::now();
+    for (uint64_t i = 0; i < query_num; i++)
+    {
+        hash += dynamic_bit_sequence.rank1(mt64() % dynamic_bit_sequence.size());
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_rank = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    std::cout << "\033[36m";
+    std::cout << "=============RESULT===============" << std::endl;
+    std::cout << "Test: " << name << std::endl;
+    std::cout << "item_num = " << item_num << ", query_num = " << query_num << ", seed = " << seed << std::endl;
+    std::cout << "Checksum                 : " << hash << std::endl;
+    std::cout << "Construction Time        : " << (time_construction / (1000 * 1000)) << "[ms] (Avg: " << (time_construction / item_num) << "[ns])" << std::endl;
+    std::cout << "Sequential Insertion Time: " << (time_sequential_insertion / (1000 * 1000)) << "[ms] (Avg: " << (time_sequential_insertion / query_num) << "[ns])" << std::endl;
+    std::cout << "Random Insertion Time    : " << (time_random_insertion / (1000 * 1000)) << "[ms] (Avg: " << (time_random_insertion / query_num) << "[ns])" << std::endl;
+    std::cout << "Rank Time                : " << (time_rank / (1000 * 1000)) << "[ms] (Avg: " << (time_rank / query_num) << "[ns])" << std::endl;
+    stool::Memory::print_memory_usage();
+    std::cout << "==================================" << std::endl;
+    std::cout << "\033[39m" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    cmdline::parser p;
+
+    p.add<std::string>("index_name", 'x', "index_name (BTreePlusAlpha or GapBuffer)", false, "BTreePlusAlpha");
+    p.add<uint64_t>("item_num", 'n', "item_num", false, 1000000);
+    p.add<uint64_t>("query_num", 'q', "query_num", false, 1000000);
+    p.add<uint64_t>("seed", 's', "seed", false, 0);
+
+    p.parse_check(argc, argv);
+    std::string index_name = p.get<std::string>("index_name");
+    uint64_t item_num = p.get<uint64_t>("item_num");
+    uint64_t query_num = p.get<uint64_t>("query_num");
+    uint64_t seed = p.get<uint64_t>("seed");
+
+    if (index_name == "BTreePlusAlpha")
+    {
+        stool::bptree::SimpleDynamicBitSequence dbs;
+        bit_insertion_test(dbs, "stool::bptree::SimpleDynamicBitSequence", item_num, query_num, seed);
+    }
+    else if (index_name == "GapBuffer")
+    {
+        stool::bptree::DynamicGapBitSequence dbs;
+        bit_insertion_test(dbs, "stool::bptree::DynamicGapBitSequence", item_num, query_num, seed);
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown index_name: " + index_name);
+    }
+}
@@ -4,6 +4,7 @@
 #include <bitset>
 #include <cassert>
 #include <chrono>
+#include <algorithm>
 #include "stool/include/all.hpp"
 #include "../../include/all.hpp"
 #if defined(__x86_64__)
@@ -14,6 +15,15 @@
 
 std::vector<uint64_t> checksum_vector;
 
+using NBC = stool::bptree::NaiveBitVectorContainer<10000ULL>;
+/**
+ * @brief SimpleDynamicBitSequence with the old leaves of stool::NaiveBitVector, for comparing the leaf implementations
+ */
+using NaiveLeafDynamicBitSequence = stool::bptree::DynamicBitSequence<NBC, NBC::NaiveBitVectorContainerIterator, 62, 8192>;
+
+template <typename T>
+constexpr bool IS_BPTREE_BIT_SEQUENCE = std::is_same<T, stool::bptree::SimpleDynamicBitSequence>::value || std::is_same<T, NaiveLeafDynamicBitSequence>::value;
+
 template <typename T>
 void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::string test_type, uint64_t item_num, uint64_t query_num, uint64_t seed)
 {
@@ -36,7 +46,7 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
 
     st1 = std::chrono::system_clock::now();
 
-    if constexpr (std::is_same<T, stool::bptree::SimpleDynamicBitSequence>::value)
+    if constexpr (IS_BPTREE_BIT_SEQUENCE<T>)
     {
         std::vector<bool> buffer;
         uint64_t buffer_size = 10000;
@@ -72,7 +82,7 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
     st2 = std::chrono::system_clock::now();
     uint64_t time_construction = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
 
-    if constexpr (std::is_same<T, stool::bptree::SimpleDynamicBitSequence>::value) {
+    if constexpr (IS_BPTREE_BIT_SEQUENCE<T>) {
          density_when_build_is_complete = dynamic_bit_sequence.density();
     }
 
@@ -122,7 +132,9 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
     uint64_t time_deletion = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
 
     uint64_t count1 = dynamic_bit_sequence.count_c(true);
+    uint64_t count0 = dynamic_bit_sequence.size() - count1;
     std::uniform_int_distribution<uint64_t> get_rand_bits(0, count1 - 1);
+    std::uniform_int_distribution<uint64_t> get_rand_zero_bits(0, count0 - 1);
 
     std::cout << "Checksum: " << hash << std::endl;
     checksum_vector.push_back(hash);
@@ -148,7 +160,7 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
     st2 = std::chrono::system_clock::now();
     uint64_t time_access = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
 
-    if constexpr (std::is_same<T, stool::bptree::SimpleDynamicBitSequence>::value)
+    if constexpr (IS_BPTREE_BIT_SEQUENCE<T>)
     {
         dynamic_bit_sequence.print_debug_info();
     }
@@ -174,7 +186,7 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
         for (uint64_t i = 0; i < query_num; i++)
         {
             uint64_t m = get_rand_item_num(mt64);
-            if constexpr (std::is_same<T, stool::bptree::SimpleDynamicBitSequence>::value)
+            if constexpr (IS_BPTREE_BIT_SEQUENCE<T>)
             {
                 uint64_t value = dynamic_bit_sequence.one_based_rank1(m);
                 hash += value;
@@ -207,6 +219,84 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
     st2 = std::chrono::system_clock::now();
     uint64_t time_search = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
 
+    std::cout << "Checksum: " << hash << std::endl;
+    checksum_vector.push_back(hash);
+
+    st1 = std::chrono::system_clock::now();
+    if (test_type == "all" || test_type == "select0")
+    {
+        std::cout << "select0..." << std::endl;
+        for (uint64_t i = 0; i < query_num; i++)
+        {
+            uint64_t m = get_rand_zero_bits(mt64);
+            uint64_t value = dynamic_bit_sequence.select0(m);
+            hash += value;
+        }
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_search0 = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    uint64_t time_loop_rank = 0;
+    uint64_t time_batch_rank = 0;
+    uint64_t time_loop_select = 0;
+    uint64_t time_batch_select = 0;
+    if constexpr (IS_BPTREE_BIT_SEQUENCE<T>)
+    {
+        if (test_type == "all" || test_type == "batch")
+        {
+            std::cout << "batched rank1/select1..." << std::endl;
+            std::vector<uint64_t> rank_queries;
+            std::vector<uint64_t> select_queries;
+            for (uint64_t i = 0; i < query_num; i++)
+            {
+                rank_queries.push_back(get_rand_item_num(mt64));
+                select_queries.push_back(get_rand_bits(mt64));
+            }
+            std::sort(rank_queries.begin(), rank_queries.end());
+            std::sort(select_queries.begin(), select_queries.end());
+
+            uint64_t loop_hash = 0;
+            uint64_t batch_hash = 0;
+
+            st1 = std::chrono::system_clock::now();
+            for (uint64_t m : rank_queries)
+            {
+                loop_hash += dynamic_bit_sequence.rank1(m);
+            }
+            st2 = std::chrono::system_clock::now();
+            time_loop_rank = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+            st1 = std::chrono::system_clock::now();
+            for (uint64_t value : dynamic_bit_sequence.rank1_many(rank_queries))
+            {
+                batch_hash += value;
+            }
+            st2 = std::chrono::system_clock::now();
+            time_batch_rank = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+            st1 = std::chrono::system_clock::now();
+            for (uint64_t m : select_queries)
+            {
+                loop_hash += dynamic_bit_sequence.select1(m);
+            }
+            st2 = std::chrono::system_clock::now();
+            time_loop_select = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+            st1 = std::chrono::system_clock::now();
+            for (int64_t value : dynamic_bit_sequence.select1_many(select_queries))
+            {
+                batch_hash += value;
+            }
+            st2 = std::chrono::system_clock::now();
+            time_batch_select = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+            if (loop_hash != batch_hash)
+            {
+                throw std::runtime_error("The batched queries returned different results.");
+            }
+        }
+    }
+
     std::cout << "\033[36m";
     std::cout << "=============RESULT===============" << std::endl;
     std::cout << "Test: " << name << std::endl;
@@ -216,11 +306,19 @@ void dynamic_bit_operation_test(T &dynamic_bit_sequence, std::string name, std::
     std::cout << "Access Time         : " << (time_access / (1000 * 1000)) << "[ms] (Avg: " << (time_access / query_num) << "[ns])" << std::endl;
     std::cout << "Rank Time           : " << (time_psum / (1000 * 1000)) << "[ms] (Avg: " << (time_psum / query_num) << "[ns])" << std::endl;
     std::cout << "Select Time         : " << (time_search / (1000 * 1000)) << "[ms] (Avg: " << (time_search / query_num) << "[ns])" << std::endl;
+    std::cout << "Select0 Time        : " << (time_search0 / (1000 * 1000)) << "[ms] (Avg: " << (time_search0 / query_num) << "[ns])" << std::endl;
     std::cout << "Insertion Time      : " << (time_insertion / (1000 * 1000)) << "[ms] (Avg: " << (time_insertion / query_num) << "[ns])" << std::endl;
     std::cout << "Deletion Time       : " << (time_deletion / (1000 * 1000)) << "[ms] (Avg: " << (time_deletion / query_num) << "[ns])" << std::endl;
+    if (time_batch_rank > 0)
+    {
+        std::cout << "Sorted Rank Time (one by one) : " << (time_loop_rank / (1000 * 1000)) << "[ms] (Avg: " << (time_loop_rank / query_num) << "[ns])" << std::endl;
+        std::cout << "Sorted Rank Time (rank1_many) : " << (time_batch_rank / (1000 * 1000)) << "[ms] (Avg: " << (time_batch_rank / query_num) << "[ns])" << std::endl;
+        std::cout << "Sorted Select Time (one by one)   : " << (time_loop_select / (1000 * 1000)) << "[ms] (Avg: " << (time_loop_select / query_num) << "[ns])" << std::endl;
+        std::cout << "Sorted Select Time (select1_many) : " << (time_batch_select / (1000 * 1000)) << "[ms] (Avg: " << (time_batch_select / query_num) << "[ns])" << std::endl;
+    }
 
     
-    if constexpr (std::is_same<T, stool::bptree::SimpleDynamicBitSequence>::value) {
+    if constexpr (IS_BPTREE_BIT_SEQUENCE<T>) {
         std::cout << "Tree Height: " << dynamic_bit_sequence.height() << std::endl;
         std::cout << "Density of the B-tree when the build is complete: " << density_when_build_is_complete << std::endl;
         //dynamic_bit_sequence.print_information_about_performance();
@@ -277,6 +375,11 @@ int main(int argc, char *argv[])
         stool::bptree::SimpleDynamicBitSequence dbs;
         dynamic_bit_operation_test(dbs, "stool::bptree::SimpleDynamicBitSequence", query_type, item_num, query_num, seed);
     }
+    else if (index_name == "BTreePlusAlpha_NaiveLeaf")
+    {
+        NaiveLeafDynamicBitSequence dbs;
+        dynamic_bit_operation_test(dbs, "SimpleDynamicBitSequence with NaiveBitVectorContainer leaves", query_type, item_num, query_num, seed);
+    }
     else if (index_name == "DYNAMIC")
     {
         DynSucBVWrapper dbs;
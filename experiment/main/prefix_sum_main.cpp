@@ -4,6 +4,8 @@
 #include <bitset>
 #include <cassert>
 #include <chrono>
+#include <thread>
+#include <atomic>
 #include "stool/include/all.hpp"
 #include "../../include/all.hpp"
 // #include "../../test/permutation_test.hpp"
@@ -190,6 +192,92 @@ void bptree_prefix_sum_test(T &dynamic_prefix_sum, std::string name, std::string
     std::cout << "\033[39m" << std::endl;
 }
 
+/**
+ * @brief Measure ShardedDynamicPrefixSum when each writer thread increments its own disjoint range while reader threads run psum and search concurrently.
+ */
+void sharded_prefix_sum_concurrent_test(uint64_t shard_count, uint64_t writer_num, uint64_t reader_num, uint64_t item_num, uint64_t max_value, uint64_t query_num, uint64_t seed)
+{
+    using T = stool::bptree::ShardedDynamicPrefixSum<>;
+    std::mt19937_64 mt64(seed);
+    std::uniform_int_distribution<uint64_t> get_rand_value(0, max_value);
+
+    std::vector<uint64_t> items;
+    for (uint64_t i = 0; i < item_num; i++)
+    {
+        items.push_back(get_rand_value(mt64));
+    }
+
+    std::cout << "Construction..." << std::flush;
+    std::chrono::system_clock::time_point st1 = std::chrono::system_clock::now();
+    T dps(items, shard_count);
+    std::chrono::system_clock::time_point st2 = std::chrono::system_clock::now();
+    uint64_t time_construction = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+    std::cout << "[done]" << std::endl;
+
+    uint64_t initial_sum = dps.psum();
+    std::atomic<bool> writers_done{false};
+    std::atomic<uint64_t> read_count{0};
+    std::atomic<uint64_t> read_hash{0};
+    uint64_t region = item_num / writer_num;
+
+    std::cout << "Concurrent increments and queries..." << std::flush;
+    st1 = std::chrono::system_clock::now();
+    std::vector<std::thread> readers;
+    for (uint64_t t = 0; t < reader_num; t++)
+    {
+        readers.emplace_back([&, t]()
+                             {
+            std::mt19937_64 local_mt64(seed + writer_num + t);
+            uint64_t local_count = 0;
+            uint64_t local_hash = 0;
+            while (!writers_done.load(std::memory_order_relaxed))
+            {
+                local_hash += dps.psum(local_mt64() % item_num);
+                local_hash += dps.search((local_mt64() % std::max<uint64_t>(initial_sum, 1)) + 1);
+                local_count += 2;
+            }
+            read_count.fetch_add(local_count);
+            read_hash.fetch_add(local_hash); });
+    }
+    std::vector<std::thread> writers;
+    for (uint64_t t = 0; t < writer_num; t++)
+    {
+        writers.emplace_back([&, t]()
+                             {
+            std::mt19937_64 local_mt64(seed + t);
+            for (uint64_t x = 0; x < query_num; x++)
+            {
+                dps.increment(t * region + (local_mt64() % region), 1);
+            } });
+    }
+    for (std::thread &th : writers)
+    {
+        th.join();
+    }
+    st2 = std::chrono::system_clock::now();
+    writers_done.store(true);
+    for (std::thread &th : readers)
+    {
+        th.join();
+    }
+    uint64_t time_update = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+    std::cout << "[done]" << std::endl;
+
+    uint64_t update_num = writer_num * query_num;
+    std::cout << "\033[36m";
+    std::cout << "=============RESULT===============" << std::endl;
+    std::cout << "Test: " << T::name() << std::endl;
+    std::cout << "item_num = " << item_num << ", max_value = " << max_value << ", query_num = " << query_num << ", seed = " << seed << std::endl;
+    std::cout << "shard_count = " << shard_count << ", writer_num = " << writer_num << ", reader_num = " << reader_num << std::endl;
+    std::cout << "Checksum            : " << (dps.psum() + read_hash.load()) << std::endl;
+    std::cout << "Construction Time   : " << (time_construction / (1000 * 1000)) << "[ms] (Avg: " << (time_construction / item_num) << "[ns])" << std::endl;
+    std::cout << "Update Time         : " << (time_update / (1000 * 1000)) << "[ms] (Avg: " << (time_update / update_num) << "[ns] per increment, " << (update_num * 1000 / std::max<uint64_t>(time_update, 1)) << " increments/us)" << std::endl;
+    std::cout << "Concurrent queries  : " << read_count.load() << " (" << (read_count.load() * 1000 / std::max<uint64_t>(time_update, 1)) << " queries/us)" << std::endl;
+    stool::Memory::print_memory_usage();
+    std::cout << "==================================" << std::endl;
+    std::cout << "\033[39m" << std::endl;
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef DEBUG
@@ -215,6 +303,9 @@ int main(int argc, char *argv[])
     p.add<uint64_t>("max_value", 'v', "max_value", false, 100);
     p.add<uint64_t>("query_num", 'q', "query_num", false, 1000000);
     p.add<uint64_t>("seed", 's', "seed", false, 0);
+    p.add<uint64_t>("shard_count", 'k', "the number of shards (Sharded only)", false, 64);
+    p.add<uint64_t>("writer_num", 'w', "the number of writer threads (Sharded only)", false, 4);
+    p.add<uint64_t>("reader_num", 'r', "the number of reader threads (Sharded only)", false, 2);
 
     p.parse_check(argc, argv);
     std::string index_name = p.get<std::string>("index_name");
@@ -223,6 +314,9 @@ int main(int argc, char *argv[])
     uint64_t max_value = p.get<uint64_t>("max_value");
     uint64_t query_num = p.get<uint64_t>("query_num");
     uint64_t seed = p.get<uint64_t>("seed");
+    uint64_t shard_count = p.get<uint64_t>("shard_count");
+    uint64_t writer_num = p.get<uint64_t>("writer_num");
+    uint64_t reader_num = p.get<uint64_t>("reader_num");
 
     if (index_name == "BTreePlusAlpha")
     {
@@ -239,4 +333,8 @@ int main(int argc, char *argv[])
         DynPackedSPSIWrapper dps;
         bptree_prefix_sum_test(dps, "DynPackedSPSIWrapper", query_type, item_num, max_value, query_num, seed);
     }
+    else if (index_name == "Sharded")
+    {
+        sharded_prefix_sum_concurrent_test(shard_count, writer_num, reader_num, item_num, max_value, query_num, seed);
+    }
 }
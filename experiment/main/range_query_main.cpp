@@ -0,0 +1,196 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <bitset>
+#include <cassert>
+#include <chrono>
+#include "stool/include/all.hpp"
+#include "../../include/all.hpp"
+
+std::vector<uint8_t> load_text(std::string filename, uint64_t item_num)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs)
+    {
+        throw std::runtime_error("Error: cannot open " + filename);
+    }
+    std::vector<uint8_t> text;
+    char c;
+    while (text.size() < item_num && ifs.get(c))
+    {
+        text.push_back((uint8_t)c);
+    }
+    return text;
+}
+
+// Characters are drawn from a Zipf-like distribution, which is closer to natural-language text than the uniform distribution.
+std::vector<uint8_t> create_skewed_text(uint64_t item_num, uint64_t alphabet_size, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    std::vector<double> weights;
+    for (uint64_t c = 0; c < alphabet_size; c++)
+    {
+        weights.push_back(1.0 / (double)(c + 1));
+    }
+    std::discrete_distribution<uint64_t> get_rand_char(weights.begin(), weights.end());
+    std::vector<uint8_t> text;
+    for (uint64_t i = 0; i < item_num; i++)
+    {
+        text.push_back(get_rand_char(mt64));
+    }
+    return text;
+}
+
+template <typename QUANTILE, typename TOPK, typename FREQ>
+void range_query_test(std::string name, const std::vector<std::pair<uint64_t, uint64_t>> &ranges, uint64_t top_k, QUANTILE quantile_func, TOPK top_k_func, FREQ freq_func)
+{
+    std::cout << "Test: " << name << std::endl;
+    uint64_t hash = 0;
+    std::chrono::system_clock::time_point st1, st2;
+
+    st1 = std::chrono::system_clock::now();
+    for (auto [i, j] : ranges)
+    {
+        hash += quantile_func(i, j, (j - i) / 2);
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_quantile = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    st1 = std::chrono::system_clock::now();
+    for (auto [i, j] : ranges)
+    {
+        for (auto [c, freq] : top_k_func(i, j, top_k))
+        {
+            hash += c * freq;
+        }
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_top_k = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    st1 = std::chrono::system_clock::now();
+    for (auto [i, j] : ranges)
+    {
+        hash += freq_func(i, j, (uint8_t)(i % 64), (uint8_t)(j % 64 + 64));
+    }
+    st2 = std::chrono::system_clock::now();
+    uint64_t time_freq = std::chrono::duration_cast<std::chrono::nanoseconds>(st2 - st1).count();
+
+    uint64_t query_num = ranges.size();
+    std::cout << "\033[36m";
+    std::cout << "=============RESULT===============" << std::endl;
+    std::cout << "Test: " << name << std::endl;
+    std::cout << "query_num = " << query_num << ", top_k = " << top_k << std::endl;
+    std::cout << "Checksum             : " << hash << std::endl;
+    std::cout << "Range Quantile Time  : " << (time_quantile / (1000 * 1000)) << "[ms] (Avg: " << (time_quantile / query_num) << "[ns])" << std::endl;
+    std::cout << "Range Top-k Time     : " << (time_top_k / (1000 * 1000)) << "[ms] (Avg: " << (time_top_k / query_num) << "[ns])" << std::endl;
+    std::cout << "Range Frequency Time : " << (time_freq / (1000 * 1000)) << "[ms] (Avg: " << (time_freq / query_num) << "[ns])" << std::endl;
+    std::cout << "==================================" << std::endl;
+    std::cout << "\033[39m" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef DEBUG
+    std::cout << "\033[41m";
+    std::cout << "DEBUG MODE!" << std::endl;
+    std::cout << "\e[m" << std::endl;
+#endif
+
+    cmdline::parser p;
+
+    p.add<std::string>("index_name", 'x', "index_name (BTreePlusAlpha or Scan)", true);
+    p.add<std::string>("input_file", 'i', "input file name (a Zipf-like random text is used if empty)", false, "");
+    p.add<uint64_t>("item_num", 'n', "item_num", false, 1000000);
+    p.add<uint64_t>("query_num", 'q', "query_num", false, 1000);
+    p.add<uint64_t>("range_length", 'l', "range_length", false, 100000);
+    p.add<uint64_t>("top_k", 'k', "top_k", false, 10);
+    p.add<uint64_t>("alphabet_size", 'a', "alphabet_size", false, 64);
+    p.add<uint64_t>("seed", 's', "seed", false, 0);
+
+    p.parse_check(argc, argv);
+    std::string index_name = p.get<std::string>("index_name");
+    std::string input_file = p.get<std::string>("input_file");
+    uint64_t item_num = p.get<uint64_t>("item_num");
+    uint64_t query_num = p.get<uint64_t>("query_num");
+    uint64_t range_length = p.get<uint64_t>("range_length");
+    uint64_t top_k = p.get<uint64_t>("top_k");
+    uint64_t alphabet_size = p.get<uint64_t>("alphabet_size");
+    uint64_t seed = p.get<uint64_t>("seed");
+
+    std::vector<uint8_t> text = input_file.size() > 0 ? load_text(input_file, item_num) : create_skewed_text(item_num, alphabet_size, seed);
+    if (text.size() == 0)
+    {
+        throw std::runtime_error("Error: the text is empty");
+    }
+    range_length = std::min<uint64_t>(range_length, text.size());
+
+    std::mt19937_64 mt64(seed);
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (uint64_t x = 0; x < query_num; x++)
+    {
+        uint64_t i = mt64() % (text.size() - range_length + 1);
+        ranges.push_back(std::pair<uint64_t, uint64_t>(i, i + range_length));
+    }
+
+    std::vector<uint8_t> alphabet = text;
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+    stool::bptree::DynamicWaveletTree dwt = stool::bptree::DynamicWaveletTree::build(text, alphabet);
+
+    if (index_name == "BTreePlusAlpha")
+    {
+        range_query_test(
+            "stool::bptree::DynamicWaveletTree", ranges, top_k,
+            [&](uint64_t i, uint64_t j, uint64_t k)
+            { return dwt.range_quantile(i, j, k); },
+            [&](uint64_t i, uint64_t j, uint64_t k)
+            { return dwt.range_top_k(i, j, k); },
+            [&](uint64_t i, uint64_t j, uint8_t a, uint8_t b)
+            { return dwt.range_frequency(i, j, a, b); });
+    }
+    else if (index_name == "Scan")
+    {
+        // The baseline exports T[i..j-1] and scans it, as done before the range queries were supported.
+        range_query_test(
+            "to_u8_vector + scan", ranges, top_k,
+            [&](uint64_t i, uint64_t j, uint64_t k)
+            {
+                std::vector<uint8_t> tmp = dwt.to_u8_vector();
+                std::nth_element(tmp.begin() + i, tmp.begin() + i + k, tmp.begin() + j);
+                return tmp[i + k];
+            },
+            [&](uint64_t i, uint64_t j, uint64_t k)
+            {
+                std::vector<uint8_t> tmp = dwt.to_u8_vector();
+                std::vector<std::pair<uint8_t, uint64_t>> r;
+                std::vector<uint64_t> counters(256, 0);
+                for (uint64_t x = i; x < j; x++)
+                {
+                    counters[tmp[x]]++;
+                }
+                for (uint64_t c = 0; c < 256; c++)
+                {
+                    if (counters[c] > 0)
+                    {
+                        r.push_back(std::pair<uint8_t, uint64_t>(c, counters[c]));
+                    }
+                }
+                std::stable_sort(r.begin(), r.end(), [](const auto &x, const auto &y)
+                                 { return x.second > y.second; });
+                r.resize(std::min<uint64_t>(k, r.size()));
+                return r;
+            },
+            [&](uint64_t i, uint64_t j, uint8_t a, uint8_t b)
+            {
+                std::vector<uint8_t> tmp = dwt.to_u8_vector();
+                uint64_t count = 0;
+                for (uint64_t x = i; x < j; x++)
+                {
+                    count += (a <= tmp[x] && tmp[x] <= b) ? 1 : 0;
+                }
+                return count;
+            });
+    }
+    stool::Memory::print_memory_usage();
+}
@@ -32,8 +32,13 @@
 #include "./dynamic_permutation.hpp"
 #include "./permutation/dynamic_permutation_builder.hpp"
 #include "./dynamic_prefix_sum.hpp"
+#include "./dynamic_multi_prefix_sum.hpp"
+#include "./sharded_dynamic_prefix_sum.hpp"
 #include "./dynamic_bit_sequence.hpp"
 #include "./dynamic_wavelet_tree.hpp"
+#include "./dynamic_wavelet_matrix.hpp"
+#include "./dynamic_huffman_wavelet_tree.hpp"
+#include "./dynamic_fm_index.hpp"
 #include "./dynamic_sequence64.hpp"
 #include "./range_search/dynamic_wavelet_matrix_for_range_search.hpp"
 // #include "./range_search/dynamic_wavelet_tree_on_grid.hpp"
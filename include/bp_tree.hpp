@@ -1,8 +1,11 @@
 #pragma once
+#include <type_traits>
 #include "./bp_tree/bp_internal_node_functions.hpp"
 #include "./bp_tree/bp_postorder_iterator.hpp"
 #include "./bp_tree/bp_value_forward_iterator.hpp"
 #include "./bp_tree/bp_leaf_forward_iterator.hpp"
+#include "./bp_tree/integer_stream_iterator.hpp"
+#include "./sequence/packed_bit_functions.hpp"
 
 namespace stool
 {
@@ -14,12 +17,26 @@ namespace stool
         inline static uint64_t time_count2 = 0;
         inline static uint64_t time_count = 0;
 
+        /**
+         * @brief True if \p LEAF_CONTAINER provides balance_weight(), i.e., BPTree bounds its leaves by the weight instead of the number of values
+         * @details Such a LEAF CONTAINER also provides balance_split_position(), balance_capacity(max_weight), and the static function balance_weight_of_concatenation(left, right) (see RunLengthBitContainer).
+         */
+        template <typename LEAF_CONTAINER, typename = void>
+        struct HasBalanceWeight : std::false_type
+        {
+        };
+        template <typename LEAF_CONTAINER>
+        struct HasBalanceWeight<LEAF_CONTAINER, std::void_t<decltype(std::declval<const LEAF_CONTAINER &>().balance_weight())>> : std::true_type
+        {
+        };
+
         /**
          * @brief An implementation of a B+-tree for storing \p n values \p S[0..n-1] of type \p VALUE in leaves
          * @details The details of this B+-tree is as follows:
          * @li This B+-tree consists of \p x internal nodes and \p y leaves.
          * @li Every internal node has at most \p MAX_DEGREE children. The number of the children is at least \p MAX_DEGREE / 2 if \p n is sufficiently large.
          * @li Every leaf is an \p LEAF_CONTAINER instance that stores at most \p LEAF_CONTAINER_MAX_SIZE values. The number of these values is at least \p LEAF_CONTAINER_MAX_SIZE / 2 if \p n is sufficiently large.
+         *     If \p LEAF_CONTAINER provides balance_weight() (see HasBalanceWeight), the weight of every leaf is at most \p LEAF_CONTAINER_MAX_SIZE instead, and a leaf lighter than \p LEAF_CONTAINER_MAX_SIZE / 2 is merged into a sibling only if the merged leaf is not too heavy.
          * @li \p y LEAF_CONTAINER instances are stored in a vector \p W[0..z-1], where z = Ω(y)
          * @li Each value \p S[i] can have a weight w(i). If \p USE_PSUM is true, the prefix sum of the weights of \p S[0..i-1] can be computed in O(\log n) time.
          * \ingroup BPTreeClasses
@@ -36,6 +53,11 @@ namespace stool
 
             using BPFunctions = BPInternalNodeFunctions<LEAF_CONTAINER, VALUE, USE_PARENT_FIELD, MAX_DEGREE, USE_PSUM>;
 
+            /**
+             * @brief True if the leaves are balanced by the balance_weight() of \p LEAF_CONTAINER instead of the number of values
+             */
+            static inline constexpr bool USE_LEAF_WEIGHT = HasBalanceWeight<LEAF_CONTAINER>::value;
+
         private:
             std::vector<LEAF_CONTAINER> leaf_container_vec;
             std::vector<Node *> parent_vec;
@@ -426,6 +448,30 @@ namespace stool
                 }
             }
 
+            /**
+             * @brief Write the bits \p S[i..i+len-1] to \p output[0..len-1] packed in 64-bit words (see PackedBitFunctions).
+             * @note This function is available only if the LEAF CONTAINER supports extract_words (e.g., BitVectorContainer).
+             * @note O(len / 64 + \log n) time
+             */
+            void extract_words(uint64_t i, uint64_t len, uint64_t *output) const
+            {
+                if (i + len > this->size())
+                {
+                    throw std::invalid_argument("Error: BPTree::extract_words(i, len, output). The range is out of the sequence.");
+                }
+                if (len > 0)
+                {
+                    if (this->root_is_leaf_)
+                    {
+                        this->leaf_container_vec[(uint64_t)this->root].extract_words(i, len, output, 0);
+                    }
+                    else
+                    {
+                        BPFunctions::extract_words(*this->root, i, len, 0, this->leaf_container_vec, output);
+                    }
+                }
+            }
+
             //@}
 
             ////////////////////////////////////////////////////////////////////////////////
@@ -577,6 +623,10 @@ namespace stool
                     {
                         return this->leaf_container_vec[(uint64_t)this->root].search(u);
                     }
+                    else if (u > this->psum())
+                    {
+                        return -1;
+                    }
                     else
                     {
                         return BPFunctions::search(*this->root, u, this->leaf_container_vec);
@@ -601,6 +651,10 @@ namespace stool
                     {
                         return this->leaf_container_vec[(uint64_t)this->root].select0(i);
                     }
+                    else if (i >= this->size() - this->psum())
+                    {
+                        return -1;
+                    }
                     else
                     {
                         return BPFunctions::select0(*this->root, i, this->leaf_container_vec);
@@ -612,6 +666,150 @@ namespace stool
                 }
             }
 
+            /**
+             * @brief Return the sum of the weights of \p S[i..j].
+             * @details Unlike psum(j) - psum(i-1), the two positions share one descent, and only one root-to-leaf path is traversed if they are in the same leaf.
+             * @note O(\log n) time
+             */
+            uint64_t psum(uint64_t i, uint64_t j) const
+            {
+                if (i > j || j >= this->size())
+                {
+                    throw std::invalid_argument("Error: BPTree::psum(i, j). The i and j must satisfy i <= j < size.");
+                }
+                if (this->root_is_leaf_)
+                {
+                    const LEAF_CONTAINER &leaf = this->leaf_container_vec[(uint64_t)this->root];
+                    return leaf.psum(j) - (i > 0 ? leaf.psum(i - 1) : 0);
+                }
+                else
+                {
+                    return BPFunctions::psum(*this->root, i, j, this->leaf_container_vec);
+                }
+            }
+
+            /**
+             * @brief Returns the smallest position q >= \p i such that \p S[q] = \p b if it exists, otherwise return -1.
+             * @note The result of this function is undefined if S is not a bit sequence.
+             * @note O(\log n) time
+             */
+            int64_t next_bit(uint64_t i, bool b) const
+            {
+                if (i >= this->size())
+                {
+                    return -1;
+                }
+                else if (this->root_is_leaf_)
+                {
+                    return BPFunctions::next_bit_on_leaf(this->leaf_container_vec[(uint64_t)this->root], i, b);
+                }
+                else
+                {
+                    return BPFunctions::next_bit(*this->root, i, b, this->leaf_container_vec);
+                }
+            }
+
+            /**
+             * @brief Returns the largest position q < \p i such that \p S[q] = \p b if it exists, otherwise return -1.
+             * @note The result of this function is undefined if S is not a bit sequence.
+             * @note O(\log n) time
+             */
+            int64_t prev_bit(uint64_t i, bool b) const
+            {
+                if (i > this->size())
+                {
+                    throw std::invalid_argument("Error: BPTree::prev_bit(i, b). The i must be at most the size of the tree.");
+                }
+                else if (i == 0)
+                {
+                    return -1;
+                }
+                else if (this->root_is_leaf_)
+                {
+                    return BPFunctions::prev_bit_on_leaf(this->leaf_container_vec[(uint64_t)this->root], i, b);
+                }
+                else
+                {
+                    return BPFunctions::prev_bit(*this->root, i, b, this->leaf_container_vec);
+                }
+            }
+
+            /**
+             * @brief Return the vector R such that R[k] = psum(P[k]) for a given sorted sequence of positions \p P.
+             * @details The queries share one traversal of the tree, i.e., each node is visited at most once.
+             * @note O(k + m \log n) time, where k = |P| and m is the number of distinct leaves containing the positions in \p P.
+             *       The positions in a leaf are answered by one scan of the leaf if \p LEAF_CONTAINER supports batched queries (see HasBatchedLeafQueries).
+             */
+            std::vector<uint64_t> psum_many(const std::vector<uint64_t> &sorted_positions_P) const
+            {
+                uint64_t _size = this->size();
+                std::vector<uint64_t> r;
+                r.resize(sorted_positions_P.size(), 0);
+                for (uint64_t k = 0; k < sorted_positions_P.size(); k++)
+                {
+                    if (sorted_positions_P[k] >= _size)
+                    {
+                        throw std::invalid_argument("Error: BPTree::psum_many(P). The positions must be less than the size of the tree.");
+                    }
+                    else if (k > 0 && sorted_positions_P[k - 1] > sorted_positions_P[k])
+                    {
+                        throw std::invalid_argument("Error: BPTree::psum_many(P). The positions must be sorted in ascending order.");
+                    }
+                }
+
+                if (sorted_positions_P.size() > 0)
+                {
+                    if (this->root_is_leaf_)
+                    {
+                        BPFunctions::psum_many_on_leaf(this->leaf_container_vec[(uint64_t)this->root], sorted_positions_P, 0, sorted_positions_P.size(), 0, 0, r);
+                    }
+                    else
+                    {
+                        BPFunctions::psum_many(*this->root, sorted_positions_P, 0, sorted_positions_P.size(), 0, 0, this->leaf_container_vec, r);
+                    }
+                }
+                return r;
+            }
+
+            /**
+             * @brief Return the vector R such that R[k] = search(U[k]) for a given sorted sequence of sums \p U.
+             * @details The queries share one traversal of the tree. R[k] = -1 if no prefix sum reaches U[k].
+             * @note O(k + m \log n) time, where k = |U| and m is the number of distinct leaves containing the answers.
+             *       The sums answered in a leaf are found by one scan of the leaf if \p LEAF_CONTAINER supports batched queries (see HasBatchedLeafQueries).
+             */
+            std::vector<int64_t> search_many(const std::vector<uint64_t> &sorted_sums_U) const
+            {
+                std::vector<int64_t> r;
+                r.resize(sorted_sums_U.size(), -1);
+                for (uint64_t k = 1; k < sorted_sums_U.size(); k++)
+                {
+                    if (sorted_sums_U[k - 1] > sorted_sums_U[k])
+                    {
+                        throw std::invalid_argument("Error: BPTree::search_many(U). The sums must be sorted in ascending order.");
+                    }
+                }
+
+                if (!this->empty())
+                {
+                    uint64_t total_sum = this->psum();
+                    uint64_t end = 0;
+                    while (end < sorted_sums_U.size() && sorted_sums_U[end] <= total_sum)
+                    {
+                        end++;
+                    }
+
+                    if (this->root_is_leaf_)
+                    {
+                        BPFunctions::search_many_on_leaf(this->leaf_container_vec[(uint64_t)this->root], sorted_sums_U, 0, end, 0, 0, r);
+                    }
+                    else if (end > 0)
+                    {
+                        BPFunctions::search_many(*this->root, sorted_sums_U, 0, end, 0, 0, this->leaf_container_vec, r);
+                    }
+                }
+                return r;
+            }
+
             /**
              * @brief Compute the path from the root to the first leaf, and store it in the \p output_path
              * @note O(\log n) time
@@ -1182,6 +1380,45 @@ namespace stool
                 }
             }
 
+            /**
+             * @brief Add the bits \p Q[0..len-1] packed in 64-bit words \p words (see PackedBitFunctions) to the end of the sequence \p S
+             * @details Each leaf receives its bits by one word-level copy using the push_back_words function of the LEAF CONTAINER.
+             * @note This function is available only if the LEAF CONTAINER supports push_back_words (e.g., BitVectorContainer).
+             * @note O(len / 64 + (len / B) \log n) time, where B is the maximal number of values in a leaf
+             */
+            void push_back_words(const uint64_t *words, uint64_t len)
+            {
+                uint64_t i = 0;
+                std::vector<NodePointer> path;
+
+                while (i < len)
+                {
+                    path.clear();
+                    this->get_path_from_root_to_last_leaf(path);
+                    if (path.size() > 0)
+                    {
+                        uint64_t leaf = path[path.size() - 1].get_leaf_container_index();
+                        uint64_t x = std::min(len - i, this->get_insertable_count_in_leaf(leaf));
+
+                        this->leaf_container_vec[leaf].push_back_words(words, i, x);
+                        uint64_t sum = this->leaf_container_vec[leaf].reverse_psum(x - 1);
+                        for (int64_t j = path.size() - 2; j >= 0; --j)
+                        {
+                            Node *parent = path[j].get_node();
+                            uint64_t parent_edge_index = path[j + 1].get_parent_edge_index();
+                            parent->increment(parent_edge_index, x, sum);
+                        }
+                        this->balance_for_insertion(path, true);
+                        i += x;
+                    }
+                    else
+                    {
+                        this->create_root_leaf(PackedBitFunctions::get_bit(words, i));
+                        i++;
+                    }
+                }
+            }
+
             /**
              * @brief Push a given value to the beginning of the sequence \p S
              * @note O(\log n) time
@@ -1325,6 +1562,56 @@ namespace stool
                 this->insert_operation_counter++;
             }
 
+            /**
+             * @brief Insert the bits \p Q[0..len-1] packed in 64-bit words \p words (see PackedBitFunctions) at position \p i in the sequence \p S
+             * @details Each touched leaf receives its bits by one word-level copy using the insert_words function of the LEAF CONTAINER.
+             * @note This function is available only if the LEAF CONTAINER supports insert_words (e.g., BitVectorContainer).
+             * @note O(len / 64 + (len / B + 1) (B / 64 + \log n)) time, where B is the maximal number of values in a leaf
+             */
+            void insert_words(uint64_t i, const uint64_t *words, uint64_t len)
+            {
+                uint64_t _size = this->size();
+                if (i > _size)
+                {
+                    throw std::invalid_argument("Error: BPTree::insert_words(i, words, len). The position i must be at most the size of the tree.");
+                }
+                else if (i == _size)
+                {
+                    this->push_back_words(words, len);
+                }
+                else
+                {
+                    uint64_t k = 0;
+                    while (k < len)
+                    {
+                        int64_t position_to_insert = this->compute_path_from_root_to_leaf(i + k);
+                        if (position_to_insert == -1)
+                        {
+                            throw std::runtime_error("Error: insert_words");
+                        }
+                        uint64_t leaf = this->tmp_path[this->tmp_path.size() - 1].get_leaf_container_index();
+                        uint64_t x = std::min(len - k, this->get_insertable_count_in_leaf(leaf));
+
+                        this->leaf_container_vec[leaf].insert_words(position_to_insert, words, k, x);
+                        uint64_t sum = this->leaf_container_vec[leaf].psum(position_to_insert + x - 1);
+                        if (position_to_insert > 0)
+                        {
+                            sum -= this->leaf_container_vec[leaf].psum(position_to_insert - 1);
+                        }
+
+                        for (int64_t j = this->tmp_path.size() - 2; j >= 0; j--)
+                        {
+                            Node *node = this->tmp_path[j].get_node();
+                            uint64_t child_index = this->tmp_path[j + 1].get_parent_edge_index();
+                            node->increment(child_index, x, sum);
+                        }
+                        this->split_process_counter += this->balance_for_insertion(this->tmp_path);
+                        k += x;
+                    }
+                    this->insert_operation_counter++;
+                }
+            }
+
             /**
              * @brief Update \p S[i] and its weight using a given value \p delta and the increment function supported by the LEAF CONTAINER
              * @note O(\log n) time
@@ -1341,6 +1628,51 @@ namespace stool
                     Node *parent = this->tmp_path[i].get_node();
                     parent->increment(idx, 0, delta);
                 }
+                if constexpr (USE_LEAF_WEIGHT)
+                {
+                    // Changing a value can make the leaf heavier (e.g., it splits a run of RunLengthBitContainer).
+                    this->split_process_counter += this->balance_for_insertion(this->tmp_path);
+                }
+            }
+
+            /**
+             * @brief Replace \p S[i..i+|Q|-1] with a given sequence \p Q[0..|Q|-1] using the increment function supported by the LEAF CONTAINER
+             * @details The covered leaves are visited once from left to right, and each covered edge of an internal node is updated with one aggregated delta.
+             * @note O(\log n + |Q|) node visits
+             */
+            void set_values(uint64_t i, const std::vector<VALUE> &values_Q)
+            {
+                if (values_Q.size() == 0)
+                {
+                    return;
+                }
+                if (i + values_Q.size() > this->size())
+                {
+                    throw std::invalid_argument("Error: BPTree::set_values(i, Q). The range [i, i+|Q|-1] must be in the sequence.");
+                }
+                if constexpr (USE_LEAF_WEIGHT)
+                {
+                    // Each update may change the weight of its leaf, so the values are updated one by one with rebalancing.
+                    for (uint64_t k = 0; k < values_Q.size(); k++)
+                    {
+                        int64_t delta = (int64_t)values_Q[k] - (int64_t)this->at(i + k);
+                        if (delta != 0)
+                        {
+                            this->increment(i + k, delta);
+                        }
+                    }
+                    return;
+                }
+                uint64_t q_pos = 0;
+                if (this->root_is_leaf_)
+                {
+                    this->set_values_on_leaf((uint64_t)this->root, i, values_Q, q_pos);
+                }
+                else
+                {
+                    this->set_values_on_node(this->root, i, values_Q, q_pos);
+                }
+                assert(q_pos == values_Q.size());
             }
             /**
              * @brief Change the size of the sequence \p S to a given integer \p _size. If we need push a new value to \p S, then the value is initialized with \p default_value.
@@ -1362,7 +1694,7 @@ namespace stool
                         {
                             uint64_t leaf = path[path.size() - 1].get_leaf_container_index();
                             uint64_t len = 0;
-                            while (i < diff && leaf_container_vec[leaf].size() <= this->get_max_count_of_values_in_leaf())
+                            while (i < diff && this->has_room_in_leaf(leaf))
                             {
                                 this->leaf_container_vec[leaf].push_back(default_value);
                                 i++;
@@ -1504,6 +1836,68 @@ namespace stool
                 }
             }
 
+            /**
+             * @brief Builds the B+ tree so that \p S is the sequence of values in [\p begin, \p end)
+             * @details The values are consumed in a single pass. Leaf containers are filled one at a time,
+             *          and each layer of internal nodes keeps fewer than 2 * MAX_DEGREE pending children,
+             *          so the extra memory is O(LEAF_CONTAINER_MAX_SIZE + MAX_DEGREE * height) besides the tree itself.
+             * @note O(n) time
+             */
+            template <typename InputIterator>
+            void build(InputIterator begin, InputIterator end)
+            {
+                this->clear();
+                std::vector<VALUE> buffer;
+                std::vector<std::vector<Node *>> pending_layers;
+                if constexpr (USE_LEAF_WEIGHT)
+                {
+                    uint64_t leaf_index = UINT64_MAX;
+                    for (InputIterator it = begin; it != end; ++it)
+                    {
+                        uint64_t next_leaf_index = this->build_push_by_weight(leaf_index, *it);
+                        if (next_leaf_index != leaf_index && leaf_index != UINT64_MAX)
+                        {
+                            this->streaming_build_push_child(pending_layers, 0, (Node *)leaf_index);
+                        }
+                        leaf_index = next_leaf_index;
+                    }
+                    if (leaf_index != UINT64_MAX)
+                    {
+                        this->streaming_build_push_child(pending_layers, 0, (Node *)leaf_index);
+                    }
+                    this->streaming_build_finish(pending_layers);
+                    return;
+                }
+                buffer.reserve(LEAF_CONTAINER_MAX_SIZE * 2);
+
+                for (InputIterator it = begin; it != end; ++it)
+                {
+                    buffer.push_back(*it);
+                    if (buffer.size() == LEAF_CONTAINER_MAX_SIZE * 2)
+                    {
+                        uint64_t leaf_index = this->streaming_build_create_leaf(buffer, 0, LEAF_CONTAINER_MAX_SIZE);
+                        buffer.erase(buffer.begin(), buffer.begin() + LEAF_CONTAINER_MAX_SIZE);
+                        this->streaming_build_push_child(pending_layers, 0, (Node *)leaf_index);
+                    }
+                }
+
+                if (buffer.size() > LEAF_CONTAINER_MAX_SIZE)
+                {
+                    uint64_t half = buffer.size() / 2;
+                    uint64_t left_leaf = this->streaming_build_create_leaf(buffer, 0, half);
+                    this->streaming_build_push_child(pending_layers, 0, (Node *)left_leaf);
+                    uint64_t right_leaf = this->streaming_build_create_leaf(buffer, half, buffer.size());
+                    this->streaming_build_push_child(pending_layers, 0, (Node *)right_leaf);
+                }
+                else if (buffer.size() > 0)
+                {
+                    uint64_t leaf_index = this->streaming_build_create_leaf(buffer, 0, buffer.size());
+                    this->streaming_build_push_child(pending_layers, 0, (Node *)leaf_index);
+                }
+
+                this->streaming_build_finish(pending_layers);
+            }
+
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Load, save, and builder functions
             ////////////////////////////////////////////////////////////////////////////////
@@ -1598,6 +1992,212 @@ namespace stool
             ///   @name Private functions
             ////////////////////////////////////////////////////////////////////////////////
             //@{
+
+            /**
+             * @brief Create a new leaf storing \p values[begin..end-1] and return its index.
+             */
+            uint64_t streaming_build_create_leaf(const std::vector<VALUE> &values, uint64_t begin, uint64_t end)
+            {
+                uint64_t leaf_index = this->get_new_container_index();
+                for (uint64_t i = begin; i < end; i++)
+                {
+                    this->leaf_container_vec[leaf_index].push_back(values[i]);
+                }
+                return leaf_index;
+            }
+
+            /**
+             * @brief Append \p value to the last leaf \p leaf_index made by a build function, or to a new leaf if the last leaf would become heavier than LEAF_CONTAINER_MAX_SIZE
+             * @return The index of the leaf that has received \p value
+             * @note This function is used only if USE_LEAF_WEIGHT is true. \p leaf_index is UINT64_MAX if no leaf has been made yet.
+             */
+            uint64_t build_push_by_weight(uint64_t leaf_index, VALUE value)
+            {
+                if (leaf_index != UINT64_MAX)
+                {
+                    LEAF_CONTAINER &leaf = this->leaf_container_vec[leaf_index];
+                    leaf.push_back(value);
+                    if (leaf.balance_weight() <= LEAF_CONTAINER_MAX_SIZE)
+                    {
+                        return leaf_index;
+                    }
+                    leaf.pop_back();
+                }
+                uint64_t new_leaf_index = this->get_new_container_index();
+                this->leaf_container_vec[new_leaf_index].push_back(value);
+                return new_leaf_index;
+            }
+
+            /**
+             * @brief Create a new internal node whose children are \p children[begin..end-1] at the given layer.
+             * @details The children of the layer 0 are leaves, and the children of the other layers are internal nodes.
+             */
+            Node *streaming_build_create_node(const std::vector<Node *> &children, uint64_t begin, uint64_t end, uint64_t layer)
+            {
+                Node *node = this->get_new_node_pointer();
+                node->initialize(layer == 0, this->leaf_container_vec);
+                for (uint64_t i = begin; i < end; i++)
+                {
+                    uint64_t count = 0;
+                    uint64_t sum = 0;
+                    if (layer == 0)
+                    {
+                        uint64_t leaf_index = (uint64_t)children[i];
+                        count = this->leaf_container_vec[leaf_index].size();
+                        if constexpr (USE_PSUM)
+                        {
+                            sum = this->leaf_container_vec[leaf_index].psum();
+                        }
+                        if (USE_PARENT_FIELD)
+                        {
+                            this->parent_vec[leaf_index] = node;
+                        }
+                    }
+                    else
+                    {
+                        count = children[i]->psum_on_count_deque();
+                        if constexpr (USE_PSUM)
+                        {
+                            sum = children[i]->psum_on_sum_deque();
+                        }
+                        if (USE_PARENT_FIELD)
+                        {
+                            children[i]->set_parent(node);
+                        }
+                    }
+                    node->append_child(children[i], count, sum);
+                }
+                return node;
+            }
+
+            /**
+             * @brief Add a completed child to the pending children of a given layer.
+             * @details When the layer has 2 * MAX_DEGREE pending children, the first MAX_DEGREE children are moved to a new internal node, which is passed to the next layer.
+             */
+            void streaming_build_push_child(std::vector<std::vector<Node *>> &pending_layers, uint64_t layer, Node *child)
+            {
+                if (pending_layers.size() <= layer)
+                {
+                    pending_layers.resize(layer + 1);
+                }
+                pending_layers[layer].push_back(child);
+                if (pending_layers[layer].size() == MAX_DEGREE * 2)
+                {
+                    Node *node = this->streaming_build_create_node(pending_layers[layer], 0, MAX_DEGREE, layer);
+                    pending_layers[layer].erase(pending_layers[layer].begin(), pending_layers[layer].begin() + MAX_DEGREE);
+                    this->streaming_build_push_child(pending_layers, layer + 1, node);
+                }
+            }
+
+            /**
+             * @brief Close the pending children of all the layers from bottom to top, and set the root.
+             */
+            void streaming_build_finish(std::vector<std::vector<Node *>> &pending_layers)
+            {
+                this->root = nullptr;
+                this->root_is_leaf_ = false;
+                this->height_ = 0;
+
+                uint64_t layer = 0;
+                while (layer < pending_layers.size())
+                {
+                    std::vector<Node *> children;
+                    children.swap(pending_layers[layer]);
+                    bool is_top_layer = layer + 1 == pending_layers.size();
+
+                    if (children.size() == 0)
+                    {
+                        assert(is_top_layer);
+                    }
+                    else if (is_top_layer && children.size() == 1)
+                    {
+                        if (layer == 0)
+                        {
+                            this->root = (Node *)0;
+                            this->root_is_leaf_ = true;
+                            assert((uint64_t)children[0] == 0);
+                        }
+                        else
+                        {
+                            this->root = children[0];
+                        }
+                        this->height_ = layer + 1;
+                    }
+                    else if (children.size() <= MAX_DEGREE)
+                    {
+                        Node *node = this->streaming_build_create_node(children, 0, children.size(), layer);
+                        this->streaming_build_push_child(pending_layers, layer + 1, node);
+                    }
+                    else
+                    {
+                        uint64_t half = children.size() / 2;
+                        Node *left_node = this->streaming_build_create_node(children, 0, half, layer);
+                        this->streaming_build_push_child(pending_layers, layer + 1, left_node);
+                        Node *right_node = this->streaming_build_create_node(children, half, children.size(), layer);
+                        this->streaming_build_push_child(pending_layers, layer + 1, right_node);
+                    }
+                    layer++;
+                }
+            }
+
+            /**
+             * @brief Overwrite the values in the LEAF CONTAINER \p leaf_index from position \p pos with \p Q[q_pos..], and return the total change of the weights.
+             */
+            int64_t set_values_on_leaf(uint64_t leaf_index, uint64_t pos, const std::vector<VALUE> &values_Q, uint64_t &q_pos)
+            {
+                LEAF_CONTAINER &leaf = this->leaf_container_vec[leaf_index];
+                uint64_t leaf_size = leaf.size();
+                int64_t total_delta = 0;
+                while (pos < leaf_size && q_pos < values_Q.size())
+                {
+                    int64_t delta = (int64_t)values_Q[q_pos] - (int64_t)leaf.at(pos);
+                    if (delta != 0)
+                    {
+                        leaf.increment(pos, delta);
+                        total_delta += delta;
+                    }
+                    pos++;
+                    q_pos++;
+                }
+                return total_delta;
+            }
+
+            /**
+             * @brief Overwrite the values in the subtree of \p node from position \p pos with \p Q[q_pos..], and return the total change of the weights.
+             * @details Each visited child edge of \p node receives a single aggregated delta.
+             */
+            int64_t set_values_on_node(Node *node, uint64_t pos, const std::vector<VALUE> &values_Q, uint64_t &q_pos)
+            {
+                uint64_t children_count = node->children_count();
+                uint64_t child_index = 0;
+                while (child_index < children_count && pos >= node->access_count_deque(child_index))
+                {
+                    pos -= node->access_count_deque(child_index);
+                    child_index++;
+                }
+
+                int64_t total_delta = 0;
+                while (child_index < children_count && q_pos < values_Q.size())
+                {
+                    int64_t delta = 0;
+                    if (node->is_parent_of_leaves())
+                    {
+                        delta = this->set_values_on_leaf((uint64_t)node->get_child(child_index), pos, values_Q, q_pos);
+                    }
+                    else
+                    {
+                        delta = this->set_values_on_node(node->get_child(child_index), pos, values_Q, q_pos);
+                    }
+                    if (delta != 0)
+                    {
+                        node->increment(child_index, 0, delta);
+                        total_delta += delta;
+                    }
+                    pos = 0;
+                    child_index++;
+                }
+                return total_delta;
+            }
         private:
             /**
              * @brief Performs defragmentation of the B+ tree
@@ -1837,6 +2437,46 @@ namespace stool
                 return new_node;
             }
 
+            /**
+             * @brief Return the degree of the leaf \p leaf_index used for balancing, i.e., its balance_weight() if USE_LEAF_WEIGHT is true, and its number of values otherwise
+             */
+            uint64_t get_leaf_degree(uint64_t leaf_index) const
+            {
+                if constexpr (USE_LEAF_WEIGHT)
+                {
+                    return this->leaf_container_vec[leaf_index].balance_weight();
+                }
+                else
+                {
+                    return this->leaf_container_vec[leaf_index].size();
+                }
+            }
+
+            /**
+             * @brief Return true if the leaf \p leaf_index can receive one more value before balance_for_insertion splits it
+             */
+            bool has_room_in_leaf(uint64_t leaf_index) const
+            {
+                return this->get_leaf_degree(leaf_index) <= LEAF_CONTAINER_MAX_SIZE;
+            }
+
+            /**
+             * @brief Return the number of values that can be inserted into the leaf \p leaf_index at once before balance_for_insertion (at least 1)
+             */
+            uint64_t get_insertable_count_in_leaf(uint64_t leaf_index) const
+            {
+                if constexpr (USE_LEAF_WEIGHT)
+                {
+                    return std::max<uint64_t>(1, this->leaf_container_vec[leaf_index].balance_capacity(LEAF_CONTAINER_MAX_SIZE));
+                }
+                else
+                {
+                    uint64_t leaf_capacity = LEAF_CONTAINER_MAX_SIZE + 1;
+                    uint64_t leaf_size = this->leaf_container_vec[leaf_index].size();
+                    return leaf_size < leaf_capacity ? leaf_capacity - leaf_size : 1;
+                }
+            }
+
             /**
              * @brief Handles the node splitting process during tree operations
              * @param path Vector of NodePointers representing path from root to target node
@@ -1925,6 +2565,7 @@ namespace stool
              *          2. Attempting to redistribute values to siblings if possible
              *          3. Splitting nodes if redistribution is not possible
              *          The process continues up the tree path until balance is restored.
+             *          If USE_LEAF_WEIGHT is true, a leaf heavier than LEAF_CONTAINER_MAX_SIZE is always split, because moving a few values to a sibling does not always make it lighter.
              */
             uint64_t balance_for_insertion(const std::vector<NodePointer> &path, bool superLeftPushMode = false)
             {
@@ -1932,6 +2573,22 @@ namespace stool
                 for (int64_t t = path.size() - 1; t >= 0; --t)
                 {
                     const NodePointer &top = path[t];
+                    if constexpr (USE_LEAF_WEIGHT)
+                    {
+                        if (top.is_leaf())
+                        {
+                            if (this->get_leaf_degree(top.get_leaf_container_index()) > LEAF_CONTAINER_MAX_SIZE)
+                            {
+                                this->split_process(path, t);
+                                split_counter++;
+                                continue;
+                            }
+                            else
+                            {
+                                break;
+                            }
+                        }
+                    }
                     uint64_t degree = top.get_degree(this->leaf_container_vec);
                     uint64_t threshold = top.is_leaf() ? LEAF_CONTAINER_MAX_SIZE : MAX_DEGREE;
                     uint64_t LR_threshold = threshold;
@@ -2014,6 +2671,7 @@ namespace stool
              *          3. Merging nodes if borrowing is not possible
              *          4. Potentially adjusting the root if it has only one child
              *          The process continues up the tree path until balance is restored.
+             *          If USE_LEAF_WEIGHT is true, leaves are handled by merge_light_leaf instead of steps 2 and 3.
              */
             uint64_t balance_for_removal(const std::vector<NodePointer> &path)
             {
@@ -2024,6 +2682,21 @@ namespace stool
                 for (int64_t t = path.size() - 1; t >= 0; --t)
                 {
                     const NodePointer &top = path[t];
+                    if constexpr (USE_LEAF_WEIGHT)
+                    {
+                        if (top.is_leaf() && t > 0)
+                        {
+                            if (this->merge_light_leaf(path, t))
+                            {
+                                merge_counter++;
+                                continue;
+                            }
+                            else
+                            {
+                                break;
+                            }
+                        }
+                    }
                     uint64_t max_size = top.is_leaf() ? LEAF_CONTAINER_MAX_SIZE : MAX_DEGREE;
                     uint64_t threshold = max_size / 2;
 
@@ -2143,6 +2816,49 @@ namespace stool
                 return merge_counter;
             }
 
+            /**
+             * @brief Merges the leaf \p path[t] into a sibling if the leaf is lighter than LEAF_CONTAINER_MAX_SIZE / 2 and the merged leaf is not heavier than LEAF_CONTAINER_MAX_SIZE
+             * @return True if the leaf has been merged and removed
+             * @details This function is used only if USE_LEAF_WEIGHT is true. A light leaf that cannot be merged is kept, since the merge with any sibling would make a leaf too heavy.
+             */
+            bool merge_light_leaf(const std::vector<NodePointer> &path, uint64_t t)
+            {
+                const NodePointer &top = path[t];
+                uint64_t leaf = top.get_leaf_container_index();
+                const LEAF_CONTAINER &container = this->leaf_container_vec[leaf];
+                uint64_t len = container.size();
+                if (len > 0 && container.balance_weight() >= LEAF_CONTAINER_MAX_SIZE / 2)
+                {
+                    return false;
+                }
+
+                Node *parent = path[t - 1].get_node();
+                uint64_t parent_edge_index = top.get_parent_edge_index();
+                if (parent_edge_index > 0)
+                {
+                    Node *leftSibling = parent->get_child(parent_edge_index - 1);
+                    const LEAF_CONTAINER &left_container = this->leaf_container_vec[(uint64_t)leftSibling];
+                    if (len == 0 || LEAF_CONTAINER::balance_weight_of_concatenation(left_container, container) <= LEAF_CONTAINER_MAX_SIZE)
+                    {
+                        this->move_values_left(leftSibling, top.get_node(), len, true, parent, parent_edge_index);
+                        this->remove_empty_leaf(leaf, parent, parent_edge_index);
+                        return true;
+                    }
+                }
+                if (parent_edge_index + 1 < parent->children_count())
+                {
+                    Node *rightSibling = parent->get_child(parent_edge_index + 1);
+                    const LEAF_CONTAINER &right_container = this->leaf_container_vec[(uint64_t)rightSibling];
+                    if (len == 0 || LEAF_CONTAINER::balance_weight_of_concatenation(container, right_container) <= LEAF_CONTAINER_MAX_SIZE)
+                    {
+                        this->move_values_right(top.get_node(), rightSibling, len, true, parent, parent_edge_index);
+                        this->remove_empty_leaf(leaf, parent, parent_edge_index);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
             /**
              * @brief Returns the number of internal nodes in the B+ tree
              * @return The number of internal nodes in the B+ tree
@@ -2213,6 +2929,8 @@ namespace stool
 
                             parent->decrement_on_sum_deque(parent_edge_index_of_left_node, sum);
                             parent->increment_on_sum_deque(parent_edge_index_of_left_node + 1, sum);
+                            parent->decrement_on_zero_count_deque(parent_edge_index_of_left_node, len - sum);
+                            parent->increment_on_zero_count_deque(parent_edge_index_of_left_node + 1, len - sum);
                         }
                     }
 
@@ -2255,6 +2973,8 @@ namespace stool
                         uint64_t sum = len != 0 ? this->leaf_container_vec[right_leaf].psum(len - 1) : 0;
                         parent->decrement_on_sum_deque(parent_edge_index_of_right_node, sum);
                         parent->increment_on_sum_deque(parent_edge_index_of_right_node - 1, sum);
+                        parent->decrement_on_zero_count_deque(parent_edge_index_of_right_node, len - sum);
+                        parent->increment_on_zero_count_deque(parent_edge_index_of_right_node - 1, len - sum);
                     }
 
                     if (parent != nullptr)
@@ -2289,18 +3009,27 @@ namespace stool
             {
 
                 uint64_t degree = 0;
+                uint64_t left_len = 0;
                 if (is_leaf)
                 {
                     degree = leaf_container_vec[(uint64_t)left_node].size();
                     assert((uint64_t)left_node < this->leaf_container_vec.size());
                     assert((uint64_t)right_node < this->leaf_container_vec.size());
-                    assert(this->leaf_container_vec[(uint64_t)left_node].size() == this->get_max_count_of_values_in_leaf() + 1);
+                    if constexpr (USE_LEAF_WEIGHT)
+                    {
+                        left_len = this->leaf_container_vec[(uint64_t)left_node].balance_split_position();
+                    }
+                    else
+                    {
+                        assert(this->leaf_container_vec[(uint64_t)left_node].size() == this->get_max_count_of_values_in_leaf() + 1);
+                        left_len = degree / 2;
+                    }
                 }
                 else
                 {
                     degree = left_node->get_degree();
+                    left_len = degree / 2;
                 }
-                uint64_t left_len = degree / 2;
                 uint64_t right_len = degree - left_len;
                 this->move_values_right(left_node, right_node, right_len, is_leaf, parent, parent_edge_index_of_left_node);
             }
@@ -2323,7 +3052,7 @@ namespace stool
                 uint64_t x = 0;
                 uint64_t leaf = path[path.size() - 1].get_leaf_container_index();
                 uint64_t len = 0;
-                while ((value_pos + x) < values.size() && leaf_container_vec[leaf].size() <= this->get_max_count_of_values_in_leaf())
+                while ((value_pos + x) < values.size() && this->has_room_in_leaf(leaf))
                 {
 
                     this->leaf_container_vec[leaf].push_back(values[value_pos + x]);
@@ -2416,6 +3145,11 @@ namespace stool
                             b = b && (size > 0);
                             assert(b);
                         }
+                        else if constexpr (USE_LEAF_WEIGHT)
+                        {
+                            b = b && (size > 0) && (this->get_leaf_degree(pt.get_leaf_container_index()) <= LEAF_CONTAINER_MAX_SIZE);
+                            assert(b);
+                        }
                         else
                         {
 
@@ -2750,6 +3484,15 @@ namespace stool
                 if (_values.size() == 0)
                 {
                 }
+                else if constexpr (USE_LEAF_WEIGHT)
+                {
+                    uint64_t leaf_index = UINT64_MAX;
+                    while (i < _values.size())
+                    {
+                        leaf_index = this->build_push_by_weight(leaf_index, _values[i]);
+                        i++;
+                    }
+                }
                 else if (_values.size() <= LEAF_CONTAINER_MAX_SIZE)
                 {
                     uint64_t leaf_index = this->get_new_container_index();
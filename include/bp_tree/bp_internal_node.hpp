@@ -21,6 +21,18 @@ namespace stool
 #endif
 
             using DEQUE_TYPE = stool::NaiveIntegerArray<MAX_DEGREE + 2>;
+
+        public:
+            /**
+             * @brief True if this node keeps the number of 0s (i.e., count - sum) of each child, which is the case for the trees of bits
+             */
+            static inline constexpr bool USE_ZERO_COUNT = USE_PSUM && std::is_same<VALUE, bool>::value;
+
+        private:
+            struct NoZeroCountDeque
+            {
+            };
+            using ZERO_DEQUE_TYPE = std::conditional_t<USE_ZERO_COUNT, DEQUE_TYPE, NoZeroCountDeque>;
             //using DEQUE_TYPE = stool::NaiveIntegerArrayForFasterPsum<(MAX_DEGREE + 2)>;
             //using DEQUE_TYPE = stool::EytzingerLayoutForPsum<MAX_DEGREE + 2>;
             
@@ -30,6 +42,8 @@ namespace stool
             stool::SimpleDeque16<InternalNode *> children_;
             DEQUE_TYPE children_value_count_deque_;
             DEQUE_TYPE children_value_sum_deque_;
+            // The number of 0s in the subtree of each child, which is updated together with the count and sum deques for select0
+            ZERO_DEQUE_TYPE children_value_zero_count_deque_;
             bool is_parent_of_leaves_ = false;
 
 
@@ -59,6 +73,10 @@ namespace stool
 
                 this->children_value_count_deque_.clear();
                 this->children_value_sum_deque_.clear();
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.clear();
+                }
                 if (this->is_parent_of_leaves_)
                 {
                     for (InternalNode *child : this->children_)
@@ -69,6 +87,10 @@ namespace stool
                         {
                             uint64_t psum = _leaf_container_vec[(uint64_t)child].psum();
                             this->children_value_sum_deque_.push_back(psum);
+                            if constexpr (USE_ZERO_COUNT)
+                            {
+                                this->children_value_zero_count_deque_.push_back(child_count - psum);
+                            }
                         }
                     }
                 }
@@ -81,6 +103,10 @@ namespace stool
                         if constexpr (USE_PSUM)
                         {
                             this->children_value_sum_deque_.push_back(child->psum_on_sum_deque());
+                            if constexpr (USE_ZERO_COUNT)
+                            {
+                                this->children_value_zero_count_deque_.push_back(child->psum_on_zero_count_deque());
+                            }
                         }
                     }
                 }
@@ -161,6 +187,97 @@ namespace stool
             }
             //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operations on the zero-count deque
+            ///   The zero count of a child is (count - sum), i.e., the number of 0s in its subtree. The deque exists only if USE_ZERO_COUNT is true,
+            ///   and the update functions are no-ops otherwise. The callers that move counts and sums between children
+            ///   move the zero counts by the same functions, so that the three deques are consistent after each operation.
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the smallest x such that the sum of the zero counts of the first (x+1) children is at least \p value, and store the sums of the zero counts and the counts of the first x children to \p sum and \p count_sum. Return -1 if such x does not exist.
+             * @note The same indexed search as search_query_on_sum_deque is used on the zero-count deque.
+             */
+            int64_t search_query_on_zero_count(uint64_t value, uint64_t &sum, uint64_t &count_sum) const
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    int64_t x = this->children_value_zero_count_deque_.search(value, sum);
+                    count_sum = x > 0 ? this->children_value_count_deque_.psum(x - 1) : 0;
+                    return x;
+                }
+                else
+                {
+                    throw std::runtime_error("search_query_on_zero_count() is not supported");
+                }
+            }
+            uint64_t psum_on_zero_count_deque() const
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    return this->children_value_zero_count_deque_.psum();
+                }
+                else
+                {
+                    throw std::runtime_error("psum_on_zero_count_deque() is not supported");
+                }
+            }
+            uint64_t access_zero_count_deque(uint64_t pos) const
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    return this->children_value_zero_count_deque_[pos];
+                }
+                else
+                {
+                    throw std::runtime_error("access_zero_count_deque() is not supported");
+                }
+            }
+            void pop_back_many_on_zero_count_deque([[maybe_unused]] uint64_t len)
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.pop_back_many(len);
+                }
+            }
+            void pop_front_many_on_zero_count_deque([[maybe_unused]] uint64_t len)
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.pop_front_many(len);
+                }
+            }
+            void push_front_many_on_zero_count_deque([[maybe_unused]] std::vector<uint64_t> values)
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.push_front_many(values);
+                }
+            }
+            void push_back_many_on_zero_count_deque([[maybe_unused]] std::vector<uint64_t> values)
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.push_back_many(values);
+                }
+            }
+            void increment_on_zero_count_deque([[maybe_unused]] uint64_t pos, [[maybe_unused]] int64_t value)
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.increment(pos, value);
+                }
+            }
+            void decrement_on_zero_count_deque([[maybe_unused]] uint64_t pos, [[maybe_unused]] int64_t value)
+            {
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.decrement(pos, value);
+                }
+            }
+            //@}
+
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Operations on the sum deque
             ////////////////////////////////////////////////////////////////////////////////
@@ -299,7 +416,12 @@ namespace stool
             }
             uint64_t size_in_bytes() const
             {
-                return sizeof(BPInternalNode) + (this->children_.size_in_bytes(true) + this->children_value_count_deque_.size_in_bytes(true) + this->children_value_sum_deque_.size_in_bytes(true));
+                uint64_t bytes = sizeof(BPInternalNode) + (this->children_.size_in_bytes(true) + this->children_value_count_deque_.size_in_bytes(true) + this->children_value_sum_deque_.size_in_bytes(true));
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    bytes += this->children_value_zero_count_deque_.size_in_bytes(true);
+                }
+                return bytes;
             }
 
             int64_t get_index(InternalNode *node) const
@@ -377,7 +499,10 @@ namespace stool
                 this->children_.clear();
                 this->children_value_count_deque_.clear();
                 this->children_value_sum_deque_.clear();
-
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.clear();
+                }
             }
 
             void increment(uint64_t child_index, int64_t count_delta, int64_t sum_delta)
@@ -397,6 +522,13 @@ namespace stool
                         this->children_value_sum_deque_.increment(child_index, sum_delta);
                     }
                 }
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    if (count_delta != sum_delta)
+                    {
+                        this->children_value_zero_count_deque_.increment(child_index, count_delta - sum_delta);
+                    }
+                }
             }
 
             void move_container_index(uint64_t child_index, uint64_t new_leaf_index, std::vector<LEAF_CONTAINER> &leaf_container_vec)
@@ -414,6 +546,10 @@ namespace stool
                 {
                     this->children_value_sum_deque_.insert(pos, child_sum);
                 }
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.insert(pos, child_count - child_sum);
+                }
 
             }
             void append_child(InternalNode *child, uint64_t child_count, uint64_t child_sum)
@@ -424,6 +560,10 @@ namespace stool
                 {
                     this->children_value_sum_deque_.push_back(child_sum);
                 }
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.push_back(child_count - child_sum);
+                }
 
             }
 
@@ -435,6 +575,10 @@ namespace stool
                 {
                     this->children_value_sum_deque_.erase(pos);
                 }
+                if constexpr (USE_ZERO_COUNT)
+                {
+                    this->children_value_zero_count_deque_.erase(pos);
+                }
 
             }
 
@@ -1,10 +1,23 @@
 #pragma once
+#include <type_traits>
 #include "./bp_internal_node.hpp"
 
 namespace stool
 {
     namespace bptree
     {
+        /**
+         * @brief True if \p LEAF_CONTAINER answers a sorted batch of psum queries by psum_many(sorted_positions, begin, end, position_offset, sum_offset, output) and a sorted batch of search queries by search_many(...) (see BitVectorContainer)
+         */
+        template <typename LEAF_CONTAINER, typename = void>
+        struct HasBatchedLeafQueries : std::false_type
+        {
+        };
+        template <typename LEAF_CONTAINER>
+        struct HasBatchedLeafQueries<LEAF_CONTAINER, std::void_t<decltype(std::declval<const LEAF_CONTAINER &>().psum_many(std::declval<const std::vector<uint64_t> &>(), 0, 0, 0, 0, std::declval<std::vector<uint64_t> &>())),
+                                                                decltype(std::declval<const LEAF_CONTAINER &>().search_many(std::declval<const std::vector<uint64_t> &>(), 0, 0, 0, 0, std::declval<std::vector<int64_t> &>()))>> : std::true_type
+        {
+        };
 
         /**
          * @brief Helper functions of BPInternalNode [Unchecked AI's Comment]
@@ -84,28 +97,20 @@ namespace stool
 
                 while (!_is_leaf)
                 {
-                    bool b = false;
                     assert(current_psum <= nth);
-
-                    for (uint64_t x = 0; x < current_node->children_count(); x++)
+                    uint64_t tmp_psum = 0;
+                    uint64_t tmp_count_psum = 0;
+                    int64_t search_result = current_node->search_query_on_zero_count(nth - current_psum, tmp_psum, tmp_count_psum);
+                    if (search_result != -1)
                     {
-                        int64_t sub_count0 = current_node->access_count_deque(x) - current_node->access_sum_deque(x);
-                        if (current_psum + sub_count0 >= nth)
-                        {
-                            _is_leaf = current_node->is_parent_of_leaves();
-                            current_node = current_node->get_child(x);
-                            b = true;
-                            break;
-                        }
-                        else
-                        {
-                            current_psum += sub_count0;
-                            result += current_node->access_count_deque(x);
-                        }
+                        result += tmp_count_psum;
+                        _is_leaf = current_node->is_parent_of_leaves();
+                        current_node = current_node->get_child(search_result);
+                        current_psum += tmp_psum;
                     }
-                    if (!b)
+                    else
                     {
-                        throw std::invalid_argument("psum error");
+                        throw std::invalid_argument("BPInternalNodeFunctions::select0(), psum error");
                     }
                 }
                 uint64_t x = (uint64_t)current_node;
@@ -161,8 +166,347 @@ namespace stool
 
                 return pair;
             }
+
+            /**
+             * @brief Stores \p sum_offset + leaf.psum(p - \p position_offset) in \p output[k] for each p = \p sorted_positions[k] (begin <= k < end)
+             * @details The queries are passed to \p leaf at once if \p LEAF_CONTAINER supports batched queries (see HasBatchedLeafQueries).
+             */
+            static void psum_many_on_leaf(const LEAF_CONTAINER &leaf, const std::vector<uint64_t> &sorted_positions, uint64_t begin, uint64_t end, uint64_t position_offset, uint64_t sum_offset, std::vector<uint64_t> &output)
+            {
+                if constexpr (HasBatchedLeafQueries<LEAF_CONTAINER>::value)
+                {
+                    leaf.psum_many(sorted_positions, begin, end, position_offset, sum_offset, output);
+                }
+                else
+                {
+                    for (uint64_t k = begin; k < end; k++)
+                    {
+                        output[k] = sum_offset + leaf.psum(sorted_positions[k] - position_offset);
+                    }
+                }
+            }
+
+            /**
+             * @brief Stores \p position_offset + leaf.search(u - \p sum_offset) in \p output[k] for each u = \p sorted_sums[k] (begin <= k < end)
+             * @details The queries are passed to \p leaf at once if \p LEAF_CONTAINER supports batched queries (see HasBatchedLeafQueries).
+             */
+            static void search_many_on_leaf(const LEAF_CONTAINER &leaf, const std::vector<uint64_t> &sorted_sums, uint64_t begin, uint64_t end, uint64_t position_offset, uint64_t sum_offset, std::vector<int64_t> &output)
+            {
+                if constexpr (HasBatchedLeafQueries<LEAF_CONTAINER>::value)
+                {
+                    leaf.search_many(sorted_sums, begin, end, position_offset, sum_offset, output);
+                }
+                else
+                {
+                    for (uint64_t k = begin; k < end; k++)
+                    {
+                        output[k] = position_offset + leaf.search(sorted_sums[k] - sum_offset);
+                    }
+                }
+            }
+
+            /**
+             * @brief Stores psum(p) in \p output[k] for each p = \p sorted_positions[k] (begin <= k < end) by one traversal of the subtree rooted at \p node.
+             * @param position_offset The number of values preceding the subtree
+             * @param sum_offset The sum of the values preceding the subtree
+             * @note \p sorted_positions[begin..end-1] must be sorted in ascending order and lie in the subtree.
+             */
+            static void psum_many(const InternalNode &node, const std::vector<uint64_t> &sorted_positions, uint64_t begin, uint64_t end, uint64_t position_offset, uint64_t sum_offset, const std::vector<LEAF_CONTAINER> &leaf_container_vec, std::vector<uint64_t> &output)
+            {
+                uint64_t k = begin;
+                uint64_t children_count = node.children_count();
+                bool is_parent_of_leaves = node.is_parent_of_leaves();
+                for (uint64_t c = 0; c < children_count && k < end; c++)
+                {
+                    uint64_t child_count = node.access_count_deque(c);
+                    uint64_t child_sum = node.access_sum_deque(c);
+                    uint64_t next_k = k;
+                    while (next_k < end && sorted_positions[next_k] < position_offset + child_count)
+                    {
+                        next_k++;
+                    }
+
+                    if (next_k > k)
+                    {
+                        if (is_parent_of_leaves)
+                        {
+                            BPInternalNodeFunctions::psum_many_on_leaf(leaf_container_vec[(uint64_t)node.get_child(c)], sorted_positions, k, next_k, position_offset, sum_offset, output);
+                        }
+                        else
+                        {
+                            BPInternalNodeFunctions::psum_many(*node.get_child(c), sorted_positions, k, next_k, position_offset, sum_offset, leaf_container_vec, output);
+                        }
+                        k = next_k;
+                    }
+                    position_offset += child_count;
+                    sum_offset += child_sum;
+                }
+                if (k < end)
+                {
+                    throw std::invalid_argument("BPInternalNodeFunctions::psum_many(), out of range");
+                }
+            }
+
+            /**
+             * @brief Stores search(u) in \p output[k] for each u = \p sorted_sums[k] (begin <= k < end) by one traversal of the subtree rooted at \p node.
+             * @param position_offset The number of values preceding the subtree
+             * @param sum_offset The sum of the values preceding the subtree
+             * @note \p sorted_sums[begin..end-1] must be sorted in ascending order and be answered in the subtree.
+             */
+            static void search_many(const InternalNode &node, const std::vector<uint64_t> &sorted_sums, uint64_t begin, uint64_t end, uint64_t position_offset, uint64_t sum_offset, const std::vector<LEAF_CONTAINER> &leaf_container_vec, std::vector<int64_t> &output)
+            {
+                uint64_t k = begin;
+                uint64_t children_count = node.children_count();
+                bool is_parent_of_leaves = node.is_parent_of_leaves();
+                for (uint64_t c = 0; c < children_count && k < end; c++)
+                {
+                    uint64_t child_count = node.access_count_deque(c);
+                    uint64_t child_sum = node.access_sum_deque(c);
+                    uint64_t next_k = k;
+                    while (next_k < end && sorted_sums[next_k] <= sum_offset + child_sum)
+                    {
+                        next_k++;
+                    }
+
+                    if (next_k > k)
+                    {
+                        if (is_parent_of_leaves)
+                        {
+                            BPInternalNodeFunctions::search_many_on_leaf(leaf_container_vec[(uint64_t)node.get_child(c)], sorted_sums, k, next_k, position_offset, sum_offset, output);
+                        }
+                        else
+                        {
+                            BPInternalNodeFunctions::search_many(*node.get_child(c), sorted_sums, k, next_k, position_offset, sum_offset, leaf_container_vec, output);
+                        }
+                        k = next_k;
+                    }
+                    position_offset += child_count;
+                    sum_offset += child_sum;
+                }
+                if (k < end)
+                {
+                    throw std::invalid_argument("BPInternalNodeFunctions::search_many(), out of range");
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Word-level functions
+            ///   Functions for leaf containers storing bits
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Write the bits \p S[i..i+len-1] stored in the subtree rooted at \p node to \p output packed in 64-bit words.
+             * @param position_offset The number of values preceding the subtree
+             * @note The bits are written to \p output[(p - i)] for each position p in the range, using the extract_words function of the LEAF CONTAINER.
+             */
+            static void extract_words(const InternalNode &node, uint64_t i, uint64_t len, uint64_t position_offset, const std::vector<LEAF_CONTAINER> &leaf_container_vec, uint64_t *output)
+            {
+                uint64_t children_count = node.children_count();
+                bool is_parent_of_leaves = node.is_parent_of_leaves();
+                for (uint64_t c = 0; c < children_count && position_offset < i + len; c++)
+                {
+                    uint64_t child_count = node.access_count_deque(c);
+                    if (position_offset + child_count > i)
+                    {
+                        if (is_parent_of_leaves)
+                        {
+                            uint64_t begin = std::max(i, position_offset);
+                            uint64_t end = std::min(i + len, position_offset + child_count);
+                            const LEAF_CONTAINER &leaf = leaf_container_vec[(uint64_t)node.get_child(c)];
+                            leaf.extract_words(begin - position_offset, end - begin, output, begin - i);
+                        }
+                        else
+                        {
+                            BPInternalNodeFunctions::extract_words(*node.get_child(c), i, len, position_offset, leaf_container_vec, output);
+                        }
+                    }
+                    position_offset += child_count;
+                }
+            }
+
+            /**
+             * @brief Return the sum of \p S[i..j] stored in the subtree rooted at \p node.
+             * @details The two positions share one descent until they fall into different children, and the children between them are summed from the node.
+             * @note O(\log n) time. If \p S[i] and \p S[j] are in the same leaf, only one root-to-leaf descent is performed.
+             */
+            static uint64_t psum(const InternalNode &node, uint64_t i, uint64_t j, const std::vector<LEAF_CONTAINER> &leaf_container_vec)
+            {
+                assert(i <= j);
+                const InternalNode *current_node = &node;
+                while (true)
+                {
+                    uint64_t tmp_i = 0;
+                    uint64_t tmp_j = 0;
+                    int64_t ci = current_node->search_query_on_count_deque(i + 1, tmp_i);
+                    int64_t cj = current_node->search_query_on_count_deque(j + 1, tmp_j);
+                    if (ci == -1 || cj == -1)
+                    {
+                        throw std::invalid_argument("BPInternalNodeFunctions::psum(i, j), psum error");
+                    }
+                    i -= tmp_i;
+                    j -= tmp_j;
+
+                    bool is_parent_of_leaves = current_node->is_parent_of_leaves();
+                    if (ci == cj)
+                    {
+                        if (is_parent_of_leaves)
+                        {
+                            const LEAF_CONTAINER &leaf = leaf_container_vec[(uint64_t)current_node->get_child(ci)];
+                            return leaf.psum(j) - (i > 0 ? leaf.psum(i - 1) : 0);
+                        }
+                        current_node = current_node->get_child(ci);
+                    }
+                    else
+                    {
+                        uint64_t sum = current_node->psum_on_sum_deque(cj - 1) - current_node->psum_on_sum_deque(ci);
+                        sum += current_node->access_sum_deque(ci);
+                        if (i > 0)
+                        {
+                            sum -= is_parent_of_leaves ? leaf_container_vec[(uint64_t)current_node->get_child(ci)].psum(i - 1) : BPInternalNodeFunctions::psum(*current_node->get_child(ci), i - 1, leaf_container_vec);
+                        }
+                        sum += is_parent_of_leaves ? leaf_container_vec[(uint64_t)current_node->get_child(cj)].psum(j) : BPInternalNodeFunctions::psum(*current_node->get_child(cj), j, leaf_container_vec);
+                        return sum;
+                    }
+                }
+            }
+
+            /**
+             * @brief Return the smallest position q >= \p i such that \p S[q] = \p b in the subtree rooted at \p node if it exists, otherwise return -1.
+             * @details The query descends to the leaf containing \p S[i] and stays in it if the answer is there. Otherwise, the next child containing \p b is found from the counts stored in the ancestors.
+             * @note O(\log n) time. The result is undefined if S is not a bit sequence.
+             */
+            static int64_t next_bit(const InternalNode &node, uint64_t i, bool b, const std::vector<LEAF_CONTAINER> &leaf_container_vec)
+            {
+                uint64_t position_offset = 0;
+                int64_t c = node.search_query_on_count_deque(i + 1, position_offset);
+                if (c == -1)
+                {
+                    throw std::invalid_argument("BPInternalNodeFunctions::next_bit(), search error");
+                }
+
+                bool is_parent_of_leaves = node.is_parent_of_leaves();
+                int64_t result = is_parent_of_leaves ? BPInternalNodeFunctions::next_bit_on_leaf(leaf_container_vec[(uint64_t)node.get_child(c)], i - position_offset, b) : BPInternalNodeFunctions::next_bit(*node.get_child(c), i - position_offset, b, leaf_container_vec);
+                if (result != -1)
+                {
+                    return position_offset + result;
+                }
+
+                uint64_t children_count = node.children_count();
+                position_offset += node.access_count_deque(c);
+                for (uint64_t x = c + 1; x < children_count; x++)
+                {
+                    if (BPInternalNodeFunctions::count_bit(node, x, b) > 0)
+                    {
+                        return position_offset + BPInternalNodeFunctions::select_bit_on_child(node, x, 0, b, leaf_container_vec);
+                    }
+                    position_offset += node.access_count_deque(x);
+                }
+                return -1;
+            }
+
+            /**
+             * @brief Return the largest position q < \p i such that \p S[q] = \p b in the subtree rooted at \p node if it exists, otherwise return -1.
+             * @note O(\log n) time. The result is undefined if S is not a bit sequence.
+             */
+            static int64_t prev_bit(const InternalNode &node, uint64_t i, bool b, const std::vector<LEAF_CONTAINER> &leaf_container_vec)
+            {
+                if (i == 0)
+                {
+                    return -1;
+                }
+                uint64_t position_offset = 0;
+                int64_t c = node.search_query_on_count_deque(i, position_offset);
+                if (c == -1)
+                {
+                    throw std::invalid_argument("BPInternalNodeFunctions::prev_bit(), search error");
+                }
+
+                bool is_parent_of_leaves = node.is_parent_of_leaves();
+                int64_t result = is_parent_of_leaves ? BPInternalNodeFunctions::prev_bit_on_leaf(leaf_container_vec[(uint64_t)node.get_child(c)], i - position_offset, b) : BPInternalNodeFunctions::prev_bit(*node.get_child(c), i - position_offset, b, leaf_container_vec);
+                if (result != -1)
+                {
+                    return position_offset + result;
+                }
+
+                for (int64_t x = c - 1; x >= 0; x--)
+                {
+                    position_offset -= node.access_count_deque(x);
+                    uint64_t count = BPInternalNodeFunctions::count_bit(node, x, b);
+                    if (count > 0)
+                    {
+                        return position_offset + BPInternalNodeFunctions::select_bit_on_child(node, x, count - 1, b, leaf_container_vec);
+                    }
+                }
+                return -1;
+            }
+
+            /**
+             * @brief Return the smallest position q >= \p i such that \p leaf[q] = \p b if it exists, otherwise return -1.
+             */
+            static int64_t next_bit_on_leaf(const LEAF_CONTAINER &leaf, uint64_t i, bool b)
+            {
+                uint64_t size = leaf.size();
+                if (i >= size)
+                {
+                    return -1;
+                }
+                uint64_t one_count = i > 0 ? leaf.psum(i - 1) : 0;
+                if (b)
+                {
+                    return one_count < leaf.psum() ? leaf.search(one_count + 1) : -1;
+                }
+                else
+                {
+                    uint64_t zero_count = i - one_count;
+                    return zero_count < size - leaf.psum() ? leaf.select0(zero_count) : -1;
+                }
+            }
+
+            /**
+             * @brief Return the largest position q < \p i such that \p leaf[q] = \p b if it exists, otherwise return -1.
+             */
+            static int64_t prev_bit_on_leaf(const LEAF_CONTAINER &leaf, uint64_t i, bool b)
+            {
+                if (i == 0)
+                {
+                    return -1;
+                }
+                uint64_t one_count = leaf.psum(i - 1);
+                if (b)
+                {
+                    return one_count > 0 ? leaf.search(one_count) : -1;
+                }
+                else
+                {
+                    uint64_t zero_count = i - one_count;
+                    return zero_count > 0 ? leaf.select0(zero_count - 1) : -1;
+                }
+            }
             //@}
 
+        private:
+            static uint64_t count_bit(const InternalNode &node, uint64_t c, bool b)
+            {
+                uint64_t one_count = node.access_sum_deque(c);
+                return b ? one_count : node.access_count_deque(c) - one_count;
+            }
+            static int64_t select_bit_on_child(const InternalNode &node, uint64_t c, uint64_t k, bool b, const std::vector<LEAF_CONTAINER> &leaf_container_vec)
+            {
+                if (node.is_parent_of_leaves())
+                {
+                    const LEAF_CONTAINER &leaf = leaf_container_vec[(uint64_t)node.get_child(c)];
+                    return b ? leaf.search(k + 1) : leaf.select0(k);
+                }
+                else
+                {
+                    const InternalNode &child = *node.get_child(c);
+                    return b ? BPInternalNodeFunctions::search(child, k + 1, leaf_container_vec) : BPInternalNodeFunctions::select0(child, k, leaf_container_vec);
+                }
+            }
+
+        public:
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Conversion functions
             ///   Conversion functions
@@ -391,6 +735,17 @@ namespace stool
                     }
                 }
 
+                if constexpr (InternalNode::USE_ZERO_COUNT)
+                {
+                    for (uint64_t i = 0; i < node.children_count(); i++)
+                    {
+                        if (node.access_zero_count_deque(i) != node.access_count_deque(i) - node.access_sum_deque(i))
+                        {
+                            throw std::logic_error("Error(7): BPInternalNode::verify()");
+                        }
+                    }
+                }
+
                 if (node.get_degree() > max_degree)
                 {
                     throw std::logic_error("Error(3): BPInternalNode::verify()");
@@ -471,6 +826,26 @@ namespace stool
                     }
                 }
 
+                if constexpr (InternalNode::USE_ZERO_COUNT)
+                {
+                    uint64_t left_children_size = left_node.children_count();
+                    std::vector<uint64_t> tmp_zero_count_array;
+                    tmp_zero_count_array.resize(len);
+                    for (uint64_t i = 0; i < len; i++)
+                    {
+                        tmp_zero_count_array[i] = left_node.access_zero_count_deque(left_children_size - len + i);
+                    }
+                    int64_t zero_count_delta = std::accumulate(tmp_zero_count_array.begin(), tmp_zero_count_array.end(), (uint64_t)0);
+                    left_node.pop_back_many_on_zero_count_deque(len);
+                    right_node.push_front_many_on_zero_count_deque(tmp_zero_count_array);
+
+                    if (parent != nullptr)
+                    {
+                        parent->decrement_on_zero_count_deque(parent_edge_index, zero_count_delta);
+                        parent->increment_on_zero_count_deque(parent_edge_index + 1, zero_count_delta);
+                    }
+                }
+
                 stool::SimpleDeque16<InternalNode *> &left_children = left_node.get_children();
                 stool::SimpleDeque16<InternalNode *> &right_children = right_node.get_children();
                 for (uint64_t i = 0; i < len; i++)
@@ -549,6 +924,25 @@ namespace stool
                     }
                 }
 
+                if constexpr (InternalNode::USE_ZERO_COUNT)
+                {
+                    std::vector<uint64_t> tmp_zero_count_array;
+                    tmp_zero_count_array.resize(len);
+                    for (uint64_t i = 0; i < len; i++)
+                    {
+                        tmp_zero_count_array[i] = right_node.access_zero_count_deque(i);
+                    }
+                    int64_t zero_count_delta = std::accumulate(tmp_zero_count_array.begin(), tmp_zero_count_array.end(), (uint64_t)0);
+                    right_node.pop_front_many_on_zero_count_deque(len);
+                    left_node.push_back_many_on_zero_count_deque(tmp_zero_count_array);
+
+                    if (parent != nullptr)
+                    {
+                        parent->decrement_on_zero_count_deque(parent_edge_index, zero_count_delta);
+                        parent->increment_on_zero_count_deque(parent_edge_index - 1, zero_count_delta);
+                    }
+                }
+
                 stool::SimpleDeque16<InternalNode *> &left_children = left_node.get_children();
                 stool::SimpleDeque16<InternalNode *> &right_children = right_node.get_children();
 
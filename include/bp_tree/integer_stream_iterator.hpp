@@ -0,0 +1,160 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include <iterator>
+#include <cstdint>
+#include <stdexcept>
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief An input iterator reading unsigned 64-bit integers from a stream one by one.
+         * @details Two encodings are supported:
+         *          @li RAW_UINT64: each value is stored as 8 bytes in the native byte order.
+         *          @li VARINT: each value is stored in the LEB128 format (7 bits per byte, the highest bit marks continuation).
+         *
+         *          This iterator is used to build BPTree-based structures without materializing the input sequence.
+         * \ingroup BPTreeClasses
+         */
+        class IntegerStreamIterator
+        {
+        public:
+            enum class Format
+            {
+                RAW_UINT64,
+                VARINT
+            };
+
+            using iterator_category = std::input_iterator_tag;
+            using value_type = uint64_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const uint64_t *;
+            using reference = const uint64_t &;
+
+        private:
+            std::istream *is = nullptr;
+            Format format = Format::RAW_UINT64;
+            uint64_t current_value = 0;
+
+            void read_next()
+            {
+                if (this->format == Format::RAW_UINT64)
+                {
+                    uint64_t value = 0;
+                    this->is->read((char *)(&value), sizeof(uint64_t));
+                    if (this->is->gcount() == 0)
+                    {
+                        this->is = nullptr;
+                    }
+                    else if (this->is->gcount() != sizeof(uint64_t))
+                    {
+                        throw std::runtime_error("Error: IntegerStreamIterator. The stream ended in the middle of a 64-bit value.");
+                    }
+                    else
+                    {
+                        this->current_value = value;
+                    }
+                }
+                else
+                {
+                    uint64_t value = 0;
+                    uint64_t shift = 0;
+                    bool is_first_byte = true;
+                    while (true)
+                    {
+                        int c = this->is->get();
+                        if (c == std::char_traits<char>::eof())
+                        {
+                            if (is_first_byte)
+                            {
+                                this->is = nullptr;
+                                return;
+                            }
+                            else
+                            {
+                                throw std::runtime_error("Error: IntegerStreamIterator. The stream ended in the middle of a varint.");
+                            }
+                        }
+                        // The 10th byte holds bit 63 only, so its payload must be 0 or 1.
+                        if (shift >= 64 || (shift == 63 && (c & 0x7F) > 1))
+                        {
+                            throw std::runtime_error("Error: IntegerStreamIterator. A varint is longer than 64 bits.");
+                        }
+                        value |= ((uint64_t)(c & 0x7F)) << shift;
+                        shift += 7;
+                        is_first_byte = false;
+                        if ((c & 0x80) == 0)
+                        {
+                            break;
+                        }
+                    }
+                    this->current_value = value;
+                }
+            }
+
+        public:
+            /**
+             * @brief Construct the end iterator.
+             */
+            IntegerStreamIterator()
+            {
+            }
+
+            /**
+             * @brief Construct an iterator reading the values in a given stream \p _is encoded in a given format \p _format.
+             */
+            IntegerStreamIterator(std::istream &_is, Format _format) : is(&_is), format(_format)
+            {
+                this->read_next();
+            }
+
+            const uint64_t &operator*() const
+            {
+                return this->current_value;
+            }
+
+            IntegerStreamIterator &operator++()
+            {
+                this->read_next();
+                return *this;
+            }
+
+            bool is_end() const
+            {
+                return this->is == nullptr;
+            }
+
+            bool operator==(const IntegerStreamIterator &other) const
+            {
+                return this->is == other.is;
+            }
+
+            bool operator!=(const IntegerStreamIterator &other) const
+            {
+                return this->is != other.is;
+            }
+
+            /**
+             * @brief Write a given value \p value to a stream \p os in a given format \p format.
+             */
+            static void write(std::ostream &os, uint64_t value, Format format)
+            {
+                if (format == Format::RAW_UINT64)
+                {
+                    os.write((const char *)(&value), sizeof(uint64_t));
+                }
+                else
+                {
+                    while (value >= 0x80)
+                    {
+                        os.put((char)((value & 0x7F) | 0x80));
+                        value >>= 7;
+                    }
+                    os.put((char)value);
+                }
+            }
+        };
+    }
+}
@@ -8,12 +8,26 @@
 #include "./sequence/bit_container.hpp"
 #include "./sequence/bit_forward_iterator.hpp"
 #include "./sequence/bit_deque_container.hpp"
+#include "./sequence/run_length_bit_container.hpp"
+#include "./sequence/gap_bit_container.hpp"
+#include "./sequence/frozen_bit_sequence.hpp"
 #include "stool/include/all.hpp"
 namespace stool
 {
     namespace bptree
     {
 
+        /**
+         * @brief Bitwise operations supported by DynamicBitSequence::combine_into
+         * \ingroup BitClasses
+         */
+        enum class BitwiseOperation
+        {
+            AND,
+            OR,
+            XOR
+        };
+
         /**
          * @brief A dynamic data structure supporting rank and select queries on a bit sequence B[0..n-1]
          * \ingroup BitClasses
@@ -144,6 +158,17 @@ namespace stool
             {
                 return this->tree.get_value_density();
             }
+            /**
+             * @brief Call \p func(leaf) for the LEAF CONTAINER of each leaf from left to right
+             */
+            template <typename FUNC>
+            void for_each_leaf_container(FUNC func) const
+            {
+                for (auto it = this->tree.get_leaf_forward_iterator_begin(); !it.is_end(); ++it)
+                {
+                    func(this->tree.get_leaf_container(*it));
+                }
+            }
 
             //@}
 
@@ -152,17 +177,14 @@ namespace stool
             ////////////////////////////////////////////////////////////////////////////////
             //@{
             /**
-             * @brief Return \p B as a packed vector of uint64_t (i.e., the length of the vector is |B| / 64).
+             * @brief Return \p B as a packed vector of uint64_t (i.e., the length of the vector is ceil(|B| / 64)).
+             * @details The i-th bit of \p B is stored in the (63 - i % 64)-th bit of the (i / 64)-th word, and the unused bits of the last word are 0.
+             * @note O(n / 64 + log n) time
              */
             std::vector<uint64_t> to_packed_vector() const
             {
-                auto vec = this->tree.to_value_vector();
                 std::vector<uint64_t> r;
-                r.resize(vec.size());
-                for (uint64_t i = 0; i < vec.size(); i++)
-                {
-                    r[i] = vec[i];
-                }
+                this->extract_words(0, this->size(), r);
                 return r;
             }
 
@@ -172,12 +194,11 @@ namespace stool
             std::string to_string() const
             {
                 std::string s;
-                std::vector<uint64_t> bits = this->to_packed_vector();
+                std::vector<bool> bits = this->to_vector();
                 s.push_back('[');
                 for (uint64_t i = 0; i < bits.size(); i++)
                 {
-                    s.push_back(bits[i] >= 1 ? '1' : '0');
-                    // assert(bits[i] == this->at(i));
+                    s.push_back(bits[i] ? '1' : '0');
                 }
                 s.push_back(']');
                 return s;
@@ -189,31 +210,74 @@ namespace stool
             std::vector<bool> to_vector() const
             {
                 uint64_t _size = this->size();
+                std::vector<uint64_t> words = this->to_packed_vector();
                 std::vector<bool> r;
                 r.resize(_size, false);
-                uint64_t counter = 0;
-
-                auto _end = this->get_leaf_forward_iterator_end();
+                for (uint64_t i = 0; i < _size; i++)
+                {
+                    r[i] = PackedBitFunctions::get_bit(words.data(), i);
+                }
+                return r;
+            }
 
-                BitForwardIterator<CONTAINER, CONTAINER_ITERATOR, MAX_TREE_DEGREE, MAX_BIT_CONTAINER_SIZE> it = this->get_bit_forward_iterator_begin();
-                while (!it.is_end())
+            /**
+             * @brief Write the bits \p B[i..i+len-1] to \p output[0..ceil(len / 64)-1] packed in 64-bit words.
+             * @details The j-th bit of the range is stored in the (63 - j % 64)-th bit of \p output[j / 64], and the unused bits of the last word are set to 0.
+             * @note O(len / 64 + log n) time
+             */
+            void extract_words(uint64_t i, uint64_t len, uint64_t *output) const
+            {
+                if (i + len > this->size())
                 {
-                    uint64_t bits = *it;
-                    uint64_t i = 0;
+                    throw std::range_error("Error: DynamicBitSequence::extract_words()");
+                }
+                std::fill(output, output + PackedBitFunctions::get_word_size(len), 0);
+                this->tree.extract_words(i, len, output);
+            }
 
-                    while (i < 64 && counter < _size)
-                    {
-                        bool b = stool::MSBByte::get_bit(bits, i);
-                        r[counter] = b;
+            /**
+             * @brief Write the bits \p B[i..i+len-1] to \p output packed in 64-bit words (\p output is resized to ceil(len / 64)).
+             * @note O(len / 64 + log n) time
+             */
+            void extract_words(uint64_t i, uint64_t len, std::vector<uint64_t> &output) const
+            {
+                output.resize(PackedBitFunctions::get_word_size(len));
+                this->extract_words(i, len, output.data());
+            }
+
+            /**
+             * @brief Return a static copy of \p B supporting O(1) rank and O(log (n / 512))-time select queries (see FrozenBitSequence::thaw for the inverse).
+             * @details The leaves are copied into one packed array by \p thread_count threads, each of which extracts a range of \p B starting at a multiple of 64,
+             *          and the rank directory of the copy is also built by \p thread_count threads.
+             * @note O(n / (64 * thread_count) + n / 512 + thread_count log n) time
+             */
+            FrozenBitSequence freeze(uint64_t thread_count = 1) const
+            {
+                uint64_t _size = this->size();
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(_size), 0);
 
-                        counter++;
-                        i++;
+                thread_count = std::max<uint64_t>(1, thread_count);
+                uint64_t range_size = ((words.size() + thread_count - 1) / thread_count) * 64;
+                if (thread_count == 1 || range_size >= _size)
+                {
+                    this->tree.extract_words(0, _size, words.data());
+                }
+                else
+                {
+                    std::vector<std::thread> threads;
+                    for (uint64_t i = 0; i < _size; i += range_size)
+                    {
+                        uint64_t len = std::min<uint64_t>(range_size, _size - i);
+                        threads.emplace_back([this, &words, i, len]()
+                                             { this->tree.extract_words(i, len, words.data() + (i / 64)); });
+                    }
+                    for (std::thread &th : threads)
+                    {
+                        th.join();
                     }
-                    ++it;
                 }
-
-                assert(counter == _size);
-                return r;
+                return FrozenBitSequence(std::move(words), _size, thread_count);
             }
             //@}
 
@@ -385,6 +449,178 @@ namespace stool
                 return this->zero_based_select(i, c);
             }
 
+            /**
+             * @brief Returns the number of 1 in \p B[i..j-1].
+             * @details This is equivalent to rank1(j) - rank1(i), but it traverses the tree once.
+             * @note O(log n) time
+             */
+            uint64_t count1(uint64_t i, uint64_t j) const
+            {
+                if (i > j || j > this->size())
+                {
+                    throw std::range_error("Error: DynamicBitSequence::count1()");
+                }
+                return i == j ? 0 : this->tree.psum(i, j - 1);
+            }
+
+            /**
+             * @brief Returns the number of 0 in \p B[i..j-1].
+             * @note O(log n) time
+             */
+            uint64_t count0(uint64_t i, uint64_t j) const
+            {
+                return (j - i) - this->count1(i, j);
+            }
+
+            /**
+             * @brief Returns the smallest position q >= \p p such that \p B[q] = 1 if it exists, otherwise returns -1
+             * @details The query stays in the leaf containing \p B[p] if the answer is there, so it is faster than select1(rank1(p)).
+             * @note O(log n) time
+             */
+            int64_t next1(uint64_t p) const
+            {
+                return this->tree.next_bit(p, true);
+            }
+
+            /**
+             * @brief Returns the smallest position q >= \p p such that \p B[q] = 0 if it exists, otherwise returns -1
+             * @note O(log n) time
+             */
+            int64_t next0(uint64_t p) const
+            {
+                return this->tree.next_bit(p, false);
+            }
+
+            /**
+             * @brief Returns the largest position q < \p p such that \p B[q] = 1 if it exists, otherwise returns -1
+             * @note O(log n) time
+             */
+            int64_t prev1(uint64_t p) const
+            {
+                if (p > this->size())
+                {
+                    throw std::range_error("Error: DynamicBitSequence::prev1()");
+                }
+                return this->tree.prev_bit(p, true);
+            }
+
+            /**
+             * @brief Returns the largest position q < \p p such that \p B[q] = 0 if it exists, otherwise returns -1
+             * @note O(log n) time
+             */
+            int64_t prev0(uint64_t p) const
+            {
+                if (p > this->size())
+                {
+                    throw std::range_error("Error: DynamicBitSequence::prev0()");
+                }
+                return this->tree.prev_bit(p, false);
+            }
+
+            /**
+             * @brief Returns the vector R such that R[k] = rank1(P[k]) for a given sorted sequence of positions \p P.
+             * @details The queries share one traversal of the internal tree, which is faster than calling rank1 |P| times.
+             * @note O(|P| + m log n) time, where m is the number of distinct leaves touched by the queries
+             */
+            std::vector<uint64_t> rank1_many(const std::vector<uint64_t> &sorted_positions_P) const
+            {
+                uint64_t _size = this->size();
+                uint64_t zero_count = 0;
+                while (zero_count < sorted_positions_P.size() && sorted_positions_P[zero_count] == 0)
+                {
+                    zero_count++;
+                }
+
+                std::vector<uint64_t> positions;
+                positions.resize(sorted_positions_P.size() - zero_count);
+                for (uint64_t k = zero_count; k < sorted_positions_P.size(); k++)
+                {
+                    if (sorted_positions_P[k] > _size)
+                    {
+                        throw std::range_error("Error: DynamicBitSequence::rank1_many()");
+                    }
+                    positions[k - zero_count] = sorted_positions_P[k] - 1;
+                }
+
+                std::vector<uint64_t> psums = this->tree.psum_many(positions);
+                std::vector<uint64_t> r;
+                r.resize(sorted_positions_P.size(), 0);
+                for (uint64_t k = 0; k < psums.size(); k++)
+                {
+                    r[zero_count + k] = psums[k];
+                }
+                return r;
+            }
+
+            /**
+             * @brief Returns the vector R such that R[k] = select1(I[k]) for a given sorted sequence of ranks \p I.
+             * @details The queries share one traversal of the internal tree. R[k] = -1 if B contains at most I[k] 1s.
+             * @note O(|I| + m log n) time, where m is the number of distinct leaves touched by the queries
+             */
+            std::vector<int64_t> select1_many(const std::vector<uint64_t> &sorted_ranks_I) const
+            {
+                std::vector<uint64_t> sums;
+                sums.resize(sorted_ranks_I.size());
+                for (uint64_t k = 0; k < sorted_ranks_I.size(); k++)
+                {
+                    sums[k] = sorted_ranks_I[k] + 1;
+                }
+                std::vector<int64_t> r = this->tree.search_many(sums);
+                int64_t _size = this->size();
+                for (int64_t &p : r)
+                {
+                    if (p >= _size)
+                    {
+                        p = -1;
+                    }
+                }
+                return r;
+            }
+
+            /**
+             * @brief A cursor on the leaf containing the answer of the last select_with_cursor query.
+             */
+            struct LeafCursor
+            {
+                // the index of the leaf container, or -1 if the cursor is not placed
+                int64_t leaf_index = -1;
+                // the position of the first bit of the leaf in B
+                uint64_t leaf_start = 0;
+                // the number of 1 in B[0..leaf_start-1]
+                uint64_t ones_before = 0;
+                std::vector<typename Tree::NodePointer> path;
+            };
+
+            /**
+             * @brief Returns select(i, c), answering it inside the leaf of \p cursor if the (i+1)-th \p c is in that leaf.
+             * @details Otherwise, the query descends from the root, and \p cursor is moved to the leaf containing the answer.
+             *          The cursor is invalidated by update operations.
+             * @note One select query on a leaf if the answer is in the leaf of \p cursor, otherwise O(log n) time
+             */
+            int64_t select_with_cursor(uint64_t i, bool c, LeafCursor &cursor) const
+            {
+                if (cursor.leaf_index != -1)
+                {
+                    const CONTAINER &leaf = this->tree.get_leaf_container(cursor.leaf_index);
+                    uint64_t before = c ? cursor.ones_before : cursor.leaf_start - cursor.ones_before;
+                    uint64_t leaf_ones = leaf.psum();
+                    uint64_t count = c ? leaf_ones : leaf.size() - leaf_ones;
+                    if (i >= before && i - before < count)
+                    {
+                        int64_t offset = c ? leaf.search(i - before + 1) : leaf.select0(i - before);
+                        return cursor.leaf_start + offset;
+                    }
+                }
+                int64_t p = this->select(i, c);
+                if (p != -1)
+                {
+                    int64_t offset = this->tree.compute_path_from_root_to_leaf(p, cursor.path);
+                    cursor.leaf_index = cursor.path[cursor.path.size() - 1].get_leaf_container_index();
+                    cursor.leaf_start = p - offset;
+                    cursor.ones_before = this->one_based_rank1(cursor.leaf_start);
+                }
+                return p;
+            }
 
             /**
              * @brief Return the number of 1 in \p B[0..n-1]
@@ -466,6 +702,78 @@ namespace stool
 
             //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Bitwise operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the number of 1s in \p B AND \p other
+             * @details The leaves of both sequences are scanned in lockstep with 64-bit word operations, without building the result.
+             * @note O(n / 64) time. \p other must have the same length as \p B.
+             */
+            uint64_t and_count(const DynamicBitSequence &other) const
+            {
+                uint64_t count = 0;
+                this->for_each_word_pair(other, [&](uint64_t x, uint64_t y, uint64_t)
+                                         { count += __builtin_popcountll(x & y); });
+                return count;
+            }
+
+            /**
+             * @brief Return the number of 1s in \p B OR \p other
+             * @note O(n / 64) time. \p other must have the same length as \p B.
+             */
+            uint64_t or_count(const DynamicBitSequence &other) const
+            {
+                uint64_t count = 0;
+                this->for_each_word_pair(other, [&](uint64_t x, uint64_t y, uint64_t)
+                                         { count += __builtin_popcountll(x | y); });
+                return count;
+            }
+
+            /**
+             * @brief Return the number of 1s in \p B XOR \p other (i.e., the Hamming distance between \p B and \p other)
+             * @note O(n / 64) time. \p other must have the same length as \p B.
+             */
+            uint64_t xor_count(const DynamicBitSequence &other) const
+            {
+                uint64_t count = 0;
+                this->for_each_word_pair(other, [&](uint64_t x, uint64_t y, uint64_t)
+                                         { count += __builtin_popcountll(x ^ y); });
+                return count;
+            }
+
+            /**
+             * @brief Replace \p out with \p B op \p other, where op is AND, OR, or XOR
+             * @details The result is packed into a word buffer and appended to \p out by append_words. \p out may be \p B or \p other.
+             * @note O(n / 64 + (n / b) log n) time, where b is the maximal number of bits in a leaf. \p other must have the same length as \p B.
+             */
+            void combine_into(BitwiseOperation op, const DynamicBitSequence &other, DynamicBitSequence &out) const
+            {
+                static constexpr uint64_t BUFFER_BIT_SIZE = 64 * 1024;
+                DynamicBitSequence result;
+                std::vector<uint64_t> buffer;
+                buffer.resize(BUFFER_BIT_SIZE / 64, 0);
+                uint64_t buffer_size = 0;
+                this->for_each_word_pair(other, [&](uint64_t x, uint64_t y, uint64_t len)
+                                         {
+                    uint64_t z = op == BitwiseOperation::AND ? (x & y) : (op == BitwiseOperation::OR ? (x | y) : (x ^ y));
+                    if (buffer_size + len > BUFFER_BIT_SIZE)
+                    {
+                        result.append_words(buffer.data(), buffer_size);
+                        buffer_size = 0;
+                    }
+                    PackedBitFunctions::write_bits(buffer.data(), buffer_size, z, len);
+                    buffer_size += len; });
+                if (buffer_size > 0)
+                {
+                    result.append_words(buffer.data(), buffer_size);
+                }
+                out.swap(result);
+            }
+            //@}
+
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Update operations
             ////////////////////////////////////////////////////////////////////////////////
@@ -508,7 +816,62 @@ namespace stool
              */
             void push_many(const std::vector<bool> &items_Q)
             {
-                this->tree.push_many(items_Q);
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(items_Q.size()), 0);
+                for (uint64_t i = 0; i < items_Q.size(); i++)
+                {
+                    if (items_Q[i])
+                    {
+                        words[i / 64] |= 1ULL << (63 - (i % 64));
+                    }
+                }
+                this->append_words(words.data(), items_Q.size());
+            }
+
+            /**
+             * @brief Add the bits \p Q[0..len-1] packed in 64-bit words \p words to the end of \p B (see extract_words for the bit order).
+             * @details The bits are copied into each leaf word by word instead of bit by bit.
+             * @note O(len / 64 + (len / b) log n) time, where b is the maximal number of bits in a leaf
+             */
+            void append_words(const uint64_t *words, uint64_t len)
+            {
+                this->tree.push_back_words(words, len);
+            }
+
+            /**
+             * @brief Insert the bits \p Q[0..len-1] packed in 64-bit words \p words at the position \p p in \p B (see extract_words for the bit order).
+             * @details The bits are copied into each touched leaf word by word instead of bit by bit.
+             * @note O(len / 64 + (len / b + 1)(b / 64 + log n)) time, where b is the maximal number of bits in a leaf
+             */
+            void insert_words(uint64_t p, const uint64_t *words, uint64_t len)
+            {
+                if (p > this->size())
+                {
+                    throw std::range_error("Error: DynamicBitSequence::insert_words()");
+                }
+                this->tree.insert_words(p, words, len);
+            }
+
+            /**
+             * @brief Insert \p len copies of a bit \p v at the position \p p in \p B.
+             * @details The bits are inserted by insert_words in blocks of at most b bits read from one buffer of b bits, so no buffer of \p len bits is materialized.
+             * @note O(len / 64 + (len / b + 1)(b / 64 + log n)) time, where b is the maximal number of bits in a leaf
+             */
+            void insert_run(uint64_t p, bool v, uint64_t len)
+            {
+                if (p > this->size())
+                {
+                    throw std::range_error("Error: DynamicBitSequence::insert_run()");
+                }
+                std::array<uint64_t, (MAX_BIT_CONTAINER_SIZE + 63) / 64> words;
+                words.fill(v ? UINT64_MAX : 0);
+                uint64_t k = 0;
+                while (k < len)
+                {
+                    uint64_t x = std::min<uint64_t>(len - k, MAX_BIT_CONTAINER_SIZE);
+                    this->tree.insert_words(p + k, words.data(), x);
+                    k += x;
+                }
             }
 
             /**
@@ -759,6 +1122,70 @@ namespace stool
                 return s;
             }
             //@}
+
+        private:
+            /**
+             * @brief Call \p func(x, y, len) for consecutive blocks of \p B and \p other, where x and y store the next len (<= 64) bits of each sequence in their highest bits and the other bits are 0.
+             * @details Each leaf is copied into a word buffer once. A block is shorter than 64 bits only if it ends at a leaf boundary of either sequence, so unaligned leaves are combined by shifts.
+             */
+            template <typename FUNC>
+            void for_each_word_pair(const DynamicBitSequence &other, FUNC func) const
+            {
+                uint64_t _size = this->size();
+                if (_size != other.size())
+                {
+                    throw std::invalid_argument("Error: DynamicBitSequence::for_each_word_pair(). The two sequences have different lengths.");
+                }
+
+                auto it1 = this->tree.get_leaf_forward_iterator_begin();
+                auto it2 = other.tree.get_leaf_forward_iterator_begin();
+                std::vector<uint64_t> buffer1, buffer2;
+                buffer1.resize(PackedBitFunctions::get_word_size(MAX_BIT_CONTAINER_SIZE * 2), 0);
+                buffer2.resize(PackedBitFunctions::get_word_size(MAX_BIT_CONTAINER_SIZE * 2), 0);
+                uint64_t pos1 = 0, size1 = 0, pos2 = 0, size2 = 0;
+
+                uint64_t processed = 0;
+                while (processed < _size)
+                {
+                    while (pos1 == size1)
+                    {
+                        size1 = load_leaf_words(this->tree, it1, buffer1);
+                        pos1 = 0;
+                    }
+                    while (pos2 == size2)
+                    {
+                        size2 = load_leaf_words(other.tree, it2, buffer2);
+                        pos2 = 0;
+                    }
+                    uint64_t len = std::min<uint64_t>(64, std::min<uint64_t>(size1 - pos1, size2 - pos2));
+                    uint64_t mask = len == 64 ? UINT64_MAX : (UINT64_MAX << (64 - len));
+                    uint64_t x = PackedBitFunctions::read_64bits(buffer1.data(), pos1, size1) & mask;
+                    uint64_t y = PackedBitFunctions::read_64bits(buffer2.data(), pos2, size2) & mask;
+                    func(x, y, len);
+                    pos1 += len;
+                    pos2 += len;
+                    processed += len;
+                }
+            }
+
+            /**
+             * @brief Copy the leaf pointed by \p it to \p buffer, move \p it to the next leaf, and return the number of bits in the leaf.
+             */
+            template <typename LEAF_ITERATOR>
+            static uint64_t load_leaf_words(const Tree &_tree, LEAF_ITERATOR &it, std::vector<uint64_t> &buffer)
+            {
+                assert(!it.is_end());
+                const CONTAINER &leaf = _tree.get_leaf_container(*it);
+                uint64_t leaf_size = leaf.size();
+                uint64_t word_size = PackedBitFunctions::get_word_size(leaf_size);
+                if (word_size > buffer.size())
+                {
+                    buffer.resize(word_size);
+                }
+                leaf.extract_words(0, leaf_size, buffer.data(), 0);
+                ++it;
+                return leaf_size;
+            }
         };
 
         using BDC = typename stool::bptree::BitVectorContainer<10000ULL>;
@@ -767,6 +1194,20 @@ namespace stool
         // using SimpleDynamicBitSequence = DynamicBitSequence<BDC, BDC::BitVectorContainerIterator, 62, 8192>;
         using SimpleDynamicBitSequence = DynamicBitSequence<BDC, BDC::BitVectorContainerIterator, 62, 8192>;
 
+        using RLBC = typename stool::bptree::RunLengthBitContainer<10000ULL>;
+        /**
+         * @brief A dynamic bit sequence whose leaves store runs of equal bits (and raw bits if the runs are fragmented)
+         * \ingroup BitClasses
+         */
+        using DynamicRunLengthBitSequence = DynamicBitSequence<RLBC, RLBC::RunLengthBitContainerIterator, bptree::DEFAULT_MAX_DEGREE_OF_INTERNAL_NODE, 8192>;
+
+        using GBC = typename stool::bptree::GapBitContainer<10000ULL>;
+        /**
+         * @brief A dynamic bit sequence whose leaves are gap buffers, for workloads that insert and delete bits near the previous edit
+         * \ingroup BitClasses
+         */
+        using DynamicGapBitSequence = DynamicBitSequence<GBC, GBC::GapBitContainerIterator, bptree::DEFAULT_MAX_DEGREE_OF_INTERNAL_NODE, 8192>;
+
         /*
         using DynamicBitDequeSequenceA = DynamicBitSequence<BDC, BDC::BitVectorContainerIterator, 62, 512>;
         using DynamicBitDequeSequenceB = DynamicBitSequence<BDC, BDC::BitVectorContainerIterator, 62, 1024>;
@@ -0,0 +1,505 @@
+#pragma once
+#include "./dynamic_wavelet_tree.hpp"
+#include "./dynamic_sequence64.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief A dynamic FM-index of a collection of documents D_0, D_1, ..., each of which is a string over an alphabet \p U not containing 0
+         * @details The BWT \p L of the collection is stored in a DynamicWaveletTree over U ∪ {$}, where $ = 0 terminates each document.
+         *          The rows of the BWT matrix beginning with $ are ordered by the order in which the documents were inserted,
+         *          so a document can be inserted or removed by inserting or removing one character of \p L per character of the document (and no other row moves).
+         *          The suffix array is sampled by document offsets (the rows of the suffixes starting at offsets divisible by the sampling interval \p s are marked),
+         *          and each sample stores a pair (document ID, offset), which is not changed by updates of other documents.
+         * \ingroup WaveletTreeClasses
+         * \ingroup MainClasses
+         */
+        class DynamicFMIndex
+        {
+        public:
+            /**
+             * @brief The character terminating each document
+             */
+            static inline constexpr uint8_t END_MARKER = 0;
+            static inline constexpr uint64_t REMOVED_DOCUMENT = UINT64_MAX;
+
+        private:
+            DynamicWaveletTree bwt;
+            // c_array[c] is the number of rows beginning with a character smaller than c
+            std::vector<uint64_t> c_array;
+            SimpleDynamicBitSequence sampled_rows;
+            SimpleDynamicSequence64 sampled_document_ids;
+            SimpleDynamicSequence64 sampled_offsets;
+            // document_ids[r] is the ID of the document whose $ is the first character of the r-th row
+            std::vector<uint64_t> document_ids;
+            // document_lengths[d] is the length of D_d (REMOVED_DOCUMENT if D_d has been removed)
+            std::vector<uint64_t> document_lengths;
+            uint64_t sampling_interval = 32;
+
+        public:
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Constructor with no document, the alphabet \p _alphabet, and the sampling interval \p _sampling_interval of the suffix array
+             */
+            DynamicFMIndex(const std::vector<uint8_t> &_alphabet, uint64_t _sampling_interval = 32)
+            {
+                this->set_alphabet(_alphabet, _sampling_interval);
+            }
+
+            /**
+             * @brief Deleted copy constructor.
+             */
+            DynamicFMIndex(const DynamicFMIndex &) = delete;
+
+            /**
+             * @brief Default move constructor.
+             */
+            DynamicFMIndex(DynamicFMIndex &&) noexcept = default;
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Deleted copy assignment operator.
+             */
+            DynamicFMIndex &operator=(const DynamicFMIndex &) = delete;
+
+            /**
+             * @brief Default move assignment operator.
+             */
+            DynamicFMIndex &operator=(DynamicFMIndex &&) noexcept = default;
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Lightweight functions for accessing to properties of this class
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the length of the BWT \p L, i.e., the total length of the documents plus the number of documents
+             */
+            uint64_t size() const
+            {
+                return this->bwt.size();
+            }
+
+            /**
+             * @brief Return the number of documents
+             */
+            uint64_t document_count() const
+            {
+                return this->document_ids.size();
+            }
+
+            /**
+             * @brief Return true if the document with ID \p document_id exists
+             */
+            bool has_document(uint64_t document_id) const
+            {
+                return document_id < this->document_lengths.size() && this->document_lengths[document_id] != REMOVED_DOCUMENT;
+            }
+
+            /**
+             * @brief Return the length of the document with ID \p document_id
+             */
+            uint64_t get_document_length(uint64_t document_id) const
+            {
+                if (!this->has_document(document_id))
+                {
+                    throw std::invalid_argument("Error: DynamicFMIndex::get_document_length(). The document does not exist.");
+                }
+                return this->document_lengths[document_id];
+            }
+
+            /**
+             * @brief Return the sampling interval of the suffix array
+             */
+            uint64_t get_sampling_interval() const
+            {
+                return this->sampling_interval;
+            }
+
+            /**
+             * @brief Return the BWT \p L as a DynamicWaveletTree
+             */
+            const DynamicWaveletTree &get_bwt() const
+            {
+                return this->bwt;
+            }
+
+            /**
+             * @brief Return the memory usage in bytes
+             * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
+             */
+            uint64_t size_in_bytes(bool only_dynamic_memory = false) const
+            {
+                uint64_t bytes = this->bwt.size_in_bytes(only_dynamic_memory) + this->sampled_rows.size_in_bytes(only_dynamic_memory);
+                bytes += this->sampled_document_ids.size_in_bytes(only_dynamic_memory) + this->sampled_offsets.size_in_bytes(only_dynamic_memory);
+                bytes += (this->c_array.capacity() + this->document_ids.capacity() + this->document_lengths.capacity()) * sizeof(uint64_t);
+                if (only_dynamic_memory)
+                {
+                    return bytes;
+                }
+                else
+                {
+                    return bytes + sizeof(this->sampling_interval);
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Main queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the row of the BWT matrix obtained by removing the last character from the i-th row and prepending it to the row, i.e., C[L[i]] + rank(L[0..i-1], L[i])
+             * @details If L[i] = $, the returned row begins with $ but may belong to another document, since the rows beginning with $ are ordered by insertion.
+             * @note O(log σ log n) time
+             */
+            uint64_t lf(uint64_t i) const
+            {
+                uint8_t c = this->bwt.at(i);
+                return this->c_array[c] + this->bwt.one_based_rank(i, c);
+            }
+
+            /**
+             * @brief Return the range [b, e) of the rows of the BWT matrix prefixed by \p pattern
+             * @note O(|pattern| log σ log n) time
+             */
+            std::pair<uint64_t, uint64_t> backward_search(const std::vector<uint8_t> &pattern) const
+            {
+                uint64_t b = 0;
+                uint64_t e = this->size();
+                for (int64_t k = (int64_t)pattern.size() - 1; k >= 0 && b < e; k--)
+                {
+                    uint8_t c = pattern[k];
+                    if (c == END_MARKER || this->bwt.get_lexicographic_order(c) == -1)
+                    {
+                        return std::pair<uint64_t, uint64_t>(0, 0);
+                    }
+                    b = this->c_array[c] + this->bwt.one_based_rank(b, c);
+                    e = this->c_array[c] + this->bwt.one_based_rank(e, c);
+                }
+                if (b >= e)
+                {
+                    return std::pair<uint64_t, uint64_t>(0, 0);
+                }
+                return std::pair<uint64_t, uint64_t>(b, e);
+            }
+
+            /**
+             * @brief Return the number of occurrences of \p pattern in the documents
+             * @note O(|pattern| log σ log n) time
+             */
+            uint64_t count(const std::vector<uint8_t> &pattern) const
+            {
+                auto [b, e] = this->backward_search(pattern);
+                return e - b;
+            }
+
+            /**
+             * @brief Return the pair (document ID, offset) of the suffix of the i-th row of the BWT matrix
+             * @note O(s log σ log n) time, where s is the sampling interval
+             */
+            std::pair<uint64_t, uint64_t> locate_row(uint64_t i) const
+            {
+                if (i >= this->size())
+                {
+                    throw std::range_error("Error: DynamicFMIndex::locate_row(i)");
+                }
+                uint64_t steps = 0;
+                while (!this->sampled_rows.at(i))
+                {
+                    i = this->lf(i);
+                    steps++;
+                }
+                uint64_t sample_index = this->sampled_rows.one_based_rank1(i);
+                return std::pair<uint64_t, uint64_t>(this->sampled_document_ids.at(sample_index), this->sampled_offsets.at(sample_index) + steps);
+            }
+
+            /**
+             * @brief Return the occurrences of \p pattern in the documents as pairs (document ID, offset) sorted in the order of the BWT matrix
+             * @note O(|pattern| log σ log n + occ s log σ log n) time, where occ is the number of occurrences
+             */
+            std::vector<std::pair<uint64_t, uint64_t>> locate(const std::vector<uint8_t> &pattern) const
+            {
+                std::vector<std::pair<uint64_t, uint64_t>> r;
+                auto [b, e] = this->backward_search(pattern);
+                for (uint64_t i = b; i < e; i++)
+                {
+                    r.push_back(this->locate_row(i));
+                }
+                return r;
+            }
+
+            /**
+             * @brief Return the document with ID \p document_id
+             * @note O(m log σ log n + log d) time, where m is the length of the document and d is the number of documents
+             */
+            std::vector<uint8_t> get_document(uint64_t document_id) const
+            {
+                uint64_t m = this->get_document_length(document_id);
+                std::vector<uint8_t> r;
+                r.resize(m);
+                uint64_t row = this->get_end_marker_row(document_id);
+                for (uint64_t k = m; k > 0; k--)
+                {
+                    r[k - 1] = this->bwt.at(row);
+                    row = this->lf(row);
+                }
+                return r;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Initialize this instance with no document, the alphabet \p _alphabet, and the sampling interval \p _sampling_interval
+             */
+            void set_alphabet(const std::vector<uint8_t> &_alphabet, uint64_t _sampling_interval = 32)
+            {
+                if (_sampling_interval == 0)
+                {
+                    throw std::invalid_argument("Error: DynamicFMIndex::set_alphabet(). The sampling interval must be positive.");
+                }
+                std::vector<uint8_t> alphabet_with_end_marker;
+                alphabet_with_end_marker.push_back(END_MARKER);
+                for (uint8_t c : _alphabet)
+                {
+                    if (c == END_MARKER)
+                    {
+                        throw std::invalid_argument("Error: DynamicFMIndex::set_alphabet(). The alphabet must not contain the end marker 0.");
+                    }
+                    alphabet_with_end_marker.push_back(c);
+                }
+                DynamicWaveletTree tmp(alphabet_with_end_marker);
+                this->bwt.swap(tmp);
+                this->c_array.clear();
+                this->c_array.resize(257, 0);
+                this->sampled_rows.clear();
+                this->sampled_document_ids.clear();
+                this->sampled_offsets.clear();
+                this->document_ids.clear();
+                this->document_lengths.clear();
+                this->sampling_interval = _sampling_interval;
+            }
+
+            /**
+             * @brief Insert \p text into the collection as a new document and return its ID
+             * @details The rows of the suffixes of \p text$ are inserted from the shortest one, and the row of each suffix is given by the LF-mapping of the row inserted just before.
+             * @note O(m log σ log n + σ m) time, where m = |text|
+             */
+            uint64_t insert_document(const std::vector<uint8_t> &text)
+            {
+                for (uint8_t c : text)
+                {
+                    if (c == END_MARKER || this->bwt.get_lexicographic_order(c) == -1)
+                    {
+                        throw std::invalid_argument("Error: DynamicFMIndex::insert_document(). The text contains a character not in the alphabet.");
+                    }
+                }
+                uint64_t document_id = this->document_lengths.size();
+                uint64_t m = text.size();
+
+                uint64_t row = this->document_ids.size();
+                this->insert_row(row, END_MARKER, m > 0 ? text[m - 1] : END_MARKER, document_id, m);
+                this->document_ids.push_back(document_id);
+                for (int64_t k = (int64_t)m - 1; k >= 0; k--)
+                {
+                    uint8_t c = text[k];
+                    row = this->c_array[c] + this->bwt.one_based_rank(row, c);
+                    this->insert_row(row, c, k > 0 ? text[k - 1] : END_MARKER, document_id, k);
+                }
+                this->document_lengths.push_back(m);
+                return document_id;
+            }
+
+            /**
+             * @brief Remove the document with ID \p document_id from the collection
+             * @details The rows of the suffixes of the document are found by the LF-mapping from the row beginning with its $, and they are removed in decreasing order.
+             * @note O(m log σ log n + σ m + m log m + d) time, where m is the length of the document and d is the number of documents
+             */
+            void remove_document(uint64_t document_id)
+            {
+                uint64_t m = this->get_document_length(document_id);
+                uint64_t end_marker_row = this->get_end_marker_row(document_id);
+
+                // (row, the first character of the row)
+                std::vector<std::pair<uint64_t, uint8_t>> rows;
+                uint64_t row = end_marker_row;
+                rows.push_back(std::pair<uint64_t, uint8_t>(row, END_MARKER));
+                for (uint64_t k = m; k > 0; k--)
+                {
+                    uint8_t c = this->bwt.at(row);
+                    row = this->c_array[c] + this->bwt.one_based_rank(row, c);
+                    rows.push_back(std::pair<uint64_t, uint8_t>(row, c));
+                }
+                std::sort(rows.begin(), rows.end(), [](const auto &x, const auto &y)
+                          { return x.first > y.first; });
+                for (auto [r, c] : rows)
+                {
+                    this->remove_row(r, c);
+                }
+                this->document_ids.erase(this->document_ids.begin() + end_marker_row);
+                this->document_lengths[document_id] = REMOVED_DOCUMENT;
+            }
+
+            /**
+             * @brief Swap operation
+             */
+            void swap(DynamicFMIndex &item)
+            {
+                this->bwt.swap(item.bwt);
+                this->c_array.swap(item.c_array);
+                this->sampled_rows.swap(item.sampled_rows);
+                this->sampled_document_ids.swap(item.sampled_document_ids);
+                this->sampled_offsets.swap(item.sampled_offsets);
+                this->document_ids.swap(item.document_ids);
+                this->document_lengths.swap(item.document_lengths);
+                std::swap(this->sampling_interval, item.sampling_interval);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Print and verification functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the memory usage information of this data structure as a vector of strings
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            std::vector<std::string> get_memory_usage_info(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::vector<std::string> r;
+                r.push_back(stool::Message::get_paragraph_string(message_paragraph) + "=DynamicFMIndex: " + std::to_string(this->size_in_bytes()) + " bytes =");
+                for (const std::vector<std::string> &log : {this->bwt.get_memory_usage_info(message_paragraph + 1), this->sampled_rows.get_memory_usage_info(message_paragraph + 1),
+                                                           this->sampled_document_ids.get_memory_usage_info(message_paragraph + 1), this->sampled_offsets.get_memory_usage_info(message_paragraph + 1)})
+                {
+                    for (const std::string &s : log)
+                    {
+                        r.push_back(s);
+                    }
+                }
+                r.push_back(stool::Message::get_paragraph_string(message_paragraph) + "==");
+                return r;
+            }
+
+            /**
+             * @brief Print the memory usage information of this data structure
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            void print_memory_usage(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::vector<std::string> log = this->get_memory_usage_info(message_paragraph);
+                for (std::string &s : log)
+                {
+                    std::cout << s << std::endl;
+                }
+            }
+
+            /**
+             * @brief Print the statistics of this data structure
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            void print_statistics(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "Statistics(DynamicFMIndex):" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "The number of documents: " << this->document_count() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "BWT length: " << this->size() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Sampling interval: " << this->sampling_interval << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Estimated memory usage: " << this->size_in_bytes() << " bytes" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "[END]" << std::endl;
+            }
+
+            /**
+             * @brief Verify the internal consistency of this data structure
+             * @details C[c] is compared with the number of characters smaller than c in \p L, which is computed by count_c.
+             */
+            void verify() const
+            {
+                this->sampled_rows.verify();
+                uint64_t sample_count = this->sampled_rows.count1();
+                if (this->sampled_rows.size() != this->size() || this->sampled_document_ids.size() != sample_count || this->sampled_offsets.size() != sample_count)
+                {
+                    throw std::logic_error("Error: DynamicFMIndex::verify(). The sizes of the samples are inconsistent.");
+                }
+                if (this->bwt.count_c(END_MARKER) != this->document_count())
+                {
+                    throw std::logic_error("Error: DynamicFMIndex::verify(). The number of end markers is incorrect.");
+                }
+                uint64_t sum = 0;
+                for (uint64_t c = 0; c < 256; c++)
+                {
+                    if (this->c_array[c] != sum)
+                    {
+                        throw std::logic_error("Error: DynamicFMIndex::verify(). The C array is incorrect.");
+                    }
+                    sum += this->bwt.count_c(c);
+                }
+            }
+            //@}
+
+        private:
+            /**
+             * @brief Return the row beginning with the $ of the document with ID \p document_id
+             */
+            uint64_t get_end_marker_row(uint64_t document_id) const
+            {
+                if (!this->has_document(document_id))
+                {
+                    throw std::invalid_argument("Error: DynamicFMIndex::get_end_marker_row(). The document does not exist.");
+                }
+                auto it = std::lower_bound(this->document_ids.begin(), this->document_ids.end(), document_id);
+                assert(it != this->document_ids.end() && *it == document_id);
+                return it - this->document_ids.begin();
+            }
+
+            /**
+             * @brief Insert the row of the suffix starting at \p offset of the document \p document_id, whose first and last characters are \p first_char and \p last_char, at the \p row-th position
+             */
+            void insert_row(uint64_t row, uint8_t first_char, uint8_t last_char, uint64_t document_id, uint64_t offset)
+            {
+                this->bwt.insert(row, last_char);
+                for (uint64_t c = (uint64_t)first_char + 1; c < this->c_array.size(); c++)
+                {
+                    this->c_array[c]++;
+                }
+                bool is_sampled = offset % this->sampling_interval == 0;
+                this->sampled_rows.insert(row, is_sampled);
+                if (is_sampled)
+                {
+                    uint64_t sample_index = this->sampled_rows.one_based_rank1(row);
+                    this->sampled_document_ids.insert(sample_index, document_id);
+                    this->sampled_offsets.insert(sample_index, offset);
+                }
+            }
+
+            /**
+             * @brief Remove the \p row-th row, whose first character is \p first_char
+             */
+            void remove_row(uint64_t row, uint8_t first_char)
+            {
+                this->bwt.remove(row);
+                for (uint64_t c = (uint64_t)first_char + 1; c < this->c_array.size(); c++)
+                {
+                    this->c_array[c]--;
+                }
+                if (this->sampled_rows.at(row))
+                {
+                    uint64_t sample_index = this->sampled_rows.one_based_rank1(row);
+                    this->sampled_document_ids.remove(sample_index);
+                    this->sampled_offsets.remove(sample_index);
+                }
+                this->sampled_rows.remove(row);
+            }
+        };
+    }
+}
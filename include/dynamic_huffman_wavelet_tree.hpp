@@ -0,0 +1,787 @@
+#pragma once
+#include <queue>
+#include "./dynamic_bit_sequence.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief A Huffman-shaped dynamic wavelet tree supporting access, rank, and select queries on a string \p T[0..n-1] over alphabet \p U[0..σ-1]
+         * @details Each internal node stores a dynamic bit sequence, and each character \p c corresponds to the leaf whose depth is the length of the Huffman code of \p c
+         *          computed from the frequencies of the characters (plus one) when the tree was (re)built.
+         *          Hence, frequent characters have short root-to-leaf paths, and the total length of the bit sequences is n H_0 + O(n) instead of n ceil(log σ).
+         *          If the drift threshold ε > 0 is set, the weighted path length of the current shape is compared with that of the Huffman tree of the current frequencies every
+         *          max(CHECK_INTERVAL, n / 16) updates, and the tree is rebuilt if the former exceeds the latter by a factor of more than 1 + ε.
+         * \ingroup WaveletTreeClasses
+         * \ingroup MainClasses
+         */
+        class DynamicHuffmanWaveletTree
+        {
+            using BIT_SEQUENCE = SimpleDynamicBitSequence;
+
+        public:
+            static inline constexpr uint64_t CHECK_INTERVAL = 4096;
+
+        private:
+            // bits_seq[x] is the bit sequence of the x-th internal node (the 0-th node is the root)
+            std::vector<BIT_SEQUENCE> bits_seq;
+            // children[x][b] is the b-th child of the x-th internal node, where a negative value -(r+1) represents the leaf of the character with lexicographic order r
+            std::vector<std::array<int64_t, 2>> children;
+            // codes[r] is the code (i.e., the path from the root) of the character with lexicographic order r
+            std::vector<std::vector<bool>> codes;
+            std::vector<uint64_t> char_counters;
+            std::vector<int64_t> char_rank_vec;
+            std::vector<uint8_t> alphabet;
+            // The sum of the code lengths of the characters in T
+            uint64_t total_code_length = 0;
+            double drift_threshold = 0;
+            uint64_t update_counter = 0;
+            uint64_t rebuild_count = 0;
+
+        public:
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Default constructor with |T| = 0 and |U| = 0
+             */
+            DynamicHuffmanWaveletTree()
+            {
+            }
+
+            /**
+             * @brief Constructor with |T| = 0 and U = \p _alphabet (the tree is balanced until the first rebuild)
+             */
+            DynamicHuffmanWaveletTree(const std::vector<uint8_t> &_alphabet)
+            {
+                this->set_alphabet(_alphabet, std::vector<uint64_t>());
+            }
+
+            /**
+             * @brief Constructor with |T| = 0, U = \p _alphabet, and the tree shaped by the expected frequencies \p frequencies (\p frequencies[r] is the frequency of \p _alphabet[r])
+             */
+            DynamicHuffmanWaveletTree(const std::vector<uint8_t> &_alphabet, const std::vector<uint64_t> &frequencies)
+            {
+                this->set_alphabet(_alphabet, frequencies);
+            }
+
+            /**
+             * @brief Deleted copy constructor.
+             */
+            DynamicHuffmanWaveletTree(const DynamicHuffmanWaveletTree &) = delete;
+
+            /**
+             * @brief Default move constructor.
+             */
+            DynamicHuffmanWaveletTree(DynamicHuffmanWaveletTree &&) noexcept = default;
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Deleted copy assignment operator.
+             */
+            DynamicHuffmanWaveletTree &operator=(const DynamicHuffmanWaveletTree &) = delete;
+
+            /**
+             * @brief Default move assignment operator.
+             */
+            DynamicHuffmanWaveletTree &operator=(DynamicHuffmanWaveletTree &&) noexcept = default;
+
+            /**
+             * @brief The alias for at query
+             */
+            uint8_t operator[](uint64_t i) const
+            {
+                return this->at(i);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Lightweight functions for accessing to properties of this class
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return |T|
+             */
+            uint64_t size() const
+            {
+                return this->bits_seq.size() > 0 ? this->bits_seq[0].size() : 0;
+            }
+
+            /**
+             * @brief Return σ
+             */
+            uint64_t get_alphabet_size() const
+            {
+                return this->alphabet.size();
+            }
+
+            /**
+             * @brief Return the lexicographic order of the character \p c in \p U if it exists, otherwise return -1
+             */
+            int64_t get_lexicographic_order(uint8_t c) const
+            {
+                return this->alphabet.size() > 0 ? this->char_rank_vec[c] : -1;
+            }
+
+            /**
+             * @brief Return the length of the root-to-leaf path of the character \p c
+             */
+            uint64_t get_code_length(uint8_t c) const
+            {
+                int64_t c_rank = this->get_lexicographic_order(c);
+                if (c_rank == -1)
+                {
+                    throw std::invalid_argument("Error: DynamicHuffmanWaveletTree::get_code_length(). The character is not in the alphabet.");
+                }
+                return this->codes[c_rank].size();
+            }
+
+            /**
+             * @brief Return the average length of the root-to-leaf paths of the characters in \p T, i.e., the number of bit-sequence operations per access, rank, and update operation
+             */
+            double get_average_code_length() const
+            {
+                return this->size() > 0 ? (double)this->total_code_length / (double)this->size() : 0;
+            }
+
+            /**
+             * @brief Return the drift threshold ε (0 means that the tree is never rebuilt automatically)
+             */
+            double get_drift_threshold() const
+            {
+                return this->drift_threshold;
+            }
+
+            /**
+             * @brief Return the number of times this wavelet tree has been rebuilt (by rebuild() or by the drift check)
+             */
+            uint64_t get_rebuild_count() const
+            {
+                return this->rebuild_count;
+            }
+
+            /**
+             * @brief Return the memory usage in bytes
+             * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
+             */
+            uint64_t size_in_bytes(bool only_dynamic_memory = false) const
+            {
+                uint64_t total_size_in_bytes = 0;
+                for (const BIT_SEQUENCE &seq : this->bits_seq)
+                {
+                    total_size_in_bytes += seq.size_in_bytes(only_dynamic_memory);
+                }
+                total_size_in_bytes += this->children.capacity() * sizeof(std::array<int64_t, 2>);
+                for (const std::vector<bool> &code : this->codes)
+                {
+                    total_size_in_bytes += code.capacity() / 8;
+                }
+                total_size_in_bytes += this->char_counters.capacity() * sizeof(uint64_t) + this->char_rank_vec.capacity() * sizeof(int64_t) + this->alphabet.capacity();
+                if (only_dynamic_memory)
+                {
+                    return total_size_in_bytes;
+                }
+                else
+                {
+                    return total_size_in_bytes + sizeof(DynamicHuffmanWaveletTree);
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Main queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return \p T[i]
+             * @note O(|code(T[i])| log n) time
+             */
+            uint8_t at(uint64_t i) const
+            {
+                if (i >= this->size())
+                {
+                    throw std::range_error("Error: DynamicHuffmanWaveletTree::at(i)");
+                }
+                int64_t node = 0;
+                while (node >= 0)
+                {
+                    const BIT_SEQUENCE &bits = this->bits_seq[node];
+                    bool b = bits.at(i);
+                    i = bits.one_based_rank(i, b);
+                    node = this->children[node][b];
+                }
+                return this->alphabet[-node - 1];
+            }
+
+            /**
+             * @brief Counts the number of occurrences of a character \p c in \p T[0..i-1].
+             * @note O(|code(c)| log n) time
+             */
+            int64_t one_based_rank(uint64_t i, uint8_t c) const
+            {
+                int64_t c_rank = this->get_lexicographic_order(c);
+                if (c_rank == -1)
+                {
+                    return 0;
+                }
+                int64_t node = 0;
+                for (bool b : this->codes[c_rank])
+                {
+                    if (i == 0)
+                    {
+                        return 0;
+                    }
+                    i = this->bits_seq[node].one_based_rank(i, b);
+                    node = this->children[node][b];
+                }
+                return i;
+            }
+
+            /**
+             * @brief Returns the position of the (i+1)-th occurrence of \p c in \p T if such a position exists, otherwise returns -1
+             * @note O(|code(c)| log n) time
+             */
+            int64_t select(uint64_t i, uint8_t c) const
+            {
+                int64_t c_rank = this->get_lexicographic_order(c);
+                if (c_rank == -1 || i >= this->char_counters[c_rank])
+                {
+                    return -1;
+                }
+                const std::vector<bool> &code = this->codes[c_rank];
+                std::vector<uint64_t> path;
+                int64_t node = 0;
+                for (bool b : code)
+                {
+                    path.push_back(node);
+                    node = this->children[node][b];
+                }
+                int64_t p = i;
+                for (int64_t h = (int64_t)code.size() - 1; h >= 0; h--)
+                {
+                    p = this->bits_seq[path[h]].select(p, code[h]);
+                }
+                return p;
+            }
+
+            /**
+             * @brief Return the number of occurrences of the character \p c in \p T
+             * @note O(1) time
+             */
+            uint64_t count_c(uint8_t c) const
+            {
+                int64_t c_rank = this->get_lexicographic_order(c);
+                return c_rank == -1 ? 0 : this->char_counters[c_rank];
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return \p T as a vector of uint8_t
+             * @note O(n H_0 + n) time
+             */
+            std::vector<uint8_t> to_u8_vector() const
+            {
+                std::vector<uint8_t> r;
+                r.resize(this->size());
+                if (r.size() > 0)
+                {
+                    this->decode_sub(0, 0, r.size(), r.data());
+                }
+                return r;
+            }
+
+            /**
+             * @brief Return \p T as a string
+             */
+            std::string to_string() const
+            {
+                std::vector<uint8_t> chars = this->to_u8_vector();
+                return std::string(chars.begin(), chars.end());
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Swap operation
+             */
+            void swap(DynamicHuffmanWaveletTree &item)
+            {
+                this->bits_seq.swap(item.bits_seq);
+                this->children.swap(item.children);
+                this->codes.swap(item.codes);
+                this->char_counters.swap(item.char_counters);
+                this->char_rank_vec.swap(item.char_rank_vec);
+                this->alphabet.swap(item.alphabet);
+                std::swap(this->total_code_length, item.total_code_length);
+                std::swap(this->drift_threshold, item.drift_threshold);
+                std::swap(this->update_counter, item.update_counter);
+                std::swap(this->rebuild_count, item.rebuild_count);
+            }
+
+            /**
+             * @brief Initialize this instance with |T| = 0, U = \p _alphabet, and the tree shaped by \p frequencies (a balanced tree if \p frequencies is empty)
+             */
+            void set_alphabet(const std::vector<uint8_t> &_alphabet, const std::vector<uint64_t> &frequencies)
+            {
+                if (frequencies.size() > 0 && frequencies.size() != _alphabet.size())
+                {
+                    throw std::invalid_argument("Error: DynamicHuffmanWaveletTree::set_alphabet(). The number of frequencies must be equal to the alphabet size.");
+                }
+                std::vector<std::pair<uint8_t, uint64_t>> items;
+                for (uint64_t x = 0; x < _alphabet.size(); x++)
+                {
+                    items.push_back(std::pair<uint8_t, uint64_t>(_alphabet[x], frequencies.size() > 0 ? frequencies[x] : 0));
+                }
+                std::sort(items.begin(), items.end());
+
+                this->alphabet.clear();
+                this->char_rank_vec.clear();
+                this->char_rank_vec.resize(256, -1);
+                std::vector<uint64_t> sorted_frequencies;
+                for (auto [c, freq] : items)
+                {
+                    if (this->char_rank_vec[c] != -1)
+                    {
+                        throw std::invalid_argument("Error: DynamicHuffmanWaveletTree::set_alphabet(). The alphabet contains a duplicate character.");
+                    }
+                    this->char_rank_vec[c] = this->alphabet.size();
+                    this->alphabet.push_back(c);
+                    sorted_frequencies.push_back(freq);
+                }
+                this->char_counters.clear();
+                this->char_counters.resize(this->alphabet.size(), 0);
+                this->total_code_length = 0;
+                this->update_counter = 0;
+                this->children.clear();
+                this->codes.clear();
+                this->bits_seq.clear();
+                if (this->alphabet.size() > 0)
+                {
+                    build_shape(sorted_frequencies, this->children, this->codes);
+                    this->bits_seq.resize(this->children.size());
+                }
+            }
+
+            /**
+             * @brief Set the drift threshold ε (0 disables the automatic rebuild)
+             */
+            void set_drift_threshold(double threshold)
+            {
+                if (threshold < 0)
+                {
+                    throw std::invalid_argument("Error: DynamicHuffmanWaveletTree::set_drift_threshold(). The threshold must be non-negative.");
+                }
+                this->drift_threshold = threshold;
+            }
+
+            /**
+             * @brief Rebuild this wavelet tree with the Huffman tree of the current frequencies of the characters
+             * @note O(n H_0 + n + σ log σ) time
+             */
+            void rebuild()
+            {
+                std::vector<uint8_t> text = this->to_u8_vector();
+                DynamicHuffmanWaveletTree tmp = build(text, this->alphabet);
+                tmp.drift_threshold = this->drift_threshold;
+                tmp.rebuild_count = this->rebuild_count + 1;
+                this->swap(tmp);
+            }
+
+            /**
+             * @brief Insert a character \p c at position \p i in \p T
+             * @note O(|code(c)| log n) time (amortized, if the drift threshold is set)
+             */
+            void insert(uint64_t i, uint8_t c)
+            {
+                int64_t c_rank = this->get_lexicographic_order(c);
+                if (c_rank == -1)
+                {
+                    throw std::invalid_argument("Error: DynamicHuffmanWaveletTree::insert(). The character is not in the alphabet.");
+                }
+                if (i > this->size())
+                {
+                    throw std::range_error("Error: DynamicHuffmanWaveletTree::insert()");
+                }
+                int64_t node = 0;
+                for (bool b : this->codes[c_rank])
+                {
+                    BIT_SEQUENCE &bits = this->bits_seq[node];
+                    bits.insert(i, b);
+                    i = bits.one_based_rank(i, b);
+                    node = this->children[node][b];
+                }
+                this->char_counters[c_rank]++;
+                this->total_code_length += this->codes[c_rank].size();
+                this->count_update();
+            }
+
+            /**
+             * @brief Add a character \p c to the end of \p T
+             * @note O(|code(c)| log n) time
+             */
+            void push_back(uint8_t c)
+            {
+                this->insert(this->size(), c);
+            }
+
+            /**
+             * @brief Remove the character at position \p i from \p T
+             * @note O(|code(T[i])| log n) time
+             */
+            void remove(uint64_t i)
+            {
+                if (i >= this->size())
+                {
+                    throw std::range_error("Error: DynamicHuffmanWaveletTree::remove()");
+                }
+                int64_t node = 0;
+                uint64_t code_length = 0;
+                while (node >= 0)
+                {
+                    BIT_SEQUENCE &bits = this->bits_seq[node];
+                    bool b = bits.at(i);
+                    uint64_t next_i = bits.one_based_rank(i, b);
+                    bits.remove(i);
+                    i = next_i;
+                    node = this->children[node][b];
+                    code_length++;
+                }
+                this->char_counters[-node - 1]--;
+                this->total_code_length -= code_length;
+                this->count_update();
+            }
+
+            /**
+             * @brief Remove all characters from \p T (the shape of the tree is not changed)
+             */
+            void clear()
+            {
+                for (BIT_SEQUENCE &bits : this->bits_seq)
+                {
+                    bits.clear();
+                }
+                std::fill(this->char_counters.begin(), this->char_counters.end(), 0);
+                this->total_code_length = 0;
+                this->update_counter = 0;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Print and verification functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the memory usage information of this data structure as a vector of strings
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            std::vector<std::string> get_memory_usage_info(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::vector<std::string> r;
+                r.push_back(stool::Message::get_paragraph_string(message_paragraph) + "=DynamicHuffmanWaveletTree: " + std::to_string(this->size_in_bytes()) + " bytes =");
+                for (const BIT_SEQUENCE &bits : this->bits_seq)
+                {
+                    std::vector<std::string> log1 = bits.get_memory_usage_info(message_paragraph + 1);
+                    for (auto &s : log1)
+                    {
+                        r.push_back(s);
+                    }
+                }
+                r.push_back(stool::Message::get_paragraph_string(message_paragraph) + "==");
+                return r;
+            }
+
+            /**
+             * @brief Print the statistics of this data structure
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            void print_statistics(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "Statistics(DynamicHuffmanWaveletTree):" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Alphabet size: " << this->get_alphabet_size() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Text length: " << this->size() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Average code length: " << this->get_average_code_length() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Estimated memory usage: " << this->size_in_bytes() << " bytes" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "[END]" << std::endl;
+            }
+
+            /**
+             * @brief Print the memory usage information of this data structure
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            void print_memory_usage(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::vector<std::string> log = this->get_memory_usage_info(message_paragraph);
+                for (std::string &s : log)
+                {
+                    std::cout << s << std::endl;
+                }
+            }
+
+            /**
+             * @brief Verify the internal consistency of this data structure
+             */
+            void verify() const
+            {
+                uint64_t sum = 0;
+                for (uint64_t r = 0; r < this->alphabet.size(); r++)
+                {
+                    sum += this->char_counters[r] * this->codes[r].size();
+                }
+                if (sum != this->total_code_length)
+                {
+                    throw std::logic_error("Error: DynamicHuffmanWaveletTree::verify(). The total code length is incorrect.");
+                }
+                for (uint64_t x = 0; x < this->bits_seq.size(); x++)
+                {
+                    const BIT_SEQUENCE &bits = this->bits_seq[x];
+                    bits.verify();
+                    for (uint64_t b = 0; b < 2; b++)
+                    {
+                        int64_t child = this->children[x][b];
+                        uint64_t child_size = child >= 0 ? this->bits_seq[child].size() : this->char_counters[-child - 1];
+                        if (child_size != (uint64_t)bits.count_c(b == 1) && !(this->alphabet.size() == 1 && b == 1))
+                        {
+                            throw std::logic_error("Error: DynamicHuffmanWaveletTree::verify(). The size of a child is incorrect.");
+                        }
+                    }
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Load, save, and builder functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Build a Huffman-shaped wavelet tree of \p _text over \p _alphabet, shaped by the frequencies of the characters in \p _text
+             * @note O(n H_0 + n + σ log σ) time
+             */
+            static DynamicHuffmanWaveletTree build(const std::vector<uint8_t> &_text, const std::vector<uint8_t> &_alphabet)
+            {
+                std::vector<uint64_t> counters(256, 0);
+                for (uint8_t c : _text)
+                {
+                    counters[c]++;
+                }
+                std::vector<uint64_t> frequencies;
+                for (uint8_t c : _alphabet)
+                {
+                    frequencies.push_back(counters[c]);
+                }
+                DynamicHuffmanWaveletTree r(_alphabet, frequencies);
+                for (uint8_t c : _text)
+                {
+                    int64_t c_rank = r.get_lexicographic_order(c);
+                    if (c_rank == -1)
+                    {
+                        throw std::invalid_argument("Error: DynamicHuffmanWaveletTree::build(). The text contains a character not in the alphabet.");
+                    }
+                    r.char_counters[c_rank]++;
+                    r.total_code_length += r.codes[c_rank].size();
+                }
+                if (_text.size() > 0)
+                {
+                    r.build_bits(_text, 0, 0);
+                }
+                return r;
+            }
+            //@}
+
+        private:
+            /**
+             * @brief Build the Huffman tree of the characters with frequencies \p frequencies[0..σ-1] plus one (or a balanced tree if all the frequencies are 0)
+             */
+            static void build_shape(const std::vector<uint64_t> &frequencies, std::vector<std::array<int64_t, 2>> &output_children, std::vector<std::vector<bool>> &output_codes)
+            {
+                uint64_t sigma = frequencies.size();
+                output_children.clear();
+                output_codes.clear();
+                output_codes.resize(sigma);
+                if (sigma == 1)
+                {
+                    output_children.push_back(std::array<int64_t, 2>{-1, -1});
+                    output_codes[0].push_back(false);
+                    return;
+                }
+
+                // (weight, the smallest lexicographic order in the subtree, node)
+                using Item = std::tuple<uint64_t, uint64_t, int64_t>;
+                std::priority_queue<Item, std::vector<Item>, std::greater<Item>> que;
+                for (uint64_t r = 0; r < sigma; r++)
+                {
+                    que.push(Item(frequencies[r] + 1, r, -(int64_t)r - 1));
+                }
+                std::vector<std::array<int64_t, 2>> reversed_children;
+                while (que.size() > 1)
+                {
+                    auto [w1, r1, node1] = que.top();
+                    que.pop();
+                    auto [w2, r2, node2] = que.top();
+                    que.pop();
+                    if (r2 < r1)
+                    {
+                        std::swap(r1, r2);
+                        std::swap(node1, node2);
+                    }
+                    reversed_children.push_back(std::array<int64_t, 2>{node1, node2});
+                    que.push(Item(w1 + w2, r1, reversed_children.size() - 1));
+                }
+
+                // Renumber the internal nodes so that the root is the 0-th node
+                uint64_t k = reversed_children.size();
+                for (uint64_t x = 0; x < k; x++)
+                {
+                    std::array<int64_t, 2> item = reversed_children[k - 1 - x];
+                    for (int64_t &child : item)
+                    {
+                        if (child >= 0)
+                        {
+                            child = k - 1 - child;
+                        }
+                    }
+                    output_children.push_back(item);
+                }
+
+                std::vector<std::pair<int64_t, std::vector<bool>>> stack;
+                stack.push_back(std::pair<int64_t, std::vector<bool>>(0, std::vector<bool>()));
+                while (stack.size() > 0)
+                {
+                    auto [node, code] = stack.back();
+                    stack.pop_back();
+                    for (uint64_t b = 0; b < 2; b++)
+                    {
+                        std::vector<bool> child_code = code;
+                        child_code.push_back(b == 1);
+                        int64_t child = output_children[node][b];
+                        if (child >= 0)
+                        {
+                            stack.push_back(std::pair<int64_t, std::vector<bool>>(child, child_code));
+                        }
+                        else
+                        {
+                            output_codes[-child - 1] = child_code;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief Return the weighted path length of the Huffman tree of the current frequencies
+             */
+            uint64_t compute_huffman_code_length() const
+            {
+                std::vector<std::array<int64_t, 2>> tmp_children;
+                std::vector<std::vector<bool>> tmp_codes;
+                build_shape(this->char_counters, tmp_children, tmp_codes);
+                uint64_t sum = 0;
+                for (uint64_t r = 0; r < this->alphabet.size(); r++)
+                {
+                    sum += this->char_counters[r] * tmp_codes[r].size();
+                }
+                return sum;
+            }
+
+            /**
+             * @brief Count an update operation, and rebuild this wavelet tree if the shape has drifted from the Huffman tree of the current frequencies
+             */
+            void count_update()
+            {
+                if (this->drift_threshold > 0)
+                {
+                    this->update_counter++;
+                    if (this->update_counter >= std::max<uint64_t>(CHECK_INTERVAL, this->size() / 16))
+                    {
+                        this->update_counter = 0;
+                        uint64_t optimal_length = this->compute_huffman_code_length();
+                        if ((double)this->total_code_length > (1.0 + this->drift_threshold) * (double)optimal_length)
+                        {
+                            this->rebuild();
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief Build the bit sequences of the subtree rooted at the \p node-th node from the characters \p _text whose codes have the prefix of length \p depth leading to the node
+             */
+            void build_bits(const std::vector<uint8_t> &_text, int64_t node, uint64_t depth)
+            {
+                std::vector<bool> bits;
+                bits.resize(_text.size(), false);
+                std::vector<uint8_t> left, right;
+                for (uint64_t x = 0; x < _text.size(); x++)
+                {
+                    bool b = this->codes[this->char_rank_vec[_text[x]]][depth];
+                    bits[x] = b;
+                    if (b)
+                    {
+                        right.push_back(_text[x]);
+                    }
+                    else
+                    {
+                        left.push_back(_text[x]);
+                    }
+                }
+                BIT_SEQUENCE dbs = BIT_SEQUENCE::build(bits);
+                this->bits_seq[node].swap(dbs);
+                if (this->children[node][0] >= 0 && left.size() > 0)
+                {
+                    this->build_bits(left, this->children[node][0], depth + 1);
+                }
+                if (this->children[node][1] >= 0 && right.size() > 0)
+                {
+                    this->build_bits(right, this->children[node][1], depth + 1);
+                }
+            }
+
+            /**
+             * @brief Write the characters of the range [i..j-1] of the bit sequence of the \p node-th node to \p output[0..j-i-1]
+             */
+            void decode_sub(int64_t node, uint64_t i, uint64_t j, uint8_t *output) const
+            {
+                if (node < 0)
+                {
+                    std::fill(output, output + (j - i), this->alphabet[-node - 1]);
+                    return;
+                }
+                const BIT_SEQUENCE &bits = this->bits_seq[node];
+                uint64_t len = j - i;
+                std::vector<uint64_t> words;
+                bits.extract_words(i, len, words);
+                uint64_t ones = PackedBitFunctions::popcount_words(words.data(), words.size());
+                uint64_t right_i = bits.one_based_rank1(i);
+                uint64_t left_i = i - right_i;
+                std::vector<uint8_t> left, right;
+                left.resize(len - ones);
+                right.resize(ones);
+                if (left.size() > 0)
+                {
+                    this->decode_sub(this->children[node][0], left_i, left_i + left.size(), left.data());
+                }
+                if (right.size() > 0)
+                {
+                    this->decode_sub(this->children[node][1], right_i, right_i + right.size(), right.data());
+                }
+                uint64_t left_pos = 0;
+                uint64_t right_pos = 0;
+                for (uint64_t x = 0; x < len; x++)
+                {
+                    output[x] = PackedBitFunctions::get_bit(words.data(), x) ? right[right_pos++] : left[left_pos++];
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,1148 @@
+#pragma once
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include "./bp_tree.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+
+        /**
+         * @brief A dynamic data structure supporting prefix-sum queries on K parallel unsigned 64-bit integer sequences S_0[0..n-1], ..., S_{K-1}[0..n-1] of the same length.
+         * @details Each position \p i stores a K-tuple (S_0[i], ..., S_{K-1}[i]). The K sequences (lanes) share a single B+-tree:
+         *          every internal node keeps one value-count array and K lane-sum arrays for its children,
+         *          so that an insertion or a removal performs one descent and one rebalance for all the lanes,
+         *          instead of K independent descents in K separate DynamicPrefixSum instances.
+         *          The arrays of an internal node are prefix sums over its children, so the child containing a position or a lane sum is found by a binary search.
+         * @note This class does not reuse BPTree and BPInternalNode, because their internal nodes keep exactly one sum deque (NaiveIntegerArray) per node
+         *       and their leaf containers store one value per position; widening them to K sums would change the node layout and the leaf interface
+         *       of every tree in this library (bit sequences, wavelet trees, permutations) for the sake of this class.
+         * \ingroup PrefixSumClasses
+         * \ingroup MainClasses
+         */
+        template <uint64_t K, uint64_t TREE_DEGREE = bptree::DEFAULT_MAX_DEGREE_OF_INTERNAL_NODE, uint64_t LEAF_CONTAINER_MAX_SIZE = bptree::DEFAULT_MAX_COUNT_OF_VALUES_IN_LEAF>
+        class DynamicMultiPrefixSum
+        {
+            static_assert(K > 0, "DynamicMultiPrefixSum requires at least one lane.");
+            static_assert(TREE_DEGREE >= 4, "TREE_DEGREE must be at least 4.");
+            static_assert(LEAF_CONTAINER_MAX_SIZE >= 4, "LEAF_CONTAINER_MAX_SIZE must be at least 4.");
+
+        public:
+            using Tuple = std::array<uint64_t, K>;
+
+        private:
+            /**
+             * @brief A node of the shared tree.
+             * @details A leaf stores its K-tuples in \p values.
+             *          An internal node stores, for each child c, the number of tuples \p counts[c] and the K lane sums \p sums[c] in the subtrees of the children 0, 1, ..., c.
+             */
+            struct Node
+            {
+                bool is_leaf = true;
+                std::vector<Tuple> values;
+                std::vector<Node *> children;
+                std::vector<uint64_t> counts;
+                std::vector<Tuple> sums;
+            };
+
+            Node *root = nullptr;
+            uint64_t size_ = 0;
+            Tuple total_sums_;
+
+        public:
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Default constructor with |S_0| = ... = |S_{K-1}| = 0
+             */
+            DynamicMultiPrefixSum()
+            {
+                this->total_sums_.fill(0);
+            }
+
+            /**
+             * @brief Constructor with (S_0[i], ..., S_{K-1}[i]) = items[i] for all i
+             */
+            DynamicMultiPrefixSum(const std::vector<Tuple> &items) : DynamicMultiPrefixSum()
+            {
+                this->push_many(items);
+            }
+
+            /**
+             * @brief Default move constructor.
+             */
+            DynamicMultiPrefixSum(DynamicMultiPrefixSum &&other) noexcept
+            {
+                this->root = other.root;
+                this->size_ = other.size_;
+                this->total_sums_ = other.total_sums_;
+                other.root = nullptr;
+                other.size_ = 0;
+                other.total_sums_.fill(0);
+            }
+
+            /**
+             * @brief Destructor.
+             */
+            ~DynamicMultiPrefixSum()
+            {
+                this->clear();
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Deleted copy assignment operator.
+             */
+            DynamicMultiPrefixSum &operator=(const DynamicMultiPrefixSum &) = delete;
+
+            /**
+             * @brief Move assignment operator.
+             */
+            DynamicMultiPrefixSum &operator=(DynamicMultiPrefixSum &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    this->clear();
+                    this->swap(other);
+                }
+                return *this;
+            }
+
+            /**
+             * @brief The alias for at query
+             */
+            Tuple operator[](uint64_t i) const
+            {
+                return this->at(i);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Lightweight functions for accessing to properties of this class
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the number of lanes K
+             */
+            static constexpr uint64_t lane_count()
+            {
+                return K;
+            }
+
+            /**
+             * @brief Return the maximum degree of internal nodes of the internal tree.
+             */
+            uint64_t get_degree() const
+            {
+                return TREE_DEGREE;
+            }
+
+            /**
+             * @brief Return |S_0| (= |S_1| = ... = |S_{K-1}|)
+             */
+            uint64_t size() const
+            {
+                return this->size_;
+            }
+
+            /**
+             * @brief Return the height of the internal tree.
+             */
+            uint64_t height() const
+            {
+                uint64_t h = 0;
+                Node *node = this->root;
+                while (node != nullptr && !node->is_leaf)
+                {
+                    node = node->children[0];
+                    h++;
+                }
+                return h;
+            }
+
+            /**
+             * @brief Returns the total memory usage in bytes
+             * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
+             */
+            uint64_t size_in_bytes(bool only_dynamic_memory = false) const
+            {
+                uint64_t sum = this->root == nullptr ? 0 : DynamicMultiPrefixSum::size_in_bytes(this->root);
+                if (!only_dynamic_memory)
+                {
+                    sum += sizeof(DynamicMultiPrefixSum);
+                }
+                return sum;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the K-tuples (S_0[i], ..., S_{K-1}[i]) for all i as a vector.
+             */
+            std::vector<Tuple> to_vector() const
+            {
+                std::vector<Tuple> r;
+                r.reserve(this->size_);
+                if (this->root != nullptr)
+                {
+                    DynamicMultiPrefixSum::to_vector(this->root, r);
+                }
+                return r;
+            }
+
+            /**
+             * @brief Return \p S_lane as a vector.
+             */
+            std::vector<uint64_t> to_vector(uint64_t lane) const
+            {
+                this->check_lane(lane);
+                std::vector<uint64_t> r;
+                r.reserve(this->size_);
+                for (const Tuple &t : this->to_vector())
+                {
+                    r.push_back(t[lane]);
+                }
+                return r;
+            }
+
+            /**
+             * @brief Return the K sequences as a string.
+             */
+            std::string to_string() const
+            {
+                std::stringstream ss;
+                std::vector<Tuple> vec = this->to_vector();
+                ss << "[";
+                for (uint64_t i = 0; i < vec.size(); i++)
+                {
+                    ss << "(";
+                    for (uint64_t k = 0; k < K; k++)
+                    {
+                        ss << vec[i][k];
+                        if (k + 1 < K)
+                        {
+                            ss << ", ";
+                        }
+                    }
+                    ss << ")";
+                    if (i + 1 < vec.size())
+                    {
+                        ss << ", ";
+                    }
+                }
+                ss << "]";
+                return ss.str();
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Main queries (Access, search, and psum operations)
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the K-tuple (S_0[i], ..., S_{K-1}[i])
+             * @note O(log n) time
+             */
+            Tuple at(uint64_t i) const
+            {
+                if (i >= this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::at(i). The i must be less than the size of the sequences.");
+                }
+                Node *node = this->root;
+                while (!node->is_leaf)
+                {
+                    uint64_t c = DynamicMultiPrefixSum::find_child_for_access(node, i);
+                    node = node->children[c];
+                }
+                return node->values[i];
+            }
+
+            /**
+             * @brief Return \p S_lane[i]
+             * @note O(log n) time
+             */
+            uint64_t at(uint64_t lane, uint64_t i) const
+            {
+                this->check_lane(lane);
+                return this->at(i)[lane];
+            }
+
+            /**
+             * @brief Return the sum of \p S_lane[0..n-1].
+             * @note O(1) time
+             */
+            uint64_t psum_of_lane(uint64_t lane) const
+            {
+                this->check_lane(lane);
+                return this->total_sums_[lane];
+            }
+
+            /**
+             * @brief Return the sums of \p S_0[0..n-1], ..., \p S_{K-1}[0..n-1].
+             * @note O(1) time
+             */
+            Tuple psum() const
+            {
+                return this->total_sums_;
+            }
+
+            /**
+             * @brief Return the sum of \p S_lane[0..i].
+             * @note O(log n) time
+             */
+            uint64_t psum(uint64_t lane, uint64_t i) const
+            {
+                this->check_lane(lane);
+                if (i >= this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::psum(lane, i). The i must be less than the size of the sequences.");
+                }
+                uint64_t sum = 0;
+                Node *node = this->root;
+                while (!node->is_leaf)
+                {
+                    uint64_t c = DynamicMultiPrefixSum::find_child_for_access(node, i);
+                    if (c > 0)
+                    {
+                        sum += node->sums[c - 1][lane];
+                    }
+                    node = node->children[c];
+                }
+                for (uint64_t x = 0; x <= i; x++)
+                {
+                    sum += node->values[x][lane];
+                }
+                return sum;
+            }
+
+            /**
+             * @brief Return the sums of \p S_0[0..i], ..., \p S_{K-1}[0..i] using a single descent.
+             * @note O(K log n) time
+             */
+            Tuple psum_all(uint64_t i) const
+            {
+                if (i >= this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::psum_all(i). The i must be less than the size of the sequences.");
+                }
+                Tuple sum;
+                sum.fill(0);
+                Node *node = this->root;
+                while (!node->is_leaf)
+                {
+                    uint64_t c = DynamicMultiPrefixSum::find_child_for_access(node, i);
+                    if (c > 0)
+                    {
+                        DynamicMultiPrefixSum::add(sum, node->sums[c - 1]);
+                    }
+                    node = node->children[c];
+                }
+                for (uint64_t x = 0; x <= i; x++)
+                {
+                    DynamicMultiPrefixSum::add(sum, node->values[x]);
+                }
+                return sum;
+            }
+
+            /**
+             * @brief Return the sum of \p S_lane[i..j].
+             * @note O(log n) time
+             */
+            uint64_t psum(uint64_t lane, uint64_t i, uint64_t j) const
+            {
+                this->check_lane(lane);
+                if (i > 0)
+                {
+                    return this->psum(lane, j) - this->psum(lane, i - 1);
+                }
+                else
+                {
+                    return this->psum(lane, j);
+                }
+            }
+
+            /**
+             * @brief Return the smallest i such that psum(lane, i) >= x if such a position exists, otherwise returns -1
+             * @note O(log n) time
+             */
+            int64_t search(uint64_t lane, uint64_t x) const
+            {
+                this->check_lane(lane);
+                if (this->size_ == 0 || x > this->total_sums_[lane])
+                {
+                    return -1;
+                }
+                uint64_t pos = 0;
+                Node *node = this->root;
+                while (!node->is_leaf)
+                {
+                    auto it = std::lower_bound(node->sums.begin(), node->sums.end() - 1, x, [lane](const Tuple &t, uint64_t value)
+                                               { return t[lane] < value; });
+                    uint64_t c = it - node->sums.begin();
+                    if (c > 0)
+                    {
+                        x -= node->sums[c - 1][lane];
+                        pos += node->counts[c - 1];
+                    }
+                    node = node->children[c];
+                }
+                uint64_t sum = 0;
+                for (uint64_t y = 0; y < node->values.size(); y++)
+                {
+                    sum += node->values[y][lane];
+                    if (sum >= x)
+                    {
+                        return pos + y;
+                    }
+                }
+                return -1;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Insert a given K-tuple \p value at a given position \p pos in the K sequences
+             * @note O(K log n) time
+             */
+            void insert(uint64_t pos, const Tuple &value)
+            {
+                if (pos > this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::insert(pos, value). The pos must be at most the size of the sequences.");
+                }
+                if (this->root == nullptr)
+                {
+                    this->root = new Node();
+                }
+                Node *new_sibling = DynamicMultiPrefixSum::insert_sub(this->root, pos, value);
+                if (new_sibling != nullptr)
+                {
+                    Node *new_root = new Node();
+                    new_root->is_leaf = false;
+                    DynamicMultiPrefixSum::append_child(new_root, this->root);
+                    DynamicMultiPrefixSum::append_child(new_root, new_sibling);
+                    this->root = new_root;
+                }
+                this->size_++;
+                DynamicMultiPrefixSum::add(this->total_sums_, value);
+            }
+
+            /**
+             * @brief Remove the K-tuple at a given position \p pos from the K sequences
+             * @note O(K log n) time
+             */
+            void remove(uint64_t pos)
+            {
+                if (pos >= this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::remove(pos). The pos must be less than the size of the sequences.");
+                }
+                Tuple removed_value = DynamicMultiPrefixSum::remove_sub(this->root, pos);
+                DynamicMultiPrefixSum::subtract(this->total_sums_, removed_value);
+                this->size_--;
+
+                if (!this->root->is_leaf && this->root->children.size() == 1)
+                {
+                    Node *child = this->root->children[0];
+                    this->root->children.clear();
+                    delete this->root;
+                    this->root = child;
+                }
+                if (this->size_ == 0)
+                {
+                    this->clear();
+                }
+            }
+
+            /**
+             * @brief Add a given K-tuple \p value to the end of the K sequences
+             * @note O(K log n) time
+             */
+            void push_back(const Tuple &value)
+            {
+                this->insert(this->size_, value);
+            }
+
+            /**
+             * @brief Add given K-tuples \p items to the end of the K sequences
+             * @note O(|items| K log n) time
+             */
+            void push_many(const std::vector<Tuple> &items)
+            {
+                for (const Tuple &t : items)
+                {
+                    this->push_back(t);
+                }
+            }
+
+            /**
+             * @brief Add a given value \p delta to \p S_lane[i]
+             * @note O(log n) time
+             */
+            void increment(uint64_t lane, uint64_t i, int64_t delta)
+            {
+                this->check_lane(lane);
+                if (i >= this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::increment(lane, i, delta). The i must be less than the size of the sequences.");
+                }
+                Node *node = this->root;
+                while (!node->is_leaf)
+                {
+                    uint64_t c = DynamicMultiPrefixSum::find_child_for_access(node, i);
+                    for (uint64_t d = c; d < node->sums.size(); d++)
+                    {
+                        node->sums[d][lane] += delta;
+                    }
+                    node = node->children[c];
+                }
+                node->values[i][lane] += delta;
+                this->total_sums_[lane] += delta;
+            }
+
+            /**
+             * @brief Subtract a given value \p delta from \p S_lane[i]
+             * @note O(log n) time
+             */
+            void decrement(uint64_t lane, uint64_t i, int64_t delta)
+            {
+                this->increment(lane, i, -delta);
+            }
+
+            /**
+             * @brief Set a given value \p value at \p S_lane[i]
+             * @note O(log n) time
+             */
+            void set_value(uint64_t lane, uint64_t i, uint64_t value)
+            {
+                uint64_t old_value = this->at(lane, i);
+                this->increment(lane, i, (int64_t)value - (int64_t)old_value);
+            }
+
+            /**
+             * @brief Set a given K-tuple \p value at position \p i using a single descent
+             * @note O(K log n) time
+             */
+            void set_value(uint64_t i, const Tuple &value)
+            {
+                if (i >= this->size_)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum::set_value(i, value). The i must be less than the size of the sequences.");
+                }
+                std::vector<std::pair<Node *, uint64_t>> path;
+                Node *node = this->root;
+                while (!node->is_leaf)
+                {
+                    uint64_t c = DynamicMultiPrefixSum::find_child_for_access(node, i);
+                    path.push_back(std::pair<Node *, uint64_t>(node, c));
+                    node = node->children[c];
+                }
+                Tuple old_value = node->values[i];
+                node->values[i] = value;
+                for (auto &it : path)
+                {
+                    for (uint64_t d = it.second; d < it.first->sums.size(); d++)
+                    {
+                        DynamicMultiPrefixSum::subtract(it.first->sums[d], old_value);
+                        DynamicMultiPrefixSum::add(it.first->sums[d], value);
+                    }
+                }
+                DynamicMultiPrefixSum::subtract(this->total_sums_, old_value);
+                DynamicMultiPrefixSum::add(this->total_sums_, value);
+            }
+
+            /**
+             * @brief Swap operation
+             */
+            void swap(DynamicMultiPrefixSum &item)
+            {
+                std::swap(this->root, item.root);
+                std::swap(this->size_, item.size_);
+                std::swap(this->total_sums_, item.total_sums_);
+            }
+
+            /**
+             * @brief Clear the elements in the K sequences.
+             */
+            void clear()
+            {
+                if (this->root != nullptr)
+                {
+                    DynamicMultiPrefixSum::release(this->root);
+                    this->root = nullptr;
+                }
+                this->size_ = 0;
+                this->total_sums_.fill(0);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Print and verification functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Verify the internal consistency of this data structure.
+             */
+            void verify() const
+            {
+                if (this->root == nullptr)
+                {
+                    if (this->size_ != 0)
+                    {
+                        throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). The root is missing.");
+                    }
+                    return;
+                }
+                uint64_t count = 0;
+                Tuple sum;
+                sum.fill(0);
+                uint64_t leaf_depth = UINT64_MAX;
+                DynamicMultiPrefixSum::verify_sub(this->root, true, 0, leaf_depth, count, sum);
+                if (count != this->size_ || sum != this->total_sums_)
+                {
+                    throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). The size or the sums are inconsistent.");
+                }
+            }
+
+            /**
+             * @brief Print the statistics of this data structure
+             */
+            void print_statistics(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "Statistics(DynamicMultiPrefixSum):" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " The number of lanes: " << K << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " The length of each sequence: " << this->size() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " The height of the tree: " << this->height() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " Total memory usage: " << this->size_in_bytes() << " bytes" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "[END]" << std::endl;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Builder functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Build a new DynamicMultiPrefixSum from given K-tuples \p items
+             */
+            static DynamicMultiPrefixSum build(const std::vector<Tuple> &items)
+            {
+                DynamicMultiPrefixSum r;
+                if (items.size() == 0)
+                {
+                    return r;
+                }
+                std::vector<Node *> nodes;
+                uint64_t leaf_count = (items.size() + LEAF_CONTAINER_MAX_SIZE - 1) / LEAF_CONTAINER_MAX_SIZE;
+                for (uint64_t x = 0; x < leaf_count; x++)
+                {
+                    Node *leaf = new Node();
+                    leaf->values.assign(items.begin() + (items.size() * x) / leaf_count, items.begin() + (items.size() * (x + 1)) / leaf_count);
+                    nodes.push_back(leaf);
+                    DynamicMultiPrefixSum::add(r.total_sums_, DynamicMultiPrefixSum::sums_of(leaf));
+                }
+                while (nodes.size() > 1)
+                {
+                    std::vector<Node *> parents;
+                    uint64_t parent_count = (nodes.size() + TREE_DEGREE - 1) / TREE_DEGREE;
+                    for (uint64_t x = 0; x < parent_count; x++)
+                    {
+                        Node *parent = new Node();
+                        parent->is_leaf = false;
+                        for (uint64_t y = (nodes.size() * x) / parent_count; y < (nodes.size() * (x + 1)) / parent_count; y++)
+                        {
+                            DynamicMultiPrefixSum::append_child(parent, nodes[y]);
+                        }
+                        parents.push_back(parent);
+                    }
+                    nodes.swap(parents);
+                }
+                r.root = nodes[0];
+                r.size_ = items.size();
+                return r;
+            }
+
+            /**
+             * @brief Returns the DynamicMultiPrefixSum instance loaded from a byte vector \p data at the position \p pos
+             */
+            static DynamicMultiPrefixSum load_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
+                uint64_t header[2];
+                std::memcpy(header, data.data() + pos, sizeof(header));
+                pos += sizeof(header);
+                DynamicMultiPrefixSum::check_lane_count(header[0]);
+                std::vector<Tuple> items;
+                items.resize(header[1]);
+                if (items.size() > 0)
+                {
+                    std::memcpy(items.data(), data.data() + pos, items.size() * sizeof(Tuple));
+                    pos += items.size() * sizeof(Tuple);
+                }
+                return DynamicMultiPrefixSum::build(items);
+            }
+
+            /**
+             * @brief Returns the DynamicMultiPrefixSum instance loaded from a file stream \p ifs
+             */
+            static DynamicMultiPrefixSum load_from_file(std::ifstream &ifs)
+            {
+                uint64_t header[2];
+                ifs.read(reinterpret_cast<char *>(header), sizeof(header));
+                DynamicMultiPrefixSum::check_lane_count(header[0]);
+                std::vector<Tuple> items;
+                items.resize(header[1]);
+                ifs.read(reinterpret_cast<char *>(items.data()), items.size() * sizeof(Tuple));
+                return DynamicMultiPrefixSum::build(items);
+            }
+
+            /**
+             * @brief Save the given instance \p item to a byte vector \p output at the position \p pos
+             * @details The format is K, n, and the n K-tuples.
+             */
+            static void store_to_bytes(const DynamicMultiPrefixSum &item, std::vector<uint8_t> &output, uint64_t &pos)
+            {
+                std::vector<Tuple> items = item.to_vector();
+                uint64_t header[2] = {K, items.size()};
+                uint64_t byte_size = sizeof(header) + items.size() * sizeof(Tuple);
+                if (pos + byte_size > output.size())
+                {
+                    output.resize(pos + byte_size);
+                }
+                std::memcpy(output.data() + pos, header, sizeof(header));
+                pos += sizeof(header);
+                if (items.size() > 0)
+                {
+                    std::memcpy(output.data() + pos, items.data(), items.size() * sizeof(Tuple));
+                    pos += items.size() * sizeof(Tuple);
+                }
+            }
+
+            /**
+             * @brief Save the given instance \p item to a file stream \p os
+             */
+            static void store_to_file(const DynamicMultiPrefixSum &item, std::ofstream &os)
+            {
+                std::vector<uint8_t> bytes;
+                uint64_t pos = 0;
+                DynamicMultiPrefixSum::store_to_bytes(item, bytes, pos);
+                os.write(reinterpret_cast<const char *>(bytes.data()), pos);
+            }
+            //@}
+
+            /**
+             * @brief Return the name of this class.
+             */
+            static std::string name()
+            {
+                std::string s;
+                s += "DynamicMultiPrefixSum(" + std::to_string(K) + ", " + std::to_string(TREE_DEGREE) + ", " + std::to_string(LEAF_CONTAINER_MAX_SIZE) + ")";
+                return s;
+            }
+
+        private:
+            void check_lane(uint64_t lane) const
+            {
+                if (lane >= K)
+                {
+                    throw std::invalid_argument("Error: DynamicMultiPrefixSum. The lane must be less than K.");
+                }
+            }
+
+            static void check_lane_count(uint64_t lane_count)
+            {
+                if (lane_count != K)
+                {
+                    throw std::runtime_error("Error: DynamicMultiPrefixSum. The number of lanes in the data is different from K.");
+                }
+            }
+
+            static void add(Tuple &x, const Tuple &y)
+            {
+                for (uint64_t k = 0; k < K; k++)
+                {
+                    x[k] += y[k];
+                }
+            }
+            static void subtract(Tuple &x, const Tuple &y)
+            {
+                for (uint64_t k = 0; k < K; k++)
+                {
+                    x[k] -= y[k];
+                }
+            }
+
+            /**
+             * @brief Return the index of the child containing the i-th tuple of the subtree of \p node, and replace \p i with the position in the child.
+             */
+            static uint64_t find_child_for_access(const Node *node, uint64_t &i)
+            {
+                uint64_t c = std::upper_bound(node->counts.begin(), node->counts.end(), i) - node->counts.begin();
+                assert(c < node->counts.size());
+                if (c > 0)
+                {
+                    i -= node->counts[c - 1];
+                }
+                return c;
+            }
+
+            /**
+             * @brief Return the number of tuples in the subtrees of the children 0, 1, ..., c-1 of \p node
+             */
+            static uint64_t count_before(const Node *node, uint64_t c)
+            {
+                return c > 0 ? node->counts[c - 1] : 0;
+            }
+
+            /**
+             * @brief Return the lane sums of the subtrees of the children 0, 1, ..., c-1 of \p node
+             */
+            static Tuple sums_before(const Node *node, uint64_t c)
+            {
+                if (c > 0)
+                {
+                    return node->sums[c - 1];
+                }
+                else
+                {
+                    Tuple sum;
+                    sum.fill(0);
+                    return sum;
+                }
+            }
+
+            static uint64_t count_of(const Node *node)
+            {
+                if (node->is_leaf)
+                {
+                    return node->values.size();
+                }
+                else
+                {
+                    return node->counts.size() > 0 ? node->counts.back() : 0;
+                }
+            }
+
+            static Tuple sums_of(const Node *node)
+            {
+                Tuple sum;
+                sum.fill(0);
+                if (node->is_leaf)
+                {
+                    for (const Tuple &t : node->values)
+                    {
+                        DynamicMultiPrefixSum::add(sum, t);
+                    }
+                }
+                else if (node->sums.size() > 0)
+                {
+                    sum = node->sums.back();
+                }
+                return sum;
+            }
+
+            static uint64_t degree_of(const Node *node)
+            {
+                return node->is_leaf ? node->values.size() : node->children.size();
+            }
+            static uint64_t max_degree_of(const Node *node)
+            {
+                return node->is_leaf ? LEAF_CONTAINER_MAX_SIZE : TREE_DEGREE;
+            }
+
+            static void append_child(Node *parent, Node *child)
+            {
+                uint64_t c = parent->children.size();
+                Tuple sum = DynamicMultiPrefixSum::sums_before(parent, c);
+                DynamicMultiPrefixSum::add(sum, DynamicMultiPrefixSum::sums_of(child));
+                parent->children.push_back(child);
+                parent->counts.push_back(DynamicMultiPrefixSum::count_before(parent, c) + DynamicMultiPrefixSum::count_of(child));
+                parent->sums.push_back(sum);
+            }
+
+            /**
+             * @brief Recompute the c-th entries of the prefix arrays of \p parent from the (c-1)-th entries and the c-th child.
+             */
+            static void refresh_child(Node *parent, uint64_t c)
+            {
+                Tuple sum = DynamicMultiPrefixSum::sums_before(parent, c);
+                DynamicMultiPrefixSum::add(sum, DynamicMultiPrefixSum::sums_of(parent->children[c]));
+                parent->counts[c] = DynamicMultiPrefixSum::count_before(parent, c) + DynamicMultiPrefixSum::count_of(parent->children[c]);
+                parent->sums[c] = sum;
+            }
+
+            /**
+             * @brief Move the second half of the entries of a given overflowing node \p node to a new node, and return the new node.
+             */
+            static Node *split(Node *node)
+            {
+                Node *right = new Node();
+                right->is_leaf = node->is_leaf;
+                if (node->is_leaf)
+                {
+                    uint64_t half = node->values.size() / 2;
+                    right->values.assign(node->values.begin() + half, node->values.end());
+                    node->values.resize(half);
+                }
+                else
+                {
+                    uint64_t half = node->children.size() / 2;
+                    uint64_t count_offset = node->counts[half - 1];
+                    Tuple sum_offset = node->sums[half - 1];
+                    right->children.assign(node->children.begin() + half, node->children.end());
+                    right->counts.assign(node->counts.begin() + half, node->counts.end());
+                    right->sums.assign(node->sums.begin() + half, node->sums.end());
+                    for (uint64_t c = 0; c < right->counts.size(); c++)
+                    {
+                        right->counts[c] -= count_offset;
+                        DynamicMultiPrefixSum::subtract(right->sums[c], sum_offset);
+                    }
+                    node->children.resize(half);
+                    node->counts.resize(half);
+                    node->sums.resize(half);
+                }
+                return right;
+            }
+
+            /**
+             * @brief Insert \p value at position \p pos in the subtree of \p node. Return the new right sibling of \p node if \p node is split, otherwise nullptr.
+             */
+            static Node *insert_sub(Node *node, uint64_t pos, const Tuple &value)
+            {
+                if (node->is_leaf)
+                {
+                    node->values.insert(node->values.begin() + pos, value);
+                }
+                else
+                {
+                    // The smallest c with pos <= counts[c], i.e., an insertion at the boundary of two children goes to the left child
+                    uint64_t c = std::lower_bound(node->counts.begin(), node->counts.end() - 1, pos) - node->counts.begin();
+                    pos -= DynamicMultiPrefixSum::count_before(node, c);
+                    for (uint64_t d = c; d < node->counts.size(); d++)
+                    {
+                        node->counts[d]++;
+                        DynamicMultiPrefixSum::add(node->sums[d], value);
+                    }
+                    Node *new_child = DynamicMultiPrefixSum::insert_sub(node->children[c], pos, value);
+                    if (new_child != nullptr)
+                    {
+                        // The (c+1)-th prefix entries are the old c-th entries, which cover the new child
+                        node->children.insert(node->children.begin() + c + 1, new_child);
+                        node->counts.insert(node->counts.begin() + c + 1, node->counts[c]);
+                        node->sums.insert(node->sums.begin() + c + 1, node->sums[c]);
+                        DynamicMultiPrefixSum::refresh_child(node, c);
+                    }
+                }
+
+                if (DynamicMultiPrefixSum::degree_of(node) > DynamicMultiPrefixSum::max_degree_of(node))
+                {
+                    return DynamicMultiPrefixSum::split(node);
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+
+            /**
+             * @brief Merge or redistribute the underflowing child \p c of \p node with its neighbour.
+             */
+            static void rebalance_child(Node *node, uint64_t c)
+            {
+                uint64_t left_index = c > 0 ? c - 1 : c;
+                uint64_t right_index = left_index + 1;
+                if (right_index >= node->children.size())
+                {
+                    return;
+                }
+                Node *left = node->children[left_index];
+                Node *right = node->children[right_index];
+
+                if (left->is_leaf)
+                {
+                    left->values.insert(left->values.end(), right->values.begin(), right->values.end());
+                    right->values.clear();
+                }
+                else
+                {
+                    uint64_t count_offset = DynamicMultiPrefixSum::count_of(left);
+                    Tuple sum_offset = DynamicMultiPrefixSum::sums_of(left);
+                    for (uint64_t x = 0; x < right->children.size(); x++)
+                    {
+                        Tuple sum = right->sums[x];
+                        DynamicMultiPrefixSum::add(sum, sum_offset);
+                        left->children.push_back(right->children[x]);
+                        left->counts.push_back(right->counts[x] + count_offset);
+                        left->sums.push_back(sum);
+                    }
+                    right->children.clear();
+                    right->counts.clear();
+                    right->sums.clear();
+                }
+
+                if (DynamicMultiPrefixSum::degree_of(left) > DynamicMultiPrefixSum::max_degree_of(left))
+                {
+                    // The two children still cover the same tuples, so only the prefix entries between them change
+                    Node *new_right = DynamicMultiPrefixSum::split(left);
+                    delete right;
+                    node->children[right_index] = new_right;
+                    DynamicMultiPrefixSum::refresh_child(node, left_index);
+                }
+                else
+                {
+                    // The merged child covers the tuples of both children, which is the prefix entry of the right child
+                    delete right;
+                    node->children.erase(node->children.begin() + right_index);
+                    node->counts.erase(node->counts.begin() + left_index);
+                    node->sums.erase(node->sums.begin() + left_index);
+                }
+            }
+
+            /**
+             * @brief Remove the value at position \p pos in the subtree of \p node, and return the removed value.
+             */
+            static Tuple remove_sub(Node *node, uint64_t pos)
+            {
+                if (node->is_leaf)
+                {
+                    Tuple value = node->values[pos];
+                    node->values.erase(node->values.begin() + pos);
+                    return value;
+                }
+                else
+                {
+                    uint64_t c = DynamicMultiPrefixSum::find_child_for_access(node, pos);
+                    Tuple value = DynamicMultiPrefixSum::remove_sub(node->children[c], pos);
+                    for (uint64_t d = c; d < node->counts.size(); d++)
+                    {
+                        node->counts[d]--;
+                        DynamicMultiPrefixSum::subtract(node->sums[d], value);
+                    }
+
+                    Node *child = node->children[c];
+                    if (DynamicMultiPrefixSum::degree_of(child) < DynamicMultiPrefixSum::max_degree_of(child) / 2)
+                    {
+                        DynamicMultiPrefixSum::rebalance_child(node, c);
+                    }
+                    return value;
+                }
+            }
+
+            static void release(Node *node)
+            {
+                if (!node->is_leaf)
+                {
+                    for (Node *child : node->children)
+                    {
+                        DynamicMultiPrefixSum::release(child);
+                    }
+                }
+                delete node;
+            }
+
+            static void to_vector(const Node *node, std::vector<Tuple> &output)
+            {
+                if (node->is_leaf)
+                {
+                    output.insert(output.end(), node->values.begin(), node->values.end());
+                }
+                else
+                {
+                    for (const Node *child : node->children)
+                    {
+                        DynamicMultiPrefixSum::to_vector(child, output);
+                    }
+                }
+            }
+
+            static uint64_t size_in_bytes(const Node *node)
+            {
+                uint64_t sum = sizeof(Node);
+                sum += node->values.capacity() * sizeof(Tuple);
+                sum += node->children.capacity() * sizeof(Node *);
+                sum += node->counts.capacity() * sizeof(uint64_t);
+                sum += node->sums.capacity() * sizeof(Tuple);
+                if (!node->is_leaf)
+                {
+                    for (const Node *child : node->children)
+                    {
+                        sum += DynamicMultiPrefixSum::size_in_bytes(child);
+                    }
+                }
+                return sum;
+            }
+
+            static void verify_sub(const Node *node, bool is_root, uint64_t depth, uint64_t &leaf_depth, uint64_t &count, Tuple &sum)
+            {
+                if (!is_root && DynamicMultiPrefixSum::degree_of(node) < DynamicMultiPrefixSum::max_degree_of(node) / 2)
+                {
+                    throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). A node is underflowing.");
+                }
+                if (DynamicMultiPrefixSum::degree_of(node) > DynamicMultiPrefixSum::max_degree_of(node))
+                {
+                    throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). A node is overflowing.");
+                }
+                if (node->is_leaf)
+                {
+                    if (leaf_depth == UINT64_MAX)
+                    {
+                        leaf_depth = depth;
+                    }
+                    else if (leaf_depth != depth)
+                    {
+                        throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). The leaves have different depths.");
+                    }
+                    count += node->values.size();
+                    for (const Tuple &t : node->values)
+                    {
+                        DynamicMultiPrefixSum::add(sum, t);
+                    }
+                }
+                else
+                {
+                    if (node->counts.size() != node->children.size() || node->sums.size() != node->children.size())
+                    {
+                        throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). The arrays of an internal node have different lengths.");
+                    }
+                    for (uint64_t c = 0; c < node->children.size(); c++)
+                    {
+                        uint64_t child_count = 0;
+                        Tuple child_sum;
+                        child_sum.fill(0);
+                        DynamicMultiPrefixSum::verify_sub(node->children[c], false, depth + 1, leaf_depth, child_count, child_sum);
+                        Tuple expected_sum = DynamicMultiPrefixSum::sums_before(node, c);
+                        DynamicMultiPrefixSum::add(expected_sum, child_sum);
+                        if (DynamicMultiPrefixSum::count_before(node, c) + child_count != node->counts[c] || expected_sum != node->sums[c])
+                        {
+                            throw std::runtime_error("Error: DynamicMultiPrefixSum::verify(). The count or the sums of a child are inconsistent.");
+                        }
+                        count += child_count;
+                        DynamicMultiPrefixSum::add(sum, child_sum);
+                    }
+                }
+            }
+        };
+
+        using SimpleDynamicMultiPrefixSum2 = DynamicMultiPrefixSum<2, 62, 256>;
+
+    }
+}
@@ -223,14 +223,17 @@ namespace stool
 
             /**
              * @brief Return the sum of \p S[i..j].
-             * @note O(log n) time
+             * @note O(log n) time. If i > j, psum(j) - psum(i-1) is returned as before (e.g., 0 for the empty range S[j+1..j]).
              */
             uint64_t psum(uint64_t i, uint64_t j) const
             {
-                if(i > 0){
-                    return this->tree.psum(j) - this->tree.psum(i-1);
-                }else{
-                    return this->tree.psum(j);
+                if (i <= j)
+                {
+                    return this->tree.psum(i, j);
+                }
+                else
+                {
+                    return this->tree.psum(j) - this->tree.psum(i - 1);
                 }
             }
 
@@ -375,17 +378,11 @@ namespace stool
 
             /**
              * @brief Replaces the |Q| values \p S[i..i+|Q|-1] with the given values Q[0..|Q|-1]
-             * @note O(|Q| log n) time
+             * @note O(log n + |Q|) time
              */
             void set_values(uint64_t i, const std::vector<uint64_t> &values_Q)
             {
-                assert(i < this->size());
-                assert(i + values_Q.size() <= this->size());
-
-                for (uint64_t j = 0; j < values_Q.size(); j++)
-                {
-                    this->set_value(i + j, values_Q[j]);
-                }
+                this->tree.set_values(i, values_Q);
             }
 
             /**
@@ -619,6 +616,30 @@ namespace stool
                 return r;
             }
 
+            /**
+             * @brief Build a new DynamicPrefixSum from the values in [\p begin, \p end) in a single pass
+             * @note The input sequence is not materialized. Apart from the result, only one leaf buffer and O(height) pending children per layer are kept.
+             */
+            template <typename InputIterator>
+            static DynamicPrefixSum build(InputIterator begin, InputIterator end)
+            {
+                DynamicPrefixSum r;
+                r.tree.initialize();
+                r.tree.build(begin, end);
+                return r;
+            }
+
+            /**
+             * @brief Build a new DynamicPrefixSum from the integers stored in a stream \p is in a given format \p format (raw 64-bit integers or varints)
+             * @note The input sequence is not materialized. Apart from the result, only one leaf buffer and O(height) pending children per layer are kept.
+             */
+            static DynamicPrefixSum build_from_stream(std::istream &is, IntegerStreamIterator::Format format = IntegerStreamIterator::Format::RAW_UINT64)
+            {
+                IntegerStreamIterator begin(is, format);
+                IntegerStreamIterator end;
+                return DynamicPrefixSum::build(begin, end);
+            }
+
             /**
              * @brief Returns the DynamicPrefixSum instance loaded from a byte vector \p data at the position \p pos
              */
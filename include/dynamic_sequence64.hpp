@@ -193,6 +193,15 @@ namespace stool
                     this->decrement(i, old_v - v);
                 }
             }
+
+            /**
+             * @brief Replaces the |Q| values \p S[i..i+|Q|-1] with the given values Q[0..|Q|-1]
+             * @note O(log n + |Q|) time
+             */
+            void set_values(uint64_t i, const std::vector<uint64_t> &values_Q)
+            {
+                this->tree.set_values(i, values_Q);
+            }
             /**
              * @brief Set the value \p S[i+delta] at a given position \p i in \p S
              * @note \p O(log n) time
@@ -369,6 +378,30 @@ namespace stool
                 r.tree.build(items);
                 return r;
             }
+
+            /**
+             * @brief Build a new DynamicSequence64 from the values in [\p begin, \p end) in a single pass
+             * @note The input sequence is not materialized. Apart from the result, only one leaf buffer and O(height) pending children per layer are kept.
+             */
+            template <typename InputIterator>
+            static DynamicSequence64 build(InputIterator begin, InputIterator end)
+            {
+                DynamicSequence64 r;
+                r.tree.initialize();
+                r.tree.build(begin, end);
+                return r;
+            }
+
+            /**
+             * @brief Build a new DynamicSequence64 from the integers stored in a stream \p is in a given format \p format (raw 64-bit integers or varints)
+             * @note The input sequence is not materialized. Apart from the result, only one leaf buffer and O(height) pending children per layer are kept.
+             */
+            static DynamicSequence64 build_from_stream(std::istream &is, IntegerStreamIterator::Format format = IntegerStreamIterator::Format::RAW_UINT64)
+            {
+                IntegerStreamIterator begin(is, format);
+                IntegerStreamIterator end;
+                return DynamicSequence64::build(begin, end);
+            }
             /**
              * @brief Returns the DynamicSequence64 instance loaded from a byte vector \p data at the position \p pos
              */
@@ -0,0 +1,554 @@
+#pragma once
+#include "./dynamic_bit_sequence.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief A dynamic wavelet matrix supporting access, rank, and select queries on a string \p T[0..n-1] over integer symbols in [0, 2^H - 1]
+         * @details The H levels are stored in H dynamic bit sequences B_0, ..., B_{H-1}, where B_h stores the (H-1-h)-th bits of the symbols
+         *          stably sorted by their H-h highest bits. The number of 0s in B_h (Z_h) is given by B_h.count0() in O(1) time.
+         *          Unlike DynamicWaveletTree, the number of bit sequences is H = ceil(log σ), so the memory usage does not grow with the alphabet size σ.
+         * @tparam SYMBOL The type of the symbols (e.g., uint32_t or uint64_t)
+         * \ingroup WaveletTreeClasses
+         * \ingroup MainClasses
+         */
+        template <typename SYMBOL = uint32_t, typename BIT_SEQUENCE = SimpleDynamicBitSequence>
+        class DynamicWaveletMatrix
+        {
+            static_assert(std::is_unsigned<SYMBOL>::value && sizeof(SYMBOL) <= sizeof(uint64_t), "SYMBOL must be an unsigned integer type of at most 64 bits");
+
+            std::vector<BIT_SEQUENCE> bits_seq;
+
+        public:
+            using value_type = SYMBOL;
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Default constructor with |T| = 0 and H = the number of bits of SYMBOL
+             */
+            DynamicWaveletMatrix()
+            {
+                this->set_bit_width(sizeof(SYMBOL) * 8);
+            }
+
+            /**
+             * @brief Constructor with |T| = 0 and H = \p bit_width, i.e., the symbols must be less than 2^H
+             */
+            DynamicWaveletMatrix(uint64_t bit_width)
+            {
+                this->set_bit_width(bit_width);
+            }
+
+            /**
+             * @brief Deleted copy constructor.
+             */
+            DynamicWaveletMatrix(const DynamicWaveletMatrix &) = delete;
+
+            /**
+             * @brief Default move constructor.
+             */
+            DynamicWaveletMatrix(DynamicWaveletMatrix &&) noexcept = default;
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Deleted copy assignment operator.
+             */
+            DynamicWaveletMatrix &operator=(const DynamicWaveletMatrix &) = delete;
+
+            /**
+             * @brief Default move assignment operator.
+             */
+            DynamicWaveletMatrix &operator=(DynamicWaveletMatrix &&) noexcept = default;
+
+            /**
+             * @brief The alias for at query
+             */
+            SYMBOL operator[](uint64_t i) const
+            {
+                return this->at(i);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Lightweight functions for accessing to properties of this class
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return |T|
+             */
+            uint64_t size() const
+            {
+                return this->bits_seq.size() > 0 ? this->bits_seq[0].size() : 0;
+            }
+
+            /**
+             * @brief Checks if \p T is empty.
+             */
+            bool empty() const
+            {
+                return this->size() == 0;
+            }
+
+            /**
+             * @brief Return the number of levels H (i.e., the symbols must be less than 2^H)
+             */
+            uint64_t height() const
+            {
+                return this->bits_seq.size();
+            }
+
+            /**
+             * @brief Return the number of 0s in the bit sequence of the \p h-th level
+             * @note O(1) time
+             */
+            uint64_t get_zero_count(uint64_t h) const
+            {
+                return this->bits_seq[h].count0();
+            }
+
+            /**
+             * @brief Return the smallest H such that every symbol in [0, \p max_symbol] is less than 2^H
+             */
+            static uint64_t get_bit_width(uint64_t max_symbol)
+            {
+                uint64_t h = 1;
+                while (h < 64 && (max_symbol >> h) > 0)
+                {
+                    h++;
+                }
+                return h;
+            }
+
+            /**
+             * @brief Returns the total memory usage in bytes
+             * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
+             */
+            uint64_t size_in_bytes(bool only_dynamic_memory = false) const
+            {
+                uint64_t total_size_in_bytes = only_dynamic_memory ? 0 : sizeof(DynamicWaveletMatrix);
+                for (const BIT_SEQUENCE &seq : this->bits_seq)
+                {
+                    total_size_in_bytes += seq.size_in_bytes(only_dynamic_memory);
+                }
+                return total_size_in_bytes;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Main queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return \p T[i]
+             * @note O(H log n) time
+             */
+            SYMBOL at(uint64_t i) const
+            {
+                if (i >= this->size())
+                {
+                    throw std::range_error("Error: DynamicWaveletMatrix::at(i)");
+                }
+                uint64_t c = 0;
+                for (uint64_t h = 0; h < this->height(); h++)
+                {
+                    const BIT_SEQUENCE &bits = this->bits_seq[h];
+                    bool b = bits.at(i);
+                    c = (c << 1) | (b ? 1 : 0);
+                    i = b ? bits.count0() + bits.one_based_rank1(i) : bits.one_based_rank0(i);
+                }
+                return c;
+            }
+
+            /**
+             * @brief Counts the number of occurrences of a symbol \p c in \p T[0..i-1].
+             * @note O(H log n) time
+             */
+            int64_t one_based_rank(uint64_t i, SYMBOL c) const
+            {
+                if (i > this->size())
+                {
+                    throw std::range_error("Error: DynamicWaveletMatrix::one_based_rank(i, c)");
+                }
+                if (!this->is_valid_symbol(c))
+                {
+                    return 0;
+                }
+                uint64_t begin = 0;
+                uint64_t end = i;
+                for (uint64_t h = 0; h < this->height() && begin < end; h++)
+                {
+                    const BIT_SEQUENCE &bits = this->bits_seq[h];
+                    if (this->get_bit(c, h))
+                    {
+                        uint64_t z = bits.count0();
+                        begin = z + bits.one_based_rank1(begin);
+                        end = z + bits.one_based_rank1(end);
+                    }
+                    else
+                    {
+                        begin = bits.one_based_rank0(begin);
+                        end = bits.one_based_rank0(end);
+                    }
+                }
+                return end - begin;
+            }
+
+            /**
+             * @brief Returns the position of the (i+1)-th occurrence of a symbol \p c in \p T if such a position exists, otherwise returns -1
+             * @note O(H log n) time
+             */
+            int64_t select(uint64_t i, SYMBOL c) const
+            {
+                uint64_t _height = this->height();
+                if (!this->is_valid_symbol(c) || _height == 0)
+                {
+                    return -1;
+                }
+
+                // [begin, end) is the range of the occurrences of c after the last level.
+                uint64_t begin = 0;
+                uint64_t end = this->size();
+                for (uint64_t h = 0; h < _height; h++)
+                {
+                    const BIT_SEQUENCE &bits = this->bits_seq[h];
+                    if (this->get_bit(c, h))
+                    {
+                        uint64_t z = bits.count0();
+                        begin = z + bits.one_based_rank1(begin);
+                        end = z + bits.one_based_rank1(end);
+                    }
+                    else
+                    {
+                        begin = bits.one_based_rank0(begin);
+                        end = bits.one_based_rank0(end);
+                    }
+                }
+                if (begin + i >= end)
+                {
+                    return -1;
+                }
+
+                uint64_t p = begin + i;
+                for (int64_t h = _height - 1; h >= 0; h--)
+                {
+                    const BIT_SEQUENCE &bits = this->bits_seq[h];
+                    if (this->get_bit(c, h))
+                    {
+                        p = bits.select1(p - bits.count0());
+                    }
+                    else
+                    {
+                        p = bits.select0(p);
+                    }
+                }
+                return p;
+            }
+
+            /**
+             * @brief Return the number of occurrences of a symbol \p c in \p T
+             * @note O(H log n) time
+             */
+            uint64_t count_c(SYMBOL c) const
+            {
+                return this->one_based_rank(this->size(), c);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return \p T as a vector
+             * @note O(n H log n) time
+             */
+            std::vector<SYMBOL> to_vector() const
+            {
+                std::vector<SYMBOL> r;
+                r.resize(this->size());
+                for (uint64_t i = 0; i < r.size(); i++)
+                {
+                    r[i] = this->at(i);
+                }
+                return r;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Swap operation
+             */
+            void swap(DynamicWaveletMatrix &item)
+            {
+                this->bits_seq.swap(item.bits_seq);
+            }
+
+            /**
+             * @brief Clear the elements in \p T
+             */
+            void clear()
+            {
+                for (BIT_SEQUENCE &bits : this->bits_seq)
+                {
+                    bits.clear();
+                }
+            }
+
+            /**
+             * @brief Initialize this instance with |T| = 0 and H = \p bit_width
+             */
+            void set_bit_width(uint64_t bit_width)
+            {
+                if (bit_width == 0 || bit_width > sizeof(SYMBOL) * 8)
+                {
+                    throw std::invalid_argument("Error: DynamicWaveletMatrix::set_bit_width(bit_width). The bit width must be in [1, the number of bits of SYMBOL].");
+                }
+                this->bits_seq.clear();
+                this->bits_seq.resize(bit_width);
+            }
+
+            /**
+             * @brief Insert a symbol \p c into \p T as \p T[i]
+             * @note O(H log n) time
+             */
+            void insert(uint64_t i, SYMBOL c)
+            {
+                if (i > this->size())
+                {
+                    throw std::range_error("Error: DynamicWaveletMatrix::insert(i, c)");
+                }
+                if (!this->is_valid_symbol(c))
+                {
+                    throw std::invalid_argument("Error: DynamicWaveletMatrix::insert(i, c). The symbol c must be less than 2^H.");
+                }
+                for (uint64_t h = 0; h < this->height(); h++)
+                {
+                    BIT_SEQUENCE &bits = this->bits_seq[h];
+                    bool b = this->get_bit(c, h);
+                    bits.insert(i, b);
+                    i = b ? bits.count0() + bits.one_based_rank1(i) : bits.one_based_rank0(i);
+                }
+            }
+
+            /**
+             * @brief Adds a symbol \p c to the end of \p T.
+             * @note O(H log n) time
+             */
+            void push_back(SYMBOL c)
+            {
+                this->insert(this->size(), c);
+            }
+
+            /**
+             * @brief Add a given sequence \p Q[0..k-1] to the end of \p T[0..n-1] (i.e., \p T = T[0..n-1]Q[0..k-1])
+             * @note O(|Q| H log n) time
+             */
+            void push_many(const std::vector<SYMBOL> &items_Q)
+            {
+                for (SYMBOL c : items_Q)
+                {
+                    this->push_back(c);
+                }
+            }
+
+            /**
+             * @brief Remove the symbol at the position \p i from \p T
+             * @note O(H log n) time
+             */
+            void remove(uint64_t i)
+            {
+                if (i >= this->size())
+                {
+                    throw std::range_error("Error: DynamicWaveletMatrix::remove(i)");
+                }
+                for (uint64_t h = 0; h < this->height(); h++)
+                {
+                    BIT_SEQUENCE &bits = this->bits_seq[h];
+                    bool b = bits.at(i);
+                    uint64_t next_i = b ? bits.count0() + bits.one_based_rank1(i) : bits.one_based_rank0(i);
+                    bits.remove(i);
+                    i = next_i;
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Print and verification functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the memory usage information of this data structure as a vector of strings
+             * @param message_paragraph The paragraph depth of message logs (-1 for no output)
+             */
+            std::vector<std::string> get_memory_usage_info(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::vector<std::string> r;
+                r.push_back(stool::Message::get_paragraph_string(message_paragraph) + "=DynamicWaveletMatrix: " + std::to_string(this->size_in_bytes()) + " bytes =");
+                for (const BIT_SEQUENCE &bits : this->bits_seq)
+                {
+                    std::vector<std::string> log1 = bits.get_memory_usage_info(message_paragraph + 1);
+                    for (auto &s : log1)
+                    {
+                        r.push_back(s);
+                    }
+                }
+                r.push_back(stool::Message::get_paragraph_string(message_paragraph) + "==");
+                return r;
+            }
+
+            /**
+             * @brief Print the statistics of this data structure
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            void print_statistics(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "Statistics(DynamicWaveletMatrix):" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Bit width: " << this->height() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Text length: " << this->size() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph + 1) << "Estimated memory usage: " << this->size_in_bytes() << " bytes" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "[END]" << std::endl;
+            }
+
+            /**
+             * @brief Print the memory usage information of this data structure
+             * @param message_paragraph The paragraph depth of message logs
+             */
+            void print_memory_usage(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::vector<std::string> log = this->get_memory_usage_info(message_paragraph);
+                for (std::string &s : log)
+                {
+                    std::cout << s << std::endl;
+                }
+            }
+
+            /**
+             * @brief Verify the internal consistency of this data structure
+             */
+            void verify() const
+            {
+                for (uint64_t h = 0; h < this->height(); h++)
+                {
+                    if (this->bits_seq[h].size() != this->size())
+                    {
+                        throw std::logic_error("Error: DynamicWaveletMatrix::verify(). The levels have different lengths.");
+                    }
+                    this->bits_seq[h].verify();
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Load, save, and builder functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Build a new DynamicWaveletMatrix with H = \p bit_width from a given sequence \p text
+             * @details Each level is built from the stable partition of the previous level by one call of BIT_SEQUENCE::build.
+             * @note O(n H) time
+             */
+            static DynamicWaveletMatrix build(const std::vector<SYMBOL> &text, uint64_t bit_width)
+            {
+                DynamicWaveletMatrix r(bit_width);
+                std::vector<SYMBOL> current = text;
+                std::vector<SYMBOL> next;
+                next.resize(text.size());
+                std::vector<bool> bits;
+                bits.resize(text.size());
+                for (uint64_t h = 0; h < bit_width; h++)
+                {
+                    uint64_t zero_count = 0;
+                    for (uint64_t i = 0; i < current.size(); i++)
+                    {
+                        if (!r.is_valid_symbol(current[i]))
+                        {
+                            throw std::invalid_argument("Error: DynamicWaveletMatrix::build(text, bit_width). The symbols must be less than 2^H.");
+                        }
+                        bits[i] = r.get_bit(current[i], h);
+                        zero_count += bits[i] ? 0 : 1;
+                    }
+                    uint64_t zero_pos = 0;
+                    uint64_t one_pos = zero_count;
+                    for (uint64_t i = 0; i < current.size(); i++)
+                    {
+                        next[bits[i] ? one_pos++ : zero_pos++] = current[i];
+                    }
+                    BIT_SEQUENCE seq = BIT_SEQUENCE::build(bits);
+                    r.bits_seq[h].swap(seq);
+                    current.swap(next);
+                }
+                return r;
+            }
+
+            /**
+             * @brief Returns the DynamicWaveletMatrix instance loaded from a file stream \p ifs
+             */
+            static DynamicWaveletMatrix load_from_file(std::ifstream &ifs)
+            {
+                uint64_t bit_width = 0;
+                ifs.read(reinterpret_cast<char *>(&bit_width), sizeof(uint64_t));
+                DynamicWaveletMatrix r(bit_width);
+                for (BIT_SEQUENCE &seq : r.bits_seq)
+                {
+                    auto bits = BIT_SEQUENCE::load_from_file(ifs);
+                    seq.swap(bits);
+                }
+                return r;
+            }
+
+            /**
+             * @brief Save the given instance \p item to a file stream \p os
+             */
+            static void store_to_file(DynamicWaveletMatrix &item, std::ofstream &os)
+            {
+                uint64_t bit_width = item.height();
+                os.write(reinterpret_cast<const char *>(&bit_width), sizeof(uint64_t));
+                for (BIT_SEQUENCE &seq : item.bits_seq)
+                {
+                    BIT_SEQUENCE::store_to_file(seq, os);
+                }
+            }
+            //@}
+
+        private:
+            /**
+             * @brief Return the bit of a symbol \p c stored in the \p h-th level, i.e., the (H-1-h)-th bit of \p c
+             */
+            bool get_bit(uint64_t c, uint64_t h) const
+            {
+                return (c >> (this->height() - 1 - h)) & 1ULL;
+            }
+
+            bool is_valid_symbol(uint64_t c) const
+            {
+                return this->height() >= 64 || (c >> this->height()) == 0;
+            }
+        };
+
+        /**
+         * @brief A dynamic wavelet matrix over 32-bit symbols
+         * \ingroup WaveletTreeClasses
+         */
+        using DynamicWaveletMatrix32 = DynamicWaveletMatrix<uint32_t, SimpleDynamicBitSequence>;
+
+        /**
+         * @brief A dynamic wavelet matrix over 64-bit symbols
+         * \ingroup WaveletTreeClasses
+         */
+        using DynamicWaveletMatrix64 = DynamicWaveletMatrix<uint64_t, SimpleDynamicBitSequence>;
+    }
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <queue>
 #include "./dynamic_bit_sequence.hpp"
 
 namespace stool
@@ -14,11 +15,224 @@ namespace stool
         {
             using BIT_SEQUENCE = SimpleDynamicBitSequence;
             std::vector<std::vector<BIT_SEQUENCE>> bits_seq;
+            std::vector<std::vector<FrozenBitSequence>> frozen_bits_seq;
             std::vector<int64_t> char_rank_vec;
+            // alphabet[r] is the character of the r-th leaf
             std::vector<uint8_t> alphabet;
             uint64_t rank_bit_size = 0;
+            // true if the leaves are sorted in the lexicographic order of their characters
+            bool has_sorted_leaves = true;
+
+            template <typename FUNC>
+            auto visit_levels(FUNC func) const
+            {
+                if (this->frozen_bits_seq.size() > 0)
+                {
+                    return func(this->frozen_bits_seq);
+                }
+                else
+                {
+                    return func(this->bits_seq);
+                }
+            }
 
         public:
+            /**
+             * @brief Forward iterator over the characters \p T[i..n-1].
+             * @details The characters are decoded by extract() in chunks of BUFFER_SIZE characters, so each character costs O(log σ) amortized time.
+             *          The iterator is invalidated by update operations.
+             */
+            class CharacterForwardIterator
+            {
+            public:
+                static inline constexpr uint64_t BUFFER_SIZE = 4096;
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = uint8_t;
+                using difference_type = std::ptrdiff_t;
+
+                const DynamicWaveletTree *container = nullptr;
+                uint64_t position = 0;
+                uint64_t buffer_position = 0;
+                std::vector<uint8_t> buffer;
+
+                /** @brief Default constructor creating an end iterator. */
+                CharacterForwardIterator() : container(nullptr), position(0) {}
+
+                /** @brief Construct an iterator pointing to \p T[i]. */
+                CharacterForwardIterator(const DynamicWaveletTree *_container, uint64_t i) : container(_container), position(i)
+                {
+                    this->fill_buffer();
+                }
+
+                /** @brief Return the current character. */
+                uint8_t operator*() const
+                {
+                    return this->buffer[this->position - this->buffer_position];
+                }
+
+                /** @brief Pre-increment: move to the next character. */
+                CharacterForwardIterator &operator++()
+                {
+                    this->position++;
+                    if (this->position == this->buffer_position + this->buffer.size())
+                    {
+                        this->fill_buffer();
+                    }
+                    return *this;
+                }
+
+                /** @brief Post-increment: move to the next character and return the previous state. */
+                CharacterForwardIterator operator++(int)
+                {
+                    CharacterForwardIterator tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+
+                /** @brief Return the position of the current character. */
+                uint64_t index() const
+                {
+                    return this->position;
+                }
+
+                /** @brief Return true if this iterator points to the end of \p T. */
+                bool is_end() const
+                {
+                    return this->container == nullptr || this->position >= this->container->size();
+                }
+
+                /** @brief Equality comparison (all end iterators are equal). */
+                bool operator==(const CharacterForwardIterator &other) const
+                {
+                    if (this->is_end() || other.is_end())
+                    {
+                        return this->is_end() && other.is_end();
+                    }
+                    return this->container == other.container && this->position == other.position;
+                }
+
+                /** @brief Inequality comparison. */
+                bool operator!=(const CharacterForwardIterator &other) const
+                {
+                    return !(*this == other);
+                }
+
+            private:
+                void fill_buffer()
+                {
+                    this->buffer_position = this->position;
+                    if (!this->is_end())
+                    {
+                        uint64_t end = std::min<uint64_t>(this->position + BUFFER_SIZE, this->container->size());
+                        this->container->extract(this->position, end, this->buffer);
+                    }
+                    else
+                    {
+                        this->buffer.clear();
+                    }
+                }
+            };
+
+            /**
+             * @brief Forward iterator over the positions of a character \p c in \p T[i..j-1] in increasing order.
+             * @details The iterator keeps, for every level on the path to the leaf of \p c, a cursor on the leaf of the bit sequence containing the current occurrence.
+             *          The next occurrence is selected bottom-up inside these leaves, and a level descends from the root of its bit sequence only when the answer is in another leaf.
+             *          Hence each occurrence costs O(log σ) leaf-local select queries plus O(log n) time for each level whose cursor moves to another leaf,
+             *          instead of the O(log σ log n) time of select(k, c). The iterator is invalidated by update operations.
+             */
+            class OccurrenceForwardIterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = uint64_t;
+                using difference_type = std::ptrdiff_t;
+
+                const DynamicWaveletTree *container = nullptr;
+                uint64_t c_rank = 0;
+                // the current occurrence is the (occurrence_rank+1)-th c in T
+                uint64_t occurrence_rank = 0;
+                uint64_t end_rank = 0;
+                // positions[h] is the position of the current occurrence in the bit sequence of the node at level h
+                std::vector<uint64_t> positions;
+                // cursors[h] is on the leaf of the bit sequence at level h containing positions[h]
+                std::vector<typename BIT_SEQUENCE::LeafCursor> cursors;
+
+                /** @brief Default constructor creating an end iterator. */
+                OccurrenceForwardIterator() : container(nullptr) {}
+
+                /** @brief Construct an iterator pointing to the first occurrence of the character with the lexicographic order \p _c_rank in \p T[i..j-1]. */
+                OccurrenceForwardIterator(const DynamicWaveletTree *_container, uint64_t _c_rank, uint64_t i, uint64_t j) : container(_container), c_rank(_c_rank)
+                {
+                    this->occurrence_rank = i == 0 ? 0 : this->container->rank_sub(i - 1, this->c_rank);
+                    this->end_rank = j == 0 ? 0 : this->container->rank_sub(j - 1, this->c_rank);
+                    if (!this->is_end())
+                    {
+                        uint64_t _height = this->container->height();
+                        this->positions.resize(_height);
+                        this->cursors.resize(_height);
+                        this->select_positions();
+                    }
+                }
+
+                /** @brief Return the position of the current occurrence in \p T. */
+                uint64_t operator*() const
+                {
+                    return this->positions[0];
+                }
+
+                /** @brief Pre-increment: move to the next occurrence. */
+                OccurrenceForwardIterator &operator++()
+                {
+                    this->occurrence_rank++;
+                    if (!this->is_end())
+                    {
+                        this->select_positions();
+                    }
+                    return *this;
+                }
+
+                /** @brief Post-increment: move to the next occurrence and return the previous state. */
+                OccurrenceForwardIterator operator++(int)
+                {
+                    OccurrenceForwardIterator tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+
+                /** @brief Return true if all the occurrences have been reported. */
+                bool is_end() const
+                {
+                    return this->container == nullptr || this->occurrence_rank >= this->end_rank;
+                }
+
+                /** @brief Equality comparison (all end iterators are equal). */
+                bool operator==(const OccurrenceForwardIterator &other) const
+                {
+                    if (this->is_end() || other.is_end())
+                    {
+                        return this->is_end() && other.is_end();
+                    }
+                    return this->container == other.container && this->c_rank == other.c_rank && this->occurrence_rank == other.occurrence_rank;
+                }
+
+                /** @brief Inequality comparison. */
+                bool operator!=(const OccurrenceForwardIterator &other) const
+                {
+                    return !(*this == other);
+                }
+
+            private:
+                void select_positions()
+                {
+                    uint64_t q = this->occurrence_rank;
+                    for (int64_t h = this->positions.size() - 1; h >= 0; h--)
+                    {
+                        this->positions[h] = this->container->select_on_path(h, this->c_rank, q, this->cursors[h]);
+                        q = this->positions[h];
+                    }
+                }
+            };
+
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Constructors and Destructor
             ////////////////////////////////////////////////////////////////////////////////
@@ -52,6 +266,52 @@ namespace stool
 
             //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Iterators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return an iterator pointing to \p T[i]
+             */
+            CharacterForwardIterator get_char_forward_iterator_begin(uint64_t i = 0) const
+            {
+                return CharacterForwardIterator(this, i);
+            }
+
+            /**
+             * @brief Return an iterator pointing to the end of \p T
+             */
+            CharacterForwardIterator get_char_forward_iterator_end() const
+            {
+                return CharacterForwardIterator();
+            }
+
+            /**
+             * @brief Return an iterator over the positions of the character \p c in \p T[i..j-1]
+             */
+            OccurrenceForwardIterator get_occurrence_iterator_begin(uint64_t i, uint64_t j, uint8_t c) const
+            {
+                if (i > j || j > this->size())
+                {
+                    throw std::range_error("Error: DynamicSequence::get_occurrence_iterator_begin(i, j, c)");
+                }
+                int64_t c_rank = this->get_lexicographic_order(c);
+                if (c_rank == -1 || i == j)
+                {
+                    return OccurrenceForwardIterator();
+                }
+                return OccurrenceForwardIterator(this, c_rank, i, j);
+            }
+
+            /**
+             * @brief Return the end iterator of get_occurrence_iterator_begin(i, j, c)
+             */
+            OccurrenceForwardIterator get_occurrence_iterator_end() const
+            {
+                return OccurrenceForwardIterator();
+            }
+            //@}
+
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Operators
             ////////////////////////////////////////////////////////////////////////////////
@@ -115,14 +375,25 @@ namespace stool
             uint64_t get_smallest_character_in_alphabet() const
             {
                 assert(this->alphabet.size() > 0);
-                return this->alphabet[0];
+                return *std::min_element(this->alphabet.begin(), this->alphabet.end());
             }
             /**
              * @brief Return the lexicographic order of a given character \p c in the alphabet \p U if it exists, otherwise returns -1
+             * @note If has_lexicographic_leaf_order() is false, the returned value is the index of the leaf of \p c, which may differ from the lexicographic order.
              */
             int64_t get_lexicographic_order(uint8_t c) const
             {
-                return this->char_rank_vec[c];
+                return this->char_rank_vec.size() > 0 ? this->char_rank_vec[c] : -1;
+            }
+
+            /**
+             * @brief Return true if the leaves of this wavelet tree are sorted in the lexicographic order of their characters
+             * @details This property holds unless add_character has added a character smaller than another character in \p U.
+             *          If it does not hold, range_quantile, range_frequency, and range_top_k visit all the leaves having characters in the range.
+             */
+            bool has_lexicographic_leaf_order() const
+            {
+                return this->has_sorted_leaves;
             }
 
             /**
@@ -132,6 +403,14 @@ namespace stool
             {
                 return this->bits_seq.size();
             }
+
+            /**
+             * @brief Return true if the bit sequences of this wavelet tree are frozen (see freeze()).
+             */
+            bool is_frozen() const
+            {
+                return this->frozen_bits_seq.size() > 0;
+            }
             /**
              * @brief Returns the total memory usage in bytes
              * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
@@ -146,6 +425,13 @@ namespace stool
                         total_size_in_bytes += seq.size_in_bytes(only_dynamic_memory);
                     }
                 }
+                for (uint64_t h = 0; h < this->frozen_bits_seq.size(); h++)
+                {
+                    for (const FrozenBitSequence &seq : this->frozen_bits_seq[h])
+                    {
+                        total_size_in_bytes += seq.size_in_bytes(only_dynamic_memory);
+                    }
+                }
                 return total_size_in_bytes;
             }
 
@@ -236,15 +522,17 @@ namespace stool
                 {
                     if (i < this->size())
                     {
-                        uint64_t next_nth = i;
-                        uint64_t j = 0;
-                        for (int64_t h = 0; h < (int64_t)this->height(); h++)
-                        {
-                            bool b = this->bits_seq[h][j].at(next_nth);
-                            next_nth = this->bits_seq[h][j].one_based_rank(next_nth, b);
-                            j = (j * 2) + (b ? 1 : 0);
-                        }
-                        return j;
+                        return this->visit_levels([&](const auto &levels)
+                                                  {
+                            uint64_t next_nth = i;
+                            uint64_t j = 0;
+                            for (int64_t h = 0; h < (int64_t)this->height(); h++)
+                            {
+                                bool b = levels[h][j].at(next_nth);
+                                next_nth = levels[h][j].one_based_rank(next_nth, b);
+                                j = (j * 2) + (b ? 1 : 0);
+                            }
+                            return j; });
                     }
                     else
                     {
@@ -279,6 +567,160 @@ namespace stool
 
             //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Range queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the (k+1)-th smallest character in \p T[i..j-1]
+             * @note O(log σ log n) time (O(σ log σ log n) time if has_lexicographic_leaf_order() is false)
+             */
+            uint8_t range_quantile(uint64_t i, uint64_t j, uint64_t k) const
+            {
+                if (i >= j || j > this->size() || k >= j - i)
+                {
+                    throw std::range_error("Error: DynamicSequence::range_quantile(i, j, k)");
+                }
+                if (!this->has_sorted_leaves)
+                {
+                    std::vector<std::tuple<uint8_t, uint64_t, uint64_t>> items = this->interval_symbols(i, j);
+                    std::sort(items.begin(), items.end());
+                    for (auto [c, rank_i, rank_j] : items)
+                    {
+                        if (k < rank_j - rank_i)
+                        {
+                            return c;
+                        }
+                        k -= rank_j - rank_i;
+                    }
+                    throw std::logic_error("Error: DynamicSequence::range_quantile(i, j, k)");
+                }
+                return this->visit_levels([&](const auto &levels) -> uint8_t
+                                          {
+                    uint64_t b = i;
+                    uint64_t e = j;
+                    uint64_t node_id = 0;
+                    for (uint64_t h = 0; h < this->height(); h++)
+                    {
+                        const auto &bits = levels[h][node_id];
+                        uint64_t b1 = bits.one_based_rank1(b);
+                        uint64_t e1 = bits.one_based_rank1(e);
+                        uint64_t zeros = (e - b) - (e1 - b1);
+                        if (k < zeros)
+                        {
+                            b -= b1;
+                            e -= e1;
+                            node_id = node_id * 2;
+                        }
+                        else
+                        {
+                            k -= zeros;
+                            b = b1;
+                            e = e1;
+                            node_id = (node_id * 2) + 1;
+                        }
+                    }
+                    return this->alphabet[node_id]; });
+            }
+
+            /**
+             * @brief Return the number of characters \p c in \p T[i..j-1] such that \p a <= \p c <= \p b
+             * @note O(log σ log n) time (O(σ log σ log n) time if has_lexicographic_leaf_order() is false)
+             */
+            uint64_t range_frequency(uint64_t i, uint64_t j, uint8_t a, uint8_t b) const
+            {
+                if (i > j || j > this->size())
+                {
+                    throw std::range_error("Error: DynamicSequence::range_frequency(i, j, a, b)");
+                }
+                if (i == j || a > b)
+                {
+                    return 0;
+                }
+                if (!this->has_sorted_leaves)
+                {
+                    uint64_t sum = 0;
+                    this->interval_symbols(i, j, [&](uint8_t c, uint64_t rank_i, uint64_t rank_j)
+                                           {
+                        if (a <= c && c <= b)
+                        {
+                            sum += rank_j - rank_i;
+                        } });
+                    return sum;
+                }
+                uint64_t lower_rank = std::lower_bound(this->alphabet.begin(), this->alphabet.end(), a) - this->alphabet.begin();
+                uint64_t upper_rank = std::upper_bound(this->alphabet.begin(), this->alphabet.end(), b) - this->alphabet.begin();
+                if (lower_rank >= upper_rank)
+                {
+                    return 0;
+                }
+                return this->count_smaller_ranks(i, j, upper_rank) - this->count_smaller_ranks(i, j, lower_rank);
+            }
+
+            /**
+             * @brief Return the \p k most frequent characters in \p T[i..j-1] with their frequencies
+             * @details The characters are sorted in decreasing order of frequency, and characters with the same frequency are sorted in increasing order.
+             *          The nodes are visited in decreasing order of the number of characters in the range, so only the nodes above the reported leaves (and their siblings) are visited.
+             * @note O(k' log σ (log n + log (k' log σ))) time, where k' <= min(k, σ) is the number of reported characters
+             *       (O(σ log σ log n) time if has_lexicographic_leaf_order() is false)
+             */
+            std::vector<std::pair<uint8_t, uint64_t>> range_top_k(uint64_t i, uint64_t j, uint64_t k) const
+            {
+                if (i > j || j > this->size())
+                {
+                    throw std::range_error("Error: DynamicSequence::range_top_k(i, j, k)");
+                }
+                if (this->has_sorted_leaves)
+                {
+                    return this->range_top_k_sub(i, j, k);
+                }
+                else
+                {
+                    // Ties are broken by the characters after all the leaves are collected
+                    std::vector<std::pair<uint8_t, uint64_t>> r;
+                    this->interval_symbols(i, j, [&](uint8_t c, uint64_t rank_i, uint64_t rank_j)
+                                           { r.push_back(std::pair<uint8_t, uint64_t>(c, rank_j - rank_i)); });
+                    std::sort(r.begin(), r.end(), [](const auto &x, const auto &y)
+                              { return x.second != y.second ? x.second > y.second : x.first < y.first; });
+                    r.resize(std::min<uint64_t>(k, r.size()));
+                    return r;
+                }
+            }
+
+            /**
+             * @brief Call \p func(c, r_i, r_j) for each distinct character \p c in \p T[i..j-1], where r_i and r_j are the numbers of \p c in \p T[0..i-1] and \p T[0..j-1]
+             * @details The wavelet tree is traversed once from the root, and the subtrees whose ranges are empty are pruned.
+             *          The characters are reported in the leaf order, i.e., in increasing order if has_lexicographic_leaf_order() is true.
+             * @note O(k log σ log n) time, where k is the number of distinct characters in \p T[i..j-1]
+             */
+            template <typename FUNC>
+            void interval_symbols(uint64_t i, uint64_t j, FUNC func) const
+            {
+                if (i > j || j > this->size())
+                {
+                    throw std::range_error("Error: DynamicSequence::interval_symbols(i, j, func)");
+                }
+                if (i < j)
+                {
+                    this->visit_levels([&](const auto &levels)
+                                       { this->interval_symbols_sub(levels, 0, 0, i, j, func); });
+                }
+            }
+
+            /**
+             * @brief Return the triples (c, r_i, r_j) reported by interval_symbols(i, j, func)
+             * @note O(k log σ log n) time, where k is the number of distinct characters in \p T[i..j-1]
+             */
+            std::vector<std::tuple<uint8_t, uint64_t, uint64_t>> interval_symbols(uint64_t i, uint64_t j) const
+            {
+                std::vector<std::tuple<uint8_t, uint64_t, uint64_t>> r;
+                this->interval_symbols(i, j, [&](uint8_t c, uint64_t rank_i, uint64_t rank_j)
+                                       { r.push_back(std::tuple<uint8_t, uint64_t, uint64_t>(c, rank_i, rank_j)); });
+                return r;
+            }
+            //@}
+
             ////////////////////////////////////////////////////////////////////////////////
             ///   @name Conversion functions
             ////////////////////////////////////////////////////////////////////////////////
@@ -286,30 +728,47 @@ namespace stool
 
             /**
              * @brief Return \p T as a string
+             * @note O(n log σ + σ log n) time
              */
             std::string to_string() const
             {
-                std::string s;
-                s.resize(this->size());
-                for (uint64_t i = 0; i < this->size(); i++)
-                {
-                    s[i] = this->at(i);
-                }
-                return s;
+                std::vector<uint8_t> chars;
+                this->extract(0, this->size(), chars);
+                return std::string(chars.begin(), chars.end());
             }
 
             /**
              * @brief Return \p T as a vector of uint8_t
+             * @note O(n log σ + σ log n) time
              */
             std::vector<uint8_t> to_u8_vector() const
             {
                 std::vector<uint8_t> s;
-                s.resize(this->size());
-                for (uint64_t i = 0; i < this->size(); i++)
+                this->extract(0, this->size(), s);
+                return s;
+            }
+
+            /**
+             * @brief Write \p T[i..j-1] to \p output (\p output is resized to j-i).
+             * @details The bits of the range are read from each visited node with one extract_words call, the ranges of the two children are computed by two rank queries,
+             *          and the characters decoded in the children are merged by the bits of the node. Hence, no root-to-leaf descent is performed per character.
+             * @note O((j-i) log σ + k log n) time, where k (<= min(2σ, 2(j-i) log σ)) is the number of visited nodes
+             */
+            void extract(uint64_t i, uint64_t j, std::vector<uint8_t> &output) const
+            {
+                if (i > j || j > this->size())
                 {
-                    s[i] = this->at(i);
+                    throw std::range_error("Error: DynamicSequence::extract(i, j, output)");
+                }
+                output.resize(j - i);
+                if (i < j)
+                {
+                    this->extract_sub(0, 0, i, j, output.data());
+                    for (uint8_t &c : output)
+                    {
+                        c = this->alphabet[c];
+                    }
                 }
-                return s;
             }
 
             /**
@@ -318,6 +777,7 @@ namespace stool
             std::vector<uint8_t> to_alphabet_vector() const
             {
                 std::vector<uint8_t> r = this->alphabet;
+                std::sort(r.begin(), r.end());
                 return r;
             }
 
@@ -334,10 +794,69 @@ namespace stool
             void swap(DynamicWaveletTree &item)
             {
                 this->bits_seq.swap(item.bits_seq);
+                this->frozen_bits_seq.swap(item.frozen_bits_seq);
 
                 this->char_rank_vec.swap(item.char_rank_vec);
                 this->alphabet.swap(item.alphabet);
                 std::swap(this->rank_bit_size, item.rank_bit_size);
+                std::swap(this->has_sorted_leaves, item.has_sorted_leaves);
+            }
+
+            /**
+             * @brief Freeze all the bit sequences of this wavelet tree, i.e., build a FrozenBitSequence for each of them.
+             * @details Until the next update operation (or thaw()), at, rank, and select queries use the frozen bit sequences,
+             *          which answer rank queries in O(1) time instead of O(log n) time. The bit sequences are frozen by \p thread_count threads.
+             *          The dynamic bit sequences are kept, so the memory usage is about doubled while this wavelet tree is frozen.
+             * @note O(σ n / (64 * thread_count)) time
+             */
+            void freeze(uint64_t thread_count = 1)
+            {
+                std::vector<std::pair<uint64_t, uint64_t>> items;
+                this->frozen_bits_seq.clear();
+                this->frozen_bits_seq.resize(this->bits_seq.size());
+                for (uint64_t h = 0; h < this->bits_seq.size(); h++)
+                {
+                    this->frozen_bits_seq[h].resize(this->bits_seq[h].size());
+                    for (uint64_t j = 0; j < this->bits_seq[h].size(); j++)
+                    {
+                        items.push_back(std::pair<uint64_t, uint64_t>(h, j));
+                    }
+                }
+
+                thread_count = std::max<uint64_t>(1, std::min<uint64_t>(thread_count, items.size()));
+                auto freeze_items = [this, &items, thread_count](uint64_t t)
+                {
+                    for (uint64_t x = t; x < items.size(); x += thread_count)
+                    {
+                        auto [h, j] = items[x];
+                        this->frozen_bits_seq[h][j] = this->bits_seq[h][j].freeze();
+                    }
+                };
+                if (thread_count == 1)
+                {
+                    freeze_items(0);
+                }
+                else
+                {
+                    std::vector<std::thread> threads;
+                    for (uint64_t t = 0; t < thread_count; t++)
+                    {
+                        threads.emplace_back(freeze_items, t);
+                    }
+                    for (std::thread &th : threads)
+                    {
+                        th.join();
+                    }
+                }
+            }
+
+            /**
+             * @brief Discard the frozen bit sequences built by freeze().
+             * @note This function is called by every update operation.
+             */
+            void thaw()
+            {
+                this->frozen_bits_seq.clear();
             }
 
             /**
@@ -352,13 +871,15 @@ namespace stool
                     this->alphabet.push_back(c);
                 }
                 std::sort(this->alphabet.begin(), this->alphabet.end());
+                this->has_sorted_leaves = true;
 
                 this->char_rank_vec.resize(256, -1);
                 for (uint64_t i = 0; i < alphabet.size(); i++)
                 {
                     this->char_rank_vec[alphabet[i]] = i;
                 }
-                this->rank_bit_size = stool::LSBByte::get_code_length(alphabet.size() - 1);
+                // A tree with one level is used even if |U| = 1, so that a character can be added without rebuilding the tree
+                this->rank_bit_size = this->alphabet.size() > 0 ? std::max<uint64_t>(1, stool::LSBByte::get_code_length(this->alphabet.size() - 1)) : 0;
 
                 for (uint64_t i = 0; i < rank_bit_size; i++)
                 {
@@ -378,11 +899,46 @@ namespace stool
                 }
             }
 
+            /**
+             * @brief Add a character \p c to the alphabet \p U if \p c is not in \p U
+             * @details The new leaf of \p c is the leaf next to the last leaf in use, so no bit sequence is changed.
+             *          If all the 2^h leaves are in use, a new root is added above the current root, whose bit sequence consists of n 0s
+             *          (i.e., the current tree becomes the left subtree of the new root, and the new leaves are in the right subtree).
+             *          If \p c is smaller than another character in \p U, the leaves are no longer sorted in the lexicographic order (see has_lexicographic_leaf_order).
+             * @note O(1) time, or O(n / 64 + σ + log n) time if a new level is added, which happens O(log σ) times in total
+             */
+            void add_character(uint8_t c)
+            {
+                if (this->get_lexicographic_order(c) != -1)
+                {
+                    return;
+                }
+                if (this->has_empty_alphabet())
+                {
+                    // T is empty, so the tree is simply rebuilt for the new alphabet
+                    std::vector<uint8_t> new_alphabet = this->alphabet;
+                    new_alphabet.push_back(c);
+                    this->set_alphabet(new_alphabet);
+                    return;
+                }
+                if (this->alphabet.size() == (1ULL << this->rank_bit_size))
+                {
+                    this->add_top_level();
+                }
+                if (c < this->alphabet.back())
+                {
+                    this->has_sorted_leaves = false;
+                }
+                this->char_rank_vec[c] = this->alphabet.size();
+                this->alphabet.push_back(c);
+            }
+
             /**
              * @brief Clear the elements in \p T
              */
             void clear()
             {
+                this->thaw();
                 for (uint64_t i = 0; i < this->bits_seq.size(); i++)
                 {
                     for (uint64_t j = 0; j < this->bits_seq[i].size(); j++)
@@ -393,10 +949,12 @@ namespace stool
             }
             /**
              * @brief Adds a character \p c to the end of \p T.
+             * @details If \p c is not in \p U, \p c is added to \p U by add_character.
              * @note O(log σ log n) time
              */
             void push_back(uint8_t c)
             {
+                this->add_character(c);
                 assert(!this->has_empty_alphabet());
                 if (!this->has_empty_alphabet())
                 {
@@ -418,22 +976,62 @@ namespace stool
             }
             /**
              * @brief Add a given sequence \p Q[0..k-1] to the end of \p T[0..n-1] (i.e., \p T = T[0..n-1]Q[0..k-1])
-             * @note O(|Q| log σ log n) time
+             * @details See insert_many.
+             * @note O(|Q| log σ + σ (|Q| / b + 1) log n) time, where b is the maximal number of bits in a leaf
+             */
+            void push_many(const std::vector<uint8_t> &str, uint64_t thread_count = 1)
+            {
+                this->insert_many(this->size(), str, thread_count);
+            }
+
+            /**
+             * @brief Insert a given sequence \p Q[0..k-1] into \p T at the position \p i (i.e., \p T = T[0..i-1]Q[0..k-1]T[i..n-1])
+             * @details The characters of \p Q reaching each node are inserted into its bit sequence as one packed block by insert_words,
+             *          and the characters are stably partitioned by their bits for the two children.
+             *          The subtrees of different nodes are processed by up to \p thread_count threads.
+             *          The characters of \p Q not in \p U are added to \p U by add_character.
+             * @note O(|Q| log σ + σ (|Q| / b + 1) log n) time, where b is the maximal number of bits in a leaf
              */
-            void push_many(const std::vector<uint8_t> &str)
+            void insert_many(uint64_t i, const std::vector<uint8_t> &str, uint64_t thread_count = 1)
             {
-                for (auto c : str)
+                if (i > this->size())
+                {
+                    throw std::range_error("Error: DynamicSequence::insert_many(i, str)");
+                }
+                for (uint8_t c : str)
+                {
+                    this->add_character(c);
+                }
+                if (str.size() > 0 && this->has_empty_alphabet())
+                {
+                    throw std::runtime_error("Error: DynamicSequence::insert_many(i, str)");
+                }
+                std::vector<uint8_t> c_ranks;
+                c_ranks.resize(str.size());
+                for (uint64_t x = 0; x < str.size(); x++)
+                {
+                    int64_t c_rank = this->char_rank_vec[str[x]];
+                    if (c_rank == -1)
+                    {
+                        throw std::runtime_error("Error: DynamicSequence::insert_many(i, str)");
+                    }
+                    c_ranks[x] = c_rank;
+                }
+                this->thaw();
+                if (c_ranks.size() > 0)
                 {
-                    this->push_back(c);
+                    this->insert_block_sub(0, 0, i, c_ranks, std::max<uint64_t>(1, thread_count));
                 }
             }
 
             /**
              * @brief Insert a character \p c into \p T as \p T[i]
+             * @details If \p c is not in \p U, \p c is added to \p U by add_character.
              * @note O(log σ log n) time
              */
             void insert(uint64_t i, uint8_t c)
             {
+                this->add_character(c);
                 assert(!this->has_empty_alphabet());
                 if (!this->has_empty_alphabet())
                 {
@@ -459,6 +1057,7 @@ namespace stool
              */
             void remove(uint64_t i)
             {
+                this->thaw();
                 if (i < this->size())
                 {
                     uint64_t next_nth = i;
@@ -581,11 +1180,13 @@ namespace stool
             //@{
             /**
              * @brief Build a new DynamicWaveletTree from a given sequence \p _text and alphabet \p _alphabet
+             * @details The characters are stably partitioned level by level by counting sort, and then the bit sequences of all the nodes are built by up to \p thread_count threads.
+             * @note O(n log σ) time
              */
-            static DynamicWaveletTree build(const std::vector<uint8_t> &_text, const std::vector<uint8_t> &_alphabet)
+            static DynamicWaveletTree build(const std::vector<uint8_t> &_text, const std::vector<uint8_t> &_alphabet, uint64_t thread_count = 1)
             {
                 DynamicWaveletTree dwt(_alphabet);
-                dwt.build_bits(_text, 0, 0);
+                dwt.build_bits(_text, thread_count);
                 return dwt;
             }
 
@@ -603,6 +1204,16 @@ namespace stool
                 ifs.read(reinterpret_cast<char *>(_alphabet.data()), _alphabet_size * sizeof(uint8_t));
 
                 r.set_alphabet(_alphabet);
+                if (!std::is_sorted(_alphabet.begin(), _alphabet.end()))
+                {
+                    // The alphabet is stored in the leaf order
+                    r.alphabet = _alphabet;
+                    for (uint64_t x = 0; x < _alphabet.size(); x++)
+                    {
+                        r.char_rank_vec[_alphabet[x]] = x;
+                    }
+                    r.has_sorted_leaves = false;
+                }
                 for (auto &it : r.bits_seq)
                 {
                     for (auto &it2 : it)
@@ -632,65 +1243,96 @@ namespace stool
             //@}
 
         private:
-            void build_bits(const std::vector<uint8_t> &_text, uint64_t h, uint64_t i)
+            void build_bits(const std::vector<uint8_t> &_text, uint64_t thread_count)
             {
-                uint64_t bit_idx = this->rank_bit_size - h - 1;
-                std::vector<bool> bits;
-                bits.resize(_text.size(), false);
-                uint64_t counter = 0;
-                uint64_t bits1_count = 0;
-                uint64_t bits0_count = 0;
+                uint64_t n = _text.size();
+                uint64_t _height = this->rank_bit_size;
+                std::vector<uint8_t> current;
+                current.resize(n);
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    int64_t c_rank = this->char_rank_vec.size() > 0 ? this->char_rank_vec[_text[i]] : -1;
+                    if (c_rank == -1)
+                    {
+                        throw std::invalid_argument("Error: DynamicWaveletTree::build(). The text contains a character not in the alphabet.");
+                    }
+                    current[i] = c_rank;
+                }
 
-                for (uint8_t c : _text)
+                // level_bits[h][node_starts[h][j]..node_starts[h][j+1]-1] is the bit sequence of the j-th node at level h
+                std::vector<std::vector<bool>> level_bits;
+                std::vector<std::vector<uint64_t>> node_starts;
+                level_bits.resize(_height);
+                node_starts.resize(_height);
+                if (_height > 0)
                 {
-                    int64_t c_rank = this->char_rank_vec[c];
-                    bool b = stool::LSBByte::get_bit(c_rank, bit_idx);
-                    bits[counter++] = b;
-                    if (b)
+                    node_starts[0] = {0, n};
+                }
+                std::vector<uint8_t> next;
+                next.resize(n);
+                for (uint64_t h = 0; h < _height; h++)
+                {
+                    uint64_t bit_idx = _height - h - 1;
+                    level_bits[h].resize(n);
+                    for (uint64_t i = 0; i < n; i++)
                     {
-                        bits1_count++;
+                        level_bits[h][i] = stool::LSBByte::get_bit(current[i], bit_idx);
                     }
-                    else
+                    if (h + 1 < _height)
                     {
-                        bits0_count++;
+                        // The characters are sorted by their top h+1 bits, which stably partitions each node into its children
+                        std::vector<uint64_t> &child_starts = node_starts[h + 1];
+                        child_starts.resize((1ULL << (h + 1)) + 1, 0);
+                        for (uint8_t c_rank : current)
+                        {
+                            child_starts[(c_rank >> bit_idx) + 1]++;
+                        }
+                        for (uint64_t x = 1; x < child_starts.size(); x++)
+                        {
+                            child_starts[x] += child_starts[x - 1];
+                        }
+                        std::vector<uint64_t> child_pos(child_starts.begin(), child_starts.end() - 1);
+                        for (uint8_t c_rank : current)
+                        {
+                            next[child_pos[c_rank >> bit_idx]++] = c_rank;
+                        }
+                        current.swap(next);
                     }
                 }
-                BIT_SEQUENCE dbs = BIT_SEQUENCE::build(bits);
-                this->bits_seq[h][i].swap(dbs);
-                if (h + 1 < rank_bit_size)
+
+                std::vector<std::pair<uint64_t, uint64_t>> items;
+                for (uint64_t h = 0; h < _height; h++)
                 {
-                    uint64_t next_i = i * 2;
+                    for (uint64_t j = 0; j < this->bits_seq[h].size(); j++)
                     {
-                        std::vector<uint8_t> left;
-                        left.resize(bits0_count);
-                        counter = 0;
-
-                        for (uint8_t c : _text)
-                        {
-                            int64_t c_rank = this->char_rank_vec[c];
-                            bool b = stool::LSBByte::get_bit(c_rank, bit_idx);
-                            if (!b)
-                            {
-                                left[counter++] = c;
-                            }
-                        }
-                        this->build_bits(left, h + 1, next_i);
+                        items.push_back(std::pair<uint64_t, uint64_t>(h, j));
                     }
+                }
+                thread_count = std::max<uint64_t>(1, std::min<uint64_t>(thread_count, items.size()));
+                auto build_items = [this, &items, &level_bits, &node_starts, thread_count](uint64_t t)
+                {
+                    for (uint64_t x = t; x < items.size(); x += thread_count)
                     {
-                        std::vector<uint8_t> right;
-                        right.resize(bits1_count);
-                        counter = 0;
-
-                        for (uint8_t c : _text)
-                        {
-                            int64_t c_rank = this->char_rank_vec[c];
-                            bool b = stool::LSBByte::get_bit(c_rank, bit_idx);
-                            if (b)
-                            {
-                                right[counter++] = c;
-                            }
-                        }
-                        this->build_bits(right, h + 1, next_i + 1);
+                        auto [h, j] = items[x];
+                        std::vector<bool> bits(level_bits[h].begin() + node_starts[h][j], level_bits[h].begin() + node_starts[h][j + 1]);
+                        BIT_SEQUENCE dbs = BIT_SEQUENCE::build(bits);
+                        this->bits_seq[h][j].swap(dbs);
+                    }
+                };
+                if (thread_count == 1)
+                {
+                    build_items(0);
+                }
+                else
+                {
+                    std::vector<std::thread> threads;
+                    for (uint64_t t = 0; t < thread_count; t++)
+                    {
+                        threads.emplace_back(build_items, t);
+                    }
+                    for (std::thread &th : threads)
+                    {
+                        th.join();
                     }
                 }
             }
@@ -698,6 +1340,7 @@ namespace stool
         private:
             void initialize()
             {
+                this->thaw();
                 for (uint64_t i = 0; i < this->bits_seq.size(); i++)
                 {
                     for (uint64_t j = 0; j < this->bits_seq[i].size(); j++)
@@ -712,8 +1355,27 @@ namespace stool
             }
 
         private:
+            /**
+             * @brief Add a new root whose bit sequence consists of n 0s above the current root, i.e., double the number of leaves
+             */
+            void add_top_level()
+            {
+                this->thaw();
+                uint64_t n = this->size();
+                for (uint64_t h = 0; h < this->bits_seq.size(); h++)
+                {
+                    this->bits_seq[h].resize(this->bits_seq[h].size() * 2);
+                }
+                std::vector<BIT_SEQUENCE> root;
+                root.resize(1);
+                root[0].insert_run(0, false, n);
+                this->bits_seq.insert(this->bits_seq.begin(), std::move(root));
+                this->rank_bit_size++;
+            }
+
             void push_back_sub(uint64_t c_rank)
             {
+                this->thaw();
 #ifdef DEBUG
                 uint64_t _size = this->size();
 #endif
@@ -731,81 +1393,311 @@ namespace stool
             }
             int64_t rank_sub(uint64_t i, uint64_t c_rank) const
             {
-                bool b1 = stool::LSBByte::get_bit(c_rank, this->rank_bit_size - 1);
-                uint64_t _rank = this->bits_seq[0][0].one_based_rank(i + 1, b1);
-                if (_rank == 0)
+                return this->visit_levels([&](const auto &levels) -> int64_t
+                                          {
+                    bool b1 = stool::LSBByte::get_bit(c_rank, this->rank_bit_size - 1);
+                    uint64_t _rank = levels[0][0].one_based_rank(i + 1, b1);
+                    if (_rank == 0)
+                    {
+                        return 0;
+                    }
+                    else
+                    {
+                        uint64_t nth = _rank - 1;
+                        uint64_t next = b1 ? 1 : 0;
+
+                        for (uint64_t i = 1; i < this->rank_bit_size; i++)
+                        {
+                            bool bx = stool::LSBByte::get_bit(c_rank, this->rank_bit_size - 1 - i);
+
+                            if (nth >= levels[i][next].size())
+                            {
+                                assert(false);
+                                throw std::range_error("Error: DynamicSequence::rank_sub()");
+                            }
+
+                            uint64_t _rankx = levels[i][next].one_based_rank(nth + 1, bx);
+                            if (_rankx == 0)
+                            {
+                                return 0;
+                            }
+                            else
+                            {
+                                nth = _rankx - 1;
+                                next = (next * 2) + (bx ? 1 : 0);
+                            }
+                        }
+                        return nth + 1;
+                    } });
+            }
+            int64_t select_sub(uint64_t nth, uint64_t c_rank) const
+            {
+                return this->visit_levels([&](const auto &levels) -> int64_t
+                                          {
+                    int64_t depth = levels.size();
+                    assert(depth > 0);
+                    int64_t h = 0;
+                    int64_t j = c_rank / 2;
+                    bool hbit = stool::LSBByte::get_bit(c_rank, h);
+                    assert(j < (int64_t)levels[depth - h - 1].size());
+                    uint64_t hbit_rank = levels[depth - h - 1][j].count_c(hbit);
+
+                    if (nth <= hbit_rank)
+                    {
+                        int64_t hbit_select = levels[depth - h - 1][j].select(nth - 1, hbit);
+
+                        assert(hbit_select >= 0);
+
+                        int64_t next_nth = hbit_select + 1;
+                        j = j / 2;
+                        h++;
+                        while (h < (int64_t)this->rank_bit_size)
+                        {
+                            hbit = stool::LSBByte::get_bit(c_rank, h);
+                            assert(next_nth <= levels[depth - h - 1][j].count_c(hbit));
+                            hbit_select = levels[depth - h - 1][j].select(next_nth - 1, hbit);
+
+                            assert(hbit_select >= 0);
+                            next_nth = hbit_select + 1;
+                            j = j / 2;
+                            h++;
+                        }
+                        assert(next_nth > 0);
+                        return next_nth - 1;
+                    }
+                    else
+                    {
+                        return -1;
+                    } });
+            }
+            template <typename LEVELS, typename FUNC>
+            void interval_symbols_sub(const LEVELS &levels, uint64_t h, uint64_t node_id, uint64_t b, uint64_t e, FUNC &func) const
+            {
+                if (h == this->height())
                 {
-                    return 0;
+                    func(this->alphabet[node_id], b, e);
+                    return;
                 }
-                else
+                const auto &bits = levels[h][node_id];
+                uint64_t b1 = bits.one_based_rank1(b);
+                uint64_t e1 = bits.one_based_rank1(e);
+                if (e - b > e1 - b1)
                 {
-                    uint64_t nth = _rank - 1;
-                    uint64_t next = b1 ? 1 : 0;
+                    this->interval_symbols_sub(levels, h + 1, node_id * 2, b - b1, e - e1, func);
+                }
+                if (e1 > b1)
+                {
+                    this->interval_symbols_sub(levels, h + 1, (node_id * 2) + 1, b1, e1, func);
+                }
+            }
 
-                    for (uint64_t i = 1; i < this->rank_bit_size; i++)
+            /**
+             * @brief Return the \p k leaves having the most characters in \p T[i..j-1] (ties are broken by the leaf order) as pairs (character, frequency)
+             */
+            std::vector<std::pair<uint8_t, uint64_t>> range_top_k_sub(uint64_t i, uint64_t j, uint64_t k) const
+            {
+                std::vector<std::pair<uint8_t, uint64_t>> r;
+                if (i == j || k == 0)
+                {
+                    return r;
+                }
+                return this->visit_levels([&](const auto &levels)
+                                          {
+                    // (count, the first leaf in the subtree, level, node id, range begin)
+                    using Item = std::tuple<uint64_t, uint64_t, uint64_t, uint64_t, uint64_t>;
+                    auto comp = [](const Item &x, const Item &y)
                     {
-                        bool bx = stool::LSBByte::get_bit(c_rank, this->rank_bit_size - 1 - i);
-
-                        if (nth >= this->bits_seq[i][next].size())
+                        if (std::get<0>(x) != std::get<0>(y))
                         {
-                            assert(false);
-                            throw std::range_error("Error: DynamicSequence::rank_sub()");
+                            return std::get<0>(x) < std::get<0>(y);
                         }
-
-                        uint64_t _rankx = this->bits_seq[i][next].one_based_rank(nth + 1, bx);
-                        if (_rankx == 0)
+                        else
+                        {
+                            return std::get<1>(x) > std::get<1>(y);
+                        }
+                    };
+                    std::priority_queue<Item, std::vector<Item>, decltype(comp)> que(comp);
+                    que.push(Item(j - i, 0, 0, 0, i));
+                    uint64_t _height = this->height();
+                    while (!que.empty() && r.size() < k)
+                    {
+                        auto [count, first_rank, h, node_id, b] = que.top();
+                        que.pop();
+                        if (h == _height)
                         {
-                            return 0;
+                            r.push_back(std::pair<uint8_t, uint64_t>(this->alphabet[node_id], count));
                         }
                         else
                         {
-                            nth = _rankx - 1;
-                            next = (next * 2) + (bx ? 1 : 0);
+                            const auto &bits = levels[h][node_id];
+                            uint64_t b1 = bits.one_based_rank1(b);
+                            uint64_t e1 = bits.one_based_rank1(b + count);
+                            uint64_t ones = e1 - b1;
+                            uint64_t child_shift = _height - h - 1;
+                            if (count - ones > 0)
+                            {
+                                que.push(Item(count - ones, first_rank, h + 1, node_id * 2, b - b1));
+                            }
+                            if (ones > 0)
+                            {
+                                que.push(Item(ones, first_rank + (1ULL << child_shift), h + 1, (node_id * 2) + 1, b1));
+                            }
                         }
                     }
-                    return nth + 1;
-                }
+                    return r; });
             }
-            int64_t select_sub(uint64_t nth, uint64_t c_rank) const
+
+            /**
+             * @brief Return the number of characters in \p T[i..j-1] whose lexicographic orders are smaller than \p c_rank
+             */
+            uint64_t count_smaller_ranks(uint64_t i, uint64_t j, uint64_t c_rank) const
             {
-                int64_t depth = this->bits_seq.size();
-                assert(depth > 0);
-                int64_t h = 0;
-                int64_t j = c_rank / 2;
-                bool hbit = stool::LSBByte::get_bit(c_rank, h);
-                assert(j < (int64_t)this->bits_seq[depth - h - 1].size());
-                uint64_t hbit_rank = this->bits_seq[depth - h - 1][j].count_c(hbit);
+                if (c_rank >= (1ULL << this->height()))
+                {
+                    return j - i;
+                }
+                return this->visit_levels([&](const auto &levels) -> uint64_t
+                                          {
+                    uint64_t result = 0;
+                    uint64_t b = i;
+                    uint64_t e = j;
+                    uint64_t node_id = 0;
+                    for (uint64_t h = 0; h < this->height() && b < e; h++)
+                    {
+                        const auto &bits = levels[h][node_id];
+                        uint64_t b1 = bits.one_based_rank1(b);
+                        uint64_t e1 = bits.one_based_rank1(e);
+                        if (stool::LSBByte::get_bit(c_rank, this->height() - h - 1))
+                        {
+                            result += (e - b) - (e1 - b1);
+                            b = b1;
+                            e = e1;
+                            node_id = (node_id * 2) + 1;
+                        }
+                        else
+                        {
+                            b -= b1;
+                            e -= e1;
+                            node_id = node_id * 2;
+                        }
+                    }
+                    return result; });
+            }
 
-                if (nth <= hbit_rank)
+            /**
+             * @brief Return the position of the (i+1)-th occurrence of the bit for \p c_rank in the node on the path to the leaf of \p c_rank at level \p h
+             * @details The query is answered inside the leaf of \p cursor if possible (see DynamicBitSequence::select_with_cursor).
+             */
+            int64_t select_on_path(uint64_t h, uint64_t c_rank, uint64_t i, typename BIT_SEQUENCE::LeafCursor &cursor) const
+            {
+                uint64_t node_id = c_rank >> (this->rank_bit_size - h);
+                bool b = stool::LSBByte::get_bit(c_rank, this->rank_bit_size - 1 - h);
+                if (this->is_frozen())
                 {
-                    int64_t hbit_select = this->bits_seq[depth - h - 1][j].select(nth - 1, hbit);
+                    return this->frozen_bits_seq[h][node_id].select(i, b);
+                }
+                else
+                {
+                    return this->bits_seq[h][node_id].select_with_cursor(i, b, cursor);
+                }
+            }
 
-                    assert(hbit_select >= 0);
+            /**
+             * @brief Write the lexicographic orders of the characters in the range [i..j-1] of the node \p j_node at the level \p h to \p output[0..j-i-1]
+             */
+            void extract_sub(uint64_t h, uint64_t node_id, uint64_t i, uint64_t j, uint8_t *output) const
+            {
+                const BIT_SEQUENCE &bits = this->bits_seq[h][node_id];
+                uint64_t len = j - i;
+                std::vector<uint64_t> words;
+                bits.extract_words(i, len, words);
 
-                    int64_t next_nth = hbit_select + 1;
-                    j = j / 2;
-                    h++;
-                    while (h < (int64_t)this->rank_bit_size)
+                if (h + 1 == this->rank_bit_size)
+                {
+                    for (uint64_t x = 0; x < len; x++)
                     {
-                        hbit = stool::LSBByte::get_bit(c_rank, h);
-                        assert(next_nth <= this->bits_seq[depth - h - 1][j].count_c(hbit));
-                        hbit_select = this->bits_seq[depth - h - 1][j].select(next_nth - 1, hbit);
-
-                        assert(hbit_select >= 0);
-                        next_nth = hbit_select + 1;
-                        j = j / 2;
-                        h++;
+                        output[x] = (node_id * 2) + (PackedBitFunctions::get_bit(words.data(), x) ? 1 : 0);
                     }
-                    assert(next_nth > 0);
-                    return next_nth - 1;
                 }
                 else
                 {
-                    return -1;
+                    uint64_t ones = PackedBitFunctions::popcount_words(words.data(), words.size());
+                    uint64_t right_i = bits.one_based_rank1(i);
+                    uint64_t left_i = i - right_i;
+                    std::vector<uint8_t> left, right;
+                    left.resize(len - ones);
+                    right.resize(ones);
+                    if (left.size() > 0)
+                    {
+                        this->extract_sub(h + 1, node_id * 2, left_i, left_i + left.size(), left.data());
+                    }
+                    if (right.size() > 0)
+                    {
+                        this->extract_sub(h + 1, (node_id * 2) + 1, right_i, right_i + right.size(), right.data());
+                    }
+                    uint64_t left_pos = 0;
+                    uint64_t right_pos = 0;
+                    for (uint64_t x = 0; x < len; x++)
+                    {
+                        output[x] = PackedBitFunctions::get_bit(words.data(), x) ? right[right_pos++] : left[left_pos++];
+                    }
+                }
+            }
+
+            void insert_block_sub(uint64_t h, uint64_t j, uint64_t nth, const std::vector<uint8_t> &c_ranks, uint64_t thread_count)
+            {
+                uint64_t bit_idx = this->rank_bit_size - h - 1;
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(c_ranks.size()), 0);
+                uint64_t bits1_count = 0;
+                for (uint64_t x = 0; x < c_ranks.size(); x++)
+                {
+                    if (stool::LSBByte::get_bit(c_ranks[x], bit_idx))
+                    {
+                        words[x / 64] |= 1ULL << (63 - (x % 64));
+                        bits1_count++;
+                    }
+                }
+
+                BIT_SEQUENCE &bits = this->bits_seq[h][j];
+                uint64_t left_nth = bits.one_based_rank0(nth);
+                uint64_t right_nth = nth - left_nth;
+                bits.insert_words(nth, words.data(), c_ranks.size());
+
+                if (h + 1 < this->rank_bit_size)
+                {
+                    std::vector<uint8_t> left, right;
+                    left.reserve(c_ranks.size() - bits1_count);
+                    right.reserve(bits1_count);
+                    for (uint64_t x = 0; x < c_ranks.size(); x++)
+                    {
+                        (stool::LSBByte::get_bit(c_ranks[x], bit_idx) ? right : left).push_back(c_ranks[x]);
+                    }
+
+                    if (thread_count > 1 && left.size() > 0 && right.size() > 0)
+                    {
+                        std::thread th([this, h, j, right_nth, &right, thread_count]()
+                                       { this->insert_block_sub(h + 1, (j * 2) + 1, right_nth, right, thread_count / 2); });
+                        this->insert_block_sub(h + 1, j * 2, left_nth, left, thread_count - (thread_count / 2));
+                        th.join();
+                    }
+                    else
+                    {
+                        if (left.size() > 0)
+                        {
+                            this->insert_block_sub(h + 1, j * 2, left_nth, left, thread_count);
+                        }
+                        if (right.size() > 0)
+                        {
+                            this->insert_block_sub(h + 1, (j * 2) + 1, right_nth, right, thread_count);
+                        }
+                    }
                 }
             }
+
             void insert_sub(uint64_t nth, uint8_t c_rank)
             {
+                this->thaw();
                 if (nth <= this->size())
                 {
 
@@ -15,6 +15,11 @@ namespace stool
             stool::NaiveFLCVector<false> keys;
             stool::NaiveFLCVector<false> pointers;
 
+            // A chained hash index from (pointer, key) to the slot in this container, which is used by get_index.
+            // bucket_heads[b] and next_slots[i] store (slot + 1), and 0 represents the end of a chain.
+            std::vector<uint16_t> bucket_heads;
+            std::vector<uint16_t> next_slots;
+
         public:
             static constexpr uint64_t ___PermutationLeafSize = 252;
             using Tree = bptree::BPTree<PermutationContainer, PermutationItem, bptree::DEFAULT_MAX_DEGREE_OF_INTERNAL_NODE, ___PermutationLeafSize, true, false>;
@@ -125,15 +130,17 @@ namespace stool
             }
             uint64_t size_in_bytes(bool only_extra_bytes) const
             {
+                uint64_t index_bytes = (this->bucket_heads.capacity() + this->next_slots.capacity()) * sizeof(uint16_t);
                 if(only_extra_bytes){
-                    return this->keys.size_in_bytes(true) + this->pointers.size_in_bytes(true);
+                    return this->keys.size_in_bytes(true) + this->pointers.size_in_bytes(true) + index_bytes;
                 }else{
-                    return sizeof(PermutationContainer) + this->keys.size_in_bytes(true) + this->pointers.size_in_bytes(true);
+                    return sizeof(PermutationContainer) + this->keys.size_in_bytes(true) + this->pointers.size_in_bytes(true) + index_bytes;
                 }
             }
             uint64_t unused_size_in_bytes() const
             {
-                return this->keys.unused_size_in_bytes() + this->pointers.unused_size_in_bytes();
+                uint64_t unused_index_bytes = ((this->bucket_heads.capacity() - this->bucket_heads.size()) + (this->next_slots.capacity() - this->next_slots.size())) * sizeof(uint16_t);
+                return this->keys.unused_size_in_bytes() + this->pointers.unused_size_in_bytes() + unused_index_bytes;
             }
 
 
@@ -153,6 +160,8 @@ namespace stool
             {
                 this->keys.clear();
                 this->pointers.clear();
+                this->bucket_heads.clear();
+                this->next_slots.clear();
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -162,6 +171,8 @@ namespace stool
 
                 this->keys.swap(item.keys);
                 this->pointers.swap(item.pointers);
+                this->bucket_heads.swap(item.bucket_heads);
+                this->next_slots.swap(item.next_slots);
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -181,26 +192,28 @@ namespace stool
             {
                 return -1;
             }
+            /**
+             * @brief Return the smallest position i such that the i-th item of this container is \p item if it exists, otherwise return -1
+             * @note O(1) expected time
+             */
             int64_t get_index(const PermutationItem &&item) const
             {
-                int64_t size = this->pointers.size();
-                for(int64_t i = 0; i < size; i++){
-                    if(this->pointers[i] == item.pointer && this->keys[i] == item.key){
-                        return i;
-                    }
+                if (this->bucket_heads.size() == 0)
+                {
+                    return -1;
                 }
-                return -1;
-
-                /*
-                for (uint64_t pointer : this->pointers)
+                int64_t result = -1;
+                uint64_t next = this->bucket_heads[this->get_bucket(item.pointer, item.key)];
+                while (next != 0)
                 {
-                    if (pointer == item.pointer && this->keys[i] == item.key)
+                    uint64_t i = next - 1;
+                    if ((result == -1 || (int64_t)i < result) && this->pointers[i] == item.pointer && this->keys[i] == item.key)
                     {
-                        return i;
+                        result = i;
                     }
-                    i++;
+                    next = this->next_slots[i];
                 }
-                */
+                return result;
             }
 
             std::string to_string() const
@@ -230,15 +243,21 @@ namespace stool
 
             void insert(uint64_t pos, PermutationItem value)
             {
+                this->shift_slots(pos, true);
+                this->next_slots.insert(this->next_slots.begin() + pos, 0);
                 this->keys.insert(pos, value.key);
                 this->pointers.insert(pos, value.pointer);
+                this->link_or_rebuild(pos);
 
                 assert(this->keys.size() == this->pointers.size());
             }
             void remove(uint64_t pos)
             {
+                this->unlink(pos);
+                this->next_slots.erase(this->next_slots.begin() + pos);
                 this->keys.remove(pos);
                 this->pointers.remove(pos);
+                this->shift_slots(pos + 1, false);
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -256,6 +275,7 @@ namespace stool
                 }
                 this->keys.push_front_many(tmp_keys);
                 this->pointers.push_front_many(tmp_pointers);
+                this->rebuild_index();
 
                 /*
                 for (int64_t i = new_items.size() - 1; i >= 0; i--)
@@ -271,6 +291,7 @@ namespace stool
             {
                 this->keys.push_front(new_item.key);
                 this->pointers.push_front(new_item.pointer);
+                this->rebuild_index();
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -282,6 +303,7 @@ namespace stool
                     this->keys.push_back(item.key);
                     this->pointers.push_back(item.pointer);
                 }
+                this->rebuild_index();
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -289,6 +311,8 @@ namespace stool
             {
                 this->keys.push_back(value.key);
                 this->pointers.push_back(value.pointer);
+                this->next_slots.push_back(0);
+                this->link_or_rebuild(this->size() - 1);
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -298,6 +322,7 @@ namespace stool
                 uint64_t pointer = this->pointers.head();
                 this->keys.pop_front();
                 this->pointers.pop_front();
+                this->rebuild_index();
 
                 assert(this->keys.size() == this->pointers.size());
                 return PermutationItem(pointer, key);
@@ -316,6 +341,7 @@ namespace stool
                 }
                 this->keys.pop_front_many(len);
                 this->pointers.pop_front_many(len);
+                this->rebuild_index();
 
                 assert(this->keys.size() == this->pointers.size());
                 return r;
@@ -326,6 +352,8 @@ namespace stool
                 assert(this->keys.size() > 0 && this->pointers.size() > 0);
                 uint64_t key = this->keys[this->keys.size() - 1];
                 uint64_t pointer = this->pointers.tail();
+                this->unlink(this->size() - 1);
+                this->next_slots.pop_back();
                 this->keys.pop_back();
                 this->pointers.pop_back();
 
@@ -400,17 +428,23 @@ namespace stool
                 // container.print();
 
                 assert(idx < (int64_t)container.size());
+                container.unlink(idx);
                 container.pointers.set_value(idx, leaf_index_of_this_container);
                 container.keys.set_value(idx, new_key);
+                container.link(idx);
+                this->unlink(ith);
                 this->keys.set_value(ith, new_key);
+                this->link(ith);
 
                 assert(this->keys.size() == this->pointers.size());
             }
             void set_value(uint64_t ith, const PermutationItem &&item)
             {
                 assert(ith < this->size());
+                this->unlink(ith);
                 this->keys.set_value(ith, item.key);
                 this->pointers.set_value(ith, item.pointer);
+                this->link(ith);
 
                 assert(this->keys.size() == this->pointers.size());
             }
@@ -469,6 +503,7 @@ namespace stool
                 NaiveFLCVector<false> tmp2 = NaiveFLCVector<false>::load_from_bytes(data, pos);
                 r.keys.swap(tmp1);
                 r.pointers.swap(tmp2);
+                r.rebuild_index();
 
                 return r;
             }
@@ -479,6 +514,7 @@ namespace stool
                 NaiveFLCVector<false> tmp2 = NaiveFLCVector<false>::load_from_file(ifs);
                 r.keys.swap(tmp1);
                 r.pointers.swap(tmp2);
+                r.rebuild_index();
 
                 return r;
             }
@@ -508,6 +544,88 @@ namespace stool
                 }
                 return r;
             }
+
+        private:
+            uint64_t get_bucket(uint64_t pointer, uint64_t key) const
+            {
+                uint64_t x = ((pointer << 8) | key) * 0x9E3779B97F4A7C15ULL;
+                return (x >> 32) & (this->bucket_heads.size() - 1);
+            }
+            /**
+             * @brief Add the i-th item to the hash index
+             */
+            void link(uint64_t i)
+            {
+                uint64_t b = this->get_bucket(this->pointers[i], this->keys[i]);
+                this->next_slots[i] = this->bucket_heads[b];
+                this->bucket_heads[b] = i + 1;
+            }
+            /**
+             * @brief Remove the i-th item from the hash index
+             */
+            void unlink(uint64_t i)
+            {
+                uint64_t b = this->get_bucket(this->pointers[i], this->keys[i]);
+                if (this->bucket_heads[b] == i + 1)
+                {
+                    this->bucket_heads[b] = this->next_slots[i];
+                }
+                else
+                {
+                    uint64_t prev = this->bucket_heads[b];
+                    while (this->next_slots[prev - 1] != i + 1)
+                    {
+                        prev = this->next_slots[prev - 1];
+                        assert(prev != 0);
+                    }
+                    this->next_slots[prev - 1] = this->next_slots[i];
+                }
+            }
+            void link_or_rebuild(uint64_t i)
+            {
+                if (this->size() > this->bucket_heads.size())
+                {
+                    this->rebuild_index();
+                }
+                else
+                {
+                    this->link(i);
+                }
+            }
+            /**
+             * @brief Increment (or decrement) every slot >= \p pos stored in the hash index
+             */
+            void shift_slots(uint64_t pos, bool increment)
+            {
+                uint16_t threshold = pos + 1;
+                uint16_t delta = increment ? 1 : UINT16_MAX;
+                for (uint16_t &v : this->bucket_heads)
+                {
+                    v += v >= threshold ? delta : 0;
+                }
+                for (uint16_t &v : this->next_slots)
+                {
+                    v += v >= threshold ? delta : 0;
+                }
+            }
+            /**
+             * @brief Build the hash index with at least as many buckets as items
+             */
+            void rebuild_index()
+            {
+                uint64_t _size = this->size();
+                uint64_t bucket_count = 16;
+                while (bucket_count < _size)
+                {
+                    bucket_count *= 2;
+                }
+                this->bucket_heads.assign(bucket_count, 0);
+                this->next_slots.assign(_size, 0);
+                for (int64_t i = (int64_t)_size - 1; i >= 0; i--)
+                {
+                    this->link(i);
+                }
+            }
         };
     }
 }
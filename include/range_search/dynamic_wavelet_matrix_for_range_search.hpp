@@ -23,6 +23,9 @@ namespace stool
             std::vector<BIT_SEQUENCE> bits_seq;
             std::vector<PREFIX_SUM> length_seq;
 
+            // Read-optimized copies of bits_seq built by freeze() (empty unless frozen)
+            std::vector<FrozenBitSequence> frozen_bits_seq;
+
             // std::vector<stool::NaiveFLCVector<false>> leaves;
 
             // inline static uint64_t LEAF_MAX_SIZE = 8;
@@ -295,6 +298,19 @@ namespace stool
             }
 
         private:
+            template <typename FUNC>
+            auto visit_level(uint64_t h, FUNC func) const
+            {
+                if (this->is_frozen())
+                {
+                    return func(this->frozen_bits_seq[h]);
+                }
+                else
+                {
+                    return func(this->bits_seq[h]);
+                }
+            }
+
             /**
              * @brief Return the starting index of a node's bit sequence at level \p h.
              * @param h Level in the wavelet tree (0 is the root level).
@@ -327,7 +343,8 @@ namespace stool
             {
                 assert(i <= this->length_seq[h].at(h_node_id));
                 assert(node_x_pos_in_bit_sequence == this->get_node_x_pos_in_bit_sequence(h, h_node_id));
-                return this->bits_seq[h].one_based_rank0(node_x_pos_in_bit_sequence + i + 1) - this->bits_seq[h].one_based_rank0(node_x_pos_in_bit_sequence);
+                return this->visit_level(h, [&](const auto &bits)
+                                         { return bits.one_based_rank0(node_x_pos_in_bit_sequence + i + 1) - bits.one_based_rank0(node_x_pos_in_bit_sequence); });
             }
 
             /**
@@ -343,7 +360,8 @@ namespace stool
             {
                 assert(i <= this->length_seq[h].at(h_node_id));
                 assert(node_x_pos_in_bit_sequence == this->get_node_x_pos_in_bit_sequence(h, h_node_id));
-                return this->bits_seq[h].one_based_rank1(node_x_pos_in_bit_sequence + i + 1) - this->bits_seq[h].one_based_rank1(node_x_pos_in_bit_sequence);
+                return this->visit_level(h, [&](const auto &bits)
+                                         { return bits.one_based_rank1(node_x_pos_in_bit_sequence + i + 1) - bits.one_based_rank1(node_x_pos_in_bit_sequence); });
             }
 
             /**
@@ -636,24 +654,14 @@ namespace stool
                     uint64_t next_node_id = prev_node_id / 2;
                     uint64_t next_x_pos = this->get_node_x_pos_in_bit_sequence(h, next_node_id);
 
-                    if (prev_node_id % 2 == 0)
-                    {
-                        uint64_t count_zero_offset = this->bits_seq[h].one_based_rank0(next_x_pos);
-                        uint64_t next_y_rank = this->bits_seq[h].select0(current_y_rank + count_zero_offset) - next_x_pos;
-                        current_y_rank = next_y_rank;
-                        prev_node_id = next_node_id;
-                    }
-                    else
-                    {
-
-                        uint64_t count_one_offset = this->bits_seq[h].one_based_rank1(next_x_pos);
-                        int64_t select_result = this->bits_seq[h].select1(current_y_rank + count_one_offset);
-                        assert(select_result >= 0);
-                        uint64_t next_y_rank = select_result - next_x_pos;
-
-                        current_y_rank = next_y_rank;
-                        prev_node_id = next_node_id;
-                    }
+                    bool b = prev_node_id % 2 == 1;
+                    int64_t select_result = this->visit_level(h, [&](const auto &bits)
+                                                              {
+                        uint64_t count_offset = bits.one_based_rank(next_x_pos, b);
+                        return bits.select(current_y_rank + count_offset, b); });
+                    assert(select_result >= 0);
+                    current_y_rank = select_result - next_x_pos;
+                    prev_node_id = next_node_id;
                 }
                 return current_y_rank;
             }
@@ -680,7 +688,8 @@ namespace stool
 
                     assert(node_x_pos + local_y_rank < this->bits_seq[h].size());
 
-                    bool b = this->bits_seq[h].at(node_x_pos + local_y_rank);
+                    bool b = this->visit_level(h, [&](const auto &bits)
+                                               { return bits.at(node_x_pos + local_y_rank); });
                     uint64_t next_node_id = (2 * h_node_id) + (uint64_t)b;
                     if (b)
                     {
@@ -928,10 +937,12 @@ namespace stool
             {
                 this->length_seq.swap(item.length_seq);
                 this->bits_seq.swap(item.bits_seq);
+                this->frozen_bits_seq.swap(item.frozen_bits_seq);
             }
             /** @brief Clear all bit sequences, length sequences, and reset the structure to empty. */
             void clear()
             {
+                this->thaw();
                 for (uint64_t i = 0; i < this->bits_seq.size(); i++)
                 {
                     this->bits_seq[i].clear();
@@ -941,6 +952,59 @@ namespace stool
                 this->length_seq.clear();
             }
 
+            /**
+             * @brief Freeze the bit sequences of all the levels, i.e., build a FrozenBitSequence for each level.
+             * @details Until the next update operation (or thaw()), the rank, select, and access operations on the levels use the frozen bit sequences,
+             *          which answer rank queries in O(1) time instead of O(log n) time. The levels are frozen by \p thread_count threads.
+             * @note O(H n / (64 * thread_count)) time
+             */
+            void freeze(uint64_t thread_count = 1)
+            {
+                uint64_t height = this->height();
+                this->frozen_bits_seq.clear();
+                this->frozen_bits_seq.resize(height);
+                thread_count = std::max<uint64_t>(1, std::min<uint64_t>(thread_count, height));
+                auto freeze_levels = [this, height, thread_count](uint64_t t)
+                {
+                    for (uint64_t h = t; h < height; h += thread_count)
+                    {
+                        this->frozen_bits_seq[h] = this->bits_seq[h].freeze();
+                    }
+                };
+                if (thread_count == 1)
+                {
+                    freeze_levels(0);
+                }
+                else
+                {
+                    std::vector<std::thread> threads;
+                    for (uint64_t t = 0; t < thread_count; t++)
+                    {
+                        threads.emplace_back(freeze_levels, t);
+                    }
+                    for (std::thread &th : threads)
+                    {
+                        th.join();
+                    }
+                }
+            }
+
+            /**
+             * @brief Discard the frozen bit sequences built by freeze(). This function is called by every update operation.
+             */
+            void thaw()
+            {
+                this->frozen_bits_seq.clear();
+            }
+
+            /**
+             * @brief Return true if the levels are frozen (see freeze()).
+             */
+            bool is_frozen() const
+            {
+                return this->frozen_bits_seq.size() > 0;
+            }
+
             void rebuild(const std::vector<uint64_t> &rank_elements, int message_paragraph = stool::Message::NO_MESSAGE)
             {
                 DynamicWaveletMatrixForRangeSearch r = DynamicWaveletMatrixForRangeSearch::build(rank_elements, message_paragraph);
@@ -958,6 +1022,7 @@ namespace stool
              */
             void insert(uint64_t x_rank, uint64_t y_rank)
             {
+                this->thaw();
 
                 if (this->size() > 0)
                 {
@@ -1005,6 +1070,7 @@ namespace stool
              */
             void erase_y_rank(uint64_t y_rank)
             {
+                this->thaw();
                 int64_t height = this->height();
                 if (height == 0)
                 {
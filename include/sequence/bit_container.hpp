@@ -1,5 +1,6 @@
 #pragma once
 #include "../bp_tree.hpp"
+#include "./packed_bit_functions.hpp"
 
 namespace stool
 {
@@ -281,7 +282,7 @@ namespace stool
                     uint64_t count = this->psum();
                     if (x <= count)
                     {
-                        return stool::LSBByte::select1(this->bits, x - 1);
+                        return PackedBitFunctions::select1_in_word_from_lsb(this->bits, x - 1);
                     }
                     else
                     {
@@ -498,7 +499,16 @@ namespace stool
             }
             int64_t select0(uint64_t i) const
             {
-                return stool::LSBByte::select0(this->bits, i);
+                uint64_t size = this->size();
+                uint64_t zeros = (~this->bits) & ((1ULL << size) - 1);
+                if (i < (uint64_t)__builtin_popcountll(zeros))
+                {
+                    return PackedBitFunctions::select1_in_word_from_lsb(zeros, i);
+                }
+                else
+                {
+                    return -1;
+                }
             }
 
             void to_data(std::vector<uint8_t> &output) const
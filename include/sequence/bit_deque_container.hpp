@@ -1,35 +1,120 @@
 #pragma once
 #include "../bp_tree.hpp"
+#include "./packed_bit_functions.hpp"
+#include "./naive_bit_vector_container.hpp"
 
 namespace stool
 {
     namespace bptree
     {
         /**
-         * @brief A container that stores a short sequence of bits. [Unchecked AI's Comment]
+         * @brief A container that stores a short sequence of bits in a packed array of 64-bit words with a block-count table.
+         * @details The bits B[0..n-1] are stored in an array of 64-bit words W in the order of PackedBitFunctions, and the bits of W beyond n are always 0.
+         *          The table R stores the number of 1s before each block of BLOCK_WORD_SIZE words (i.e., R[b] is the number of 1s in W[0..b * BLOCK_WORD_SIZE - 1]).
+         *          Rank jumps to the block by R and counts the rest with the popcount kernel, and select finds the block by a binary search on R
+         *          and then runs the select kernels of PackedBitFunctions in the block.
+         *          An update at position i shifts the words after i and recounts the blocks after i by the popcount kernel.
+         * @note A vector of leaves is saved as FORMAT_MAGIC, FORMAT_VERSION, the number of leaves, and (n, W) for each leaf.
+         *       Files without FORMAT_MAGIC were written with the leaves of NaiveBitVectorContainer, and they are converted while they are loaded.
          * \ingroup BitClasses
          */
         template <uint64_t MAX_BIT_SIZE = 8192ULL>
         class BitVectorContainer
         {
-            //using BitArrayDeque = typename stool::BitArrayDeque<MAX_BIT_SIZE>;
-            using BitArrayDeque = typename stool::NaiveBitVector<MAX_BIT_SIZE>;
-
-            BitArrayDeque bits;
+        public:
+            static inline constexpr uint64_t BLOCK_WORD_SIZE = 8;
+            static inline constexpr uint64_t BLOCK_BIT_SIZE = BLOCK_WORD_SIZE * 64;
+            static_assert(MAX_BIT_SIZE <= UINT16_MAX, "BitVectorContainer stores the block counts in 16-bit integers.");
+            static inline constexpr uint64_t FORMAT_MAGIC = 0x4456435041434B42ULL;
+            static inline constexpr uint64_t FORMAT_VERSION = 2;
+            using LegacyContainer = NaiveBitVectorContainer<MAX_BIT_SIZE>;
+
+        private:
+            std::vector<uint64_t> words_;
+            std::vector<uint16_t> block_ranks_ = {0};
+            uint64_t size_ = 0;
 
         public:
-            //using BitVectorContainerIterator = typename BitArrayDeque::BitArrayDequeIterator;
+            /**
+             * @brief A random access iterator over the bits of a BitVectorContainer.
+             */
+            class BitVectorContainerIterator
+            {
+            public:
+                const BitVectorContainer *container = nullptr;
+                uint64_t index = UINT64_MAX;
+
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = bool;
+                using difference_type = std::ptrdiff_t;
+
+                BitVectorContainerIterator() {}
+                BitVectorContainerIterator(const BitVectorContainer *_container, uint64_t _index) : container(_container), index(_index) {}
+
+                bool operator*() const
+                {
+                    return this->container->at(this->index);
+                }
+                uint64_t get_size() const
+                {
+                    return this->container->size();
+                }
+                bool is_end() const
+                {
+                    return this->container == nullptr || this->index >= this->container->size();
+                }
+
+                /**
+                 * @brief Return the 64 bits starting at the current position (MSB first; the bits beyond the end are 0)
+                 */
+                uint64_t read_64bits_string() const
+                {
+                    return this->container->read_64bits(this->index);
+                }
+
+                BitVectorContainerIterator &operator++()
+                {
+                    this->index++;
+                    return *this;
+                }
+                BitVectorContainerIterator operator++(int)
+                {
+                    BitVectorContainerIterator tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+                BitVectorContainerIterator &operator+=(difference_type n)
+                {
+                    this->index += n;
+                    return *this;
+                }
+                BitVectorContainerIterator operator+(difference_type n) const
+                {
+                    return BitVectorContainerIterator(this->container, this->index + n);
+                }
+                difference_type operator-(const BitVectorContainerIterator &other) const
+                {
+                    return (difference_type)this->index - (difference_type)other.index;
+                }
 
-            using BitVectorContainerIterator = typename BitArrayDeque::NaiveBitVectorIterator;
+                bool operator==(const BitVectorContainerIterator &other) const { return this->container == other.container && this->index == other.index; }
+                bool operator!=(const BitVectorContainerIterator &other) const { return !(*this == other); }
+                bool operator<(const BitVectorContainerIterator &other) const { return this->index < other.index; }
+                bool operator>(const BitVectorContainerIterator &other) const { return this->index > other.index; }
+                bool operator<=(const BitVectorContainerIterator &other) const { return this->index <= other.index; }
+                bool operator>=(const BitVectorContainerIterator &other) const { return this->index >= other.index; }
+            };
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
             BitVectorContainer()
             {
             }
             BitVectorContainer(std::vector<uint64_t> &_items)
             {
-                for (uint64_t x : _items)
-                {
-                    this->push_back(x);
-                }
+                this->push_back_many(_items);
             }
             BitVectorContainer(std::vector<bool> &_items)
             {
@@ -38,290 +123,523 @@ namespace stool
                     this->push_back(_items[i]);
                 }
             }
+            //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Properties
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
             void swap(BitVectorContainer &item)
             {
-                std::swap(this->bits, item.bits);
+                this->words_.swap(item.words_);
+                this->block_ranks_.swap(item.block_ranks_);
+                std::swap(this->size_, item.size_);
             }
             uint64_t size() const
             {
-                return this->bits.size();
+                return this->size_;
             }
             uint64_t size_in_bytes(bool only_extra_bytes) const
             {
-                return this->bits.size_in_bytes(only_extra_bytes);
+                uint64_t extra = (this->words_.capacity() * sizeof(uint64_t)) + (this->block_ranks_.capacity() * sizeof(uint16_t));
+                return only_extra_bytes ? extra : sizeof(BitVectorContainer) + extra;
             }
             uint64_t unused_size_in_bytes() const
             {
-                return this->bits.unused_size_in_bytes();
+                return ((this->words_.capacity() - this->words_.size()) * sizeof(uint64_t)) + ((this->block_ranks_.capacity() - this->block_ranks_.size()) * sizeof(uint16_t));
+            }
+            static std::string name()
+            {
+                return "BitVectorContainer";
             }
+            //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
             uint64_t at(uint64_t pos) const
             {
-                return this->bits.at(pos);
+                assert(pos < this->size_);
+                return PackedBitFunctions::get_bit(this->words_.data(), pos);
             }
-            void print() const
+
+            /**
+             * @brief Return the 64 bits starting at position \p pos (MSB first; the bits beyond the end are 0)
+             */
+            uint64_t read_64bits(uint64_t pos) const
             {
-                throw std::runtime_error("Error: BitVectorContainer");
+                if (pos >= this->size_)
+                {
+                    return 0;
+                }
+                return PackedBitFunctions::read_64bits(this->words_.data(), pos, this->size_);
             }
 
-            void clear()
+            uint64_t psum(uint64_t i) const noexcept
             {
-                this->bits.clear();
+                return this->rank1(i + 1);
             }
-            static std::string name()
+            uint64_t psum() const noexcept
             {
-                return "BitVectorContainer";
+                return this->block_ranks_[this->block_ranks_.size() - 1];
             }
-            uint64_t psum(uint64_t i) const noexcept
+            uint64_t psum(uint64_t i, uint64_t j) const
             {
-                return this->bits.psum(i);
+                if (i == j)
+                {
+                    return this->at(i);
+                }
+                else
+                {
+                    return this->psum(j) - (i > 0 ? this->psum(i - 1) : 0);
+                }
             }
-            uint64_t psum() const noexcept
+            uint64_t reverse_psum(uint64_t i) const
             {
-                return this->bits.psum();
+                if (i + 1 >= this->size_)
+                {
+                    return this->psum();
+                }
+                else
+                {
+                    return this->psum() - this->psum(this->size_ - i - 2);
+                }
             }
+
             int64_t search(uint64_t x) const noexcept
             {
-                uint64_t v = this->bits.search(x);
-                return v;
+                if (x == 0)
+                {
+                    return 0;
+                }
+                else
+                {
+                    return this->select1(x - 1);
+                }
             }
 
-            std::string to_string() const
+            /**
+             * @brief Return the number of 1s in B[0..i-1]
+             * @note O(1) time with AVX-512 VPOPCNTQ, otherwise O(BLOCK_WORD_SIZE) time
+             */
+            int64_t rank1(uint64_t i) const
             {
-                return this->bits.to_string();
+                assert(i <= this->size_);
+                uint64_t block = i / BLOCK_BIT_SIZE;
+                return this->block_ranks_[block] + PackedBitFunctions::rank1(this->words_.data() + (block * BLOCK_WORD_SIZE), i - (block * BLOCK_BIT_SIZE));
             }
-            std::vector<uint64_t> to_value_vector() const
+            int64_t rank0(uint64_t i) const
             {
-                std::vector<uint64_t> r;
-                for (uint64_t i = 0; i < this->size(); i++)
+                return i - this->rank1(i);
+            }
+            int64_t rank(uint64_t i, bool b) const
+            {
+                return b ? this->rank1(i) : this->rank0(i);
+            }
+            int64_t select(uint64_t i, bool b) const
+            {
+                return b ? this->select1(i) : this->select0(i);
+            }
+
+            /**
+             * @brief Return the position of the (i+1)-th 1 if it exists, otherwise return -1.
+             * @note O(log (n / BLOCK_BIT_SIZE) + BLOCK_WORD_SIZE) time, and the final word is searched by the in-word select kernel
+             */
+            int64_t select1(uint64_t i) const
+            {
+                if (i >= this->psum())
                 {
-                    r.push_back(this->at(i));
+                    return -1;
                 }
-                return r;
+                // The last block b such that R[b] <= i.
+                uint64_t block = (std::upper_bound(this->block_ranks_.begin(), this->block_ranks_.end(), i) - this->block_ranks_.begin()) - 1;
+                uint64_t block_pos = block * BLOCK_BIT_SIZE;
+                uint64_t block_bit_size = std::min<uint64_t>(BLOCK_BIT_SIZE, this->size_ - block_pos);
+                return block_pos + PackedBitFunctions::select1(this->words_.data() + (block * BLOCK_WORD_SIZE), block_bit_size, i - this->block_ranks_[block]);
             }
-            uint64_t to_uint64() const
+
+            /**
+             * @brief Return the position of the (i+1)-th 0 if it exists, otherwise return -1.
+             * @note O(log (n / BLOCK_BIT_SIZE) + BLOCK_WORD_SIZE) time
+             */
+            int64_t select0(uint64_t i) const
             {
-                uint64_t size = this->size();
-                if (size > 0)
+                if (i >= this->size_ - this->psum())
                 {
-                    uint64_t value = this->bits.read_64_bit_string();
-                    if (size >= 64)
+                    return -1;
+                }
+                // The last block b such that the number of 0s before b is at most i.
+                uint64_t lo = 0;
+                uint64_t hi = this->block_count() - 1;
+                while (lo < hi)
+                {
+                    uint64_t mid = (lo + hi + 1) / 2;
+                    if ((mid * BLOCK_BIT_SIZE) - this->block_ranks_[mid] <= i)
                     {
-                        return value;
+                        lo = mid;
                     }
                     else
                     {
-                        return value >> (64 - size);
+                        hi = mid - 1;
                     }
                 }
-                else
+                uint64_t block_pos = lo * BLOCK_BIT_SIZE;
+                uint64_t block_bit_size = std::min<uint64_t>(BLOCK_BIT_SIZE, this->size_ - block_pos);
+                return block_pos + PackedBitFunctions::select0(this->words_.data() + (lo * BLOCK_WORD_SIZE), block_bit_size, i - (block_pos - this->block_ranks_[lo]));
+            }
+
+            /**
+             * @brief Stores \p sum_offset + psum(p - \p position_offset) in \p output[k] for each p = \p sorted_positions[k] (begin <= k < end).
+             * @details The words are scanned once from left to right for all the queries, and the blocks without queries are skipped by R.
+             * @note \p sorted_positions[begin..end-1] must be sorted in ascending order, and p - \p position_offset must be less than the size of this container.
+             */
+            void psum_many(const std::vector<uint64_t> &sorted_positions, uint64_t begin, uint64_t end, uint64_t position_offset, uint64_t sum_offset, std::vector<uint64_t> &output) const
+            {
+                // ones is the number of 1s in W[0..w-1].
+                uint64_t w = 0;
+                uint64_t ones = 0;
+                for (uint64_t k = begin; k < end; k++)
                 {
-                    return 0;
+                    uint64_t p = sorted_positions[k] - position_offset;
+                    assert(p < this->size_);
+                    uint64_t last_word = p / 64;
+                    uint64_t block = last_word / BLOCK_WORD_SIZE;
+                    if (block > w / BLOCK_WORD_SIZE)
+                    {
+                        w = block * BLOCK_WORD_SIZE;
+                        ones = this->block_ranks_[block];
+                    }
+                    for (; w < last_word; w++)
+                    {
+                        ones += __builtin_popcountll(this->words_[w]);
+                    }
+                    output[k] = sum_offset + ones + __builtin_popcountll(this->words_[last_word] >> (63 - (p % 64)));
                 }
             }
 
-            template <typename VEC>
-            void to_values(VEC &output_vec) const
+            /**
+             * @brief Stores \p position_offset + search(u - \p sum_offset) in \p output[k] for each u = \p sorted_sums[k] (begin <= k < end).
+             * @details The words are scanned once from left to right for all the queries, and the blocks without answers are skipped by R.
+             * @note \p sorted_sums[begin..end-1] must be sorted in ascending order, and u - \p sum_offset must be at most psum().
+             */
+            void search_many(const std::vector<uint64_t> &sorted_sums, uint64_t begin, uint64_t end, uint64_t position_offset, uint64_t sum_offset, std::vector<int64_t> &output) const
             {
-                output_vec.clear();
-                output_vec.resize(this->size());
-                for (uint64_t i = 0; i < this->size(); i++)
+                // ones is the number of 1s in W[0..w-1].
+                uint64_t w = 0;
+                uint64_t ones = 0;
+                uint64_t block_count = this->block_count();
+                for (uint64_t k = begin; k < end; k++)
                 {
-                    output_vec[i] = this->at(i);
+                    uint64_t x = sorted_sums[k] - sum_offset;
+                    assert(x <= this->psum());
+                    if (x == 0)
+                    {
+                        output[k] = position_offset;
+                        continue;
+                    }
+                    // The (x-1)-th 1 is in the last block b such that R[b] < x.
+                    uint64_t block = w / BLOCK_WORD_SIZE;
+                    while (block + 1 < block_count && this->block_ranks_[block + 1] < x)
+                    {
+                        block++;
+                    }
+                    if (block > w / BLOCK_WORD_SIZE)
+                    {
+                        w = block * BLOCK_WORD_SIZE;
+                        ones = this->block_ranks_[block];
+                    }
+                    uint64_t count = __builtin_popcountll(this->words_[w]);
+                    while (ones + count < x)
+                    {
+                        ones += count;
+                        w++;
+                        count = __builtin_popcountll(this->words_[w]);
+                    }
+                    output[k] = position_offset + (w * 64) + PackedBitFunctions::select1_in_word(this->words_[w], x - 1 - ones);
                 }
-
-                
-
             }
+            //@}
 
-            void insert(uint64_t pos, uint64_t value)
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void print() const
             {
-                this->bits.insert(pos, value >= 1);
+                std::cout << this->to_string() << std::endl;
             }
-            void remove(uint64_t pos)
+            std::string to_string() const
             {
-                assert(this->size() > 0);
-                this->bits.erase(pos);
-            }
-            uint64_t to_bit_array(const std::vector<uint64_t> &new_items, std::array<uint64_t, MAX_BIT_SIZE / 64> &output){
-                uint64_t added_block_size = ((new_items.size()-1) / 64) + 1;
-                for(uint64_t i = 0; i < added_block_size; i++){
-                    output[i] = 0;
-                }
-                for(uint64_t i = 0; i < new_items.size(); i++){
-                    uint64_t v = i / 64;
-                    uint64_t w = i % 64;
-                    output[v] |= ((new_items[i] >= 1) ? 1ULL : 0ULL) << (63 - w);
+                std::string s;
+                for (uint64_t i = 0; i < this->size_; i++)
+                {
+                    s.push_back(this->at(i) ? '1' : '0');
                 }
-                return added_block_size;
+                return s;
             }
-            void push_front_many(const std::vector<uint64_t> &new_items)
+            std::vector<uint64_t> to_value_vector() const
             {
-                if(new_items.size() > 0){
-                    std::array<uint64_t, MAX_BIT_SIZE / 64> tmp_buffer;
-                    uint64_t added_block_size = this->to_bit_array(new_items, tmp_buffer);
-
-                    #ifdef DEBUG
-                    uint64_t sum1 = this->bits.psum();
-                    uint64_t sum2 = 0;
-                    for(uint64_t i = 0; i < new_items.size(); i++){
-                        sum2 += new_items[i] >= 1 ? 1 : 0;
-                    }
-                    uint64_t x_size = this->size();
-                    #endif
-
-                    this->bits.push_front64(tmp_buffer, new_items.size(), added_block_size);
-
-                    #ifdef DEBUG
-                    if(sum1 + sum2 != this->bits.psum()){
-                        std::cout << new_items.size() << "/" << x_size << std::endl;
-                        std::cout << sum1 << "/" << sum2 << std::endl;
-                        std::cout << this->bits.psum() << std::endl;
-                    }
-                    assert(sum1 + sum2 == this->bits.psum());
-                    #endif
-                }
-
+                std::vector<uint64_t> r;
+                this->to_values(r);
+                return r;
             }
-            void push_front(uint64_t new_item)
+            uint64_t to_uint64() const
             {
-
-                this->bits.push_back64(new_item >= 1);
+                uint64_t value = this->read_64bits(0);
+                return this->size_ >= 64 ? value : (this->size_ > 0 ? value >> (64 - this->size_) : 0);
             }
-
-            void push_back_many(const std::vector<uint64_t> &new_items)
+            template <typename VEC>
+            void to_values(VEC &output_vec) const
             {
-
-                if(new_items.size() > 0){
-                    std::array<uint64_t, MAX_BIT_SIZE / 64> tmp_buffer;
-                    uint64_t added_block_size = this->to_bit_array(new_items, tmp_buffer);
-                    this->bits.push_back64(tmp_buffer, new_items.size(), added_block_size);
+                output_vec.clear();
+                output_vec.resize(this->size_);
+                for (uint64_t i = 0; i < this->size_; i++)
+                {
+                    output_vec[i] = this->at(i);
                 }
             }
-            void push_back(uint64_t value)
-            {
 
-                this->bits.push_back(value >= 1);
-            }
-            void pop_front()
+            /**
+             * @brief Write the bits of this container in the range [pos..pos+len-1] to \p output[output_offset..output_offset+len-1] packed in 64-bit words.
+             * @note O(len / 64) time
+             */
+            void extract_words(uint64_t pos, uint64_t len, uint64_t *output, uint64_t output_offset) const
             {
+                assert(pos + len <= this->size_);
+                PackedBitFunctions::copy_bits(this->words_.data(), pos, len, output, output_offset);
+            }
 
-                assert(this->size() > 0);
-                this->bits.pop_front();
+            BitVectorContainerIterator begin() const
+            {
+                return BitVectorContainerIterator(this, 0);
             }
-            std::vector<uint64_t> pop_front_many(uint64_t len)
+            BitVectorContainerIterator end() const
             {
+                return BitVectorContainerIterator(this, this->size_);
+            }
+            //@}
 
-                assert(len <= this->size());
-                std::array<uint64_t, MAX_BIT_SIZE / 64> tmp_buffer;
-                this->bits.pop_front(len, tmp_buffer, MAX_BIT_SIZE / 64);
-                std::vector<uint64_t> r;
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void clear()
+            {
+                this->words_.clear();
+                this->words_.shrink_to_fit();
+                this->block_ranks_.clear();
+                this->block_ranks_.push_back(0);
+                this->block_ranks_.shrink_to_fit();
+                this->size_ = 0;
+            }
 
-                for(uint64_t i = 0; i < len; i++){
-                    uint64_t v = i / 64;
-                    uint64_t w = i % 64;
-                    r.push_back((tmp_buffer[v] >> (63 - w)) & 1);
+            /**
+             * @brief Insert a bit \p value at position \p pos
+             * @note O((n - pos) / 64) time
+             */
+            void insert(uint64_t pos, uint64_t value)
+            {
+                assert(pos <= this->size_);
+                assert(this->size_ < MAX_BIT_SIZE);
+                if (this->size_ % 64 == 0)
+                {
+                    this->words_.push_back(0);
                 }
-
-                /*
-                for (uint64_t i = 0; i < len; i++)
+                uint64_t w = pos / 64;
+                for (uint64_t j = this->words_.size() - 1; j > w; j--)
                 {
-                    bool b = this->at(0);
-                    r.push_back(b ? 1 : 0);
-                    this->pop_front();
+                    this->words_[j] = (this->words_[j] >> 1) | (this->words_[j - 1] << 63);
                 }
-                */
-                return r;
-            }
-            void pop_back()
+                uint64_t offset = pos % 64;
+                uint64_t upper_mask = offset == 0 ? 0 : (UINT64_MAX << (64 - offset));
+                uint64_t word = this->words_[w];
+                this->words_[w] = (word & upper_mask) | ((word & ~upper_mask) >> 1) | ((value >= 1 ? 1ULL : 0ULL) << (63 - offset));
+                this->size_++;
+                this->update_block_ranks(w);
+            }
+
+            /**
+             * @brief Remove the bit at position \p pos
+             * @note O((n - pos) / 64) time
+             */
+            void remove(uint64_t pos)
             {
-
-                assert(this->size() > 0);
-                this->bits.pop_back();
+                assert(pos < this->size_);
+                uint64_t w = pos / 64;
+                uint64_t offset = pos % 64;
+                uint64_t upper_mask = offset == 0 ? 0 : (UINT64_MAX << (64 - offset));
+                uint64_t word = this->words_[w];
+                this->words_[w] = (word & upper_mask) | ((word << 1) & ~upper_mask);
+                for (uint64_t j = w + 1; j < this->words_.size(); j++)
+                {
+                    this->words_[j - 1] |= this->words_[j] >> 63;
+                    this->words_[j] <<= 1;
+                }
+                this->size_--;
+                if (this->size_ % 64 == 0)
+                {
+                    this->words_.pop_back();
+                }
+                this->update_block_ranks(w);
             }
 
-            std::vector<uint64_t> pop_back_many(uint64_t len)
+            void increment(uint64_t i, int64_t delta)
             {
-
-                assert(len <= this->size());
-                std::vector<uint64_t> r;
-                r.resize(len);
-
-                for (uint64_t i = 0; i < len; i++)
+                assert(i < this->size_);
+                uint64_t mask = 1ULL << (63 - (i % 64));
+                bool b = this->words_[i / 64] & mask;
+                if ((delta >= 1 && !b) || (delta <= -1 && b))
                 {
-                    bool b = this->at(this->size() - 1);
-                    r[len - i - 1] = b ? 1 : 0;
-                    this->pop_back();
+                    this->words_[i / 64] ^= mask;
+                    for (uint64_t x = (i / BLOCK_BIT_SIZE) + 1; x < this->block_ranks_.size(); x++)
+                    {
+                        this->block_ranks_[x] += b ? -1 : 1;
+                    }
                 }
-                return r;
             }
 
-            uint64_t reverse_psum(uint64_t i) const
+            void push_back(uint64_t value)
             {
-                return this->bits.reverse_psum(i);
+                this->insert(this->size_, value);
             }
-
-            uint64_t psum(uint64_t i, uint64_t j) const
+            void push_front(uint64_t new_item)
             {
-                return this->bits.psum(i, j);
+                this->insert(0, new_item);
             }
-
-            void increment(uint64_t i, int64_t delta)
+            void pop_back()
             {
-                this->bits.increment(i, delta);
+                assert(this->size_ > 0);
+                this->remove(this->size_ - 1);
             }
-
-            int64_t rank1(uint64_t i) const
+            void pop_front()
             {
-                return this->bits.rank1(i);
+                assert(this->size_ > 0);
+                this->remove(0);
             }
 
-            int64_t rank0(uint64_t i) const
+            void push_back_many(const std::vector<uint64_t> &new_items)
             {
-                return i - this->rank1(i);
+                std::vector<uint64_t> tmp_words = BitVectorContainer::to_words(new_items);
+                this->push_back_words(tmp_words.data(), 0, new_items.size());
             }
-            int64_t rank(uint64_t i, bool b) const
+            void push_front_many(const std::vector<uint64_t> &new_items)
             {
-                return b ? this->rank1(i) : this->rank0(i);
+                std::vector<uint64_t> tmp_words = BitVectorContainer::to_words(new_items);
+                this->insert_words(0, tmp_words.data(), 0, new_items.size());
             }
 
-            int64_t select(uint64_t i, bool b) const
+            /**
+             * @brief Remove the first \p len bits and return them
+             * @note O(n / 64 + len) time
+             */
+            std::vector<uint64_t> pop_front_many(uint64_t len)
             {
-                return b ? this->select1(i) : this->select0(i);
+                assert(len <= this->size_);
+                std::vector<uint64_t> r;
+                r.resize(len);
+                for (uint64_t i = 0; i < len; i++)
+                {
+                    r[i] = this->at(i);
+                }
+                uint64_t new_size = this->size_ - len;
+                std::vector<uint64_t> tmp_words;
+                tmp_words.resize(PackedBitFunctions::get_word_size(new_size), 0);
+                PackedBitFunctions::copy_bits(this->words_.data(), len, new_size, tmp_words.data(), 0);
+                this->words_.swap(tmp_words);
+                this->size_ = new_size;
+                this->update_block_ranks(0);
+                return r;
             }
 
-            int64_t select1(uint64_t i) const
+            /**
+             * @brief Remove the last \p len bits and return them
+             * @note O(len) time
+             */
+            std::vector<uint64_t> pop_back_many(uint64_t len)
             {
-                return this->bits.select1(i);
+                assert(len <= this->size_);
+                std::vector<uint64_t> r;
+                r.resize(len);
+                uint64_t new_size = this->size_ - len;
+                for (uint64_t i = 0; i < len; i++)
+                {
+                    r[i] = this->at(new_size + i);
+                }
+                this->truncate(new_size);
+                return r;
             }
-            int64_t select0(uint64_t i) const
+
+            /**
+             * @brief Append the bits \p words[offset..offset+len-1] packed in 64-bit words (see PackedBitFunctions) to the end of this container.
+             * @note O(len / 64) time
+             */
+            void push_back_words(const uint64_t *words, uint64_t offset, uint64_t len)
             {
-                return this->bits.select0(i);
+                if (len > 0)
+                {
+                    assert(this->size_ + len <= MAX_BIT_SIZE);
+                    uint64_t old_size = this->size_;
+                    this->words_.resize(PackedBitFunctions::get_word_size(old_size + len), 0);
+                    PackedBitFunctions::copy_bits(words, offset, len, this->words_.data(), old_size);
+                    this->size_ += len;
+                    this->update_block_ranks(old_size / 64);
+                }
             }
 
-            void to_data(std::vector<uint8_t> &output) const
+            /**
+             * @brief Insert the bits \p words[offset..offset+len-1] packed in 64-bit words at the position \p pos of this container.
+             * @note O((n + len) / 64) time, where n is the size of this container
+             */
+            void insert_words(uint64_t pos, const uint64_t *words, uint64_t offset, uint64_t len)
             {
-                uint64_t byte_size = BitArrayDeque::get_byte_size(this->bits);
-                uint64_t size = this->size();
-                for (uint64_t i = 0; i < byte_size; i++)
+                assert(pos <= this->size_);
+                if (pos == this->size_)
                 {
-                    output.push_back(0);
+                    this->push_back_words(words, offset, len);
+                }
+                else if (len > 0)
+                {
+                    assert(this->size_ + len <= MAX_BIT_SIZE);
+                    uint64_t new_size = this->size_ + len;
+                    std::vector<uint64_t> tmp_words;
+                    tmp_words.resize(PackedBitFunctions::get_word_size(new_size), 0);
+                    PackedBitFunctions::copy_bits(this->words_.data(), 0, pos, tmp_words.data(), 0);
+                    PackedBitFunctions::copy_bits(words, offset, len, tmp_words.data(), pos);
+                    PackedBitFunctions::copy_bits(this->words_.data(), pos, this->size_ - pos, tmp_words.data(), pos + len);
+                    this->words_.swap(tmp_words);
+                    this->size_ = new_size;
+                    this->update_block_ranks(pos / 64);
                 }
-                BitArrayDeque::store_to_bytes(this->bits, output, size);
             }
-            /*
-            void load_from_data(std::vector<uint64_t> &output){
+            //@}
 
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Load, save, and builder functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void to_data(std::vector<uint8_t> &output) const
+            {
+                uint64_t pos = output.size();
+                output.resize(pos + this->get_byte_size());
+                this->store_to_bytes(output, pos);
+            }
+
+            /**
+             * @brief Replace the bits with the bits written by to_data() at \p data[pos..], and move \p pos to the end of them.
+             */
+            void load_from_data(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
+                BitVectorContainer tmp = BitVectorContainer::load_from_bytes(data, pos);
+                this->swap(tmp);
             }
-            */
 
             static uint64_t get_byte_size(const std::vector<BitVectorContainer> &items)
             {
-                uint64_t size = sizeof(uint64_t);
+                uint64_t size = sizeof(uint64_t) * 3;
                 for (const auto &item : items)
                 {
-                    size += BitArrayDeque::get_byte_size(item.bits);
+                    size += item.get_byte_size();
                 }
                 return size;
             }
@@ -332,43 +650,68 @@ namespace stool
                 {
                     output.resize(pos + size);
                 }
-
-                uint64_t items_size = items.size();
-                std::memcpy(output.data() + pos, &items_size, sizeof(uint64_t));
-                pos += sizeof(uint64_t);
-
+                uint64_t header[3] = {FORMAT_MAGIC, FORMAT_VERSION, items.size()};
+                std::memcpy(output.data() + pos, header, sizeof(header));
+                pos += sizeof(header);
                 for (const auto &item : items)
                 {
-                    BitArrayDeque::store_to_bytes(item.bits, output, pos);
+                    item.store_to_bytes(output, pos);
                 }
             }
             static void store_to_file(const std::vector<BitVectorContainer> &items, std::ofstream &os)
             {
-                uint64_t items_size = items.size();
-                os.write(reinterpret_cast<const char *>(&items_size), sizeof(uint64_t));
-    
-                for (const auto &item : items)
-                {
-                    BitArrayDeque::store_to_file(item.bits, os);
-                }
+                std::vector<uint8_t> bytes;
+                uint64_t pos = 0;
+                store_to_bytes(items, bytes, pos);
+                os.write(reinterpret_cast<const char *>(bytes.data()), pos);
             }
-            static BitVectorContainer load_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos){
+            static BitVectorContainer load_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
                 BitVectorContainer r;
-                r.bits = BitArrayDeque::load_from_bytes(data, pos);
+                uint64_t size = 0;
+                std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(size));
+                if (words.size() > 0)
+                {
+                    std::memcpy(words.data(), data.data() + pos, words.size() * sizeof(uint64_t));
+                    pos += words.size() * sizeof(uint64_t);
+                }
+                r.push_back_words(words.data(), 0, size);
                 return r;
             }
             static BitVectorContainer load_from_file(std::ifstream &ifs)
             {
+                uint64_t size = 0;
+                ifs.read(reinterpret_cast<char *>(&size), sizeof(uint64_t));
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(size));
+                ifs.read(reinterpret_cast<char *>(words.data()), words.size() * sizeof(uint64_t));
                 BitVectorContainer r;
-                r.bits = BitArrayDeque::load_from_file(ifs);
+                r.push_back_words(words.data(), 0, size);
                 return r;
             }
+            /**
+             * @brief Load a vector of leaves written by store_to_bytes(), or by the old NaiveBitVectorContainer leaves if \p data[pos..] does not start with FORMAT_MAGIC.
+             */
             static std::vector<BitVectorContainer> load_vector_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
             {
                 uint64_t size = 0;
                 std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                if (size != FORMAT_MAGIC)
+                {
+                    std::vector<LegacyContainer> legacy_items = LegacyContainer::load_vector_from_bytes(data, pos);
+                    return BitVectorContainer::convert_legacy_items(legacy_items);
+                }
                 pos += sizeof(uint64_t);
-    
+                uint64_t version = 0;
+                std::memcpy(&version, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                BitVectorContainer::check_format_version(version);
+                std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+
                 std::vector<BitVectorContainer> output;
                 output.resize(size);
                 for (uint64_t i = 0; i < size; i++)
@@ -377,30 +720,140 @@ namespace stool
                 }
                 return output;
             }
+
+            /**
+             * @brief Load a vector of leaves written by store_to_file(), or by the old NaiveBitVectorContainer leaves if the stream does not start with FORMAT_MAGIC.
+             */
             static std::vector<BitVectorContainer> load_vector_from_file(std::ifstream &ifs)
             {
                 uint64_t size = 0;
+                std::streampos start = ifs.tellg();
+                ifs.read(reinterpret_cast<char *>(&size), sizeof(uint64_t));
+                if (size != FORMAT_MAGIC)
+                {
+                    ifs.seekg(start);
+                    std::vector<LegacyContainer> legacy_items = LegacyContainer::load_vector_from_file(ifs);
+                    return BitVectorContainer::convert_legacy_items(legacy_items);
+                }
+                uint64_t version = 0;
+                ifs.read(reinterpret_cast<char *>(&version), sizeof(uint64_t));
+                BitVectorContainer::check_format_version(version);
                 ifs.read(reinterpret_cast<char *>(&size), sizeof(uint64_t));
-    
+
                 std::vector<BitVectorContainer> output;
                 output.resize(size);
                 for (uint64_t i = 0; i < size; i++)
                 {
                     output[i] = BitVectorContainer::load_from_file(ifs);
                 }
-    
                 return output;
             }
+            //@}
 
-            BitVectorContainerIterator begin() const
+        private:
+            uint64_t block_count() const
             {
-                return this->bits.begin();
+                return this->block_ranks_.size() - 1;
             }
-            BitVectorContainerIterator end() const
+
+            static void check_format_version(uint64_t version)
             {
-                return this->bits.end();
+                if (version != FORMAT_VERSION)
+                {
+                    throw std::runtime_error("Error: BitVectorContainer. Unsupported format version " + std::to_string(version) + ".");
+                }
+            }
+
+            /**
+             * @brief Convert the leaves loaded in the old format into BitVectorContainer
+             */
+            static std::vector<BitVectorContainer> convert_legacy_items(const std::vector<LegacyContainer> &legacy_items)
+            {
+                std::vector<BitVectorContainer> output;
+                output.resize(legacy_items.size());
+                for (uint64_t i = 0; i < legacy_items.size(); i++)
+                {
+                    const LegacyContainer &item = legacy_items[i];
+                    std::vector<uint64_t> words;
+                    words.resize(PackedBitFunctions::get_word_size(item.size()), 0);
+                    for (uint64_t j = 0; j < item.size(); j++)
+                    {
+                        if (item.at(j))
+                        {
+                            words[j / 64] |= 1ULL << (63 - (j % 64));
+                        }
+                    }
+                    output[i].push_back_words(words.data(), 0, item.size());
+                }
+                return output;
+            }
+
+            uint64_t get_byte_size() const
+            {
+                return sizeof(uint64_t) + (this->words_.size() * sizeof(uint64_t));
+            }
+            void store_to_bytes(std::vector<uint8_t> &output, uint64_t &pos) const
+            {
+                std::memcpy(output.data() + pos, &this->size_, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                if (this->words_.size() > 0)
+                {
+                    std::memcpy(output.data() + pos, this->words_.data(), this->words_.size() * sizeof(uint64_t));
+                    pos += this->words_.size() * sizeof(uint64_t);
+                }
+            }
+
+            /**
+             * @brief Pack given bits \p items into 64-bit words
+             */
+            static std::vector<uint64_t> to_words(const std::vector<uint64_t> &items)
+            {
+                std::vector<uint64_t> r;
+                r.resize(PackedBitFunctions::get_word_size(items.size()), 0);
+                for (uint64_t i = 0; i < items.size(); i++)
+                {
+                    if (items[i] >= 1)
+                    {
+                        r[i / 64] |= 1ULL << (63 - (i % 64));
+                    }
+                }
+                return r;
+            }
+
+            /**
+             * @brief Shrink B to the first \p new_size bits, clearing the removed bits of the last word
+             */
+            void truncate(uint64_t new_size)
+            {
+                assert(new_size <= this->size_);
+                this->words_.resize(PackedBitFunctions::get_word_size(new_size));
+                if (new_size % 64 != 0)
+                {
+                    this->words_[this->words_.size() - 1] &= UINT64_MAX << (64 - (new_size % 64));
+                }
+                this->size_ = new_size;
+                this->update_block_ranks(new_size / 64);
+            }
+
+            /**
+             * @brief Recompute the entries of the block-count table after the block containing the \p first_word-th word
+             * @details R is resized to the current number of blocks, and the blocks after the changed one are recounted by the popcount kernel.
+             * @note O((n - first_word * 64) / 64) time
+             */
+            void update_block_ranks(uint64_t first_word)
+            {
+                uint64_t word_size = this->words_.size();
+                uint64_t new_block_count = (word_size + BLOCK_WORD_SIZE - 1) / BLOCK_WORD_SIZE;
+                uint64_t first_block = std::min<uint64_t>(first_word / BLOCK_WORD_SIZE, new_block_count);
+                first_block = std::min<uint64_t>(first_block, this->block_count());
+                this->block_ranks_.resize(new_block_count + 1);
+                for (uint64_t b = first_block; b < new_block_count; b++)
+                {
+                    uint64_t block_word_size = std::min<uint64_t>(BLOCK_WORD_SIZE, word_size - (b * BLOCK_WORD_SIZE));
+                    this->block_ranks_[b + 1] = this->block_ranks_[b] + PackedBitFunctions::popcount_words(this->words_.data() + (b * BLOCK_WORD_SIZE), block_word_size);
+                }
             }
         };
     }
 
-}
\ No newline at end of file
+}
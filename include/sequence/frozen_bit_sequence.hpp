@@ -0,0 +1,493 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include "./packed_bit_functions.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief A static bit sequence B[0..n-1] supporting O(1) rank and O(log (n / 512))-time select queries, which is built from a DynamicBitSequence by freeze().
+         * @details The bits are stored in one contiguous packed array (see PackedBitFunctions).
+         *          Rank queries use a rank9-style directory: for each block of 512 bits, one word stores the number of 1s before the block,
+         *          and another word stores the seven 9-bit counts of 1s before each word in the block.
+         *          Select queries jump to the block containing every SELECT_SAMPLE_RATE-th 1 (or 0), and binary search the blocks between two samples,
+         *          which takes O(log (n / 512)) time in the worst case (i.e., when the 1s (or 0s) are sparse).
+         * \ingroup BitClasses
+         */
+        class FrozenBitSequence
+        {
+        public:
+            static inline constexpr uint64_t BLOCK_BIT_SIZE = 512;
+            static inline constexpr uint64_t WORDS_IN_BLOCK = BLOCK_BIT_SIZE / 64;
+            static inline constexpr uint64_t SELECT_SAMPLE_RATE = 4096;
+
+        private:
+            std::vector<uint64_t> words;
+            std::vector<uint64_t> rank_directory;
+            std::vector<uint64_t> select1_samples;
+            std::vector<uint64_t> select0_samples;
+            uint64_t _size = 0;
+
+        public:
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Default constructor with |B| = 0
+             */
+            FrozenBitSequence()
+            {
+                this->build_directory(1);
+            }
+
+            /**
+             * @brief Construct B from the first \p bit_size bits of a packed array \p _words (see PackedBitFunctions for the bit order).
+             * @details The rank directory is built by \p thread_count threads, each of which processes a contiguous range of blocks.
+             * @note O(n / (64 * thread_count) + n / 512) time
+             */
+            FrozenBitSequence(std::vector<uint64_t> &&_words, uint64_t bit_size, uint64_t thread_count = 1)
+            {
+                if (_words.size() < PackedBitFunctions::get_word_size(bit_size))
+                {
+                    throw std::invalid_argument("Error: FrozenBitSequence(). The packed array is shorter than the given bit size.");
+                }
+                this->words.swap(_words);
+                this->_size = bit_size;
+                this->words.resize(PackedBitFunctions::get_word_size(bit_size));
+                if (bit_size % 64 != 0)
+                {
+                    this->words[this->words.size() - 1] &= UINT64_MAX << (64 - (bit_size % 64));
+                }
+                this->build_directory(thread_count);
+            }
+
+            /**
+             * @brief Default copy constructor.
+             */
+            FrozenBitSequence(const FrozenBitSequence &) = default;
+            /**
+             * @brief Default move constructor.
+             */
+            FrozenBitSequence(FrozenBitSequence &&) noexcept = default;
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Default copy assignment operator.
+             */
+            FrozenBitSequence &operator=(const FrozenBitSequence &) = default;
+            /**
+             * @brief Default move assignment operator.
+             */
+            FrozenBitSequence &operator=(FrozenBitSequence &&) noexcept = default;
+
+            /**
+             * @brief The alias for at query
+             */
+            bool operator[](uint64_t i) const
+            {
+                return this->at(i);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Lightweight functions for accessing to properties of this class
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return \p |B|
+             */
+            uint64_t size() const
+            {
+                return this->_size;
+            }
+
+            /**
+             * @brief Checks if \p B is empty.
+             */
+            bool empty() const
+            {
+                return this->_size == 0;
+            }
+
+            /**
+             * @brief Return the total memory usage in bytes
+             * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
+             */
+            uint64_t size_in_bytes(bool only_dynamic_memory = false) const
+            {
+                uint64_t bytes = (this->words.capacity() + this->rank_directory.capacity() + this->select1_samples.capacity() + this->select0_samples.capacity()) * sizeof(uint64_t);
+                if (!only_dynamic_memory)
+                {
+                    bytes += sizeof(FrozenBitSequence);
+                }
+                return bytes;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return \p B as a packed vector of uint64_t (see PackedBitFunctions for the bit order).
+             */
+            const std::vector<uint64_t> &to_packed_vector() const
+            {
+                return this->words;
+            }
+
+            /**
+             * @brief Return \p B as a vector of bool.
+             */
+            std::vector<bool> to_vector() const
+            {
+                std::vector<bool> r;
+                r.resize(this->_size, false);
+                for (uint64_t i = 0; i < this->_size; i++)
+                {
+                    r[i] = PackedBitFunctions::get_bit(this->words.data(), i);
+                }
+                return r;
+            }
+
+            /**
+             * @brief Return a dynamic bit sequence storing \p B (e.g., SimpleDynamicBitSequence).
+             * @note O(n / 64 + (n / b) log n) time, where b is the maximal number of bits in a leaf of BIT_SEQUENCE
+             */
+            template <typename BIT_SEQUENCE>
+            BIT_SEQUENCE thaw() const
+            {
+                BIT_SEQUENCE r;
+                r.append_words(this->words.data(), this->_size);
+                return r;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Main queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return \p B[i]
+             * @note O(1) time
+             */
+            bool at(uint64_t i) const
+            {
+                assert(i < this->_size);
+                return PackedBitFunctions::get_bit(this->words.data(), i);
+            }
+
+            /**
+             * @brief Returns the number of 1 in \p B[0..i-1].
+             * @note O(1) time
+             */
+            int64_t one_based_rank1(uint64_t i) const
+            {
+                if (i > this->_size)
+                {
+                    throw std::range_error("Error: FrozenBitSequence::one_based_rank1()");
+                }
+                uint64_t block = i / BLOCK_BIT_SIZE;
+                uint64_t word_in_block = (i / 64) % WORDS_IN_BLOCK;
+                uint64_t r = this->rank_directory[block * 2];
+                if (word_in_block > 0)
+                {
+                    r += (this->rank_directory[block * 2 + 1] >> (9 * (word_in_block - 1))) & 511ULL;
+                }
+                if (i % 64 != 0)
+                {
+                    r += __builtin_popcountll(this->words[i / 64] >> (64 - (i % 64)));
+                }
+                return r;
+            }
+
+            /**
+             * @brief Returns the number of 0 in \p B[0..i-1].
+             * @note O(1) time
+             */
+            int64_t one_based_rank0(uint64_t i) const
+            {
+                return i - this->one_based_rank1(i);
+            }
+
+            /**
+             * @brief Returns the number of \p c in \p B[0..i-1].
+             * @note O(1) time
+             */
+            int64_t one_based_rank(uint64_t i, bool c) const
+            {
+                return c ? this->one_based_rank1(i) : this->one_based_rank0(i);
+            }
+
+            /**
+             * @brief Alias for one_based_rank1.
+             */
+            int64_t rank1(uint64_t i) const
+            {
+                return this->one_based_rank1(i);
+            }
+
+            /**
+             * @brief Alias for one_based_rank0.
+             */
+            int64_t rank0(uint64_t i) const
+            {
+                return this->one_based_rank0(i);
+            }
+
+            /**
+             * @brief Alias for one_based_rank.
+             */
+            int64_t rank(uint64_t i, bool c) const
+            {
+                return this->one_based_rank(i, c);
+            }
+
+            /**
+             * @brief Returns the position \p p of the (i+1)-th 1 in \p B if such a position exists, otherwise returns -1
+             * @note O(log (n / 512)) time in the worst case, because the blocks between two samples are binary searched,
+             *       and O(log (SELECT_SAMPLE_RATE / 512)) time if the SELECT_SAMPLE_RATE 1s of the sample containing the answer lie in O(SELECT_SAMPLE_RATE) bits
+             */
+            int64_t select1(uint64_t i) const
+            {
+                return this->select_sub<true>(i);
+            }
+
+            /**
+             * @brief Returns the position \p p of the (i+1)-th 0 in \p B if such a position exists, otherwise returns -1
+             * @note O(log (n / 512)) time in the worst case, because the blocks between two samples are binary searched,
+             *       and O(log (SELECT_SAMPLE_RATE / 512)) time if the SELECT_SAMPLE_RATE 0s of the sample containing the answer lie in O(SELECT_SAMPLE_RATE) bits
+             */
+            int64_t select0(uint64_t i) const
+            {
+                return this->select_sub<false>(i);
+            }
+
+            /**
+             * @brief Returns the position \p p of the (i+1)-th \p c in \p B if such a position exists, otherwise returns -1
+             */
+            int64_t select(uint64_t i, bool c) const
+            {
+                return c ? this->select1(i) : this->select0(i);
+            }
+
+            /**
+             * @brief Return the number of 1 in \p B[0..n-1]
+             * @note O(1) time
+             */
+            int64_t count1() const
+            {
+                return this->rank_directory[this->rank_directory.size() - 2];
+            }
+
+            /**
+             * @brief Return the number of 0 in \p B[0..n-1]
+             * @note O(1) time
+             */
+            int64_t count0() const
+            {
+                return this->_size - this->count1();
+            }
+
+            /**
+             * @brief Return the number of \p c in \p B[0..n-1]
+             * @note O(1) time
+             */
+            int64_t count_c(bool c) const
+            {
+                return c ? this->count1() : this->count0();
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Print and verification functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the name of the FrozenBitSequence for debugging
+             */
+            static std::string name()
+            {
+                return "FrozenBitSequence";
+            }
+            //@}
+
+        private:
+            uint64_t block_count() const
+            {
+                return (this->_size + BLOCK_BIT_SIZE - 1) / BLOCK_BIT_SIZE;
+            }
+
+            /**
+             * @brief Return the number of \p c in the first \p block blocks
+             */
+            template <bool c>
+            uint64_t count_before_block(uint64_t block) const
+            {
+                uint64_t ones = this->rank_directory[block * 2];
+                if constexpr (c)
+                {
+                    return ones;
+                }
+                else
+                {
+                    return std::min(block * BLOCK_BIT_SIZE, this->_size) - ones;
+                }
+            }
+
+            /**
+             * @brief Return the number of \p c in the first \p word_in_block words of the \p block-th block
+             */
+            template <bool c>
+            uint64_t count_in_block(uint64_t block, uint64_t word_in_block) const
+            {
+                uint64_t ones = word_in_block == 0 ? 0 : (this->rank_directory[block * 2 + 1] >> (9 * (word_in_block - 1))) & 511ULL;
+                if constexpr (c)
+                {
+                    return ones;
+                }
+                else
+                {
+                    return (word_in_block * 64) - ones;
+                }
+            }
+
+            template <bool c>
+            int64_t select_sub(uint64_t i) const
+            {
+                if (i >= (uint64_t)this->count_c(c))
+                {
+                    return -1;
+                }
+                const std::vector<uint64_t> &samples = c ? this->select1_samples : this->select0_samples;
+                uint64_t sample = i / SELECT_SAMPLE_RATE;
+                uint64_t lo = samples[sample];
+                uint64_t hi = sample + 1 < samples.size() ? samples[sample + 1] : this->block_count() - 1;
+
+                // Find the last block b in [lo, hi] such that count_before_block(b) <= i.
+                while (lo < hi)
+                {
+                    uint64_t mid = (lo + hi + 1) / 2;
+                    if (this->count_before_block<c>(mid) <= i)
+                    {
+                        lo = mid;
+                    }
+                    else
+                    {
+                        hi = mid - 1;
+                    }
+                }
+                uint64_t block = lo;
+                uint64_t k = i - this->count_before_block<c>(block);
+                uint64_t word_in_block = 0;
+                uint64_t block_word_size = std::min<uint64_t>(WORDS_IN_BLOCK, this->words.size() - (block * WORDS_IN_BLOCK));
+                while (word_in_block + 1 < block_word_size && this->count_in_block<c>(block, word_in_block + 1) <= k)
+                {
+                    word_in_block++;
+                }
+                k -= this->count_in_block<c>(block, word_in_block);
+                uint64_t word_index = (block * WORDS_IN_BLOCK) + word_in_block;
+                uint64_t word = c ? this->words[word_index] : ~this->words[word_index];
+                return (word_index * 64) + PackedBitFunctions::select1_in_word(word, k);
+            }
+
+            /**
+             * @brief Build the rank directory and the select samples.
+             * @details The blocks are partitioned into \p thread_count ranges. Each thread computes the counts inside its blocks,
+             *          and the counts before the blocks are computed by one prefix-sum pass over the blocks.
+             */
+            void build_directory(uint64_t thread_count)
+            {
+                uint64_t _block_count = this->block_count();
+                this->rank_directory.clear();
+                this->rank_directory.resize((_block_count + 1) * 2, 0);
+
+                auto build_blocks = [this](uint64_t first_block, uint64_t last_block)
+                {
+                    for (uint64_t b = first_block; b < last_block; b++)
+                    {
+                        uint64_t count = 0;
+                        uint64_t packed_counts = 0;
+                        uint64_t first_word = b * WORDS_IN_BLOCK;
+                        uint64_t last_word = std::min<uint64_t>(first_word + WORDS_IN_BLOCK, this->words.size());
+                        for (uint64_t w = first_word; w < last_word; w++)
+                        {
+                            if (w > first_word)
+                            {
+                                packed_counts |= count << (9 * (w - first_word - 1));
+                            }
+                            count += __builtin_popcountll(this->words[w]);
+                        }
+                        for (uint64_t w = last_word; w < first_word + WORDS_IN_BLOCK; w++)
+                        {
+                            if (w > first_word)
+                            {
+                                packed_counts |= count << (9 * (w - first_word - 1));
+                            }
+                        }
+                        this->rank_directory[b * 2] = count;
+                        this->rank_directory[b * 2 + 1] = packed_counts;
+                    }
+                };
+
+                thread_count = std::max<uint64_t>(1, std::min<uint64_t>(thread_count, _block_count));
+                if (thread_count == 1)
+                {
+                    build_blocks(0, _block_count);
+                }
+                else
+                {
+                    std::vector<std::thread> threads;
+                    uint64_t blocks_per_thread = (_block_count + thread_count - 1) / thread_count;
+                    for (uint64_t t = 0; t < thread_count; t++)
+                    {
+                        uint64_t first_block = std::min(t * blocks_per_thread, _block_count);
+                        uint64_t last_block = std::min(first_block + blocks_per_thread, _block_count);
+                        threads.emplace_back(build_blocks, first_block, last_block);
+                    }
+                    for (std::thread &th : threads)
+                    {
+                        th.join();
+                    }
+                }
+
+                uint64_t sum = 0;
+                for (uint64_t b = 0; b <= _block_count; b++)
+                {
+                    uint64_t count = this->rank_directory[b * 2];
+                    this->rank_directory[b * 2] = sum;
+                    sum += count;
+                }
+
+                this->select1_samples.clear();
+                this->select0_samples.clear();
+                for (uint64_t b = 0; b < _block_count; b++)
+                {
+                    uint64_t ones_end = this->count_before_block<true>(b + 1);
+                    uint64_t zeros_end = this->count_before_block<false>(b + 1);
+                    while (this->select1_samples.size() * SELECT_SAMPLE_RATE < ones_end)
+                    {
+                        this->select1_samples.push_back(b);
+                    }
+                    while (this->select0_samples.size() * SELECT_SAMPLE_RATE < zeros_end)
+                    {
+                        this->select0_samples.push_back(b);
+                    }
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,793 @@
+#pragma once
+#include "../bp_tree.hpp"
+#include "./packed_bit_functions.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief A container that stores a short sequence of bits in a gap buffer.
+         * @details The bits B[0..n-1] are stored in an array of 64-bit words W with an unused region (the gap) of g bits at the position p of the last edit,
+         *          i.e., B[0..p-1] is stored in W[0..p-1] and B[p..n-1] is stored in W[p+g..n+g-1] (packed in the same order as PackedBitFunctions).
+         *          An insertion or deletion at position i moves the gap to i in O(|i - p| / 64) time and then takes O(1) time,
+         *          so consecutive edits at nearby positions (e.g., sequential editing and BWT construction) do not shift the whole array.
+         *          The bits in the gap are always 0, which lets rank and select run the popcount kernels over W directly.
+         * \ingroup BitClasses
+         */
+        template <uint64_t MAX_BIT_SIZE = 8192ULL>
+        class GapBitContainer
+        {
+            std::vector<uint64_t> words_;
+            uint64_t gap_pos_ = 0;
+            uint64_t gap_size_ = 0;
+            uint64_t size_ = 0;
+            uint64_t one_count_ = 0;
+
+        public:
+            /**
+             * @brief A random access iterator over the bits of a GapBitContainer.
+             */
+            class GapBitContainerIterator
+            {
+            public:
+                const GapBitContainer *container = nullptr;
+                uint64_t index = UINT64_MAX;
+
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = bool;
+                using difference_type = std::ptrdiff_t;
+
+                GapBitContainerIterator() {}
+                GapBitContainerIterator(const GapBitContainer *_container, uint64_t _index) : container(_container), index(_index) {}
+
+                bool operator*() const
+                {
+                    return this->container->at(this->index);
+                }
+                uint64_t get_size() const
+                {
+                    return this->container->size();
+                }
+                bool is_end() const
+                {
+                    return this->container == nullptr || this->index >= this->container->size();
+                }
+
+                /**
+                 * @brief Return the 64 bits starting at the current position (MSB first; the bits beyond the end are 0)
+                 */
+                uint64_t read_64bits_string() const
+                {
+                    return this->container->read_64bits(this->index);
+                }
+
+                GapBitContainerIterator &operator++()
+                {
+                    this->index++;
+                    return *this;
+                }
+                GapBitContainerIterator operator++(int)
+                {
+                    GapBitContainerIterator tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+                GapBitContainerIterator &operator+=(difference_type n)
+                {
+                    this->index += n;
+                    return *this;
+                }
+                GapBitContainerIterator operator+(difference_type n) const
+                {
+                    return GapBitContainerIterator(this->container, this->index + n);
+                }
+                difference_type operator-(const GapBitContainerIterator &other) const
+                {
+                    return (difference_type)this->index - (difference_type)other.index;
+                }
+
+                bool operator==(const GapBitContainerIterator &other) const { return this->container == other.container && this->index == other.index; }
+                bool operator!=(const GapBitContainerIterator &other) const { return !(*this == other); }
+                bool operator<(const GapBitContainerIterator &other) const { return this->index < other.index; }
+                bool operator>(const GapBitContainerIterator &other) const { return this->index > other.index; }
+                bool operator<=(const GapBitContainerIterator &other) const { return this->index <= other.index; }
+                bool operator>=(const GapBitContainerIterator &other) const { return this->index >= other.index; }
+            };
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            GapBitContainer()
+            {
+            }
+            GapBitContainer(std::vector<uint64_t> &_items)
+            {
+                this->push_back_many(_items);
+            }
+            GapBitContainer(std::vector<bool> &_items)
+            {
+                for (uint64_t i = 0; i < _items.size(); i++)
+                {
+                    this->push_back(_items[i]);
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Properties
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void swap(GapBitContainer &item)
+            {
+                this->words_.swap(item.words_);
+                std::swap(this->gap_pos_, item.gap_pos_);
+                std::swap(this->gap_size_, item.gap_size_);
+                std::swap(this->size_, item.size_);
+                std::swap(this->one_count_, item.one_count_);
+            }
+            uint64_t size() const
+            {
+                return this->size_;
+            }
+
+            /**
+             * @brief Return the position of the gap (i.e., the position of the last edit)
+             */
+            uint64_t gap_position() const
+            {
+                return this->gap_pos_;
+            }
+            uint64_t size_in_bytes(bool only_extra_bytes) const
+            {
+                uint64_t extra = this->words_.capacity() * sizeof(uint64_t);
+                return only_extra_bytes ? extra : sizeof(GapBitContainer) + extra;
+            }
+            uint64_t unused_size_in_bytes() const
+            {
+                return (this->words_.capacity() * sizeof(uint64_t)) - ((this->size_ + 7) / 8);
+            }
+            static std::string name()
+            {
+                return "GapBitContainer";
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            uint64_t at(uint64_t pos) const
+            {
+                assert(pos < this->size_);
+                return PackedBitFunctions::get_bit(this->words_.data(), this->to_physical_position(pos));
+            }
+
+            /**
+             * @brief Return the 64 bits starting at position \p pos (MSB first; the bits beyond the end are 0)
+             */
+            uint64_t read_64bits(uint64_t pos) const
+            {
+                if (pos >= this->size_)
+                {
+                    return 0;
+                }
+                uint64_t capacity = this->capacity();
+                uint64_t value = 0;
+                if (pos >= this->gap_pos_)
+                {
+                    value = PackedBitFunctions::read_64bits(this->words_.data(), pos + this->gap_size_, capacity);
+                }
+                else
+                {
+                    uint64_t left_len = this->gap_pos_ - pos;
+                    value = PackedBitFunctions::read_64bits(this->words_.data(), pos, capacity);
+                    if (left_len < 64)
+                    {
+                        value &= UINT64_MAX << (64 - left_len);
+                        if (this->gap_pos_ < this->size_)
+                        {
+                            value |= PackedBitFunctions::read_64bits(this->words_.data(), this->gap_pos_ + this->gap_size_, capacity) >> left_len;
+                        }
+                    }
+                }
+                uint64_t valid_len = this->size_ - pos;
+                return valid_len >= 64 ? value : value & (UINT64_MAX << (64 - valid_len));
+            }
+
+            uint64_t psum(uint64_t i) const noexcept
+            {
+                return PackedBitFunctions::rank1(this->words_.data(), this->to_physical_position(i) + 1);
+            }
+            uint64_t psum() const noexcept
+            {
+                return this->one_count_;
+            }
+            uint64_t psum(uint64_t i, uint64_t j) const
+            {
+                if (i == j)
+                {
+                    return this->at(i);
+                }
+                else
+                {
+                    return this->psum(j) - (i > 0 ? this->psum(i - 1) : 0);
+                }
+            }
+            uint64_t reverse_psum(uint64_t i) const
+            {
+                if (i + 1 >= this->size_)
+                {
+                    return this->one_count_;
+                }
+                else
+                {
+                    return this->one_count_ - this->psum(this->size_ - i - 2);
+                }
+            }
+
+            int64_t search(uint64_t x) const noexcept
+            {
+                if (x == 0)
+                {
+                    return 0;
+                }
+                else if (x > this->one_count_)
+                {
+                    return -1;
+                }
+                else
+                {
+                    int64_t p = PackedBitFunctions::select1(this->words_.data(), this->capacity(), x - 1);
+                    return this->to_logical_position(p);
+                }
+            }
+
+            int64_t rank1(uint64_t i) const
+            {
+                return i == 0 ? 0 : this->psum(i - 1);
+            }
+            int64_t rank0(uint64_t i) const
+            {
+                return i - this->rank1(i);
+            }
+            int64_t rank(uint64_t i, bool b) const
+            {
+                return b ? this->rank1(i) : this->rank0(i);
+            }
+            int64_t select(uint64_t i, bool b) const
+            {
+                return b ? this->select1(i) : this->select0(i);
+            }
+            int64_t select1(uint64_t i) const
+            {
+                return this->search(i + 1);
+            }
+
+            /**
+             * @brief Return the position of the (i+1)-th 0 if it exists, otherwise return -1.
+             * @details The 0s in the gap are skipped by searching the left and right parts of the array separately.
+             */
+            int64_t select0(uint64_t i) const
+            {
+                uint64_t left_zero_count = this->gap_pos_ - PackedBitFunctions::rank1(this->words_.data(), this->gap_pos_);
+                if (i < left_zero_count)
+                {
+                    return PackedBitFunctions::select0(this->words_.data(), this->gap_pos_, i);
+                }
+                else if (i >= this->size_ - this->one_count_)
+                {
+                    return -1;
+                }
+                else
+                {
+                    uint64_t k = i - left_zero_count;
+                    uint64_t p = this->gap_pos_ + this->gap_size_;
+                    uint64_t capacity = this->capacity();
+                    while (true)
+                    {
+                        uint64_t len = std::min<uint64_t>(64, capacity - p);
+                        uint64_t word = ~PackedBitFunctions::read_64bits(this->words_.data(), p, capacity) & (UINT64_MAX << (64 - len));
+                        uint64_t count = __builtin_popcountll(word);
+                        if (k < count)
+                        {
+                            return this->to_logical_position(p + PackedBitFunctions::select1_in_word(word, k));
+                        }
+                        k -= count;
+                        p += len;
+                    }
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void print() const
+            {
+                std::cout << this->to_string() << std::endl;
+            }
+            std::string to_string() const
+            {
+                std::string s;
+                for (uint64_t i = 0; i < this->size_; i++)
+                {
+                    s.push_back(this->at(i) ? '1' : '0');
+                }
+                return s;
+            }
+            std::vector<uint64_t> to_value_vector() const
+            {
+                std::vector<uint64_t> r;
+                this->to_values(r);
+                return r;
+            }
+            uint64_t to_uint64() const
+            {
+                uint64_t value = this->read_64bits(0);
+                return this->size_ >= 64 ? value : (this->size_ > 0 ? value >> (64 - this->size_) : 0);
+            }
+            template <typename VEC>
+            void to_values(VEC &output_vec) const
+            {
+                output_vec.clear();
+                output_vec.resize(this->size_);
+                for (uint64_t i = 0; i < this->size_; i++)
+                {
+                    output_vec[i] = this->at(i);
+                }
+            }
+
+            /**
+             * @brief Write the bits in the range [pos..pos+len-1] to \p output[output_offset..output_offset+len-1] packed in 64-bit words.
+             * @note O(len / 64) time
+             */
+            void extract_words(uint64_t pos, uint64_t len, uint64_t *output, uint64_t output_offset) const
+            {
+                assert(pos + len <= this->size_);
+                uint64_t left_len = pos < this->gap_pos_ ? std::min<uint64_t>(len, this->gap_pos_ - pos) : 0;
+                if (left_len > 0)
+                {
+                    PackedBitFunctions::copy_bits(this->words_.data(), pos, left_len, output, output_offset);
+                }
+                if (len > left_len)
+                {
+                    PackedBitFunctions::copy_bits(this->words_.data(), this->to_physical_position(pos + left_len), len - left_len, output, output_offset + left_len);
+                }
+            }
+
+            GapBitContainerIterator begin() const
+            {
+                return GapBitContainerIterator(this, 0);
+            }
+            GapBitContainerIterator end() const
+            {
+                return GapBitContainerIterator(this, this->size_);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void clear()
+            {
+                this->words_.clear();
+                this->words_.shrink_to_fit();
+                this->gap_pos_ = 0;
+                this->gap_size_ = 0;
+                this->size_ = 0;
+                this->one_count_ = 0;
+            }
+
+            /**
+             * @brief Insert a bit \p value at position \p pos
+             * @note O(|pos - p| / 64) amortized time, where p is the position of the last edit
+             */
+            void insert(uint64_t pos, uint64_t value)
+            {
+                assert(pos <= this->size_);
+                assert(this->size_ < MAX_BIT_SIZE);
+                this->reserve_gap(1);
+                this->move_gap(pos);
+                if (value >= 1)
+                {
+                    this->words_[pos / 64] |= 1ULL << (63 - (pos % 64));
+                    this->one_count_++;
+                }
+                this->gap_pos_++;
+                this->gap_size_--;
+                this->size_++;
+            }
+
+            /**
+             * @brief Remove the bit at position \p pos
+             * @note O(|pos - p| / 64) time, where p is the position of the last edit
+             */
+            void remove(uint64_t pos)
+            {
+                assert(pos < this->size_);
+                this->move_gap(pos);
+                uint64_t p = this->gap_pos_ + this->gap_size_;
+                uint64_t mask = 1ULL << (63 - (p % 64));
+                if (this->words_[p / 64] & mask)
+                {
+                    this->words_[p / 64] &= ~mask;
+                    this->one_count_--;
+                }
+                this->gap_size_++;
+                this->size_--;
+            }
+
+            void increment(uint64_t i, int64_t delta)
+            {
+                uint64_t p = this->to_physical_position(i);
+                uint64_t mask = 1ULL << (63 - (p % 64));
+                bool b = this->words_[p / 64] & mask;
+                if (delta >= 1 && !b)
+                {
+                    this->words_[p / 64] |= mask;
+                    this->one_count_++;
+                }
+                else if (delta <= -1 && b)
+                {
+                    this->words_[p / 64] &= ~mask;
+                    this->one_count_--;
+                }
+            }
+
+            void push_back(uint64_t value)
+            {
+                this->insert(this->size_, value);
+            }
+            void push_front(uint64_t new_item)
+            {
+                this->insert(0, new_item);
+            }
+            void pop_back()
+            {
+                assert(this->size_ > 0);
+                this->remove(this->size_ - 1);
+            }
+            void pop_front()
+            {
+                assert(this->size_ > 0);
+                this->remove(0);
+            }
+
+            void push_back_many(const std::vector<uint64_t> &new_items)
+            {
+                this->reserve_gap(new_items.size());
+                this->move_gap(this->size_);
+                for (uint64_t v : new_items)
+                {
+                    this->insert(this->size_, v);
+                }
+            }
+            void push_front_many(const std::vector<uint64_t> &new_items)
+            {
+                this->reserve_gap(new_items.size());
+                for (uint64_t i = 0; i < new_items.size(); i++)
+                {
+                    this->insert(i, new_items[i]);
+                }
+            }
+
+            /**
+             * @brief Remove the first \p len bits and return them
+             * @details The removed bits are merged into the gap, and the array is shrunk if the gap becomes larger than the bits.
+             */
+            std::vector<uint64_t> pop_front_many(uint64_t len)
+            {
+                assert(len <= this->size_);
+                std::vector<uint64_t> r;
+                r.resize(len);
+                this->move_gap(len);
+                for (uint64_t i = 0; i < len; i++)
+                {
+                    r[i] = PackedBitFunctions::get_bit(this->words_.data(), i);
+                }
+                this->one_count_ -= PackedBitFunctions::rank1(this->words_.data(), len);
+                this->clear_bits(0, len);
+                this->gap_pos_ = 0;
+                this->gap_size_ += len;
+                this->size_ -= len;
+                this->shrink_if_sparse();
+                return r;
+            }
+            std::vector<uint64_t> pop_back_many(uint64_t len)
+            {
+                assert(len <= this->size_);
+                std::vector<uint64_t> r;
+                r.resize(len);
+                this->move_gap(this->size_ - len);
+                uint64_t p = this->gap_pos_ + this->gap_size_;
+                for (uint64_t i = 0; i < len; i++)
+                {
+                    r[i] = PackedBitFunctions::get_bit(this->words_.data(), p + i);
+                    this->one_count_ -= r[i];
+                }
+                this->clear_bits(p, len);
+                this->gap_size_ += len;
+                this->size_ -= len;
+                this->shrink_if_sparse();
+                return r;
+            }
+
+            /**
+             * @brief Append the bits \p words[offset..offset+len-1] packed in 64-bit words to the end of this container.
+             * @note O(len / 64) amortized time
+             */
+            void push_back_words(const uint64_t *words, uint64_t offset, uint64_t len)
+            {
+                this->insert_words(this->size_, words, offset, len);
+            }
+
+            /**
+             * @brief Insert the bits \p words[offset..offset+len-1] packed in 64-bit words at the position \p pos of this container.
+             * @note O((|pos - p| + len) / 64) amortized time, where p is the position of the last edit
+             */
+            void insert_words(uint64_t pos, const uint64_t *words, uint64_t offset, uint64_t len)
+            {
+                assert(pos <= this->size_);
+                if (len > 0)
+                {
+                    this->reserve_gap(len);
+                    this->move_gap(pos);
+                    PackedBitFunctions::copy_bits(words, offset, len, this->words_.data(), pos);
+                    this->one_count_ += PackedBitFunctions::rank1(this->words_.data(), pos + len) - PackedBitFunctions::rank1(this->words_.data(), pos);
+                    this->gap_pos_ += len;
+                    this->gap_size_ -= len;
+                    this->size_ += len;
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Load, save, and builder functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void to_data(std::vector<uint8_t> &output) const
+            {
+                uint64_t pos = output.size();
+                output.resize(pos + this->get_byte_size());
+                this->store_to_bytes(output, pos);
+            }
+
+            static uint64_t get_byte_size(const std::vector<GapBitContainer> &items)
+            {
+                uint64_t size = sizeof(uint64_t);
+                for (const auto &item : items)
+                {
+                    size += item.get_byte_size();
+                }
+                return size;
+            }
+            static void store_to_bytes(const std::vector<GapBitContainer> &items, std::vector<uint8_t> &output, uint64_t &pos)
+            {
+                uint64_t size = get_byte_size(items);
+                if (pos + size > output.size())
+                {
+                    output.resize(pos + size);
+                }
+                uint64_t items_size = items.size();
+                std::memcpy(output.data() + pos, &items_size, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                for (const auto &item : items)
+                {
+                    item.store_to_bytes(output, pos);
+                }
+            }
+            static void store_to_file(const std::vector<GapBitContainer> &items, std::ofstream &os)
+            {
+                std::vector<uint8_t> bytes;
+                uint64_t pos = 0;
+                store_to_bytes(items, bytes, pos);
+                os.write(reinterpret_cast<const char *>(bytes.data()), pos);
+            }
+            static GapBitContainer load_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
+                GapBitContainer r;
+                uint64_t size = 0;
+                std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(size));
+                if (words.size() > 0)
+                {
+                    std::memcpy(words.data(), data.data() + pos, words.size() * sizeof(uint64_t));
+                    pos += words.size() * sizeof(uint64_t);
+                }
+                r.push_back_words(words.data(), 0, size);
+                return r;
+            }
+            static GapBitContainer load_from_file(std::ifstream &ifs)
+            {
+                uint64_t size = 0;
+                ifs.read(reinterpret_cast<char *>(&size), sizeof(uint64_t));
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(size));
+                ifs.read(reinterpret_cast<char *>(words.data()), words.size() * sizeof(uint64_t));
+                GapBitContainer r;
+                r.push_back_words(words.data(), 0, size);
+                return r;
+            }
+            static std::vector<GapBitContainer> load_vector_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
+                uint64_t size = 0;
+                std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+
+                std::vector<GapBitContainer> output;
+                output.resize(size);
+                for (uint64_t i = 0; i < size; i++)
+                {
+                    output[i] = GapBitContainer::load_from_bytes(data, pos);
+                }
+                return output;
+            }
+            static std::vector<GapBitContainer> load_vector_from_file(std::ifstream &ifs)
+            {
+                uint64_t size = 0;
+                ifs.read(reinterpret_cast<char *>(&size), sizeof(uint64_t));
+
+                std::vector<GapBitContainer> output;
+                output.resize(size);
+                for (uint64_t i = 0; i < size; i++)
+                {
+                    output[i] = GapBitContainer::load_from_file(ifs);
+                }
+                return output;
+            }
+            //@}
+
+        private:
+            uint64_t capacity() const
+            {
+                return this->words_.size() * 64;
+            }
+            uint64_t to_physical_position(uint64_t pos) const
+            {
+                return pos < this->gap_pos_ ? pos : pos + this->gap_size_;
+            }
+            uint64_t to_logical_position(uint64_t p) const
+            {
+                assert(p < this->gap_pos_ || p >= this->gap_pos_ + this->gap_size_);
+                return p < this->gap_pos_ ? p : p - this->gap_size_;
+            }
+
+            uint64_t get_byte_size() const
+            {
+                return sizeof(uint64_t) + (PackedBitFunctions::get_word_size(this->size_) * sizeof(uint64_t));
+            }
+            void store_to_bytes(std::vector<uint8_t> &output, uint64_t &pos) const
+            {
+                std::memcpy(output.data() + pos, &this->size_, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                std::vector<uint64_t> words;
+                words.resize(PackedBitFunctions::get_word_size(this->size_), 0);
+                this->extract_words(0, this->size_, words.data(), 0);
+                if (words.size() > 0)
+                {
+                    std::memcpy(output.data() + pos, words.data(), words.size() * sizeof(uint64_t));
+                    pos += words.size() * sizeof(uint64_t);
+                }
+            }
+
+            /**
+             * @brief Set the bits W[pos..pos+len-1] to 0
+             */
+            void clear_bits(uint64_t pos, uint64_t len)
+            {
+                for (uint64_t k = 0; k < len; k += 64)
+                {
+                    PackedBitFunctions::write_bits(this->words_.data(), pos + k, 0, std::min<uint64_t>(64, len - k));
+                }
+            }
+
+            /**
+             * @brief Move the bits W[source_pos..source_pos+len-1] to W[target_pos..target_pos+len-1] (the two ranges may overlap)
+             */
+            void move_bits(uint64_t source_pos, uint64_t len, uint64_t target_pos)
+            {
+                if (len == 0 || source_pos == target_pos)
+                {
+                    return;
+                }
+                else if (target_pos < source_pos)
+                {
+                    PackedBitFunctions::copy_bits(this->words_.data(), source_pos, len, this->words_.data(), target_pos);
+                }
+                else
+                {
+                    uint64_t k = ((len - 1) / 64) * 64;
+                    while (true)
+                    {
+                        uint64_t block_len = std::min<uint64_t>(64, len - k);
+                        uint64_t value = PackedBitFunctions::read_64bits(this->words_.data(), source_pos + k, source_pos + len);
+                        PackedBitFunctions::write_bits(this->words_.data(), target_pos + k, value, block_len);
+                        if (k == 0)
+                        {
+                            break;
+                        }
+                        k -= 64;
+                    }
+                }
+            }
+
+            /**
+             * @brief Move the gap to the position \p pos
+             * @note O(|pos - p| / 64) time, where p is the current position of the gap
+             */
+            void move_gap(uint64_t pos)
+            {
+                assert(pos <= this->size_);
+                if (pos < this->gap_pos_)
+                {
+                    this->move_bits(pos, this->gap_pos_ - pos, pos + this->gap_size_);
+                    this->clear_bits(pos, std::min(this->gap_pos_, pos + this->gap_size_) - pos);
+                }
+                else if (pos > this->gap_pos_)
+                {
+                    uint64_t old_right_pos = this->gap_pos_ + this->gap_size_;
+                    this->move_bits(old_right_pos, pos - this->gap_pos_, this->gap_pos_);
+                    uint64_t clear_pos = std::max(pos, old_right_pos);
+                    this->clear_bits(clear_pos, pos + this->gap_size_ - clear_pos);
+                }
+                this->gap_pos_ = pos;
+            }
+
+            /**
+             * @brief Enlarge the array so that the gap has at least \p len bits
+             * @details The array grows by 1/8 of its size (at least 128 bits) beyond the requested length, so that insertions take O(1) amortized time.
+             */
+            void reserve_gap(uint64_t len)
+            {
+                if (this->gap_size_ < len)
+                {
+                    uint64_t new_bit_size = this->size_ + len;
+                    new_bit_size += std::max<uint64_t>(128, new_bit_size / 8);
+                    this->resize_array(PackedBitFunctions::get_word_size(new_bit_size));
+                }
+            }
+
+            /**
+             * @brief Shrink the array if the gap is larger than the bits
+             */
+            void shrink_if_sparse()
+            {
+                if (this->gap_size_ > this->size_ + 256)
+                {
+                    uint64_t new_bit_size = this->size_ + std::max<uint64_t>(128, this->size_ / 8);
+                    this->resize_array(PackedBitFunctions::get_word_size(new_bit_size));
+                    this->words_.shrink_to_fit();
+                }
+            }
+
+            /**
+             * @brief Resize the array to \p new_word_size words, keeping the bits after the gap at the end of the array
+             */
+            void resize_array(uint64_t new_word_size)
+            {
+                assert(new_word_size * 64 >= this->size_);
+                uint64_t right_len = this->size_ - this->gap_pos_;
+                uint64_t old_right_pos = this->gap_pos_ + this->gap_size_;
+                uint64_t new_right_pos = (new_word_size * 64) - right_len;
+                if (new_right_pos > old_right_pos)
+                {
+                    this->words_.resize(new_word_size, 0);
+                    this->move_bits(old_right_pos, right_len, new_right_pos);
+                    this->clear_bits(old_right_pos, std::min(new_right_pos, old_right_pos + right_len) - old_right_pos);
+                }
+                else if (new_right_pos < old_right_pos)
+                {
+                    this->move_bits(old_right_pos, right_len, new_right_pos);
+                    this->words_.resize(new_word_size);
+                }
+                this->gap_size_ = new_right_pos - this->gap_pos_;
+            }
+        };
+    }
+}
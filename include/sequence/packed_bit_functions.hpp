@@ -0,0 +1,299 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(STOOL_BPTREE_NO_X86_KERNELS)
+#include <immintrin.h>
+#define STOOL_BPTREE_X86_KERNELS 1
+#endif
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief Helper functions for bit sequences packed into arrays of 64-bit words.
+         * @details The i-th bit of a packed array W is stored in the (63 - i % 64)-th bit of W[i / 64], i.e., the bits are packed from the most significant bit of each word.
+         *          This is the same order as the one used by BitForwardIterator.
+         *
+         *          The popcount and select kernels use AVX-512 VPOPCNTQ and BMI2 PDEP/TZCNT if the running CPU supports them.
+         *          The check is done once at runtime, so the binary does not need to be compiled with -mbmi2 or -mavx512vpopcntdq.
+         * \ingroup BitClasses
+         */
+        class PackedBitFunctions
+        {
+        public:
+            /**
+             * @brief Return the number of 64-bit words required to store \p bit_size bits
+             */
+            static uint64_t get_word_size(uint64_t bit_size)
+            {
+                return (bit_size + 63) / 64;
+            }
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Runtime dispatch
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return true if the running CPU supports BMI2 (PDEP and TZCNT).
+             */
+            static bool cpu_supports_bmi2()
+            {
+#if defined(STOOL_BPTREE_X86_KERNELS)
+                static const bool b = __builtin_cpu_supports("bmi2");
+                return b;
+#else
+                return false;
+#endif
+            }
+
+            /**
+             * @brief Return true if the running CPU supports AVX-512 VPOPCNTQ.
+             */
+            static bool cpu_supports_avx512_popcount()
+            {
+#if defined(STOOL_BPTREE_X86_KERNELS)
+                static const bool b = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+                return b;
+#else
+                return false;
+#endif
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Rank and select kernels
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the position of the (k+1)-th 1 in a given word \p word counted from the least significant bit.
+             * @note \p k must be less than the number of 1s in \p word.
+             * @note O(1) time with BMI2, otherwise O(8 + 8) time
+             */
+            static uint64_t select1_in_word_from_lsb(uint64_t word, uint64_t k)
+            {
+                assert(k < (uint64_t)__builtin_popcountll(word));
+#if defined(STOOL_BPTREE_X86_KERNELS)
+                if (cpu_supports_bmi2())
+                {
+                    return select1_in_word_from_lsb_bmi2(word, k);
+                }
+#endif
+                uint64_t pos = 0;
+                while (true)
+                {
+                    uint64_t count = __builtin_popcountll(word & 0xFFULL);
+                    if (k < count)
+                    {
+                        break;
+                    }
+                    k -= count;
+                    word >>= 8;
+                    pos += 8;
+                }
+                while (true)
+                {
+                    if (word & 1ULL)
+                    {
+                        if (k == 0)
+                        {
+                            return pos;
+                        }
+                        k--;
+                    }
+                    word >>= 1;
+                    pos++;
+                }
+            }
+
+            /**
+             * @brief Return the position of the (k+1)-th 1 in a given word \p word counted from the most significant bit.
+             * @note \p k must be less than the number of 1s in \p word.
+             */
+            static uint64_t select1_in_word(uint64_t word, uint64_t k)
+            {
+                uint64_t count = __builtin_popcountll(word);
+                return 63 - select1_in_word_from_lsb(word, count - 1 - k);
+            }
+
+            /**
+             * @brief Return the number of 1s in \p words[0..word_size-1].
+             * @note O(word_size / 8) time with AVX-512 VPOPCNTQ, otherwise O(word_size) time
+             */
+            static uint64_t popcount_words(const uint64_t *words, uint64_t word_size)
+            {
+                uint64_t sum = 0;
+                uint64_t i = 0;
+#if defined(STOOL_BPTREE_X86_KERNELS)
+                if (word_size >= 8 && cpu_supports_avx512_popcount())
+                {
+                    i = word_size - (word_size % 8);
+                    sum += popcount_words_avx512(words, i);
+                }
+#endif
+                for (; i < word_size; i++)
+                {
+                    sum += __builtin_popcountll(words[i]);
+                }
+                return sum;
+            }
+
+            /**
+             * @brief Return the number of 1s in the first \p i bits of a given packed array \p words.
+             */
+            static uint64_t rank1(const uint64_t *words, uint64_t i)
+            {
+                uint64_t sum = popcount_words(words, i / 64);
+                if (i % 64 != 0)
+                {
+                    sum += __builtin_popcountll(words[i / 64] >> (64 - (i % 64)));
+                }
+                return sum;
+            }
+
+            /**
+             * @brief Return the position of the (k+1)-th 1 in a given packed array \p words storing \p bit_size bits if it exists, otherwise return -1.
+             * @details Blocks of 8 words are skipped by the popcount kernel, and the answer in the final word is found by the in-word select kernel.
+             */
+            static int64_t select1(const uint64_t *words, uint64_t bit_size, uint64_t k)
+            {
+                uint64_t word_size = get_word_size(bit_size);
+                uint64_t i = 0;
+                while (i + 8 <= word_size)
+                {
+                    uint64_t count = popcount_words(words + i, 8);
+                    if (k < count)
+                    {
+                        break;
+                    }
+                    k -= count;
+                    i += 8;
+                }
+                for (; i < word_size; i++)
+                {
+                    uint64_t word = words[i];
+                    if (i + 1 == word_size && bit_size % 64 != 0)
+                    {
+                        word &= UINT64_MAX << (64 - (bit_size % 64));
+                    }
+                    uint64_t count = __builtin_popcountll(word);
+                    if (k < count)
+                    {
+                        return (i * 64) + select1_in_word(word, k);
+                    }
+                    k -= count;
+                }
+                return -1;
+            }
+
+            /**
+             * @brief Return the position of the (k+1)-th 0 in a given packed array \p words storing \p bit_size bits if it exists, otherwise return -1.
+             */
+            static int64_t select0(const uint64_t *words, uint64_t bit_size, uint64_t k)
+            {
+                uint64_t word_size = get_word_size(bit_size);
+                for (uint64_t i = 0; i < word_size; i++)
+                {
+                    uint64_t word = ~words[i];
+                    if (i + 1 == word_size && bit_size % 64 != 0)
+                    {
+                        word &= UINT64_MAX << (64 - (bit_size % 64));
+                    }
+                    uint64_t count = __builtin_popcountll(word);
+                    if (k < count)
+                    {
+                        return (i * 64) + select1_in_word(word, k);
+                    }
+                    k -= count;
+                }
+                return -1;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Functions on packed arrays
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the \p i-th bit of a given packed array \p words
+             */
+            static bool get_bit(const uint64_t *words, uint64_t i)
+            {
+                return (words[i / 64] >> (63 - (i % 64))) & 1ULL;
+            }
+
+            /**
+             * @brief Return the 64 bits starting at position \p pos of a given packed array \p words storing \p bit_size bits.
+             * @note The bits beyond \p bit_size in the returned word are unspecified.
+             */
+            static uint64_t read_64bits(const uint64_t *words, uint64_t pos, uint64_t bit_size)
+            {
+                uint64_t block = pos / 64;
+                uint64_t shift = pos % 64;
+                uint64_t value = words[block] << shift;
+                if (shift > 0 && (block + 1) * 64 < bit_size)
+                {
+                    value |= words[block + 1] >> (64 - shift);
+                }
+                return value;
+            }
+
+            /**
+             * @brief Overwrite the \p len (<= 64) bits starting at position \p pos of a packed array \p words with the \p len highest bits of \p value.
+             */
+            static void write_bits(uint64_t *words, uint64_t pos, uint64_t value, uint64_t len)
+            {
+                assert(len > 0 && len <= 64);
+                uint64_t block = pos / 64;
+                uint64_t shift = pos % 64;
+                uint64_t mask = len == 64 ? UINT64_MAX : (UINT64_MAX << (64 - len));
+                value &= mask;
+                words[block] = (words[block] & ~(mask >> shift)) | (value >> shift);
+                if (shift + len > 64)
+                {
+                    words[block + 1] = (words[block + 1] & ~(mask << (64 - shift))) | (value << (64 - shift));
+                }
+            }
+
+            /**
+             * @brief Copy the bits \p source[source_pos..source_pos+len-1] to \p target[target_pos..target_pos+len-1].
+             * @note O(len / 64) time
+             */
+            static void copy_bits(const uint64_t *source, uint64_t source_pos, uint64_t len, uint64_t *target, uint64_t target_pos)
+            {
+                for (uint64_t k = 0; k < len; k += 64)
+                {
+                    uint64_t block_len = std::min<uint64_t>(64, len - k);
+                    uint64_t value = read_64bits(source, source_pos + k, source_pos + len);
+                    write_bits(target, target_pos + k, value, block_len);
+                }
+            }
+            //@}
+
+        private:
+#if defined(STOOL_BPTREE_X86_KERNELS)
+            __attribute__((target("bmi,bmi2"))) static uint64_t select1_in_word_from_lsb_bmi2(uint64_t word, uint64_t k)
+            {
+                return _tzcnt_u64(_pdep_u64(1ULL << k, word));
+            }
+
+            __attribute__((target("avx512f,avx512vpopcntdq"))) static uint64_t popcount_words_avx512(const uint64_t *words, uint64_t word_size)
+            {
+                __m512i sum = _mm512_setzero_si512();
+                for (uint64_t i = 0; i < word_size; i += 8)
+                {
+                    __m512i block = _mm512_loadu_si512((const void *)(words + i));
+                    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(block));
+                }
+                uint64_t lanes[8];
+                _mm512_storeu_si512((void *)lanes, sum);
+                return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+            }
+#endif
+        };
+    }
+}
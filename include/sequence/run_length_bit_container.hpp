@@ -0,0 +1,1135 @@
+#pragma once
+#include <memory>
+#include "../bp_tree.hpp"
+#include "./bit_deque_container.hpp"
+#include "./packed_bit_functions.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+        /**
+         * @brief A container that stores a short sequence of bits as runs of equal bits, and falls back to raw bits when the runs are fragmented.
+         * @details In the run-length mode, the j-th run is represented by the position E[j] following its last bit and the number of 1s R[j] in the prefix ending at E[j] (the running rank).
+         *          rank and select are answered by binary search on E or R, and insert, remove, and increment update the arrays in O(r) time, where r is the number of runs.
+         *          E and R are 32-bit integers. If r exceeds |B| / 64 (i.e., the runs need more space than raw bits) and |B| <= \p MAX_BIT_SIZE, the bits are re-encoded as a BitVectorContainer.
+         *          The bulk operations used by splits and merges of the B+-tree switch back to the run-length mode when the runs are compact again.
+         * @note BPTree bounds a leaf of this container by balance_weight() instead of |B|, i.e., a leaf holds at most about LEAF_CONTAINER_MAX_SIZE / 64 runs,
+         *       and a leaf of long runs holds up to 256 * LEAF_CONTAINER_MAX_SIZE bits. LEAF_CONTAINER_MAX_SIZE must be smaller than \p MAX_BIT_SIZE, the capacity of the raw mode.
+         * \ingroup BitClasses
+         */
+        template <uint64_t MAX_BIT_SIZE = 8192ULL>
+        class RunLengthBitContainer
+        {
+            using RawContainer = BitVectorContainer<MAX_BIT_SIZE>;
+            using Run = std::pair<uint64_t, bool>;
+
+            /**
+             * @brief The weight of a run in balance_weight() (the bits of E[j] and R[j])
+             */
+            static constexpr uint64_t RUN_WEIGHT = 64;
+            /**
+             * @brief balance_weight() counts one unit per 2^BIT_WEIGHT_SHIFT bits in the run-length mode
+             */
+            static constexpr uint64_t BIT_WEIGHT_SHIFT = 8;
+
+            std::vector<uint32_t> run_ends_;
+            std::vector<uint32_t> run_ranks_;
+            std::unique_ptr<RawContainer> raw_;
+
+        public:
+            /**
+             * @brief A random access iterator over the bits of a RunLengthBitContainer.
+             */
+            class RunLengthBitContainerIterator
+            {
+            public:
+                const RunLengthBitContainer *container = nullptr;
+                uint64_t index = UINT64_MAX;
+
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = bool;
+                using difference_type = std::ptrdiff_t;
+
+                RunLengthBitContainerIterator() {}
+                RunLengthBitContainerIterator(const RunLengthBitContainer *_container, uint64_t _index) : container(_container), index(_index) {}
+
+                bool operator*() const
+                {
+                    return this->container->at(this->index);
+                }
+                uint64_t get_size() const
+                {
+                    return this->container->size();
+                }
+                bool is_end() const
+                {
+                    return this->container == nullptr || this->index >= this->container->size();
+                }
+
+                /**
+                 * @brief Return the 64 bits starting at the current position (MSB first; the bits beyond the end are 0)
+                 */
+                uint64_t read_64bits_string() const
+                {
+                    return this->container->read_64bits(this->index);
+                }
+
+                RunLengthBitContainerIterator &operator++()
+                {
+                    this->index++;
+                    return *this;
+                }
+                RunLengthBitContainerIterator operator++(int)
+                {
+                    RunLengthBitContainerIterator tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+                RunLengthBitContainerIterator &operator+=(difference_type n)
+                {
+                    this->index += n;
+                    return *this;
+                }
+                RunLengthBitContainerIterator operator+(difference_type n) const
+                {
+                    return RunLengthBitContainerIterator(this->container, this->index + n);
+                }
+                difference_type operator-(const RunLengthBitContainerIterator &other) const
+                {
+                    return (difference_type)this->index - (difference_type)other.index;
+                }
+
+                bool operator==(const RunLengthBitContainerIterator &other) const { return this->container == other.container && this->index == other.index; }
+                bool operator!=(const RunLengthBitContainerIterator &other) const { return !(*this == other); }
+                bool operator<(const RunLengthBitContainerIterator &other) const { return this->index < other.index; }
+                bool operator>(const RunLengthBitContainerIterator &other) const { return this->index > other.index; }
+                bool operator<=(const RunLengthBitContainerIterator &other) const { return this->index <= other.index; }
+                bool operator>=(const RunLengthBitContainerIterator &other) const { return this->index >= other.index; }
+            };
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            RunLengthBitContainer()
+            {
+            }
+            RunLengthBitContainer(std::vector<uint64_t> &_items)
+            {
+                this->push_back_many(_items);
+            }
+            RunLengthBitContainer(std::vector<bool> &_items)
+            {
+                for (uint64_t i = 0; i < _items.size(); i++)
+                {
+                    this->push_back(_items[i]);
+                }
+            }
+            RunLengthBitContainer(const RunLengthBitContainer &other) : run_ends_(other.run_ends_), run_ranks_(other.run_ranks_)
+            {
+                if (other.raw_ != nullptr)
+                {
+                    this->raw_ = std::make_unique<RawContainer>(*other.raw_);
+                }
+            }
+            RunLengthBitContainer(RunLengthBitContainer &&) noexcept = default;
+            RunLengthBitContainer &operator=(const RunLengthBitContainer &other)
+            {
+                if (this != &other)
+                {
+                    RunLengthBitContainer tmp(other);
+                    this->swap(tmp);
+                }
+                return *this;
+            }
+            RunLengthBitContainer &operator=(RunLengthBitContainer &&) noexcept = default;
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Properties
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void swap(RunLengthBitContainer &item)
+            {
+                this->run_ends_.swap(item.run_ends_);
+                this->run_ranks_.swap(item.run_ranks_);
+                std::swap(this->raw_, item.raw_);
+            }
+
+            /**
+             * @brief Return true if the bits are stored as runs, false if they are stored as raw bits.
+             */
+            bool is_run_length_mode() const
+            {
+                return this->raw_ == nullptr;
+            }
+
+            /**
+             * @brief Return the number of runs in the run-length mode (0 in the raw mode)
+             */
+            uint64_t run_count() const
+            {
+                return this->run_ends_.size();
+            }
+
+            uint64_t size() const
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->size();
+                }
+                else
+                {
+                    return this->run_ends_.size() == 0 ? 0 : this->run_ends_[this->run_ends_.size() - 1];
+                }
+            }
+            uint64_t size_in_bytes(bool only_extra_bytes) const
+            {
+                uint64_t extra = (this->run_ends_.capacity() + this->run_ranks_.capacity()) * sizeof(uint32_t);
+                if (this->raw_ != nullptr)
+                {
+                    extra += this->raw_->size_in_bytes(false);
+                }
+                return only_extra_bytes ? extra : sizeof(RunLengthBitContainer) + extra;
+            }
+            uint64_t unused_size_in_bytes() const
+            {
+                uint64_t unused = ((this->run_ends_.capacity() - this->run_ends_.size()) + (this->run_ranks_.capacity() - this->run_ranks_.size())) * sizeof(uint32_t);
+                if (this->raw_ != nullptr)
+                {
+                    unused += this->raw_->unused_size_in_bytes();
+                }
+                return unused;
+            }
+            static std::string name()
+            {
+                return "RunLengthBitContainer";
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Queries
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            uint64_t at(uint64_t pos) const
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->at(pos);
+                }
+                else
+                {
+                    return this->run_bit(this->find_run(pos));
+                }
+            }
+
+            /**
+             * @brief Return the 64 bits starting at position \p pos (MSB first; the bits beyond the end are 0)
+             * @note O(log r + 64) time in the run-length mode
+             */
+            uint64_t read_64bits(uint64_t pos) const
+            {
+                uint64_t size = this->size();
+                uint64_t value = 0;
+                if (pos >= size)
+                {
+                    return 0;
+                }
+                else if (this->raw_ != nullptr)
+                {
+                    this->raw_->extract_words(pos, std::min<uint64_t>(64, size - pos), &value, 0);
+                    return value;
+                }
+                else
+                {
+                    this->extract_words(pos, std::min<uint64_t>(64, size - pos), &value, 0);
+                    return value;
+                }
+            }
+
+            uint64_t psum(uint64_t i) const noexcept
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->psum(i);
+                }
+                else
+                {
+                    uint64_t j = this->find_run(i);
+                    uint64_t ones_before = this->run_rank_before(j);
+                    return this->run_bit(j) ? ones_before + (i - this->run_start(j) + 1) : ones_before;
+                }
+            }
+            uint64_t psum() const noexcept
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->psum();
+                }
+                else
+                {
+                    return this->run_ranks_.size() == 0 ? 0 : this->run_ranks_[this->run_ranks_.size() - 1];
+                }
+            }
+            uint64_t psum(uint64_t i, uint64_t j) const
+            {
+                if (i == j)
+                {
+                    return this->at(i);
+                }
+                else
+                {
+                    return this->psum(j) - (i > 0 ? this->psum(i - 1) : 0);
+                }
+            }
+            uint64_t reverse_psum(uint64_t i) const
+            {
+                uint64_t size = this->size();
+                if (i + 1 >= size)
+                {
+                    return this->psum();
+                }
+                else
+                {
+                    return this->psum() - this->psum(size - i - 2);
+                }
+            }
+
+            int64_t search(uint64_t x) const noexcept
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->search(x);
+                }
+                else if (x == 0)
+                {
+                    return 0;
+                }
+                else if (x > this->psum())
+                {
+                    return -1;
+                }
+                else
+                {
+                    uint64_t j = std::lower_bound(this->run_ranks_.begin(), this->run_ranks_.end(), x) - this->run_ranks_.begin();
+                    return this->run_start(j) + (x - this->run_rank_before(j)) - 1;
+                }
+            }
+
+            int64_t rank1(uint64_t i) const
+            {
+                return i == 0 ? 0 : this->psum(i - 1);
+            }
+            int64_t rank0(uint64_t i) const
+            {
+                return i - this->rank1(i);
+            }
+            int64_t rank(uint64_t i, bool b) const
+            {
+                return b ? this->rank1(i) : this->rank0(i);
+            }
+            int64_t select(uint64_t i, bool b) const
+            {
+                return b ? this->select1(i) : this->select0(i);
+            }
+            int64_t select1(uint64_t i) const
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->select1(i);
+                }
+                else
+                {
+                    return this->search(i + 1);
+                }
+            }
+            int64_t select0(uint64_t i) const
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->select0(i);
+                }
+                else
+                {
+                    uint64_t left = 0;
+                    uint64_t right = this->run_ends_.size();
+                    while (left < right)
+                    {
+                        uint64_t mid = (left + right) / 2;
+                        uint64_t zeros = this->run_ends_[mid] - this->run_ranks_[mid];
+                        if (zeros > i)
+                        {
+                            right = mid;
+                        }
+                        else
+                        {
+                            left = mid + 1;
+                        }
+                    }
+                    if (left == this->run_ends_.size())
+                    {
+                        return -1;
+                    }
+                    uint64_t start = this->run_start(left);
+                    uint64_t zeros_before = start - this->run_rank_before(left);
+                    return start + (i - zeros_before);
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void print() const
+            {
+                std::cout << this->to_string() << std::endl;
+            }
+            std::string to_string() const
+            {
+                std::string s;
+                for (uint64_t i = 0; i < this->size(); i++)
+                {
+                    s.push_back(this->at(i) ? '1' : '0');
+                }
+                return s;
+            }
+            std::vector<uint64_t> to_value_vector() const
+            {
+                std::vector<uint64_t> r;
+                this->to_values(r);
+                return r;
+            }
+            uint64_t to_uint64() const
+            {
+                uint64_t size = this->size();
+                uint64_t value = this->read_64bits(0);
+                return size >= 64 ? value : (size > 0 ? value >> (64 - size) : 0);
+            }
+            template <typename VEC>
+            void to_values(VEC &output_vec) const
+            {
+                output_vec.clear();
+                output_vec.resize(this->size());
+                std::vector<Run> runs = this->get_runs();
+                uint64_t p = 0;
+                for (const Run &run : runs)
+                {
+                    for (uint64_t k = 0; k < run.first; k++)
+                    {
+                        output_vec[p++] = run.second ? 1 : 0;
+                    }
+                }
+            }
+
+            /**
+             * @brief Write the bits in the range [pos..pos+len-1] to \p output[output_offset..output_offset+len-1] packed in 64-bit words.
+             * @note O(log r + r' + len / 64) time in the run-length mode, where r' is the number of runs intersecting the range
+             */
+            void extract_words(uint64_t pos, uint64_t len, uint64_t *output, uint64_t output_offset) const
+            {
+                assert(pos + len <= this->size());
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->extract_words(pos, len, output, output_offset);
+                }
+                else if (len > 0)
+                {
+                    uint64_t j = this->find_run(pos);
+                    uint64_t p = pos;
+                    while (p < pos + len)
+                    {
+                        uint64_t end = std::min<uint64_t>(this->run_ends_[j], pos + len);
+                        uint64_t value = this->run_bit(j) ? UINT64_MAX : 0;
+                        for (uint64_t k = p; k < end; k += 64)
+                        {
+                            PackedBitFunctions::write_bits(output, output_offset + (k - pos), value, std::min<uint64_t>(64, end - k));
+                        }
+                        p = end;
+                        j++;
+                    }
+                }
+            }
+
+            RunLengthBitContainerIterator begin() const
+            {
+                return RunLengthBitContainerIterator(this, 0);
+            }
+            RunLengthBitContainerIterator end() const
+            {
+                return RunLengthBitContainerIterator(this, this->size());
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void clear()
+            {
+                this->run_ends_.clear();
+                this->run_ranks_.clear();
+                this->run_ends_.shrink_to_fit();
+                this->run_ranks_.shrink_to_fit();
+                this->raw_.reset();
+            }
+
+            void insert(uint64_t pos, uint64_t value)
+            {
+                bool b = value >= 1;
+                uint64_t size = this->size();
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->insert(pos, b);
+                }
+                else if (pos == size)
+                {
+                    this->push_back_run(1, b);
+                }
+                else
+                {
+                    uint64_t j = this->find_run(pos);
+                    uint64_t start = this->run_start(j);
+                    if (this->run_bit(j) == b)
+                    {
+                        this->add_to_runs(j, 1, b);
+                    }
+                    else if (pos == start && j > 0)
+                    {
+                        this->add_to_runs(j - 1, 1, b);
+                    }
+                    else if (pos == start)
+                    {
+                        this->run_ends_.insert(this->run_ends_.begin(), 0);
+                        this->run_ranks_.insert(this->run_ranks_.begin(), 0);
+                        this->add_to_runs(0, 1, b);
+                    }
+                    else
+                    {
+                        uint64_t ones_before = this->run_rank_before(j);
+                        uint32_t left_rank = ones_before + (this->run_bit(j) ? pos - start : 0);
+                        this->run_ends_.insert(this->run_ends_.begin() + j, {(uint32_t)pos, (uint32_t)pos});
+                        this->run_ranks_.insert(this->run_ranks_.begin() + j, {left_rank, left_rank});
+                        this->add_to_runs(j + 1, 1, b);
+                    }
+                    this->update_mode_after_update();
+                }
+            }
+
+            void remove(uint64_t pos)
+            {
+                assert(pos < this->size());
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->remove(pos);
+                }
+                else
+                {
+                    uint64_t j = this->find_run(pos);
+                    bool b = this->run_bit(j);
+                    this->add_to_runs(j, -1, b ? -1 : 0);
+                    if (this->run_ends_[j] == this->run_start(j))
+                    {
+                        this->run_ends_.erase(this->run_ends_.begin() + j);
+                        this->run_ranks_.erase(this->run_ranks_.begin() + j);
+                        if (j > 0 && j < this->run_ends_.size())
+                        {
+                            this->run_ends_.erase(this->run_ends_.begin() + (j - 1));
+                            this->run_ranks_.erase(this->run_ranks_.begin() + (j - 1));
+                        }
+                    }
+                    this->update_mode_after_update();
+                }
+            }
+
+            void increment(uint64_t i, int64_t delta)
+            {
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->increment(i, delta);
+                }
+                else if (delta != 0)
+                {
+                    bool b = delta >= 1;
+                    if ((this->at(i) >= 1) != b)
+                    {
+                        this->remove(i);
+                        this->insert(i, b);
+                    }
+                }
+            }
+
+            void push_back(uint64_t value)
+            {
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->push_back(value);
+                }
+                else
+                {
+                    this->push_back_run(1, value >= 1);
+                    this->update_mode_after_update();
+                }
+            }
+            void push_front(uint64_t new_item)
+            {
+                this->insert(0, new_item);
+            }
+            void pop_back()
+            {
+                assert(this->size() > 0);
+                this->remove(this->size() - 1);
+            }
+            void pop_front()
+            {
+                assert(this->size() > 0);
+                this->remove(0);
+            }
+
+            void push_back_many(const std::vector<uint64_t> &new_items)
+            {
+                std::vector<Run> runs = this->get_runs();
+                RunLengthBitContainer::append_runs_of_values(new_items, runs);
+                this->set_runs(runs);
+            }
+            void push_front_many(const std::vector<uint64_t> &new_items)
+            {
+                std::vector<Run> runs;
+                RunLengthBitContainer::append_runs_of_values(new_items, runs);
+                for (const Run &run : this->get_runs())
+                {
+                    RunLengthBitContainer::append_run(runs, run.first, run.second);
+                }
+                this->set_runs(runs);
+            }
+            std::vector<uint64_t> pop_front_many(uint64_t len)
+            {
+                assert(len <= this->size());
+                std::vector<uint64_t> r;
+                std::vector<Run> runs = this->get_runs();
+                std::vector<Run> new_runs;
+                for (const Run &run : runs)
+                {
+                    uint64_t x = std::min<uint64_t>(run.first, len - r.size());
+                    r.insert(r.end(), x, run.second ? 1 : 0);
+                    RunLengthBitContainer::append_run(new_runs, run.first - x, run.second);
+                }
+                this->set_runs(new_runs);
+                return r;
+            }
+            std::vector<uint64_t> pop_back_many(uint64_t len)
+            {
+                assert(len <= this->size());
+                uint64_t keep = this->size() - len;
+                std::vector<uint64_t> r;
+                std::vector<Run> runs = this->get_runs();
+                std::vector<Run> new_runs;
+                uint64_t p = 0;
+                for (const Run &run : runs)
+                {
+                    uint64_t x = p < keep ? std::min<uint64_t>(run.first, keep - p) : 0;
+                    RunLengthBitContainer::append_run(new_runs, x, run.second);
+                    r.insert(r.end(), run.first - x, run.second ? 1 : 0);
+                    p += run.first;
+                }
+                this->set_runs(new_runs);
+                return r;
+            }
+
+            /**
+             * @brief Append the bits \p words[offset..offset+len-1] packed in 64-bit words to the end of this container.
+             * @note O(r' + len / 64) time in the run-length mode, where r' is the number of runs in the appended bits
+             */
+            void push_back_words(const uint64_t *words, uint64_t offset, uint64_t len)
+            {
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->push_back_words(words, offset, len);
+                }
+                else
+                {
+                    std::vector<Run> runs;
+                    RunLengthBitContainer::append_runs_of_words(words, offset, len, runs);
+                    for (const Run &run : runs)
+                    {
+                        this->push_back_run(run.first, run.second);
+                    }
+                    this->update_mode_after_update();
+                }
+            }
+
+            /**
+             * @brief Insert the bits \p words[offset..offset+len-1] packed in 64-bit words at the position \p pos of this container.
+             */
+            void insert_words(uint64_t pos, const uint64_t *words, uint64_t offset, uint64_t len)
+            {
+                if (this->raw_ != nullptr)
+                {
+                    this->raw_->insert_words(pos, words, offset, len);
+                }
+                else
+                {
+                    std::vector<Run> runs = this->get_runs();
+                    std::vector<Run> new_runs;
+                    uint64_t p = 0;
+                    uint64_t k = 0;
+                    while (k < runs.size() && p + runs[k].first <= pos)
+                    {
+                        RunLengthBitContainer::append_run(new_runs, runs[k].first, runs[k].second);
+                        p += runs[k].first;
+                        k++;
+                    }
+                    if (k < runs.size())
+                    {
+                        RunLengthBitContainer::append_run(new_runs, pos - p, runs[k].second);
+                    }
+                    RunLengthBitContainer::append_runs_of_words(words, offset, len, new_runs);
+                    if (k < runs.size())
+                    {
+                        RunLengthBitContainer::append_run(new_runs, runs[k].first - (pos - p), runs[k].second);
+                        k++;
+                    }
+                    for (; k < runs.size(); k++)
+                    {
+                        RunLengthBitContainer::append_run(new_runs, runs[k].first, runs[k].second);
+                    }
+                    this->set_runs(new_runs);
+                }
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Balancing functions for BPTree
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return the weight of this container, which BPTree keeps at most LEAF_CONTAINER_MAX_SIZE in each leaf instead of the number of bits
+             * @details The weight is 64r + |B| / 256 in the run-length mode and |B| in the raw mode.
+             */
+            uint64_t balance_weight() const
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return this->raw_->size();
+                }
+                else
+                {
+                    return (this->run_ends_.size() * RUN_WEIGHT) + (this->size() >> BIT_WEIGHT_SHIFT);
+                }
+            }
+
+            /**
+             * @brief Return the number of bits that can be inserted into this container without making its weight exceed \p max_weight
+             * @details In the run-length mode, inserting x bits adds at most x + 1 runs.
+             */
+            uint64_t balance_capacity(uint64_t max_weight) const
+            {
+                uint64_t weight = this->balance_weight();
+                if (this->raw_ != nullptr)
+                {
+                    return weight < max_weight ? max_weight - weight : 0;
+                }
+                else
+                {
+                    uint64_t weight_per_bit = RUN_WEIGHT + 1;
+                    return weight + weight_per_bit < max_weight ? (max_weight - weight - weight_per_bit) / weight_per_bit : 0;
+                }
+            }
+
+            /**
+             * @brief Return the number of bits kept in the left container when BPTree splits this container
+             * @details In the run-length mode, the position is found by binary search so that both sides have almost the same weight.
+             * @note O(log |B| log r) time
+             */
+            uint64_t balance_split_position() const
+            {
+                uint64_t size = this->size();
+                if (this->raw_ != nullptr || size < 2)
+                {
+                    return size / 2;
+                }
+                else
+                {
+                    uint64_t left = 1;
+                    uint64_t right = size - 1;
+                    while (left < right)
+                    {
+                        uint64_t mid = (left + right) / 2;
+                        if (this->weight_of_range(0, mid) >= this->weight_of_range(mid, size))
+                        {
+                            right = mid;
+                        }
+                        else
+                        {
+                            left = mid + 1;
+                        }
+                    }
+                    return left;
+                }
+            }
+
+            /**
+             * @brief Return the weight of the container obtained by appending \p right to \p left, i.e., the weight of the leaf made by a merge of BPTree
+             * @note O(1) time in the run-length mode and O(|B| / 64) time in the raw mode
+             */
+            static uint64_t balance_weight_of_concatenation(const RunLengthBitContainer &left, const RunLengthBitContainer &right)
+            {
+                uint64_t left_size = left.size();
+                uint64_t right_size = right.size();
+                uint64_t run_count = left.count_runs() + right.count_runs();
+                if (left_size > 0 && right_size > 0 && left.at(left_size - 1) == right.at(0))
+                {
+                    run_count--;
+                }
+                return RunLengthBitContainer::weight_of(run_count, left_size + right_size);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Load, save, and builder functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            void to_data(std::vector<uint8_t> &output) const
+            {
+                uint64_t pos = output.size();
+                output.resize(pos + this->get_byte_size());
+                this->store_to_bytes(output, pos);
+            }
+
+            static uint64_t get_byte_size(const std::vector<RunLengthBitContainer> &items)
+            {
+                uint64_t size = sizeof(uint64_t);
+                for (const auto &item : items)
+                {
+                    size += item.get_byte_size();
+                }
+                return size;
+            }
+            static void store_to_bytes(const std::vector<RunLengthBitContainer> &items, std::vector<uint8_t> &output, uint64_t &pos)
+            {
+                uint64_t size = get_byte_size(items);
+                if (pos + size > output.size())
+                {
+                    output.resize(pos + size);
+                }
+                uint64_t items_size = items.size();
+                std::memcpy(output.data() + pos, &items_size, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                for (const auto &item : items)
+                {
+                    item.store_to_bytes(output, pos);
+                }
+            }
+            static void store_to_file(const std::vector<RunLengthBitContainer> &items, std::ofstream &os)
+            {
+                std::vector<uint8_t> bytes;
+                uint64_t pos = 0;
+                store_to_bytes(items, bytes, pos);
+                os.write(reinterpret_cast<const char *>(bytes.data()), pos);
+            }
+            static RunLengthBitContainer load_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
+                RunLengthBitContainer r;
+                uint64_t size = 0;
+                uint64_t run_count = 0;
+                std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                std::memcpy(&run_count, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                if (run_count == UINT64_MAX)
+                {
+                    std::vector<uint64_t> words;
+                    words.resize(PackedBitFunctions::get_word_size(size));
+                    std::memcpy(words.data(), data.data() + pos, words.size() * sizeof(uint64_t));
+                    pos += words.size() * sizeof(uint64_t);
+                    r.raw_ = std::make_unique<RawContainer>();
+                    r.raw_->push_back_words(words.data(), 0, size);
+                }
+                else if (run_count > 0)
+                {
+                    r.run_ends_.resize(run_count);
+                    r.run_ranks_.resize(run_count);
+                    std::memcpy(r.run_ends_.data(), data.data() + pos, run_count * sizeof(uint32_t));
+                    pos += run_count * sizeof(uint32_t);
+                    std::memcpy(r.run_ranks_.data(), data.data() + pos, run_count * sizeof(uint32_t));
+                    pos += run_count * sizeof(uint32_t);
+                }
+                return r;
+            }
+            static RunLengthBitContainer load_from_file(std::ifstream &ifs)
+            {
+                uint64_t header[2];
+                ifs.read(reinterpret_cast<char *>(header), sizeof(header));
+                uint64_t body_size = header[1] == UINT64_MAX ? PackedBitFunctions::get_word_size(header[0]) * sizeof(uint64_t) : header[1] * 2 * sizeof(uint32_t);
+                std::vector<uint8_t> bytes;
+                bytes.resize(sizeof(header) + body_size);
+                std::memcpy(bytes.data(), header, sizeof(header));
+                ifs.read(reinterpret_cast<char *>(bytes.data() + sizeof(header)), body_size);
+                uint64_t pos = 0;
+                return RunLengthBitContainer::load_from_bytes(bytes, pos);
+            }
+            static std::vector<RunLengthBitContainer> load_vector_from_bytes(const std::vector<uint8_t> &data, uint64_t &pos)
+            {
+                uint64_t size = 0;
+                std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+
+                std::vector<RunLengthBitContainer> output;
+                output.resize(size);
+                for (uint64_t i = 0; i < size; i++)
+                {
+                    output[i] = RunLengthBitContainer::load_from_bytes(data, pos);
+                }
+                return output;
+            }
+            static std::vector<RunLengthBitContainer> load_vector_from_file(std::ifstream &ifs)
+            {
+                uint64_t size = 0;
+                ifs.read(reinterpret_cast<char *>(&size), sizeof(uint64_t));
+
+                std::vector<RunLengthBitContainer> output;
+                output.resize(size);
+                for (uint64_t i = 0; i < size; i++)
+                {
+                    output[i] = RunLengthBitContainer::load_from_file(ifs);
+                }
+                return output;
+            }
+            //@}
+
+        private:
+            /**
+             * @brief Return the number of runs, which are counted from the raw bits in the raw mode
+             */
+            uint64_t count_runs() const
+            {
+                return this->raw_ != nullptr ? this->get_runs().size() : this->run_ends_.size();
+            }
+            uint64_t find_run(uint64_t pos) const
+            {
+                return std::upper_bound(this->run_ends_.begin(), this->run_ends_.end(), pos) - this->run_ends_.begin();
+            }
+            uint64_t run_start(uint64_t j) const
+            {
+                return j == 0 ? 0 : this->run_ends_[j - 1];
+            }
+            uint64_t run_rank_before(uint64_t j) const
+            {
+                return j == 0 ? 0 : this->run_ranks_[j - 1];
+            }
+            bool run_bit(uint64_t j) const
+            {
+                return this->run_ranks_[j] != this->run_rank_before(j);
+            }
+
+            /**
+             * @brief Add \p len_delta to the lengths and \p ones_delta to the ranks of the runs from the j-th run
+             */
+            void add_to_runs(uint64_t j, int64_t len_delta, int64_t ones_delta)
+            {
+                for (uint64_t t = j; t < this->run_ends_.size(); t++)
+                {
+                    this->run_ends_[t] = (int64_t)this->run_ends_[t] + len_delta;
+                    this->run_ranks_[t] = (int64_t)this->run_ranks_[t] + ones_delta;
+                }
+            }
+
+            void push_back_run(uint64_t len, bool b)
+            {
+                if (len > 0)
+                {
+                    uint64_t size = this->size();
+                    uint64_t ones = this->psum();
+                    if (this->run_ends_.size() > 0 && this->run_bit(this->run_ends_.size() - 1) == b)
+                    {
+                        this->run_ends_.pop_back();
+                        this->run_ranks_.pop_back();
+                    }
+                    this->run_ends_.push_back(size + len);
+                    this->run_ranks_.push_back(ones + (b ? len : 0));
+                }
+            }
+
+            uint64_t get_byte_size() const
+            {
+                if (this->raw_ != nullptr)
+                {
+                    return (2 * sizeof(uint64_t)) + (PackedBitFunctions::get_word_size(this->size()) * sizeof(uint64_t));
+                }
+                else
+                {
+                    return (2 * sizeof(uint64_t)) + (this->run_ends_.size() * 2 * sizeof(uint32_t));
+                }
+            }
+            void store_to_bytes(std::vector<uint8_t> &output, uint64_t &pos) const
+            {
+                uint64_t size = this->size();
+                uint64_t run_count = this->raw_ != nullptr ? UINT64_MAX : this->run_ends_.size();
+                std::memcpy(output.data() + pos, &size, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                std::memcpy(output.data() + pos, &run_count, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                if (this->raw_ != nullptr)
+                {
+                    std::vector<uint64_t> words;
+                    words.resize(PackedBitFunctions::get_word_size(size), 0);
+                    this->raw_->extract_words(0, size, words.data(), 0);
+                    std::memcpy(output.data() + pos, words.data(), words.size() * sizeof(uint64_t));
+                    pos += words.size() * sizeof(uint64_t);
+                }
+                else if (run_count > 0)
+                {
+                    std::memcpy(output.data() + pos, this->run_ends_.data(), run_count * sizeof(uint32_t));
+                    pos += run_count * sizeof(uint32_t);
+                    std::memcpy(output.data() + pos, this->run_ranks_.data(), run_count * sizeof(uint32_t));
+                    pos += run_count * sizeof(uint32_t);
+                }
+            }
+
+            static void append_run(std::vector<Run> &runs, uint64_t len, bool b)
+            {
+                if (len > 0)
+                {
+                    if (runs.size() > 0 && runs[runs.size() - 1].second == b)
+                    {
+                        runs[runs.size() - 1].first += len;
+                    }
+                    else
+                    {
+                        runs.push_back(Run(len, b));
+                    }
+                }
+            }
+            static void append_runs_of_values(const std::vector<uint64_t> &values, std::vector<Run> &runs)
+            {
+                for (uint64_t v : values)
+                {
+                    RunLengthBitContainer::append_run(runs, 1, v >= 1);
+                }
+            }
+
+            /**
+             * @brief Append the runs of \p words[offset..offset+len-1] to \p runs by counting the leading equal bits of each word.
+             */
+            static void append_runs_of_words(const uint64_t *words, uint64_t offset, uint64_t len, std::vector<Run> &runs)
+            {
+                uint64_t p = 0;
+                while (p < len)
+                {
+                    uint64_t value = PackedBitFunctions::read_64bits(words, offset + p, offset + len);
+                    bool b = (value >> 63) & 1ULL;
+                    uint64_t diff = b ? ~value : value;
+                    uint64_t run_len = diff == 0 ? 64 : __builtin_clzll(diff);
+                    run_len = std::min<uint64_t>(run_len, len - p);
+                    RunLengthBitContainer::append_run(runs, run_len, b);
+                    p += run_len;
+                }
+            }
+
+            std::vector<Run> get_runs() const
+            {
+                std::vector<Run> runs;
+                if (this->raw_ != nullptr)
+                {
+                    uint64_t size = this->raw_->size();
+                    std::vector<uint64_t> words;
+                    words.resize(PackedBitFunctions::get_word_size(size), 0);
+                    this->raw_->extract_words(0, size, words.data(), 0);
+                    RunLengthBitContainer::append_runs_of_words(words.data(), 0, size, runs);
+                }
+                else
+                {
+                    for (uint64_t j = 0; j < this->run_ends_.size(); j++)
+                    {
+                        runs.push_back(Run(this->run_ends_[j] - this->run_start(j), this->run_bit(j)));
+                    }
+                }
+                return runs;
+            }
+
+            /**
+             * @brief Replace the bits with the given runs, choosing the mode by use_run_length_mode
+             * @details The mode depends only on the runs, so that balance_weight_of_concatenation can predict the weight of a merged leaf.
+             */
+            void set_runs(const std::vector<Run> &runs)
+            {
+                uint64_t size = 0;
+                for (const Run &run : runs)
+                {
+                    size += run.first;
+                }
+                bool use_run_length = RunLengthBitContainer::use_run_length_mode(runs.size(), size);
+
+                this->clear();
+                if (use_run_length)
+                {
+                    this->run_ends_.reserve(runs.size());
+                    this->run_ranks_.reserve(runs.size());
+                    for (const Run &run : runs)
+                    {
+                        this->push_back_run(run.first, run.second);
+                    }
+                }
+                else
+                {
+                    std::vector<uint64_t> words;
+                    words.resize(PackedBitFunctions::get_word_size(size), 0);
+                    uint64_t p = 0;
+                    for (const Run &run : runs)
+                    {
+                        uint64_t value = run.second ? UINT64_MAX : 0;
+                        for (uint64_t k = 0; k < run.first; k += 64)
+                        {
+                            PackedBitFunctions::write_bits(words.data(), p + k, value, std::min<uint64_t>(64, run.first - k));
+                        }
+                        p += run.first;
+                    }
+                    this->raw_ = std::make_unique<RawContainer>();
+                    this->raw_->push_back_words(words.data(), 0, size);
+                }
+            }
+
+            /**
+             * @brief Return true if \p run_count runs are smaller than raw bits of length \p size
+             */
+            static bool is_compact(uint64_t run_count, uint64_t size)
+            {
+                return run_count <= 8 || run_count * RUN_WEIGHT <= size;
+            }
+
+            /**
+             * @brief Return true if \p run_count runs of total length \p size are stored in the run-length mode, i.e., they are compact or too long for the raw mode
+             */
+            static bool use_run_length_mode(uint64_t run_count, uint64_t size)
+            {
+                return RunLengthBitContainer::is_compact(run_count, size) || size > MAX_BIT_SIZE;
+            }
+
+            /**
+             * @brief Return the weight of \p run_count runs of total length \p size in the mode chosen by use_run_length_mode
+             */
+            static uint64_t weight_of(uint64_t run_count, uint64_t size)
+            {
+                return RunLengthBitContainer::use_run_length_mode(run_count, size) ? (run_count * RUN_WEIGHT) + (size >> BIT_WEIGHT_SHIFT) : size;
+            }
+
+            /**
+             * @brief Return the weight of the runs intersecting the range [begin..end-1] in the run-length mode
+             */
+            uint64_t weight_of_range(uint64_t begin, uint64_t end) const
+            {
+                uint64_t run_count = begin < end ? this->find_run(end - 1) - this->find_run(begin) + 1 : 0;
+                return (run_count * RUN_WEIGHT) + ((end - begin) >> BIT_WEIGHT_SHIFT);
+            }
+
+            void update_mode_after_update()
+            {
+                if (this->raw_ == nullptr && !RunLengthBitContainer::use_run_length_mode(this->run_ends_.size(), this->size()))
+                {
+                    this->set_runs(this->get_runs());
+                }
+            }
+        };
+    }
+}
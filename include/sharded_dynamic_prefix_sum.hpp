@@ -0,0 +1,673 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include "./dynamic_prefix_sum.hpp"
+
+namespace stool
+{
+    namespace bptree
+    {
+
+        /**
+         * @brief A dynamic prefix-sum data structure on a sequence S[0..n-1] that is partitioned into K shards for parallel writers.
+         * @details S is the concatenation of K DynamicPrefixSum instances (shards) S_0 S_1 ... S_{K-1}.
+         *          Each shard is stored with its mutex and its total in its own cache line, and the sizes of the shards are stored in a small Fenwick tree of K atomic counters.
+         *          @li increment, decrement, and set_value lock only the shard containing the position and write only the cache line of the shard, so threads updating disjoint regions run in parallel without sharing a written cache line.
+         *          @li insert, remove, and push_back change the shard sizes and lock all the shards in order.
+         *          @li When a shard becomes much larger than the average after an insertion, or much smaller than the average after a removal, the values are redistributed evenly over the shards.
+         *
+         *          A query running concurrently with writers observes each shard atomically, but not the whole sequence.
+         * @note The total of a shard is updated while the shard is locked, so a query that locks a shard sees the shard and its total in the same state.
+         *       Since the totals are not kept in a Fenwick tree, psum and search read the K totals in O(K) time; this is the price for not writing a shared counter on every increment.
+         * \ingroup PrefixSumClasses
+         */
+        template <typename LEAF_CONTAINER = VLCDeque, uint64_t TREE_DEGREE = bptree::DEFAULT_MAX_DEGREE_OF_INTERNAL_NODE, uint64_t LEAF_CONTAINER_MAX_SIZE = bptree::DEFAULT_MAX_COUNT_OF_VALUES_IN_LEAF>
+        class ShardedDynamicPrefixSum
+        {
+        public:
+            using Shard = DynamicPrefixSum<LEAF_CONTAINER, TREE_DEGREE, LEAF_CONTAINER_MAX_SIZE>;
+            static inline constexpr uint64_t DEFAULT_SHARD_COUNT = 64;
+            static inline constexpr uint64_t MIN_SIZE_FOR_REBALANCING = 4096;
+            static inline constexpr uint64_t CACHE_LINE_SIZE = 64;
+
+        private:
+            /**
+             * @brief A Fenwick tree of K atomic counters.
+             */
+            class AtomicFenwickTree
+            {
+                std::vector<std::atomic<uint64_t>> tree;
+
+            public:
+                void initialize(uint64_t k)
+                {
+                    std::vector<std::atomic<uint64_t>> tmp(k + 1);
+                    this->tree.swap(tmp);
+                    for (auto &it : this->tree)
+                    {
+                        it.store(0, std::memory_order_relaxed);
+                    }
+                }
+                void initialize(const std::vector<uint64_t> &values)
+                {
+                    this->initialize(values.size());
+                    for (uint64_t i = 0; i < values.size(); i++)
+                    {
+                        this->add(i, values[i]);
+                    }
+                }
+
+                /**
+                 * @brief Add \p delta to the i-th counter.
+                 */
+                void add(uint64_t i, int64_t delta)
+                {
+                    for (uint64_t x = i + 1; x < this->tree.size(); x += x & (~x + 1))
+                    {
+                        this->tree[x].fetch_add((uint64_t)delta, std::memory_order_relaxed);
+                    }
+                }
+
+                /**
+                 * @brief Return the sum of the first i counters.
+                 */
+                uint64_t prefix(uint64_t i) const
+                {
+                    uint64_t sum = 0;
+                    for (uint64_t x = i; x > 0; x -= x & (~x + 1))
+                    {
+                        sum += this->tree[x].load(std::memory_order_relaxed);
+                    }
+                    return sum;
+                }
+
+                /**
+                 * @brief Return the smallest k such that the sum of the first (k+1) counters is at least \p x (x > 0), or K if it does not exist. \p rest receives x minus the sum of the first k counters.
+                 */
+                uint64_t search(uint64_t x, uint64_t &rest) const
+                {
+                    uint64_t k = this->tree.size() - 1;
+                    uint64_t pos = 0;
+                    uint64_t step = 1;
+                    while (step * 2 <= k)
+                    {
+                        step *= 2;
+                    }
+                    for (; step > 0; step /= 2)
+                    {
+                        if (pos + step <= k)
+                        {
+                            uint64_t v = this->tree[pos + step].load(std::memory_order_relaxed);
+                            if (v < x)
+                            {
+                                pos += step;
+                                x -= v;
+                            }
+                        }
+                    }
+                    rest = x;
+                    return pos;
+                }
+            };
+
+            /**
+             * @brief A shard, its mutex, and its total, which are aligned to a cache line so that writers of different shards do not share a cache line.
+             */
+            struct alignas(CACHE_LINE_SIZE) ShardState
+            {
+                Shard shard;
+                mutable std::mutex mutex;
+                std::atomic<uint64_t> sum{0};
+            };
+
+            /**
+             * @brief Lock all the shards in the order of their indexes, which excludes every other operation.
+             */
+            class AllShardsLock
+            {
+                const ShardedDynamicPrefixSum &seq;
+
+            public:
+                AllShardsLock(const ShardedDynamicPrefixSum &_seq) : seq(_seq)
+                {
+                    for (uint64_t k = 0; k < this->seq.shard_count_K; k++)
+                    {
+                        this->seq.shards[k].mutex.lock();
+                    }
+                }
+                ~AllShardsLock()
+                {
+                    for (uint64_t k = this->seq.shard_count_K; k > 0; k--)
+                    {
+                        this->seq.shards[k - 1].mutex.unlock();
+                    }
+                }
+                AllShardsLock(const AllShardsLock &) = delete;
+                AllShardsLock &operator=(const AllShardsLock &) = delete;
+            };
+
+            std::unique_ptr<ShardState[]> shards;
+            uint64_t shard_count_K = 0;
+            AtomicFenwickTree shard_sizes;
+            std::atomic<uint64_t> size_;
+
+        public:
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Constructors and Destructor
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Default constructor with |S| = 0 and a given number of shards \p shard_count_K
+             */
+            ShardedDynamicPrefixSum(uint64_t shard_count_K = DEFAULT_SHARD_COUNT)
+            {
+                this->initialize(shard_count_K);
+            }
+
+            /**
+             * @brief Constructor with S = S_, which is evenly distributed over \p shard_count_K shards
+             */
+            ShardedDynamicPrefixSum(const std::vector<uint64_t> &S_, uint64_t shard_count_K = DEFAULT_SHARD_COUNT)
+            {
+                this->initialize(shard_count_K);
+                this->build_shards(S_);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Operators
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Deleted copy assignment operator.
+             */
+            ShardedDynamicPrefixSum &operator=(const ShardedDynamicPrefixSum &) = delete;
+
+            /**
+             * @brief The alias for at query
+             */
+            uint64_t operator[](uint64_t i) const
+            {
+                return this->at(i);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Lightweight functions for accessing to properties of this class
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return the number of shards K
+             */
+            uint64_t shard_count() const
+            {
+                return this->shard_count_K;
+            }
+
+            /**
+             * @brief Return |S|
+             */
+            uint64_t size() const
+            {
+                return this->size_.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Return the number of values in the k-th shard
+             */
+            uint64_t shard_size(uint64_t k) const
+            {
+                std::lock_guard<std::mutex> shard_lock(this->shards[k].mutex);
+                return this->shards[k].shard.size();
+            }
+
+            /**
+             * @brief Returns the total memory usage in bytes
+             * @param only_dynamic_memory If true, only the size of the dynamic memory is returned
+             */
+            uint64_t size_in_bytes(bool only_dynamic_memory = false) const
+            {
+                AllShardsLock lock(*this);
+                uint64_t sum = 0;
+                for (uint64_t k = 0; k < this->shard_count_K; k++)
+                {
+                    sum += this->shards[k].shard.size_in_bytes(true);
+                }
+                sum += this->shard_count_K * sizeof(ShardState);
+                sum += (this->shard_count_K + 1) * sizeof(std::atomic<uint64_t>);
+                if (!only_dynamic_memory)
+                {
+                    sum += sizeof(ShardedDynamicPrefixSum);
+                }
+                return sum;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Conversion functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+            /**
+             * @brief Return \p S as a vector.
+             */
+            std::vector<uint64_t> to_vector() const
+            {
+                AllShardsLock lock(*this);
+                return this->to_vector_without_lock();
+            }
+
+            /**
+             * @brief Return \p S as a string.
+             */
+            std::string to_string() const
+            {
+                std::stringstream ss;
+                auto vec = this->to_vector();
+                ss << stool::ConverterToString::to_integer_string(vec);
+                return ss.str();
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Main queries (Access, search, and psum operations)
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Return \p S[i]
+             * @note O(log K + log n) time
+             */
+            uint64_t at(uint64_t i) const
+            {
+                uint64_t local_i = 0;
+                std::unique_lock<std::mutex> shard_lock;
+                uint64_t k = this->lock_shard_of(i, local_i, shard_lock);
+                return this->shards[k].shard.at(local_i);
+            }
+
+            /**
+             * @brief Return the sum of \p S[0..n-1].
+             * @note O(K) time
+             */
+            uint64_t psum() const
+            {
+                return this->sum_of_shards(this->shard_count_K);
+            }
+
+            /**
+             * @brief Return the sum of \p S[0..i].
+             * @note O(K + log n) time
+             */
+            uint64_t psum(uint64_t i) const
+            {
+                uint64_t local_i = 0;
+                std::unique_lock<std::mutex> shard_lock;
+                uint64_t k = this->lock_shard_of(i, local_i, shard_lock);
+                return this->sum_of_shards(k) + this->shards[k].shard.psum(local_i);
+            }
+
+            /**
+             * @brief Return the smallest i such that psum(i) >= x if such a position exists, otherwise returns -1
+             * @details The shards are scanned by their totals, and the shard found by the scan is searched while it is locked.
+             *          If the total of the shard has decreased since it was read, the rest of \p x is carried over to the next shard.
+             * @note O(K + log n) time
+             */
+            int64_t search(uint64_t x) const
+            {
+                if (x == 0)
+                {
+                    return this->size() == 0 ? -1 : 0;
+                }
+                uint64_t rest = x;
+                for (uint64_t k = 0; k < this->shard_count_K; k++)
+                {
+                    uint64_t unlocked_sum = this->shards[k].sum.load(std::memory_order_acquire);
+                    if (unlocked_sum < rest)
+                    {
+                        rest -= unlocked_sum;
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> shard_lock(this->shards[k].mutex);
+                    const Shard &shard = this->shards[k].shard;
+                    uint64_t shard_sum = shard.psum();
+                    if (shard_sum < rest)
+                    {
+                        rest -= shard_sum;
+                        continue;
+                    }
+                    int64_t local_i = shard.search(rest);
+                    assert(local_i != -1);
+                    return (int64_t)(this->shard_sizes.prefix(k) + local_i);
+                }
+                return -1;
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Update operations
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Set the value \p S[i+delta] at a given position \p i in \p S. Only the shard containing \p S[i] is locked.
+             * @note O(log K + log n) time
+             */
+            void increment(uint64_t i, int64_t delta)
+            {
+                uint64_t local_i = 0;
+                std::unique_lock<std::mutex> shard_lock;
+                uint64_t k = this->lock_shard_of(i, local_i, shard_lock);
+                this->shards[k].shard.increment(local_i, delta);
+                this->shards[k].sum.fetch_add((uint64_t)delta, std::memory_order_release);
+            }
+
+            /**
+             * @brief Set the value \p S[i-delta] at a given position \p i in \p S. Only the shard containing \p S[i] is locked.
+             * @note O(log K + log n) time
+             */
+            void decrement(uint64_t i, int64_t delta)
+            {
+                this->increment(i, -delta);
+            }
+
+            /**
+             * @brief Set a given value \p value at a given position \p i in \p S. Only the shard containing \p S[i] is locked.
+             * @note O(log K + log n) time
+             */
+            void set_value(uint64_t i, uint64_t value)
+            {
+                uint64_t local_i = 0;
+                std::unique_lock<std::mutex> shard_lock;
+                uint64_t k = this->lock_shard_of(i, local_i, shard_lock);
+                uint64_t old_value = this->shards[k].shard.at(local_i);
+                int64_t delta = (int64_t)value - (int64_t)old_value;
+                this->shards[k].shard.increment(local_i, delta);
+                this->shards[k].sum.fetch_add((uint64_t)delta, std::memory_order_release);
+            }
+
+            /**
+             * @brief Insert a given value \p value at a given position \p pos in \p S
+             * @note Amortized O(K + log n) time. This operation locks the whole sequence.
+             */
+            void insert(uint64_t pos, uint64_t value)
+            {
+                AllShardsLock lock(*this);
+                this->insert_without_lock(pos, value);
+            }
+
+            /**
+             * @brief Add a given value \p value to the end of \p S
+             * @note Amortized O(K + log n) time. This operation locks the whole sequence.
+             */
+            void push_back(uint64_t value)
+            {
+                AllShardsLock lock(*this);
+                this->insert_without_lock(this->size(), value);
+            }
+
+            /**
+             * @brief Remove \p S[pos] from \p S
+             * @note Amortized O(K + log n) time. This operation locks the whole sequence.
+             */
+            void remove(uint64_t pos)
+            {
+                AllShardsLock lock(*this);
+                if (pos >= this->size())
+                {
+                    throw std::invalid_argument("Error: ShardedDynamicPrefixSum::remove(pos). The pos must be less than the size of the sequence.");
+                }
+                uint64_t local_pos = 0;
+                uint64_t k = this->locate(pos, local_pos);
+                uint64_t value = this->shards[k].shard.at(local_pos);
+                this->shards[k].shard.remove(local_pos);
+                this->shard_sizes.add(k, -1);
+                this->shards[k].sum.fetch_sub(value, std::memory_order_release);
+                this->size_.fetch_sub(1, std::memory_order_relaxed);
+
+                if (this->is_underflowing(k))
+                {
+                    this->rebalance_without_lock();
+                }
+            }
+
+            /**
+             * @brief Redistribute the values of \p S evenly over the K shards.
+             * @note O(n) time. This operation locks the whole sequence.
+             */
+            void rebalance()
+            {
+                AllShardsLock lock(*this);
+                this->rebalance_without_lock();
+            }
+
+            /**
+             * @brief Clear the elements in \p S.
+             */
+            void clear()
+            {
+                AllShardsLock lock(*this);
+                for (uint64_t k = 0; k < this->shard_count_K; k++)
+                {
+                    this->shards[k].shard.clear();
+                    this->shards[k].sum.store(0, std::memory_order_release);
+                }
+                this->shard_sizes.initialize(this->shard_count_K);
+                this->size_.store(0, std::memory_order_relaxed);
+            }
+            //@}
+
+            ////////////////////////////////////////////////////////////////////////////////
+            ///   @name Print and verification functions
+            ////////////////////////////////////////////////////////////////////////////////
+            //@{
+
+            /**
+             * @brief Verify the internal consistency of this data structure.
+             */
+            void verify() const
+            {
+                AllShardsLock lock(*this);
+                uint64_t total_size = 0;
+                for (uint64_t k = 0; k < this->shard_count_K; k++)
+                {
+                    this->shards[k].shard.verify();
+                    uint64_t shard_size = this->shard_sizes.prefix(k + 1) - this->shard_sizes.prefix(k);
+                    uint64_t shard_sum = this->shards[k].sum.load(std::memory_order_acquire);
+                    if (shard_size != this->shards[k].shard.size() || shard_sum != this->shards[k].shard.psum())
+                    {
+                        throw std::runtime_error("Error: ShardedDynamicPrefixSum::verify(). The top-level counters are inconsistent with the shards.");
+                    }
+                    total_size += shard_size;
+                }
+                if (total_size != this->size())
+                {
+                    throw std::runtime_error("Error: ShardedDynamicPrefixSum::verify(). The size is inconsistent.");
+                }
+            }
+
+            /**
+             * @brief Print the statistics of this data structure
+             */
+            void print_statistics(int message_paragraph = stool::Message::SHOW_MESSAGE) const
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "Statistics(ShardedDynamicPrefixSum):" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " The number of shards: " << this->shard_count() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " The length of the sequence: " << this->size() << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << " Total memory usage: " << this->size_in_bytes() << " bytes" << std::endl;
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "[END]" << std::endl;
+            }
+            //@}
+
+            /**
+             * @brief Return the name of this class.
+             */
+            static std::string name()
+            {
+                std::string s;
+                s += "ShardedDynamicPrefixSum(" + Shard::name() + ")";
+                return s;
+            }
+
+        private:
+            void initialize(uint64_t shard_count_K)
+            {
+                if (shard_count_K == 0)
+                {
+                    throw std::invalid_argument("Error: ShardedDynamicPrefixSum. The number of shards must be positive.");
+                }
+                this->shards = std::make_unique<ShardState[]>(shard_count_K);
+                this->shard_count_K = shard_count_K;
+                this->shard_sizes.initialize(shard_count_K);
+                this->size_.store(0, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Return the shard k containing \p S[i], and store the position of \p S[i] in the shard to \p local_i.
+             */
+            uint64_t locate(uint64_t i, uint64_t &local_i) const
+            {
+                if (i >= this->size())
+                {
+                    throw std::invalid_argument("Error: ShardedDynamicPrefixSum. The position must be less than the size of the sequence.");
+                }
+                uint64_t rest = 0;
+                uint64_t k = this->shard_sizes.search(i + 1, rest);
+                assert(k < this->shard_count_K);
+                local_i = rest - 1;
+                return k;
+            }
+
+            /**
+             * @brief Lock the shard k containing \p S[i] by \p shard_lock, and store the position of \p S[i] in the shard to \p local_i.
+             * @details The shard sizes change only while all the shards are locked, so they are stable once one shard is locked.
+             *          The shard is first guessed without a lock, and the guess is retried if an insertion or a removal has moved \p S[i] in the meantime.
+             */
+            uint64_t lock_shard_of(uint64_t i, uint64_t &local_i, std::unique_lock<std::mutex> &shard_lock) const
+            {
+                while (true)
+                {
+                    uint64_t rest = 0;
+                    uint64_t guess = std::min(this->shard_sizes.search(i + 1, rest), this->shard_count_K - 1);
+                    shard_lock = std::unique_lock<std::mutex>(this->shards[guess].mutex);
+                    uint64_t k = this->locate(i, local_i);
+                    if (k == guess)
+                    {
+                        return k;
+                    }
+                    shard_lock.unlock();
+                }
+            }
+
+            /**
+             * @brief Return the sum of the totals of the first \p k shards.
+             */
+            uint64_t sum_of_shards(uint64_t k) const
+            {
+                uint64_t sum = 0;
+                for (uint64_t x = 0; x < k; x++)
+                {
+                    sum += this->shards[x].sum.load(std::memory_order_acquire);
+                }
+                return sum;
+            }
+
+            void insert_without_lock(uint64_t pos, uint64_t value)
+            {
+                uint64_t n = this->size();
+                if (pos > n)
+                {
+                    throw std::invalid_argument("Error: ShardedDynamicPrefixSum::insert(pos, value). The pos must be at most the size of the sequence.");
+                }
+                uint64_t local_pos = 0;
+                uint64_t k = 0;
+                if (pos == n)
+                {
+                    k = this->shard_count_K - 1;
+                    local_pos = this->shards[k].shard.size();
+                }
+                else
+                {
+                    k = this->locate(pos, local_pos);
+                }
+                this->shards[k].shard.insert(local_pos, value);
+                this->shard_sizes.add(k, 1);
+                this->shards[k].sum.fetch_add(value, std::memory_order_release);
+                this->size_.fetch_add(1, std::memory_order_relaxed);
+
+                if (this->is_skewed(k))
+                {
+                    this->rebalance_without_lock();
+                }
+            }
+
+            bool is_skewed(uint64_t k) const
+            {
+                uint64_t n = this->size();
+                if (n < MIN_SIZE_FOR_REBALANCING)
+                {
+                    return false;
+                }
+                uint64_t average = (n + this->shard_count_K - 1) / this->shard_count_K;
+                return this->shards[k].shard.size() > 2 * average + LEAF_CONTAINER_MAX_SIZE;
+            }
+
+            /**
+             * @brief Return true if the k-th shard has less than a quarter of the average number of values.
+             * @details After a redistribution every shard has at least n/K values, so at least 3n/(4K) removals
+             *          hit a shard before it underflows, and the O(n) redistribution is amortized to O(K) per removal.
+             */
+            bool is_underflowing(uint64_t k) const
+            {
+                uint64_t n = this->size();
+                if (n < MIN_SIZE_FOR_REBALANCING)
+                {
+                    return false;
+                }
+                uint64_t average = n / this->shard_count_K;
+                return this->shards[k].shard.size() * 4 < average;
+            }
+
+            std::vector<uint64_t> to_vector_without_lock() const
+            {
+                std::vector<uint64_t> r;
+                r.reserve(this->size());
+                for (uint64_t k = 0; k < this->shard_count_K; k++)
+                {
+                    for (uint64_t v : this->shards[k].shard)
+                    {
+                        r.push_back(v);
+                    }
+                }
+                return r;
+            }
+
+            void build_shards(const std::vector<uint64_t> &items)
+            {
+                std::vector<uint64_t> sizes;
+                uint64_t begin = 0;
+                for (uint64_t k = 0; k < this->shard_count_K; k++)
+                {
+                    uint64_t end = (items.size() * (k + 1)) / this->shard_count_K;
+                    std::vector<uint64_t> part(items.begin() + begin, items.begin() + end);
+                    Shard shard = Shard::build(part);
+                    this->shards[k].shard.swap(shard);
+                    this->shards[k].sum.store(this->shards[k].shard.psum(), std::memory_order_release);
+                    sizes.push_back(this->shards[k].shard.size());
+                    begin = end;
+                }
+                this->shard_sizes.initialize(sizes);
+                this->size_.store(items.size(), std::memory_order_relaxed);
+            }
+
+            void rebalance_without_lock()
+            {
+                std::vector<uint64_t> items = this->to_vector_without_lock();
+                this->build_shards(items);
+            }
+        };
+
+    }
+}
@@ -16,8 +16,12 @@ void test(DBV &dbv, uint64_t seed, uint64_t insert_num, [[maybe_unused]]int tria
         std::cout << stool::Message::get_paragraph_string(message_paragraph) << "Testing..." << std::endl;
     }
 
-    if constexpr (std::is_same<DBV, stool::bptree::SimpleDynamicBitSequence>::value || std::is_same<DBV, stool::bptree::DynamicBitDequeSequence>::value) {
+    if constexpr (std::is_same<DBV, stool::bptree::SimpleDynamicBitSequence>::value || std::is_same<DBV, stool::bptree::DynamicBitDequeSequence>::value || std::is_same<DBV, stool::bptree::DynamicRunLengthBitSequence>::value || std::is_same<DBV, stool::bptree::DynamicGapBitSequence>::value) {
         stool::BitSequenceTest::build_test(dbv, insert_num, seed++, message_paragraph+1);
+        stool::BitSequenceTest::batched_rank_select_test(dbv, 1000, seed++, message_paragraph+1);
+        stool::BitSequenceTest::range_count_and_next_prev_test(dbv, insert_num * 5, 1000, seed++, message_paragraph+1);
+        stool::BitSequenceTest::bitwise_combine_test<DBV>(insert_num * 5, seed++, message_paragraph+1);
+        stool::BitSequenceTest::freeze_test(dbv, insert_num * 5, 1000, seed++, message_paragraph+1);
         stool::BitSequenceTest::test_iterator(dbv, message_paragraph+1);    
 
         stool::BitSequenceTest::load_write_test(dbv, message_paragraph+1);
@@ -42,6 +46,15 @@ void test(DBV &dbv, uint64_t seed, uint64_t insert_num, [[maybe_unused]]int tria
     dbv.clear();
     stool::BitSequenceTest::insert_and_delete_test2(dbv, insert_num, seed++, message_paragraph+1);
 
+    if constexpr (std::is_same<DBV, stool::bptree::SimpleDynamicBitSequence>::value || std::is_same<DBV, stool::bptree::DynamicBitDequeSequence>::value || std::is_same<DBV, stool::bptree::DynamicRunLengthBitSequence>::value || std::is_same<DBV, stool::bptree::DynamicGapBitSequence>::value) {
+        stool::BitSequenceTest::select0_after_update_test(dbv, insert_num * 5, 300, seed++, message_paragraph+1);
+        dbv.clear();
+        stool::BitSequenceTest::word_io_test(dbv, 30, seed++, message_paragraph+1);
+        dbv.clear();
+        stool::BitSequenceTest::run_length_test(dbv, insert_num * 5, 3000, seed++, message_paragraph+1);
+        dbv.clear();
+    }
+
 
 
 }
@@ -82,6 +95,7 @@ void _test(uint64_t mode, uint64_t seed, int message_paragraph = stool::Message:
         stool::bptree::SimpleDynamicBitSequence bit_seq;
 
         test(bit_seq, seed, 10000, 10, message_paragraph+1);
+        stool::BitSequenceTest::packed_leaf_test(bit_seq, 30000, 3000, seed, message_paragraph+1);
 
         if(message_paragraph != stool::Message::NO_MESSAGE){
             std::cout << "OK!" << std::endl;
@@ -101,6 +115,40 @@ void _test(uint64_t mode, uint64_t seed, int message_paragraph = stool::Message:
         }
 
     }
+    else if (mode == 5){
+        if(message_paragraph != stool::Message::NO_MESSAGE){
+            std::cout << stool::Message::get_paragraph_string(message_paragraph) << "TEST: PackedBitFunctions" << std::endl; 
+        }
+        stool::BitSequenceTest::packed_bit_functions_test(300, seed, message_paragraph+1);
+    }
+    else if (mode == 6){
+        if(message_paragraph != stool::Message::NO_MESSAGE){
+            std::cout << stool::Message::get_paragraph_string(message_paragraph) << "TEST: DynamicRunLengthBitSequence" << std::endl; 
+        }
+
+        stool::bptree::DynamicRunLengthBitSequence bit_seq;
+
+        test(bit_seq, seed, 10000, 10, message_paragraph+1);
+        stool::BitSequenceTest::run_length_memory_test(bit_seq, 1000000, 3000, seed, message_paragraph+1);
+
+        if(message_paragraph != stool::Message::NO_MESSAGE){
+            std::cout << "OK!" << std::endl;
+        }
+    }
+    else if (mode == 7){
+        if(message_paragraph != stool::Message::NO_MESSAGE){
+            std::cout << stool::Message::get_paragraph_string(message_paragraph) << "TEST: DynamicGapBitSequence" << std::endl; 
+        }
+
+        stool::bptree::DynamicGapBitSequence bit_seq;
+
+        test(bit_seq, seed, 10000, 10, message_paragraph+1);
+        stool::BitSequenceTest::local_edit_test(bit_seq, 20000, 30000, seed, message_paragraph+1);
+
+        if(message_paragraph != stool::Message::NO_MESSAGE){
+            std::cout << "OK!" << std::endl;
+        }
+    }
     else{
         if(message_paragraph != stool::Message::NO_MESSAGE){
             std::cout << stool::Message::get_paragraph_string(message_paragraph) << "TEST ALL" << std::endl;
@@ -109,6 +157,9 @@ void _test(uint64_t mode, uint64_t seed, int message_paragraph = stool::Message:
         _test(2, seed, message_paragraph+1);
         _test(3, seed, message_paragraph+1);
         _test(4, seed, message_paragraph+1);
+        _test(5, seed, message_paragraph+1);
+        _test(6, seed, message_paragraph+1);
+        _test(7, seed, message_paragraph+1);
     }
 }
 
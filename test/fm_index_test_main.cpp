@@ -0,0 +1,169 @@
+#include <iostream>
+#include <string>
+#include <memory>
+#include <bitset>
+#include <cassert>
+#include <chrono>
+#include "../include/all.hpp"
+
+std::vector<uint8_t> create_random_document(uint64_t len, const std::vector<uint8_t> &alphabet, std::mt19937_64 &mt64)
+{
+    std::vector<uint8_t> r;
+    for (uint64_t i = 0; i < len; i++)
+    {
+        r.push_back(alphabet[mt64() % alphabet.size()]);
+    }
+    return r;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> naive_locate(const std::vector<std::vector<uint8_t>> &documents, const std::vector<bool> &removed, const std::vector<uint8_t> &pattern)
+{
+    std::vector<std::pair<uint64_t, uint64_t>> r;
+    for (uint64_t d = 0; d < documents.size(); d++)
+    {
+        if (removed[d] || documents[d].size() < pattern.size())
+        {
+            continue;
+        }
+        for (uint64_t i = 0; i + pattern.size() <= documents[d].size(); i++)
+        {
+            if (std::equal(pattern.begin(), pattern.end(), documents[d].begin() + i))
+            {
+                r.push_back(std::pair<uint64_t, uint64_t>(d, i));
+            }
+        }
+    }
+    return r;
+}
+
+void query_test(const stool::bptree::DynamicFMIndex &fmi, const std::vector<std::vector<uint8_t>> &documents, const std::vector<bool> &removed, const std::vector<uint8_t> &alphabet, uint64_t number_of_queries, std::mt19937_64 &mt64)
+{
+    fmi.verify();
+    for (uint64_t d = 0; d < documents.size(); d++)
+    {
+        if (fmi.has_document(d) == removed[d])
+        {
+            throw std::logic_error("Error: query_test (has_document)");
+        }
+        if (!removed[d] && fmi.get_document(d) != documents[d])
+        {
+            throw std::logic_error("Error: query_test (get_document)");
+        }
+    }
+
+    for (uint64_t q = 0; q < number_of_queries; q++)
+    {
+        std::vector<uint8_t> pattern;
+        uint64_t d = mt64() % documents.size();
+        uint64_t len = 1 + (mt64() % 6);
+        if (!removed[d] && documents[d].size() >= len && mt64() % 2 == 0)
+        {
+            uint64_t i = mt64() % (documents[d].size() - len + 1);
+            pattern.assign(documents[d].begin() + i, documents[d].begin() + i + len);
+        }
+        else
+        {
+            std::vector<uint8_t> pattern_alphabet = alphabet;
+            pattern_alphabet.push_back(255);
+            pattern = create_random_document(len, pattern_alphabet, mt64);
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t>> correct_occurrences = naive_locate(documents, removed, pattern);
+        if (fmi.count(pattern) != correct_occurrences.size())
+        {
+            throw std::logic_error("Error: query_test (count)");
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> occurrences = fmi.locate(pattern);
+        std::sort(occurrences.begin(), occurrences.end());
+        if (occurrences != correct_occurrences)
+        {
+            throw std::logic_error("Error: query_test (locate)");
+        }
+    }
+}
+
+void fm_index_test(const std::vector<uint8_t> &alphabet, uint64_t sampling_interval, uint64_t number_of_documents, uint64_t max_document_length, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    stool::bptree::DynamicFMIndex fmi(alphabet, sampling_interval);
+    std::vector<std::vector<uint8_t>> documents;
+    std::vector<bool> removed;
+
+    for (uint64_t i = 0; i < number_of_documents; i++)
+    {
+        documents.push_back(create_random_document(mt64() % (max_document_length + 1), alphabet, mt64));
+        removed.push_back(false);
+        uint64_t document_id = fmi.insert_document(documents.back());
+        if (document_id != documents.size() - 1)
+        {
+            throw std::logic_error("Error: fm_index_test (insert_document)");
+        }
+        if (i % 4 == 3)
+        {
+            uint64_t d = mt64() % documents.size();
+            if (!removed[d])
+            {
+                fmi.remove_document(d);
+                removed[d] = true;
+            }
+        }
+        if (i % 8 == 7)
+        {
+            query_test(fmi, documents, removed, alphabet, 20, mt64);
+        }
+    }
+    query_test(fmi, documents, removed, alphabet, 100, mt64);
+
+    for (uint64_t d = 0; d < documents.size(); d++)
+    {
+        if (!removed[d])
+        {
+            fmi.remove_document(d);
+            removed[d] = true;
+        }
+    }
+    if (fmi.size() != 0 || fmi.document_count() != 0)
+    {
+        throw std::logic_error("Error: fm_index_test (remove_document)");
+    }
+    fmi.verify();
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef DEBUG
+    std::cout << "\033[41m";
+    std::cout << "DEBUG MODE!" << std::endl;
+    std::cout << "\e[m" << std::endl;
+    // std::cout << "\033[30m" << std::endl;
+#endif
+#ifdef SLOWDEBUG
+    std::cout << "\033[41m";
+    std::cout << "SLOWDEBUG MODE!" << std::endl;
+    std::cout << "\e[m" << std::endl;
+    // std::cout << "\033[30m" << std::endl;
+#endif
+
+    cmdline::parser p;
+
+    p.add<uint>("mode", 'm', "mode", false, 1);
+    p.add<uint64_t>("seed", 's', "seed", false, 0);
+
+    p.parse_check(argc, argv);
+    uint64_t mode = p.get<uint>("mode");
+    uint64_t seed = p.get<uint64_t>("seed");
+
+    if (mode == 1)
+    {
+        std::vector<std::vector<uint8_t>> alphabets = {{'a', 'b'}, {'A', 'C', 'G', 'T'}, {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'}};
+        for (const std::vector<uint8_t> &alphabet : alphabets)
+        {
+            for (uint64_t sampling_interval : {1, 4, 32})
+            {
+                std::cout << "FM-index test: alphabet size = " << alphabet.size() << ", sampling interval = " << sampling_interval << std::endl;
+                fm_index_test(alphabet, sampling_interval, 30, 100, seed++);
+            }
+        }
+    }
+    std::cout << "Finished." << std::endl;
+}
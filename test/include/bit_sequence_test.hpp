@@ -5,6 +5,7 @@
 #include <bitset>
 #include <cassert>
 #include <chrono>
+#include <algorithm>
 #include <cstdio>
 #include "../../include/all.hpp"
 #include <random>
@@ -36,6 +37,74 @@ namespace stool
             return r;
         }
 
+        template <typename BIT_SEQUENCE>
+        static std::vector<uint64_t> to_bit_values(const BIT_SEQUENCE &spsi_container)
+        {
+            std::vector<uint64_t> r;
+            for (uint64_t i = 0; i < spsi_container.size(); i++)
+            {
+                r.push_back(spsi_container.at(i) ? 1 : 0);
+            }
+            return r;
+        }
+
+        static void packed_bit_functions_test(int64_t number_of_trials, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            using PBF = stool::bptree::PackedBitFunctions;
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "packed_bit_functions_test (BMI2: " << PBF::cpu_supports_bmi2() << ", AVX-512 VPOPCNTQ: " << PBF::cpu_supports_avx512_popcount() << "): " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            for (int64_t t = 0; t < number_of_trials; t++)
+            {
+                uint64_t bit_size = mt64() % 3000;
+                std::vector<uint64_t> words;
+                for (uint64_t i = 0; i < PBF::get_word_size(bit_size); i++)
+                {
+                    uint64_t density = mt64() % 4;
+                    words.push_back(density == 0 ? 0 : (density == 1 ? UINT64_MAX : mt64()));
+                }
+
+                std::vector<uint64_t> one_positions, zero_positions;
+                for (uint64_t i = 0; i < bit_size; i++)
+                {
+                    if (PBF::get_bit(words.data(), i))
+                    {
+                        one_positions.push_back(i);
+                    }
+                    else
+                    {
+                        zero_positions.push_back(i);
+                    }
+                    if (PBF::rank1(words.data(), i) != one_positions.size() - (PBF::get_bit(words.data(), i) ? 1 : 0))
+                    {
+                        throw std::logic_error("packed_bit_functions_test: rank1 error");
+                    }
+                }
+                for (uint64_t k = 0; k <= one_positions.size(); k++)
+                {
+                    int64_t expected = k < one_positions.size() ? (int64_t)one_positions[k] : -1;
+                    if (PBF::select1(words.data(), bit_size, k) != expected)
+                    {
+                        throw std::logic_error("packed_bit_functions_test: select1 error");
+                    }
+                }
+                for (uint64_t k = 0; k <= zero_positions.size(); k++)
+                {
+                    int64_t expected = k < zero_positions.size() ? (int64_t)zero_positions[k] : -1;
+                    if (PBF::select0(words.data(), bit_size, k) != expected)
+                    {
+                        throw std::logic_error("packed_bit_functions_test: select0 error");
+                    }
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
         template <typename BIT_SEQUENCE>
         static void test_iterator(BIT_SEQUENCE &spsi_container, int message_paragraph = stool::Message::SHOW_MESSAGE)
         {
@@ -69,7 +138,7 @@ namespace stool
             {
                 std::cout << stool::Message::get_paragraph_string(message_paragraph) << "test_rank" << value << std::endl;
             }
-            std::vector<uint64_t> items = spsi_container.to_packed_vector();
+            std::vector<uint64_t> items = to_bit_values(spsi_container);
             for (uint64_t i = 0; i <= items.size(); i++)
             {
                 uint64_t rank1 = spsi_container.one_based_rank(i, value);
@@ -91,7 +160,7 @@ namespace stool
             {
                 std::cout << stool::Message::get_paragraph_string(message_paragraph) << "test_select" << bit_value << std::endl;
             }
-            std::vector<uint64_t> items = spsi_container.to_packed_vector();
+            std::vector<uint64_t> items = to_bit_values(spsi_container);
             for (uint64_t i = 0; i < items.size(); i++)
             {
                 if (items[i] == bit_value)
@@ -116,7 +185,7 @@ namespace stool
             {
                 std::cout << stool::Message::get_paragraph_string(message_paragraph) << "test_select0" << std::endl;
             }
-            std::vector<uint64_t> items = spsi_container.to_packed_vector();
+            std::vector<uint64_t> items = to_bit_values(spsi_container);
             uint64_t counter = 0;
             for (uint64_t i = 0; i < items.size(); i++)
             {
@@ -141,7 +210,7 @@ namespace stool
             {
                 std::cout << stool::Message::get_paragraph_string(message_paragraph) << "test_psum" << std::endl;
             }
-            std::vector<uint64_t> items = spsi_container.to_packed_vector();
+            std::vector<uint64_t> items = to_bit_values(spsi_container);
             uint64_t sum = 0;
             for (uint64_t i = 0; i < items.size(); i++)
             {
@@ -166,7 +235,7 @@ namespace stool
             // uint64_t psum = spsi.psum();
             uint64_t xsum = 1;
 
-            std::vector<uint64_t> items = spsi.to_packed_vector();
+            std::vector<uint64_t> items = to_bit_values(spsi);
 
             for (uint64_t i = 0; i < items.size(); i++)
             {
@@ -204,6 +273,735 @@ namespace stool
             }
         }
 
+        template <typename BIT_SEQUENCE>
+        static void batched_rank_select_test(BIT_SEQUENCE &spsi, int64_t number_of_queries, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "batched_rank_select_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            uint64_t _size = spsi.size();
+            uint64_t count1 = spsi.count1();
+
+            std::vector<uint64_t> positions;
+            positions.push_back(0);
+            positions.push_back(_size);
+            for (int64_t i = 0; i < number_of_queries; i++)
+            {
+                positions.push_back(mt64() % (_size + 1));
+            }
+            std::sort(positions.begin(), positions.end());
+            std::vector<uint64_t> ranks = spsi.rank1_many(positions);
+            for (uint64_t k = 0; k < positions.size(); k++)
+            {
+                if (ranks[k] != (uint64_t)spsi.rank1(positions[k]))
+                {
+                    throw std::logic_error("batched_rank_select_test: rank1_many error");
+                }
+            }
+
+            std::vector<uint64_t> select_ranks;
+            select_ranks.push_back(count1);
+            select_ranks.push_back(count1 + 5);
+            for (int64_t i = 0; i < number_of_queries && count1 > 0; i++)
+            {
+                select_ranks.push_back(mt64() % count1);
+            }
+            std::sort(select_ranks.begin(), select_ranks.end());
+            std::vector<int64_t> selects = spsi.select1_many(select_ranks);
+            for (uint64_t k = 0; k < select_ranks.size(); k++)
+            {
+                int64_t expected = select_ranks[k] < count1 ? spsi.select1(select_ranks[k]) : -1;
+                if (selects[k] != expected)
+                {
+                    throw std::logic_error("batched_rank_select_test: select1_many error");
+                }
+            }
+
+            uint64_t count0 = _size - count1;
+            for (bool c : {true, false})
+            {
+                typename BIT_SEQUENCE::LeafCursor cursor;
+                uint64_t count = c ? count1 : count0;
+                for (uint64_t i = 0; i < count; i += 1 + (mt64() % 8))
+                {
+                    if (spsi.select_with_cursor(i, c, cursor) != spsi.select(i, c))
+                    {
+                        throw std::logic_error("batched_rank_select_test: select_with_cursor error");
+                    }
+                }
+                if (spsi.select_with_cursor(count, c, cursor) != -1)
+                {
+                    throw std::logic_error("batched_rank_select_test: select_with_cursor error (out of range)");
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void range_count_and_next_prev_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_queries, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "range_count_and_next_prev_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            for (uint64_t density : {2, 64, 4096})
+            {
+                std::vector<bool> naive_bits;
+                spsi.clear();
+                for (int64_t i = 0; i < num; i++)
+                {
+                    bool b = density == 2 ? (mt64() % 2 == 0) : (mt64() % density == 0);
+                    if (density == 4096 && i > num / 2)
+                    {
+                        b = !b;
+                    }
+                    spsi.push_back(b);
+                    naive_bits.push_back(b);
+                }
+
+                uint64_t n = naive_bits.size();
+                std::vector<uint64_t> rank_vec(n + 1, 0);
+                std::vector<std::vector<int64_t>> next_vec(2, std::vector<int64_t>(n + 1, -1));
+                std::vector<std::vector<int64_t>> prev_vec(2, std::vector<int64_t>(n + 1, -1));
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    rank_vec[i + 1] = rank_vec[i] + (naive_bits[i] ? 1 : 0);
+                    prev_vec[0][i + 1] = naive_bits[i] ? prev_vec[0][i] : (int64_t)i;
+                    prev_vec[1][i + 1] = naive_bits[i] ? (int64_t)i : prev_vec[1][i];
+                }
+                for (int64_t i = (int64_t)n - 1; i >= 0; i--)
+                {
+                    next_vec[0][i] = naive_bits[i] ? next_vec[0][i + 1] : i;
+                    next_vec[1][i] = naive_bits[i] ? i : next_vec[1][i + 1];
+                }
+
+                for (int64_t t = 0; t < number_of_queries; t++)
+                {
+                    uint64_t i = mt64() % (n + 1);
+                    uint64_t j = i + (mt64() % (n - i + 1));
+                    if (spsi.count1(i, j) != rank_vec[j] - rank_vec[i] || spsi.count0(i, j) != (j - i) - (rank_vec[j] - rank_vec[i]))
+                    {
+                        throw std::logic_error("range_count_and_next_prev_test: count error");
+                    }
+
+                    uint64_t p = mt64() % (n + 1);
+                    if (spsi.next1(p) != next_vec[1][p] || spsi.next0(p) != next_vec[0][p] || spsi.prev1(p) != prev_vec[1][p] || spsi.prev0(p) != prev_vec[0][p])
+                    {
+                        throw std::logic_error("range_count_and_next_prev_test: next/prev error");
+                    }
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void freeze_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_queries, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "freeze_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            for (uint64_t density : {2, 64, 4096})
+            {
+                std::vector<bool> naive_bits;
+                spsi.clear();
+                for (int64_t i = 0; i < num; i++)
+                {
+                    bool b = density == 2 ? (mt64() % 2 == 0) : (mt64() % density == 0);
+                    if (density == 4096 && i > num / 2)
+                    {
+                        b = !b;
+                    }
+                    spsi.push_back(b);
+                    naive_bits.push_back(b);
+                }
+                uint64_t n = naive_bits.size();
+                std::vector<uint64_t> ones, zeros;
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    (naive_bits[i] ? ones : zeros).push_back(i);
+                }
+
+                for (uint64_t thread_count : {1, 4})
+                {
+                    stool::bptree::FrozenBitSequence frozen = spsi.freeze(thread_count);
+                    if (frozen.size() != n || frozen.count1() != (int64_t)ones.size() || frozen.to_vector() != naive_bits)
+                    {
+                        throw std::logic_error("freeze_test: size or content error");
+                    }
+                    for (int64_t t = 0; t < number_of_queries; t++)
+                    {
+                        uint64_t i = mt64() % (n + 1);
+                        if (frozen.one_based_rank1(i) != spsi.one_based_rank1(i))
+                        {
+                            throw std::logic_error("freeze_test: rank1 error");
+                        }
+                        uint64_t k1 = mt64() % (ones.size() + 1);
+                        uint64_t k0 = mt64() % (zeros.size() + 1);
+                        int64_t expected1 = k1 < ones.size() ? (int64_t)ones[k1] : -1;
+                        int64_t expected0 = k0 < zeros.size() ? (int64_t)zeros[k0] : -1;
+                        if (frozen.select1(k1) != expected1 || frozen.select0(k0) != expected0)
+                        {
+                            throw std::logic_error("freeze_test: select error");
+                        }
+                    }
+                    BIT_SEQUENCE thawed = frozen.template thaw<BIT_SEQUENCE>();
+                    if (thawed.to_vector() != naive_bits)
+                    {
+                        throw std::logic_error("freeze_test: thaw error");
+                    }
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void bitwise_combine_test(int64_t num, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "bitwise_combine_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            for (uint64_t density : {2, 64})
+            {
+                // The first sequence is built by push_back and the second one by random insertions, so their leaf boundaries differ.
+                BIT_SEQUENCE seq1, seq2;
+                std::vector<bool> naive_bits1, naive_bits2;
+                for (int64_t i = 0; i < num; i++)
+                {
+                    bool b1 = mt64() % density == 0;
+                    seq1.push_back(b1);
+                    naive_bits1.push_back(b1);
+
+                    bool b2 = mt64() % 2 == 0;
+                    uint64_t p = mt64() % (naive_bits2.size() + 1);
+                    seq2.insert(p, b2);
+                    naive_bits2.insert(naive_bits2.begin() + p, b2);
+                }
+
+                std::vector<bool> and_bits, or_bits, xor_bits;
+                uint64_t and_count = 0, or_count = 0, xor_count = 0;
+                for (int64_t i = 0; i < num; i++)
+                {
+                    and_bits.push_back(naive_bits1[i] && naive_bits2[i]);
+                    or_bits.push_back(naive_bits1[i] || naive_bits2[i]);
+                    xor_bits.push_back(naive_bits1[i] != naive_bits2[i]);
+                    and_count += and_bits[i] ? 1 : 0;
+                    or_count += or_bits[i] ? 1 : 0;
+                    xor_count += xor_bits[i] ? 1 : 0;
+                }
+
+                if (seq1.and_count(seq2) != and_count || seq1.or_count(seq2) != or_count || seq1.xor_count(seq2) != xor_count)
+                {
+                    throw std::logic_error("bitwise_combine_test: count error");
+                }
+
+                BIT_SEQUENCE out;
+                seq1.combine_into(stool::bptree::BitwiseOperation::AND, seq2, out);
+                if (out.to_vector() != and_bits)
+                {
+                    throw std::logic_error("bitwise_combine_test: AND error");
+                }
+                seq1.combine_into(stool::bptree::BitwiseOperation::OR, seq2, out);
+                if (out.to_vector() != or_bits)
+                {
+                    throw std::logic_error("bitwise_combine_test: OR error");
+                }
+                seq1.combine_into(stool::bptree::BitwiseOperation::XOR, seq2, seq1);
+                if (seq1.to_vector() != xor_bits)
+                {
+                    throw std::logic_error("bitwise_combine_test: XOR error");
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void word_io_test(BIT_SEQUENCE &spsi, int64_t number_of_operations, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "word_io_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            std::vector<bool> naive_bits;
+            spsi.clear();
+
+            for (int64_t t = 0; t < number_of_operations; t++)
+            {
+                uint64_t len = mt64() % 20000;
+                std::vector<uint64_t> words;
+                std::vector<bool> bits;
+                for (uint64_t i = 0; i < (len + 63) / 64; i++)
+                {
+                    words.push_back(mt64());
+                }
+                for (uint64_t i = 0; i < len; i++)
+                {
+                    bits.push_back(stool::bptree::PackedBitFunctions::get_bit(words.data(), i));
+                }
+
+                if (t % 3 == 0)
+                {
+                    spsi.append_words(words.data(), len);
+                    naive_bits.insert(naive_bits.end(), bits.begin(), bits.end());
+                }
+                else if (t % 3 == 1)
+                {
+                    uint64_t pos = mt64() % (naive_bits.size() + 1);
+                    bool v = mt64() % 2 == 0;
+                    spsi.insert_run(pos, v, len);
+                    naive_bits.insert(naive_bits.begin() + pos, len, v);
+                }
+                else
+                {
+                    uint64_t pos = mt64() % (naive_bits.size() + 1);
+                    spsi.insert_words(pos, words.data(), len);
+                    naive_bits.insert(naive_bits.begin() + pos, bits.begin(), bits.end());
+                }
+
+                if (spsi.size() != naive_bits.size() || spsi.count1() != (int64_t)std::count(naive_bits.begin(), naive_bits.end(), true))
+                {
+                    throw std::logic_error("word_io_test: size or count error");
+                }
+
+                for (uint64_t x = 0; x < 10; x++)
+                {
+                    uint64_t i = mt64() % (naive_bits.size() + 1);
+                    uint64_t range_len = mt64() % (naive_bits.size() - i + 1);
+                    std::vector<uint64_t> output;
+                    spsi.extract_words(i, range_len, output);
+                    for (uint64_t j = 0; j < range_len; j++)
+                    {
+                        if (stool::bptree::PackedBitFunctions::get_bit(output.data(), j) != naive_bits[i + j])
+                        {
+                            throw std::logic_error("word_io_test: extract_words error");
+                        }
+                    }
+                    if (range_len % 64 != 0 && (output[output.size() - 1] << (range_len % 64)) != 0)
+                    {
+                        throw std::logic_error("word_io_test: the unused bits are not zero");
+                    }
+                }
+            }
+
+            std::vector<uint64_t> packed = spsi.to_packed_vector();
+            auto it = spsi.get_bit_forward_iterator_begin();
+            for (uint64_t i = 0; i < packed.size(); i++)
+            {
+                if (it.is_end() || *it != packed[i])
+                {
+                    throw std::logic_error("word_io_test: to_packed_vector error");
+                }
+                ++it;
+            }
+            spsi.verify();
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        /**
+         * @brief Compare rank and select of \p spsi with a naive bit sequence for sparse, dense, and block-wise constant bits, which cross the 512-bit blocks of the packed leaves in different ways.
+         */
+        template <typename BIT_SEQUENCE>
+        static void packed_leaf_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_updates, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "packed_leaf_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            for (uint64_t pattern = 0; pattern < 3; pattern++)
+            {
+                auto get_bit = [&](uint64_t i)
+                {
+                    if (pattern == 0)
+                    {
+                        return mt64() % 500 == 0;
+                    }
+                    else if (pattern == 1)
+                    {
+                        return mt64() % 500 != 0;
+                    }
+                    else
+                    {
+                        return ((i / 700) % 2 == 0) != (mt64() % 1000 == 0);
+                    }
+                };
+
+                std::vector<bool> naive_bits;
+                spsi.clear();
+                while ((int64_t)naive_bits.size() < num)
+                {
+                    bool b = get_bit(naive_bits.size());
+                    spsi.push_back(b);
+                    naive_bits.push_back(b);
+                }
+
+                for (int64_t t = 0; t <= number_of_updates; t++)
+                {
+                    if (t % (number_of_updates / 4 + 1) == 0)
+                    {
+                        std::vector<int64_t> one_positions, zero_positions;
+                        for (uint64_t i = 0; i < naive_bits.size(); i++)
+                        {
+                            if ((uint64_t)spsi.one_based_rank(i, true) != one_positions.size() || (uint64_t)spsi.one_based_rank(i, false) != zero_positions.size())
+                            {
+                                throw std::logic_error("packed_leaf_test: rank error");
+                            }
+                            (naive_bits[i] ? one_positions : zero_positions).push_back(i);
+                        }
+                        for (uint64_t k = 0; k < one_positions.size(); k++)
+                        {
+                            if (spsi.select1(k) != one_positions[k])
+                            {
+                                throw std::logic_error("packed_leaf_test: select1 error");
+                            }
+                        }
+                        for (uint64_t k = 0; k < zero_positions.size(); k++)
+                        {
+                            if (spsi.select0(k) != zero_positions[k])
+                            {
+                                throw std::logic_error("packed_leaf_test: select0 error");
+                            }
+                        }
+                        if (spsi.select1(one_positions.size()) != -1 || spsi.select0(zero_positions.size()) != -1)
+                        {
+                            throw std::logic_error("packed_leaf_test: select error (out of range)");
+                        }
+                    }
+
+                    uint64_t type = mt64() % 3;
+                    if (type == 0 || naive_bits.size() == 0)
+                    {
+                        uint64_t pos = mt64() % (naive_bits.size() + 1);
+                        bool b = get_bit(pos);
+                        spsi.insert(pos, b);
+                        naive_bits.insert(naive_bits.begin() + pos, b);
+                    }
+                    else if (type == 1)
+                    {
+                        uint64_t pos = mt64() % naive_bits.size();
+                        spsi.remove(pos);
+                        naive_bits.erase(naive_bits.begin() + pos);
+                    }
+                    else
+                    {
+                        uint64_t pos = mt64() % naive_bits.size();
+                        bool b = !naive_bits[pos];
+                        spsi.set_bit(pos, b);
+                        naive_bits[pos] = b;
+                    }
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void select0_after_update_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_updates, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "select0_after_update_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            std::vector<bool> naive_bits;
+            spsi.clear();
+            while ((int64_t)naive_bits.size() < num)
+            {
+                bool b = mt64() % 2;
+                spsi.push_back(b);
+                naive_bits.push_back(b);
+            }
+
+            for (int64_t t = 0; t < number_of_updates; t++)
+            {
+                uint64_t type = mt64() % 3;
+                if (type == 0 || naive_bits.size() == 0)
+                {
+                    uint64_t pos = mt64() % (naive_bits.size() + 1);
+                    bool b = mt64() % 2;
+                    spsi.insert(pos, b);
+                    naive_bits.insert(naive_bits.begin() + pos, b);
+                }
+                else if (type == 1)
+                {
+                    uint64_t pos = mt64() % naive_bits.size();
+                    spsi.remove(pos);
+                    naive_bits.erase(naive_bits.begin() + pos);
+                }
+                else
+                {
+                    uint64_t pos = mt64() % naive_bits.size();
+                    bool b = mt64() % 2;
+                    spsi.set_bit(pos, b);
+                    naive_bits[pos] = b;
+                }
+
+                std::vector<uint64_t> zero_positions;
+                for (uint64_t i = 0; i < naive_bits.size(); i++)
+                {
+                    if (!naive_bits[i])
+                    {
+                        zero_positions.push_back(i);
+                    }
+                }
+                for (uint64_t x = 0; x < 10 && zero_positions.size() > 0; x++)
+                {
+                    uint64_t rank = mt64() % zero_positions.size();
+                    if (spsi.select0(rank) != (int64_t)zero_positions[rank])
+                    {
+                        throw std::logic_error("select0_after_update_test: select0 error");
+                    }
+                }
+                if (spsi.select0(zero_positions.size()) != -1)
+                {
+                    throw std::logic_error("select0_after_update_test: select0 error (out of range)");
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void run_length_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_updates, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "run_length_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            std::vector<bool> naive_bits;
+            spsi.clear();
+            bool b = false;
+            while ((int64_t)naive_bits.size() < num)
+            {
+                if (mt64() % 500 == 0)
+                {
+                    b = !b;
+                }
+                spsi.push_back(b);
+                naive_bits.push_back(b);
+            }
+
+            for (int64_t t = 0; t < number_of_updates; t++)
+            {
+                uint64_t type = mt64() % 4;
+                if (type <= 1 || naive_bits.size() == 0)
+                {
+                    uint64_t pos = mt64() % (naive_bits.size() + 1);
+                    bool value = pos < naive_bits.size() ? naive_bits[pos] : (mt64() % 2);
+                    spsi.insert(pos, value);
+                    naive_bits.insert(naive_bits.begin() + pos, value);
+                }
+                else if (type == 2)
+                {
+                    uint64_t pos = mt64() % naive_bits.size();
+                    spsi.remove(pos);
+                    naive_bits.erase(naive_bits.begin() + pos);
+                }
+                else
+                {
+                    uint64_t pos = mt64() % naive_bits.size();
+                    bool value = mt64() % 2;
+                    spsi.set_bit(pos, value);
+                    naive_bits[pos] = value;
+                }
+            }
+
+            if (to_bit_values(spsi) != std::vector<uint64_t>(naive_bits.begin(), naive_bits.end()))
+            {
+                throw std::logic_error("run_length_test: access error");
+            }
+            uint64_t ones = 0;
+            for (uint64_t i = 0; i < naive_bits.size(); i++)
+            {
+                if ((uint64_t)spsi.rank1(i) != ones)
+                {
+                    throw std::logic_error("run_length_test: rank1 error");
+                }
+                if (naive_bits[i])
+                {
+                    if (spsi.select1(ones) != (int64_t)i)
+                    {
+                        throw std::logic_error("run_length_test: select1 error");
+                    }
+                    ones++;
+                }
+                else if (spsi.select0(i - ones) != (int64_t)i)
+                {
+                    throw std::logic_error("run_length_test: select0 error");
+                }
+            }
+            if (spsi.select1(ones) != -1 || spsi.select0(naive_bits.size() - ones) != -1)
+            {
+                throw std::logic_error("run_length_test: select error (out of range)");
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        /**
+         * @brief Check that the leaves of \p spsi (a DynamicRunLengthBitSequence) stay in the run-length mode on bits with long runs, and that \p spsi is much smaller than a SimpleDynamicBitSequence storing the same bits.
+         * @details The leaves are bounded by their run count, so a leaf of long runs holds more bits than the leaf size parameter of the sequence.
+         */
+        template <typename BIT_SEQUENCE>
+        static void run_length_memory_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_updates, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "run_length_memory_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            std::vector<bool> naive_bits;
+            spsi.clear();
+            bool b = false;
+            while ((int64_t)naive_bits.size() < num)
+            {
+                if (mt64() % 2000 == 0)
+                {
+                    b = !b;
+                }
+                spsi.push_back(b);
+                naive_bits.push_back(b);
+            }
+
+            for (int64_t t = 0; t < number_of_updates; t++)
+            {
+                if (mt64() % 2 == 0)
+                {
+                    uint64_t pos = mt64() % naive_bits.size();
+                    spsi.insert(pos, naive_bits[pos]);
+                    naive_bits.insert(naive_bits.begin() + pos, naive_bits[pos]);
+                }
+                else
+                {
+                    uint64_t pos = mt64() % naive_bits.size();
+                    spsi.remove(pos);
+                    naive_bits.erase(naive_bits.begin() + pos);
+                }
+            }
+            spsi.verify();
+            if (to_bit_values(spsi) != std::vector<uint64_t>(naive_bits.begin(), naive_bits.end()))
+            {
+                throw std::logic_error("run_length_memory_test: access error");
+            }
+
+            uint64_t max_leaf_size = 0;
+            auto check_leaf = [&](const auto &leaf)
+            {
+                if (!leaf.is_run_length_mode())
+                {
+                    throw std::logic_error("run_length_memory_test: a leaf is not in the run-length mode");
+                }
+                max_leaf_size = std::max<uint64_t>(max_leaf_size, leaf.size());
+            };
+            spsi.for_each_leaf_container(check_leaf);
+            if (max_leaf_size <= 10000)
+            {
+                throw std::logic_error("run_length_memory_test: the leaves are bounded by the number of bits");
+            }
+
+            stool::bptree::SimpleDynamicBitSequence plain_bits;
+            for (bool bit : naive_bits)
+            {
+                plain_bits.push_back(bit);
+            }
+            if (spsi.size_in_bytes() * 8 > plain_bits.size_in_bytes())
+            {
+                throw std::logic_error("run_length_memory_test: the run-length leaves do not save memory (" + std::to_string(spsi.size_in_bytes()) + " bytes, raw: " + std::to_string(plain_bits.size_in_bytes()) + " bytes)");
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
+        template <typename BIT_SEQUENCE>
+        static void local_edit_test(BIT_SEQUENCE &spsi, int64_t num, int64_t number_of_updates, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
+        {
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << stool::Message::get_paragraph_string(message_paragraph) << "local_edit_test: " << std::flush;
+            }
+            std::mt19937_64 mt64(seed);
+            std::vector<bool> naive_bits;
+            spsi.clear();
+            uint64_t cursor = 0;
+            for (int64_t t = 0; t < num + number_of_updates; t++)
+            {
+                int64_t step = (int64_t)(mt64() % 17) - 8;
+                cursor = std::min<uint64_t>(std::max<int64_t>(0, (int64_t)cursor + step), naive_bits.size());
+                if (t < num || mt64() % 2 == 0 || naive_bits.size() == cursor)
+                {
+                    bool b = mt64() % 2;
+                    spsi.insert(cursor, b);
+                    naive_bits.insert(naive_bits.begin() + cursor, b);
+                    cursor++;
+                }
+                else
+                {
+                    spsi.remove(cursor);
+                    naive_bits.erase(naive_bits.begin() + cursor);
+                }
+            }
+
+            if (to_bit_values(spsi) != std::vector<uint64_t>(naive_bits.begin(), naive_bits.end()))
+            {
+                throw std::logic_error("local_edit_test: access error");
+            }
+            uint64_t ones = 0;
+            for (uint64_t i = 0; i < naive_bits.size(); i++)
+            {
+                if ((uint64_t)spsi.rank1(i) != ones)
+                {
+                    throw std::logic_error("local_edit_test: rank1 error");
+                }
+                if (naive_bits[i])
+                {
+                    if (spsi.select1(ones) != (int64_t)i)
+                    {
+                        throw std::logic_error("local_edit_test: select1 error");
+                    }
+                    ones++;
+                }
+                else if (spsi.select0(i - ones) != (int64_t)i)
+                {
+                    throw std::logic_error("local_edit_test: select0 error");
+                }
+            }
+            if (message_paragraph != stool::Message::NO_MESSAGE)
+            {
+                std::cout << "[DONE]" << std::endl;
+            }
+        }
+
         template <typename BIT_SEQUENCE>
         static void insert_and_delete_test(BIT_SEQUENCE &spsi, int64_t num, int64_t seed, int message_paragraph = stool::Message::SHOW_MESSAGE)
         {
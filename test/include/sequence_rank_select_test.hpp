@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+namespace stool
+{
+    class SequenceRankSelectTest
+    {
+    public:
+        /**
+         * @brief Compare access, rank, select, and count_c of a dynamic sequence \p ds with a naive sequence \p text for every symbol in \p symbols.
+         * @details Rank is checked at every 64th position and at every occurrence; select is checked at every occurrence and one past the last occurrence.
+         */
+        template <typename SEQ, typename SYMBOL>
+        static void rank_select_test(const SEQ &ds, const std::vector<SYMBOL> &text, const std::vector<SYMBOL> &symbols, const std::string &test_name)
+        {
+            for (SYMBOL c : symbols)
+            {
+                uint64_t rank = 0;
+                for (uint64_t i = 0; i <= text.size(); i++)
+                {
+                    bool is_occurrence = i < text.size() && text[i] == c;
+                    if ((i % 64 == 0 || is_occurrence) && (uint64_t)ds.one_based_rank(i, c) != rank)
+                    {
+                        throw std::logic_error(test_name + ": rank error");
+                    }
+                    if (is_occurrence)
+                    {
+                        if (ds.select(rank, c) != (int64_t)i || ds.at(i) != c)
+                        {
+                            throw std::logic_error(test_name + ": select error");
+                        }
+                        rank++;
+                    }
+                }
+                if (ds.count_c(c) != rank || ds.select(rank, c) != -1)
+                {
+                    throw std::logic_error(test_name + ": count error");
+                }
+            }
+        }
+    };
+}
@@ -8,6 +8,9 @@
 
 #include "../../include/all.hpp"
 #include <random>
+#include <thread>
+#include <atomic>
+#include <sstream>
 
 namespace stool
 {
@@ -440,6 +443,503 @@ static void load_write_file_test(stool::bptree::DynamicPrefixSum<A, B, C> &spsi)
             }
             stool::EqualChecker::equal_check(vec1, vec2);
         }
+
+        template <typename T>
+        static void set_values_test(uint64_t num, uint64_t max_value, uint64_t number_of_trials, int64_t seed)
+        {
+            std::cout << "set_values_test: " << T::name() << std::flush;
+            std::mt19937_64 mt64(seed);
+            std::uniform_int_distribution<uint64_t> get_rand_value(0, max_value - 1);
+
+            for (uint64_t trial = 0; trial < number_of_trials; trial++)
+            {
+                std::cout << "+" << std::flush;
+                std::vector<uint64_t> items;
+                for (uint64_t i = 0; i < num; i++)
+                {
+                    items.push_back(get_rand_value(mt64));
+                }
+                T seq = T::build(items);
+
+                for (uint64_t t = 0; t < 20; t++)
+                {
+                    uint64_t i = mt64() % num;
+                    uint64_t len = mt64() % (num - i + 1);
+                    std::vector<uint64_t> values_Q;
+                    for (uint64_t j = 0; j < len; j++)
+                    {
+                        values_Q.push_back(get_rand_value(mt64));
+                        items[i + j] = values_Q[j];
+                    }
+                    seq.set_values(i, values_Q);
+                    seq.verify();
+
+                    std::vector<uint64_t> vec = seq.to_vector();
+                    stool::EqualChecker::equal_check(items, vec);
+                }
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
+
+        template <typename T>
+        static void streaming_build_test(uint64_t max_num, uint64_t max_value, uint64_t number_of_trials, int64_t seed)
+        {
+            std::cout << "streaming_build_test: " << T::name() << std::flush;
+            std::mt19937_64 mt64(seed);
+            std::uniform_int_distribution<uint64_t> get_rand_value(0, max_value - 1);
+
+            for (uint64_t trial = 0; trial < number_of_trials; trial++)
+            {
+                std::cout << "+" << std::flush;
+                uint64_t num = mt64() % max_num;
+                std::vector<uint64_t> items;
+                for (uint64_t i = 0; i < num; i++)
+                {
+                    items.push_back(get_rand_value(mt64));
+                }
+
+                for (auto format : {stool::bptree::IntegerStreamIterator::Format::RAW_UINT64, stool::bptree::IntegerStreamIterator::Format::VARINT})
+                {
+                    std::stringstream ss;
+                    for (uint64_t v : items)
+                    {
+                        stool::bptree::IntegerStreamIterator::write(ss, v, format);
+                    }
+                    T seq = T::build_from_stream(ss, format);
+                    seq.verify();
+                    std::vector<uint64_t> vec = seq.to_vector();
+                    stool::EqualChecker::equal_check(items, vec);
+                }
+
+                T seq2 = T::build(items.begin(), items.end());
+                seq2.verify();
+                std::vector<uint64_t> vec2 = seq2.to_vector();
+                stool::EqualChecker::equal_check(items, vec2);
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
+
+        static void varint_overflow_test()
+        {
+            std::cout << "varint_overflow_test" << std::flush;
+            using Iterator = stool::bptree::IntegerStreamIterator;
+
+            // The largest 64-bit value uses all 10 bytes and must round-trip.
+            std::vector<uint64_t> items = {0, 1, 127, 128, UINT64_MAX - 1, UINT64_MAX, (1ULL << 63)};
+            std::stringstream ss;
+            for (uint64_t v : items)
+            {
+                Iterator::write(ss, v, Iterator::Format::VARINT);
+            }
+            std::vector<uint64_t> vec;
+            for (Iterator it(ss, Iterator::Format::VARINT); !it.is_end(); ++it)
+            {
+                vec.push_back(*it);
+            }
+            stool::EqualChecker::equal_check(items, vec);
+
+            // A 10th byte carrying more than bit 63, and an 11-byte varint, must be rejected.
+            std::vector<std::string> invalid_inputs;
+            invalid_inputs.push_back(std::string(9, (char)0xFF) + (char)0x02);
+            invalid_inputs.push_back(std::string(9, (char)0xFF) + (char)0x7F);
+            invalid_inputs.push_back(std::string(10, (char)0x80) + (char)0x01);
+            for (const std::string &input : invalid_inputs)
+            {
+                std::stringstream invalid_ss(input);
+                bool thrown = false;
+                try
+                {
+                    Iterator it(invalid_ss, Iterator::Format::VARINT);
+                }
+                catch (const std::runtime_error &)
+                {
+                    thrown = true;
+                }
+                if (!thrown)
+                {
+                    throw std::runtime_error("varint_overflow_test: an overlong varint is accepted");
+                }
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
+
+        template <typename T>
+        static void sharded_parallel_increment_test(uint64_t num, uint64_t shard_count, uint64_t thread_count, uint64_t increments_per_thread, int64_t seed)
+        {
+            std::cout << "sharded_parallel_increment_test: " << T::name() << std::flush;
+            std::mt19937_64 mt64(seed);
+            std::vector<uint64_t> items;
+            for (uint64_t i = 0; i < num; i++)
+            {
+                items.push_back(mt64() % 100);
+            }
+            T seq(items, shard_count);
+            uint64_t initial_sum = seq.psum();
+
+            // A reader searches concurrently with the writers. The sums only grow, so every x <= initial_sum must be found.
+            std::atomic<bool> writers_done{false};
+            std::atomic<uint64_t> search_failures{0};
+            std::thread reader([&seq, &writers_done, &search_failures, initial_sum, seed]()
+                               {
+                std::mt19937_64 local_mt64(seed + 12345);
+                while (!writers_done.load())
+                {
+                    uint64_t x = (local_mt64() % initial_sum) + 1;
+                    if (seq.search(x) == -1)
+                    {
+                        search_failures.fetch_add(1);
+                    }
+                } });
+
+            uint64_t region = num / thread_count;
+            std::vector<std::thread> threads;
+            for (uint64_t t = 0; t < thread_count; t++)
+            {
+                threads.emplace_back([&seq, t, region, increments_per_thread, seed]()
+                                     {
+                    std::mt19937_64 local_mt64(seed + t);
+                    for (uint64_t x = 0; x < increments_per_thread; x++)
+                    {
+                        seq.increment(t * region + (local_mt64() % region), 1);
+                    } });
+            }
+            for (std::thread &th : threads)
+            {
+                th.join();
+            }
+            writers_done.store(true);
+            reader.join();
+            if (search_failures.load() != 0)
+            {
+                throw std::runtime_error("sharded_parallel_increment_test: a concurrent search returned -1");
+            }
+            seq.verify();
+
+            uint64_t expected_sum = thread_count * increments_per_thread;
+            for (uint64_t v : items)
+            {
+                expected_sum += v;
+            }
+            if (seq.psum() != expected_sum || seq.psum(num - 1) != expected_sum)
+            {
+                throw std::runtime_error("sharded_parallel_increment_test: psum error");
+            }
+
+            std::vector<uint64_t> vec = seq.to_vector();
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < num; i += 97)
+            {
+                sum = seq.psum(i);
+                if (vec[i] > 0 && (uint64_t)seq.search(sum) != i)
+                {
+                    throw std::runtime_error("sharded_parallel_increment_test: search error");
+                }
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
+
+        template <typename T>
+        static void range_psum_test(uint64_t num, uint64_t max_value, uint64_t number_of_trials, int64_t seed)
+        {
+            std::cout << "range_psum_test: " << T::name() << std::flush;
+            std::mt19937_64 mt64(seed);
+            std::uniform_int_distribution<uint64_t> get_rand_value(0, max_value - 1);
+            for (uint64_t trial = 0; trial < number_of_trials; trial++)
+            {
+                std::cout << "+" << std::flush;
+                std::vector<uint64_t> items;
+                for (uint64_t i = 0; i < num; i++)
+                {
+                    items.push_back(get_rand_value(mt64));
+                }
+                T spsi = T::build(items);
+                std::vector<uint64_t> naive_psum(num + 1, 0);
+                for (uint64_t i = 0; i < num; i++)
+                {
+                    naive_psum[i + 1] = naive_psum[i] + items[i];
+                }
+
+                for (uint64_t x = 0; x < num; x++)
+                {
+                    uint64_t i = mt64() % num;
+                    uint64_t j = i + (mt64() % (num - i));
+                    if (spsi.psum(i, j) != naive_psum[j + 1] - naive_psum[i])
+                    {
+                        throw std::runtime_error("range_psum_test: psum(i, j) error");
+                    }
+                }
+
+                // The empty range S[j+1..j] has sum 0.
+                for (uint64_t j = 0; j + 1 < num; j++)
+                {
+                    if (spsi.psum(j + 1, j) != 0)
+                    {
+                        throw std::runtime_error("range_psum_test: psum(j+1, j) error");
+                    }
+                }
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
+
+        template <typename T>
+        static void sharded_verify_with_naive(const T &seq, const std::vector<uint64_t> &naive, const std::string &test_name)
+        {
+            seq.verify();
+            if (seq.size() != naive.size())
+            {
+                throw std::runtime_error(test_name + ": size error");
+            }
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < naive.size(); i++)
+            {
+                sum += naive[i];
+                if (seq.at(i) != naive[i])
+                {
+                    throw std::runtime_error(test_name + ": at error");
+                }
+                if (seq.psum(i) != sum)
+                {
+                    throw std::runtime_error(test_name + ": psum error");
+                }
+                if (naive[i] > 0 && (uint64_t)seq.search(sum) != i)
+                {
+                    throw std::runtime_error(test_name + ": search error");
+                }
+            }
+            if (seq.psum() != sum || seq.search(sum + 1) != -1)
+            {
+                throw std::runtime_error(test_name + ": total sum error");
+            }
+        }
+
+        template <typename T>
+        static void sharded_random_test(uint64_t num, uint64_t shard_count, uint64_t max_value, uint64_t number_of_trials, int64_t seed)
+        {
+            std::cout << "sharded_random_test: " << T::name() << std::flush;
+            std::mt19937_64 mt64(seed);
+            std::uniform_int_distribution<uint64_t> get_rand_value(0, max_value - 1);
+
+            for (uint64_t trial = 0; trial < number_of_trials; trial++)
+            {
+                std::cout << "+" << std::flush;
+                T seq(shard_count);
+                std::vector<uint64_t> naive;
+
+                // Skewed insertions: all the values go to the first or the last shard.
+                bool insert_front = trial % 2 == 0;
+                for (uint64_t t = 0; t < num; t++)
+                {
+                    uint64_t pos = insert_front ? 0 : naive.size();
+                    uint64_t value = get_rand_value(mt64);
+                    seq.insert(pos, value);
+                    naive.insert(naive.begin() + pos, value);
+                }
+                sharded_verify_with_naive(seq, naive, "sharded_random_test(skewed insert)");
+
+                // Random insertions and removals, with removals concentrated on the first quarter.
+                for (uint64_t t = 0; t < num; t++)
+                {
+                    if (mt64() % 2 == 0)
+                    {
+                        uint64_t pos = mt64() % (naive.size() + 1);
+                        uint64_t value = get_rand_value(mt64);
+                        seq.insert(pos, value);
+                        naive.insert(naive.begin() + pos, value);
+                    }
+                    else
+                    {
+                        uint64_t pos = mt64() % (naive.size() / 4 + 1);
+                        seq.remove(pos);
+                        naive.erase(naive.begin() + pos);
+                    }
+                }
+                sharded_verify_with_naive(seq, naive, "sharded_random_test(random update)");
+
+                // Skewed removals: the first shards are emptied repeatedly, so the shards must be redistributed.
+                seq.rebalance();
+                while (naive.size() > num / 4)
+                {
+                    uint64_t pos = mt64() % 16;
+                    pos = pos < naive.size() ? pos : 0;
+                    seq.remove(pos);
+                    naive.erase(naive.begin() + pos);
+
+                    uint64_t n = naive.size();
+                    if (n >= T::MIN_SIZE_FOR_REBALANCING && n % 97 == 0)
+                    {
+                        for (uint64_t k = 0; k < seq.shard_count(); k++)
+                        {
+                            if (seq.shard_size(k) * 4 < n / seq.shard_count())
+                            {
+                                throw std::runtime_error("sharded_random_test: a shard is not rebalanced after removals");
+                            }
+                        }
+                    }
+                }
+                sharded_verify_with_naive(seq, naive, "sharded_random_test(skewed remove)");
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
+
+        template <uint64_t K, uint64_t B, uint64_t C>
+        static void multi_prefix_sum_random_test(uint64_t num, uint64_t max_value, uint64_t number_of_trials, int64_t seed)
+        {
+            std::cout << "multi_prefix_sum_random_test: " << stool::bptree::DynamicMultiPrefixSum<K, B, C>::name() << std::flush;
+            std::mt19937_64 mt64(seed);
+            std::uniform_int_distribution<uint64_t> get_rand_value(0, max_value - 1);
+            using Tuple = typename stool::bptree::DynamicMultiPrefixSum<K, B, C>::Tuple;
+
+            for (uint64_t trial = 0; trial < number_of_trials; trial++)
+            {
+                std::cout << "+" << std::flush;
+                stool::bptree::DynamicMultiPrefixSum<K, B, C> mps;
+                std::vector<Tuple> naive;
+
+                for (uint64_t t = 0; t < num * 2; t++)
+                {
+                    uint64_t type = naive.size() == 0 || t < num ? 0 : mt64() % 6;
+                    if (type == 0)
+                    {
+                        uint64_t pos = mt64() % (naive.size() + 1);
+                        Tuple value;
+                        for (uint64_t k = 0; k < K; k++)
+                        {
+                            value[k] = get_rand_value(mt64);
+                        }
+                        mps.insert(pos, value);
+                        naive.insert(naive.begin() + pos, value);
+                    }
+                    else if (type == 1)
+                    {
+                        uint64_t pos = mt64() % naive.size();
+                        mps.remove(pos);
+                        naive.erase(naive.begin() + pos);
+                    }
+                    else if (type == 2)
+                    {
+                        uint64_t pos = mt64() % naive.size();
+                        uint64_t lane = mt64() % K;
+                        uint64_t delta = get_rand_value(mt64);
+                        mps.increment(lane, pos, delta);
+                        naive[pos][lane] += delta;
+                    }
+                    else if (type == 3)
+                    {
+                        uint64_t pos = mt64() % naive.size();
+                        uint64_t lane = mt64() % K;
+                        uint64_t delta = mt64() % (naive[pos][lane] + 1);
+                        mps.decrement(lane, pos, delta);
+                        naive[pos][lane] -= delta;
+                    }
+                    else if (type == 4)
+                    {
+                        uint64_t pos = mt64() % naive.size();
+                        uint64_t lane = mt64() % K;
+                        uint64_t value = mt64() % 4 == 0 ? 0 : get_rand_value(mt64);
+                        mps.set_value(lane, pos, value);
+                        naive[pos][lane] = value;
+                    }
+                    else
+                    {
+                        uint64_t pos = mt64() % naive.size();
+                        Tuple value;
+                        for (uint64_t k = 0; k < K; k++)
+                        {
+                            value[k] = get_rand_value(mt64);
+                        }
+                        mps.set_value(pos, value);
+                        naive[pos] = value;
+                    }
+
+                    if (naive.size() > 0 && t % 16 == 0)
+                    {
+                        uint64_t pos = mt64() % naive.size();
+                        Tuple expected_sum;
+                        expected_sum.fill(0);
+                        for (uint64_t i = 0; i <= pos; i++)
+                        {
+                            for (uint64_t k = 0; k < K; k++)
+                            {
+                                expected_sum[k] += naive[i][k];
+                            }
+                        }
+                        if (mps.psum_all(pos) != expected_sum || mps.at(pos) != naive[pos])
+                        {
+                            throw std::runtime_error("multi_prefix_sum_random_test: psum_all error after an update");
+                        }
+                    }
+                }
+                mps.verify();
+
+                Tuple all_sum;
+                all_sum.fill(0);
+                for (uint64_t i = 0; i < naive.size(); i++)
+                {
+                    for (uint64_t k = 0; k < K; k++)
+                    {
+                        all_sum[k] += naive[i][k];
+                    }
+                    if (mps.psum_all(i) != all_sum)
+                    {
+                        throw std::runtime_error("multi_prefix_sum_random_test: psum_all error");
+                    }
+                }
+                if (mps.psum() != all_sum)
+                {
+                    throw std::runtime_error("multi_prefix_sum_random_test: psum() error");
+                }
+
+                for (uint64_t k = 0; k < K; k++)
+                {
+                    uint64_t sum = 0;
+                    for (uint64_t i = 0; i < naive.size(); i++)
+                    {
+                        sum += naive[i][k];
+                        if (mps.psum(k, i) != sum)
+                        {
+                            throw std::runtime_error("multi_prefix_sum_random_test: psum error");
+                        }
+                        if (naive[i][k] > 0 && (uint64_t)mps.search(k, sum) != i)
+                        {
+                            throw std::runtime_error("multi_prefix_sum_random_test: search error");
+                        }
+                    }
+                    if (mps.psum_of_lane(k) != sum || mps.search(k, sum + 1) != -1)
+                    {
+                        throw std::runtime_error("multi_prefix_sum_random_test: total sum error");
+                    }
+                }
+
+                if (naive.size() > 1)
+                {
+                    bool thrown = false;
+                    try
+                    {
+                        mps.psum(K, 1, naive.size() - 1);
+                    }
+                    catch (const std::invalid_argument &)
+                    {
+                        thrown = true;
+                    }
+                    if (!thrown)
+                    {
+                        throw std::runtime_error("multi_prefix_sum_random_test: an invalid lane is accepted");
+                    }
+                }
+
+                std::vector<uint8_t> bytes;
+                uint64_t pos = 0;
+                stool::bptree::DynamicMultiPrefixSum<K, B, C>::store_to_bytes(mps, bytes, pos);
+                pos = 0;
+                stool::bptree::DynamicMultiPrefixSum<K, B, C> loaded = stool::bptree::DynamicMultiPrefixSum<K, B, C>::load_from_bytes(bytes, pos);
+                loaded.verify();
+                if (pos != bytes.size() || loaded.to_vector() != naive)
+                {
+                    throw std::runtime_error("multi_prefix_sum_random_test: load error");
+                }
+            }
+            std::cout << "[DONE]" << std::endl;
+        }
     };
 
 }
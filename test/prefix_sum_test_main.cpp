@@ -50,6 +50,16 @@ int main(int argc, char *argv[])
     test.remove_test(seq_len, max_value, number_of_trials, false, seed);
     test.replace_test(seq_len, max_value, number_of_trials, false, seed);
     test.template random_test<false>(seq_len, max_value, number_of_trials, 100, false, seed);
+    stool::SPSITest::set_values_test<stool::bptree::SimpleDynamicPrefixSum>(seq_len, max_value, 10, seed);
+    stool::SPSITest::streaming_build_test<stool::bptree::SimpleDynamicPrefixSum>(seq_len * 10, max_value, 10, seed);
+    stool::SPSITest::varint_overflow_test();
+    stool::SPSITest::range_psum_test<stool::bptree::SimpleDynamicPrefixSum>(seq_len, max_value, 10, seed);
+
+    stool::SPSITest::sharded_parallel_increment_test<stool::bptree::ShardedDynamicPrefixSum<>>(seq_len * 10, 16, 8, 100000, seed);
+    stool::SPSITest::sharded_random_test<stool::bptree::ShardedDynamicPrefixSum<>>(seq_len, 16, max_value, 4, seed);
+
+    stool::SPSITest::multi_prefix_sum_random_test<3, 8, 8>(1000, max_value, 10, seed);
+    stool::SPSITest::multi_prefix_sum_random_test<2, 62, 256>(seq_len, max_value, 3, seed);
 
 
     /*
@@ -238,6 +238,10 @@ void range_search_test_sub(uint64_t size, uint64_t number_of_trials, uint64_t se
     RANGED_DYNAMIC_WAVELET_MATRIX ds = RANGED_DYNAMIC_WAVELET_MATRIX::build(rank_array);
 
     for(uint64_t i = 0; i < number_of_trials; i++){
+        // The second half of the queries run on the frozen levels.
+        if(i == number_of_trials / 2){
+            ds.freeze(2);
+        }
         uint64_t x_min = get_rand_uni_int(mt64);
         uint64_t x_max = get_rand_uni_int(mt64);
         if(x_min > x_max){
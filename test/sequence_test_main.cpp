@@ -7,6 +7,7 @@
 #include <cstdio>
 #include "../include/all.hpp"
 #include "stool/test/sources/template/dynamic_integer_test.hpp"
+#include "include/spsi_test.hpp"
 
 using SEQ = stool::bptree::DynamicSequence64<stool::NaiveFLCVector<>, 62, 256>;
 
@@ -52,6 +53,8 @@ int main(int argc, char *argv[])
     test.insert_test(seq_len, max_value, number_of_trials, false, seed);
     test.remove_test(seq_len, max_value, number_of_trials, false, seed);
     test.replace_test(seq_len, max_value, number_of_trials, false, seed);
+    stool::SPSITest::set_values_test<SEQ>(seq_len, max_value, 10, seed);
+    stool::SPSITest::streaming_build_test<SEQ>(seq_len * 10, max_value, 10, seed);
 
     /*
     stool::DynamicIntegerTest::build_test<SEQ>(seq_len, max_value, number_of_trials, seed);
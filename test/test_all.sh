@@ -1,6 +1,7 @@
 #!/bin/sh
 
 ./build/bit_test
+./build/fm_index_test
 ./build/permutation_test
 ./build/prefix_sum_test
 ./build/range_search_test
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <chrono>
 #include "../include/all.hpp"
+#include "include/sequence_rank_select_test.hpp"
 #include "../modules/stool/test/sources/template/dynamic_string_test.hpp"
 #include "../modules/stool/test/sources/template/string_test.hpp"
 
@@ -21,6 +22,9 @@ void build_test(stool::bptree::DynamicWaveletTree &ds, stool::NaiveDynamicString
     std::vector<uint8_t> test_str = ds.to_u8_vector();
     stool::EqualChecker::equal_check(test_str, dyn_text.text);
 
+    auto parallel_tmp = stool::bptree::DynamicWaveletTree::build(text, alphabet, 4);
+    std::vector<uint8_t> parallel_str = parallel_tmp.to_u8_vector();
+    stool::EqualChecker::equal_check(parallel_str, dyn_text.text);
 }
 
 void rank_test(const stool::bptree::DynamicWaveletTree &ds, const stool::NaiveDynamicString &text, const std::vector<uint8_t> &alphabet)
@@ -75,6 +79,184 @@ void insert_test(stool::bptree::DynamicWaveletTree &ds, stool::NaiveDynamicStrin
     stool::EqualChecker::equal_check(test_str, text.text);
 
 }
+void insert_many_test(stool::bptree::DynamicWaveletTree &ds, stool::NaiveDynamicString &text, const std::vector<uint8_t> &alphabet, uint64_t number_of_blocks, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    for (uint64_t i = 0; i < number_of_blocks; i++)
+    {
+        std::vector<uint8_t> block;
+        uint64_t block_size = mt64() % 3000;
+        for (uint64_t x = 0; x < block_size; x++)
+        {
+            block.push_back(alphabet[mt64() % alphabet.size()]);
+        }
+        uint64_t nth = i % 2 == 0 ? text.size() : mt64() % (text.size() + 1);
+        for (uint64_t x = 0; x < block.size(); x++)
+        {
+            text.insert_string(nth + x, block[x]);
+        }
+        if (i % 2 == 0)
+        {
+            ds.push_many(block, i % 4 == 0 ? 1 : 4);
+        }
+        else
+        {
+            ds.insert_many(nth, block, i % 4 == 1 ? 1 : 4);
+        }
+    }
+
+    std::vector<uint8_t> test_str = ds.to_u8_vector();
+    stool::EqualChecker::equal_check(test_str, text.text);
+}
+
+void extract_test(const stool::bptree::DynamicWaveletTree &ds, const stool::NaiveDynamicString &text, uint64_t number_of_trials, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    std::vector<uint8_t> output;
+    for (uint64_t t = 0; t < number_of_trials; t++)
+    {
+        uint64_t i = mt64() % (text.size() + 1);
+        uint64_t j = i + (mt64() % (text.size() - i + 1));
+        ds.extract(i, j, output);
+        std::vector<uint8_t> correct_output(text.text.begin() + i, text.text.begin() + j);
+        stool::EqualChecker::equal_check(output, correct_output);
+    }
+
+    uint64_t start = text.size() == 0 ? 0 : mt64() % text.size();
+    uint64_t p = start;
+    for (auto it = ds.get_char_forward_iterator_begin(start); it != ds.get_char_forward_iterator_end(); ++it)
+    {
+        if (*it != text.text[p])
+        {
+            throw std::logic_error("Error: extract_test (iterator)");
+        }
+        p++;
+    }
+    if (p != (uint64_t)text.size())
+    {
+        throw std::logic_error("Error: extract_test (iterator length)");
+    }
+}
+
+void range_query_test(const stool::bptree::DynamicWaveletTree &ds, const stool::NaiveDynamicString &text, const std::vector<uint8_t> &alphabet, uint64_t number_of_trials, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    for (uint64_t t = 0; t < number_of_trials; t++)
+    {
+        uint64_t i = mt64() % (text.size() + 1);
+        uint64_t j = i + (mt64() % (text.size() - i + 1));
+        std::vector<uint8_t> sorted_chars(text.text.begin() + i, text.text.begin() + j);
+        std::sort(sorted_chars.begin(), sorted_chars.end());
+
+        if (i < j)
+        {
+            uint64_t k = mt64() % (j - i);
+            if (ds.range_quantile(i, j, k) != sorted_chars[k])
+            {
+                throw std::logic_error("Error: range_query_test (range_quantile)");
+            }
+        }
+
+        uint8_t a = alphabet[mt64() % alphabet.size()] - (mt64() % 2);
+        uint8_t b = alphabet[mt64() % alphabet.size()] + (mt64() % 2);
+        uint64_t correct_freq = 0;
+        for (uint8_t c : sorted_chars)
+        {
+            if (a <= c && c <= b)
+            {
+                correct_freq++;
+            }
+        }
+        if (ds.range_frequency(i, j, a, b) != correct_freq)
+        {
+            throw std::logic_error("Error: range_query_test (range_frequency)");
+        }
+
+        std::vector<std::pair<uint8_t, uint64_t>> correct_top_k;
+        for (uint8_t c : sorted_chars)
+        {
+            if (correct_top_k.size() > 0 && correct_top_k.back().first == c)
+            {
+                correct_top_k.back().second++;
+            }
+            else
+            {
+                correct_top_k.push_back(std::pair<uint8_t, uint64_t>(c, 1));
+            }
+        }
+        std::stable_sort(correct_top_k.begin(), correct_top_k.end(), [](const auto &x, const auto &y)
+                         { return x.second > y.second; });
+        uint64_t k = mt64() % (alphabet.size() + 2);
+        if (correct_top_k.size() > k)
+        {
+            correct_top_k.resize(k);
+        }
+        if (ds.range_top_k(i, j, k) != correct_top_k)
+        {
+            throw std::logic_error("Error: range_query_test (range_top_k)");
+        }
+    }
+}
+
+void interval_symbols_test(const stool::bptree::DynamicWaveletTree &ds, const stool::NaiveDynamicString &text, const std::vector<uint8_t> &alphabet, uint64_t number_of_trials, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    std::vector<uint8_t> sorted_alphabet = alphabet;
+    std::sort(sorted_alphabet.begin(), sorted_alphabet.end());
+    for (uint64_t t = 0; t < number_of_trials; t++)
+    {
+        uint64_t i = mt64() % (text.size() + 1);
+        uint64_t j = i + (mt64() % (text.size() - i + 1));
+        std::vector<std::tuple<uint8_t, uint64_t, uint64_t>> correct_items;
+        for (uint8_t c : sorted_alphabet)
+        {
+            uint64_t rank_i = stool::StringFunctions::one_based_rank_query(text.text, i, c);
+            uint64_t rank_j = stool::StringFunctions::one_based_rank_query(text.text, j, c);
+            if (rank_i < rank_j)
+            {
+                correct_items.push_back(std::tuple<uint8_t, uint64_t, uint64_t>(c, rank_i, rank_j));
+            }
+        }
+        std::vector<std::tuple<uint8_t, uint64_t, uint64_t>> items = ds.interval_symbols(i, j);
+        if (!ds.has_lexicographic_leaf_order())
+        {
+            std::sort(items.begin(), items.end());
+        }
+        if (items != correct_items)
+        {
+            throw std::logic_error("Error: interval_symbols_test");
+        }
+    }
+}
+
+void occurrence_test(const stool::bptree::DynamicWaveletTree &ds, const stool::NaiveDynamicString &text, const std::vector<uint8_t> &alphabet, uint64_t number_of_trials, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    for (uint64_t t = 0; t < number_of_trials; t++)
+    {
+        uint64_t i = mt64() % (text.size() + 1);
+        uint64_t j = i + (mt64() % (text.size() - i + 1));
+        uint8_t c = alphabet[mt64() % alphabet.size()];
+        std::vector<uint64_t> correct_positions;
+        for (uint64_t p = i; p < j; p++)
+        {
+            if (text.text[p] == c)
+            {
+                correct_positions.push_back(p);
+            }
+        }
+        std::vector<uint64_t> positions;
+        for (auto it = ds.get_occurrence_iterator_begin(i, j, c); it != ds.get_occurrence_iterator_end(); ++it)
+        {
+            positions.push_back(*it);
+        }
+        if (positions != correct_positions)
+        {
+            throw std::logic_error("Error: occurrence_test");
+        }
+    }
+}
+
 void remove_test(stool::bptree::DynamicWaveletTree &ds, stool::NaiveDynamicString &text, uint64_t seed)
 {
     std::mt19937_64 mt64(seed);
@@ -141,6 +323,164 @@ void save_and_load_test(stool::bptree::DynamicWaveletTree &ds)
     }
 }
 
+void alphabet_growth_test(uint64_t number_of_insertions, bool sorted_arrival, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    std::vector<uint8_t> new_chars;
+    for (uint64_t c = 0; c < 256; c++)
+    {
+        new_chars.push_back(c);
+    }
+    if (!sorted_arrival)
+    {
+        std::shuffle(new_chars.begin(), new_chars.end(), mt64);
+    }
+
+    stool::bptree::DynamicWaveletTree ds;
+    stool::NaiveDynamicString text;
+    std::vector<uint8_t> alphabet;
+    for (uint64_t t = 0; t < number_of_insertions; t++)
+    {
+        uint8_t c;
+        if (alphabet.size() < new_chars.size() && (alphabet.size() == 0 || mt64() % 8 == 0))
+        {
+            c = new_chars[alphabet.size()];
+            alphabet.push_back(c);
+        }
+        else
+        {
+            c = alphabet[mt64() % alphabet.size()];
+        }
+        uint64_t pos = mt64() % (text.size() + 1);
+        ds.insert(pos, c);
+        text.insert_string(pos, c);
+    }
+    if (ds.get_alphabet_size() != alphabet.size() || ds.has_lexicographic_leaf_order() != std::is_sorted(alphabet.begin(), alphabet.end()))
+    {
+        throw std::logic_error("Error: alphabet_growth_test (alphabet)");
+    }
+    stool::EqualChecker::equal_check(ds.to_u8_vector(), text.text);
+    rank_test(ds, text, alphabet);
+    select_test(ds, text, alphabet);
+    range_query_test(ds, text, alphabet, 100, seed);
+    interval_symbols_test(ds, text, alphabet, 100, seed);
+    occurrence_test(ds, text, alphabet, 100, seed);
+
+    std::vector<uint8_t> block;
+    for (uint64_t x = 0; x < 100; x++)
+    {
+        block.push_back(new_chars[(alphabet.size() + x) % new_chars.size()]);
+    }
+    uint64_t pos = mt64() % (text.size() + 1);
+    ds.insert_many(pos, block);
+    for (uint64_t x = 0; x < block.size(); x++)
+    {
+        text.insert_string(pos + x, block[x]);
+    }
+    save_and_load_test(ds);
+    stool::EqualChecker::equal_check(ds.to_u8_vector(), text.text);
+}
+
+void huffman_wavelet_tree_test(uint64_t alphabet_size, uint64_t len, uint64_t number_of_updates, double drift_threshold, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    std::vector<uint8_t> alphabet;
+    std::vector<double> weights;
+    for (uint64_t i = 0; i < alphabet_size; i++)
+    {
+        alphabet.push_back(255 - i);
+        weights.push_back(1.0 / (double)((i + 1) * (i + 1)));
+    }
+    std::discrete_distribution<uint64_t> get_rand_char(weights.begin(), weights.end());
+    std::vector<uint8_t> text;
+    for (uint64_t i = 0; i < len; i++)
+    {
+        text.push_back(alphabet[get_rand_char(mt64)]);
+    }
+    stool::bptree::DynamicHuffmanWaveletTree hwt = stool::bptree::DynamicHuffmanWaveletTree::build(text, alphabet);
+    hwt.set_drift_threshold(drift_threshold);
+    if (alphabet_size > 2 && hwt.get_code_length(alphabet[0]) > hwt.get_code_length(alphabet[alphabet_size - 1]))
+    {
+        throw std::logic_error("huffman_wavelet_tree_test: the most frequent character has a longer code");
+    }
+
+    // The distribution is reversed to make the shape drift.
+    std::reverse(weights.begin(), weights.end());
+    std::discrete_distribution<uint64_t> get_rand_char2(weights.begin(), weights.end());
+    for (uint64_t t = 0; t < number_of_updates; t++)
+    {
+        uint64_t rebuild_count = hwt.get_rebuild_count();
+        double average_code_length = hwt.get_average_code_length();
+        if (mt64() % 3 != 0 || text.size() == 0)
+        {
+            uint64_t pos = mt64() % (text.size() + 1);
+            uint8_t c = alphabet[get_rand_char2(mt64)];
+            hwt.insert(pos, c);
+            text.insert(text.begin() + pos, c);
+        }
+        else
+        {
+            uint64_t pos = mt64() % text.size();
+            hwt.remove(pos);
+            text.erase(text.begin() + pos);
+        }
+
+        // A rebuild is triggered only by a drift of more than the threshold, so it must shorten the codes.
+        if (hwt.get_rebuild_count() != rebuild_count && hwt.get_average_code_length() >= average_code_length)
+        {
+            throw std::logic_error("huffman_wavelet_tree_test: a rebuild does not shorten the average code length");
+        }
+    }
+    if (drift_threshold > 0 && number_of_updates >= 2 * stool::bptree::DynamicHuffmanWaveletTree::CHECK_INTERVAL && hwt.get_rebuild_count() == 0)
+    {
+        throw std::logic_error("huffman_wavelet_tree_test: the drifted tree is not rebuilt");
+    }
+    else if (drift_threshold == 0 && hwt.get_rebuild_count() != 0)
+    {
+        throw std::logic_error("huffman_wavelet_tree_test: the tree is rebuilt without a drift threshold");
+    }
+    hwt.verify();
+    stool::EqualChecker::equal_check(text, hwt.to_u8_vector(), "huffman_wavelet_tree_test");
+    stool::SequenceRankSelectTest::rank_select_test(hwt, text, alphabet, "huffman_wavelet_tree_test");
+}
+
+template <typename WM>
+void wavelet_matrix_test(uint64_t bit_width, uint64_t alphabet_size, uint64_t len, uint64_t number_of_updates, uint64_t seed)
+{
+    std::mt19937_64 mt64(seed);
+    std::vector<typename WM::value_type> symbols;
+    for (uint64_t i = 0; i < alphabet_size; i++)
+    {
+        symbols.push_back(bit_width == 64 ? mt64() : mt64() % (1ULL << bit_width));
+    }
+    std::vector<typename WM::value_type> text;
+    for (uint64_t i = 0; i < len; i++)
+    {
+        text.push_back(symbols[mt64() % alphabet_size]);
+    }
+    WM wm = WM::build(text, bit_width);
+
+    for (uint64_t t = 0; t < number_of_updates; t++)
+    {
+        if (mt64() % 3 != 0 || text.size() == 0)
+        {
+            uint64_t pos = mt64() % (text.size() + 1);
+            auto c = symbols[mt64() % alphabet_size];
+            wm.insert(pos, c);
+            text.insert(text.begin() + pos, c);
+        }
+        else
+        {
+            uint64_t pos = mt64() % text.size();
+            wm.remove(pos);
+            text.erase(text.begin() + pos);
+        }
+    }
+    wm.verify();
+    stool::EqualChecker::equal_check(text, wm.to_vector(), "wavelet_matrix_test");
+    stool::SequenceRankSelectTest::rank_select_test(wm, text, symbols, "wavelet_matrix_test");
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef DEBUG
@@ -218,8 +558,20 @@ int main(int argc, char *argv[])
                 rank_test(ds, dyn_text, chars);
                 std::cout << "C" << std::flush;
                 select_test(ds, dyn_text, chars);
+                ds.freeze(2);
+                rank_test(ds, dyn_text, chars);
+                select_test(ds, dyn_text, chars);
+                range_query_test(ds, dyn_text, chars, 20, seed);
+                occurrence_test(ds, dyn_text, chars, 20, seed);
+                ds.thaw();
                 std::cout << "D" << std::flush;
                 save_and_load_test(ds);
+                insert_many_test(ds, dyn_text, chars, 8, seed);
+                rank_test(ds, dyn_text, chars);
+                extract_test(ds, dyn_text, 100, seed);
+                range_query_test(ds, dyn_text, chars, 100, seed);
+                interval_symbols_test(ds, dyn_text, chars, 100, seed);
+                occurrence_test(ds, dyn_text, chars, 100, seed);
                 //std::cout << "E" << std::flush;
                 //insert_test(ds, dyn_text, chars, 1000, seed++);
                 std::cout << "F" << std::flush;
@@ -231,5 +583,23 @@ int main(int argc, char *argv[])
                 std::cout << std::endl;
 
         }
+
+        std::cout << "wavelet_matrix_test" << std::flush;
+        wavelet_matrix_test<stool::bptree::DynamicWaveletMatrix32>(20, 50, 3000, 2000, seed++);
+        wavelet_matrix_test<stool::bptree::DynamicWaveletMatrix32>(32, 1000, 3000, 2000, seed++);
+        wavelet_matrix_test<stool::bptree::DynamicWaveletMatrix64>(64, 50, 3000, 2000, seed++);
+        std::cout << "[DONE]" << std::endl;
+
+        std::cout << "huffman_wavelet_tree_test" << std::flush;
+        huffman_wavelet_tree_test(1, 1000, 1000, 0, seed++);
+        huffman_wavelet_tree_test(2, 3000, 2000, 0, seed++);
+        huffman_wavelet_tree_test(20, 3000, 2000, 0, seed++);
+        huffman_wavelet_tree_test(200, 3000, 10000, 0.05, seed++);
+        std::cout << "[DONE]" << std::endl;
+
+        std::cout << "alphabet_growth_test" << std::flush;
+        alphabet_growth_test(2000, true, seed++);
+        alphabet_growth_test(2000, false, seed++);
+        std::cout << "[DONE]" << std::endl;
     }
 }